@@ -0,0 +1,138 @@
+import argparse
+import os
+import pathlib
+import re
+import sys
+
+# 解释器实现了处理的超级指令, 依次为合并后的操作码, 前一条指令, 后一条指令
+# 前一条指令本身也可以是超级指令, 用于合并三条指令
+CANDIDATES = [
+    ("EXT_OP_GET_LOCAL_GET_LOCAL", "EXT_OP_GET_LOCAL_FAST", "EXT_OP_GET_LOCAL_FAST"),
+    ("EXT_OP_GET_LOCAL_GET_LOCAL_I32_ADD", "EXT_OP_GET_LOCAL_GET_LOCAL", "WASM_OP_I32_ADD"),
+    ("EXT_OP_GET_LOCAL_I32_CONST", "EXT_OP_GET_LOCAL_FAST", "WASM_OP_I32_CONST"),
+    ("EXT_OP_GET_LOCAL_I32_CONST_ADD", "EXT_OP_GET_LOCAL_I32_CONST", "WASM_OP_I32_ADD"),
+    ("EXT_OP_GET_LOCAL_I32_LOAD", "EXT_OP_GET_LOCAL_FAST", "WASM_OP_I32_LOAD"),
+    ("EXT_OP_I32_CONST_ADD", "WASM_OP_I32_CONST", "WASM_OP_I32_ADD"),
+    ("EXT_OP_I32_ADD_SET_LOCAL", "WASM_OP_I32_ADD", "EXT_OP_SET_LOCAL_FAST"),
+    ("EXT_OP_I32_EQZ_BR_IF", "WASM_OP_I32_EQZ", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_EQ_BR_IF", "WASM_OP_I32_EQ", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_NE_BR_IF", "WASM_OP_I32_NE", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_LT_S_BR_IF", "WASM_OP_I32_LT_S", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_LT_U_BR_IF", "WASM_OP_I32_LT_U", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_GT_S_BR_IF", "WASM_OP_I32_GT_S", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_GT_U_BR_IF", "WASM_OP_I32_GT_U", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_LE_S_BR_IF", "WASM_OP_I32_LE_S", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_LE_U_BR_IF", "WASM_OP_I32_LE_U", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_GE_S_BR_IF", "WASM_OP_I32_GE_S", "WASM_OP_BR_IF"),
+    ("EXT_OP_I32_GE_U_BR_IF", "WASM_OP_I32_GE_U", "WASM_OP_BR_IF"),
+]
+
+
+def read_opcodes(opcode_header):
+    opcodes = {}
+    for name, value in re.findall(r"\b((?:WASM|EXT)_OP_\w+)\s*=\s*(0x[0-9a-fA-F]+)", opcode_header.read_text()):
+        opcodes.setdefault(name, int(value, 16))
+    return opcodes
+
+
+# opcode_pairs.log每行为: 前一条指令 后一条指令 次数
+# 每个负载先换算为占比再取平均, 避免运行时间长的负载占满整张表
+def read_profiles(profiles):
+    pairs = {}
+    for profile in profiles:
+        counts = {}
+        for line in profile.read_text().splitlines():
+            fields = line.split()
+            if len(fields) != 3:
+                continue
+            key = (int(fields[0], 16), int(fields[1], 16))
+            counts[key] = counts.get(key, 0) + int(fields[2])
+        total = sum(counts.values())
+        for key, count in counts.items():
+            pairs[key] = pairs.get(key, 0) + count / total / len(profiles)
+    return pairs
+
+
+# 三条指令的次数取两个指令对中较小的一个作为估计
+def estimate_counts(opcodes, pairs):
+    counts = {}
+    lasts = {}
+    for fused, first, second in CANDIDATES:
+        if first in counts:
+            count = min(counts[first], pairs.get((opcodes[lasts[first]], opcodes[second]), 0))
+        else:
+            count = pairs.get((opcodes[first], opcodes[second]), 0)
+        counts[fused] = count
+        lasts[fused] = second
+    return counts
+
+
+def select(counts, max_num, min_share):
+    selected = []
+    for fused, share in sorted(counts.items(), key=lambda item: -item[1]):
+        if len(selected) >= max_num or share == 0 or share < min_share:
+            break
+        selected.append(fused)
+
+    # 合并三条指令时依赖前两条指令的超级指令
+    for fused, first, _ in CANDIDATES:
+        if fused in selected and first in counts and first not in selected:
+            selected.append(first)
+    return selected
+
+
+def write_def(output, selected, counts):
+    lines = ["// 由build-scripts/gen_superinstr.py生成, 请勿手动修改"]
+    for fused, first, second in CANDIDATES:
+        if fused in selected:
+            lines.append(f"SUPER_INSTR({fused}, {first}, {second}) // {counts[fused] * 100:.2f}%")
+    output.write_text("\n".join(lines) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="select interpreter superinstructions from opcode pair profiles")
+    parser.add_argument(
+        "profiles",
+        nargs="+",
+        type=pathlib.Path,
+        help="opcode_pairs.log files written by a RUNTIME_BUILD_OPCODE_PROFILE=1 build",
+    )
+    parser.add_argument(
+        "--max",
+        type=int,
+        default=len(CANDIDATES),
+        help="maximum number of superinstructions to enable",
+    )
+    parser.add_argument(
+        "--min-share",
+        type=float,
+        default=0.005,
+        help="minimum average share of executed instructions a sequence must reach",
+    )
+
+    options = parser.parse_args()
+
+    current_file = pathlib.Path(__file__)
+    if current_file.is_symlink():
+        current_file = pathlib.Path(os.readlink(current_file))
+    current_dir = current_file.parent.resolve()
+    include_dir = current_dir.joinpath("../runtime/wasmvm/common/include").resolve()
+
+    opcodes = read_opcodes(include_dir.joinpath("wasm_opcode.h"))
+    pairs = read_profiles(options.profiles)
+    if not pairs:
+        print("no opcode pairs recorded")
+        return False
+
+    counts = estimate_counts(opcodes, pairs)
+    selected = select(counts, options.max, options.min_share)
+    write_def(include_dir.joinpath("wasm_superinstr.def"), selected, counts)
+
+    print(f"{len(selected)} superinstructions selected from {len(options.profiles)} profiles")
+    for fused in selected:
+        print(f"  {fused}: {counts[fused] * 100:.2f}%")
+    return True
+
+
+if __name__ == "__main__":
+    sys.exit(0 if main() else 1)
@@ -29,6 +29,49 @@ else ()
     message ("     interpreter don not use builtin function")
 endif ()
 
+if (RUNTIME_BUILD_TAIL_CALL_DISPATCH EQUAL 1)
+    add_definitions (-DWASM_ENABLE_TAIL_CALL_DISPATCH=1)
+    message ("     interpreter tail-call dispatch enabled")
+    # 尾调用分发只实现了栈式指令的处理
+    set (RUNTIME_BUILD_SLOT_INTERP 0)
+    set (RUNTIME_BUILD_TOS_CACHE 0)
+else ()
+    add_definitions (-DWASM_ENABLE_TAIL_CALL_DISPATCH=0)
+    message ("     interpreter tail-call dispatch disabled")
+endif ()
+
+if (RUNTIME_BUILD_SLOT_INTERP EQUAL 1)
+    add_definitions (-DWASM_ENABLE_SLOT_INTERP=1)
+    message ("     interpreter slot mode enabled")
+else ()
+    add_definitions (-DWASM_ENABLE_SLOT_INTERP=0)
+    message ("     interpreter slot mode disabled")
+endif ()
+
+if (RUNTIME_BUILD_TOS_CACHE EQUAL 1)
+    add_definitions (-DWASM_ENABLE_TOS_CACHE=1)
+    message ("     interpreter top-of-stack cache enabled")
+else ()
+    add_definitions (-DWASM_ENABLE_TOS_CACHE=0)
+    message ("     interpreter top-of-stack cache disabled")
+endif ()
+
+if (RUNTIME_BUILD_OPCODE_PROFILE EQUAL 1)
+    add_definitions (-DWASM_ENABLE_OPCODE_PROFILE=1)
+    message ("     interpreter opcode pair profile enabled")
+else ()
+    add_definitions (-DWASM_ENABLE_OPCODE_PROFILE=0)
+    message ("     interpreter opcode pair profile disabled")
+endif ()
+
+if (RUNTIME_BUILD_HW_BOUND_CHECK EQUAL 1)
+    add_definitions (-DWASM_ENABLE_HW_BOUND_CHECK=1)
+    message ("     hardware bound check enabled")
+else ()
+    add_definitions (-DWASM_ENABLE_HW_BOUND_CHECK=0)
+    message ("     hardware bound check disabled")
+endif ()
+
 if (RUNTIME_BUILD_WASI EQUAL 1)
     add_definitions (-DWASM_ENABLE_WASI=1)
     message ("     wasi enable")
@@ -54,11 +97,27 @@ if (RUNTIME_BUILD_JIT EQUAL 1)
     message(STATUS "Found LLVM ${LLVM_PACKAGE_VERSION}")
     message(STATUS "Using LLVMConfig.cmake in: ${LLVM_DIR}")
     message ("     Jit enabled")
+    if (RUNTIME_BUILD_TIERED_JIT EQUAL 1)
+        add_definitions (-DWASM_ENABLE_TIERED_JIT=1)
+        message ("     tiered jit enabled")
+    else ()
+        add_definitions (-DWASM_ENABLE_TIERED_JIT=0)
+        message ("     tiered jit disabled")
+    endif ()
 else ()
     add_definitions (-DWASM_ENABLE_JIT=0)
+    add_definitions (-DWASM_ENABLE_TIERED_JIT=0)
     message ("     Jit disabled")
 endif ()
 
+if (RUNTIME_BUILD_AOT EQUAL 1)
+    add_definitions (-DWASM_ENABLE_AOT=1)
+    message ("     aot loader enabled")
+else ()
+    add_definitions (-DWASM_ENABLE_AOT=0)
+    message ("     aot loader disabled")
+endif ()
+
 include(${PLATFORM_DIR}/platform.cmake)
 include(${UTILS_DIR}/utils.cmake)
 include (${WASMVM_DIR}/wasmvm.cmake)
@@ -2,6 +2,16 @@ if (NOT DEFINED RUNTIME_BUILD_JIT)
   set (RUNTIME_BUILD_JIT 0)
 endif ()
 
+# 仅在启用JIT时有效: 先由解释器执行, 热点函数在后台线程编译后切换到本地代码
+if (NOT DEFINED RUNTIME_BUILD_TIERED_JIT)
+  set (RUNTIME_BUILD_TIERED_JIT 0)
+endif ()
+
+# 加载wasmc预编译的本地代码, 不需要链接LLVM
+if (NOT DEFINED RUNTIME_BUILD_AOT)
+  set (RUNTIME_BUILD_AOT 0)
+endif ()
+
 if(NOT DEFINED RUNTIME_BUILD_THREAD)
   set (RUNTIME_BUILD_THREAD 0)
 endif()
@@ -14,6 +24,45 @@ if(NOT DEFINED RUNTIME_BUILD_DISPATCH)
   set (RUNTIME_BUILD_DISPATCH 1)
 endif()
 
+# 每条指令一个处理函数并以尾调用分发, 用于与计算跳转的解释器对比
+if(NOT DEFINED RUNTIME_BUILD_TAIL_CALL_DISPATCH)
+  set (RUNTIME_BUILD_TAIL_CALL_DISPATCH 0)
+endif()
+
+# 编译器不支持musttail时只能依赖优化阶段的尾调用消除, 未优化的构建每条指令都会占用一层C栈
+if (RUNTIME_BUILD_TAIL_CALL_DISPATCH EQUAL 1 AND CMAKE_BUILD_TYPE STREQUAL "Debug")
+  include (CheckCSourceCompiles)
+  set (CMAKE_REQUIRED_FLAGS "-Werror")
+  check_c_source_compiles ("
+    int f(int x);
+    int g(int x) { __attribute__((musttail)) return f(x); }
+    int main(void) { return 0; }" RUNTIME_HAVE_MUSTTAIL)
+  unset (CMAKE_REQUIRED_FLAGS)
+  if (NOT RUNTIME_HAVE_MUSTTAIL)
+    message (FATAL_ERROR "RUNTIME_BUILD_TAIL_CALL_DISPATCH=1 needs a compiler with musttail "
+                         "(e.g. clang) or an optimized build (CMAKE_BUILD_TYPE=Release/RelWithDebInfo)")
+  endif ()
+endif()
+
+if(NOT DEFINED RUNTIME_BUILD_SLOT_INTERP)
+  set (RUNTIME_BUILD_SLOT_INTERP 0)
+endif()
+
+# 只把栈顶的一个i32值缓存在寄存器中, i64和浮点指令仍经由内存中的操作数栈
+if(NOT DEFINED RUNTIME_BUILD_TOS_CACHE)
+  set (RUNTIME_BUILD_TOS_CACHE 0)
+endif()
+
+if(NOT DEFINED RUNTIME_BUILD_OPCODE_PROFILE)
+  set (RUNTIME_BUILD_OPCODE_PROFILE 0)
+endif()
+
+# 线性内存预留8GiB虚拟地址, 越界访问由保护页触发信号后转换为陷入, 不再逐次比较,
+# 关闭时只按最大页数预留, JIT在访存前显式检查并合并, 外提冗余的检查
+if(NOT DEFINED RUNTIME_BUILD_HW_BOUND_CHECK)
+  set (RUNTIME_BUILD_HW_BOUND_CHECK 1)
+endif()
+
 if(NOT DEFINED RUNTIME_BUILD_BUILTIN)
   set (RUNTIME_BUILD_BUILTIN 1)
 endif()
@@ -21,4 +70,6 @@ endif()
 set(RUNTIME_BUILD_WASI 1)
 
 file (GLOB_RECURSE source_all ${PRODUCT_DIR}/main.c)
-set (MAIN_SOURCE ${source_all})
\ No newline at end of file
+set (MAIN_SOURCE ${source_all})
+
+set (WASMC_SOURCE ${PRODUCT_DIR}/wasmc.c)
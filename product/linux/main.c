@@ -3,6 +3,8 @@
 #include "wasm_exception.h"
 #include "wasm_memory.h"
 
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
 static int app_argc;
 static char **app_argv;
 
@@ -30,6 +32,29 @@ print_help()
     printf("                           --allow-resolve=example.com # allow the lookup of the specific domain\n");
     printf("                           --allow-resolve=*.example.com # allow the lookup of all subdomains\n");
     printf("                           --allow-resolve=* # allow any lookup\n");
+    printf("  --huge-pages=<mode>      Back linear memory with 2 MiB pages, mode is\n"
+           "                           \"advise\" (transparent huge pages) or \"explicit\"\n"
+           "                           (MAP_HUGETLB), and report the huge page backed size\n");
+    printf("  --lazy-validation        Validate each function on its first call instead of\n"
+           "                           validating the whole module before running\n");
+    printf("  --stream                 Load and validate the module while reading it in\n"
+           "                           chunks, wasm_file \"-\" reads from stdin\n");
+    printf("  --instances=n            Compile the module once and run it in n instances\n"
+           "                           one after another, each with its own memory\n");
+    printf("  --pool                   Take instances from a pre-created pool and reset\n"
+           "                           them after each run instead of creating new ones\n");
+    printf("  --snapshot-save=<file>   Run _initialize and the start function, then save\n"
+           "                           memory, globals and tables to file and exit\n");
+    printf("  --snapshot=<file>        Restore the initialized state from file instead of\n"
+           "                           running _initialize and the start function\n");
+#if WASM_ENABLE_AOT != 0
+    printf("  --aot=<file>             Run the native code compiled by wasmc from file,\n"
+           "                           fall back when it does not match the module\n");
+#endif
+#if WASM_ENABLE_JIT != 0
+    printf("  --jit-cache=<dir>        Reuse JIT compiled code saved in dir, compile and\n"
+           "                           save the whole module there on a cache miss\n");
+#endif
     printf("  --version                Show version information\n");
     return 1;
 }
@@ -69,6 +94,52 @@ split_string(char *str, int *count)
     return res;
 }
 
+// 按块读取wasm文件并交给流式加载器, 加载器由调用者在销毁模块之后释放
+static bool
+load_module_stream(WASMModule *module, const char *wasm_file,
+                   WASMStreamLoader **p_loader)
+{
+    uint8 *chunk = NULL;
+    ssize_t read_size;
+    int fd = 0;
+    bool ret = false;
+
+    if (strcmp(wasm_file, "-") && (fd = open(wasm_file, O_RDONLY)) < 0)
+    {
+        wasm_set_exception(module, "open file failed");
+        return false;
+    }
+
+    if (!(chunk = wasm_runtime_malloc(STREAM_CHUNK_SIZE)))
+    {
+        wasm_set_exception(module, "malloc error");
+        goto fail;
+    }
+
+    if (!(*p_loader = wasm_stream_loader_create(module)))
+        goto fail;
+
+    while ((read_size = read(fd, chunk, STREAM_CHUNK_SIZE)) > 0)
+    {
+        if (!wasm_stream_loader_feed(*p_loader, chunk, (uint32)read_size))
+            goto fail;
+    }
+
+    if (read_size < 0)
+    {
+        wasm_set_exception(module, "read file failed");
+        goto fail;
+    }
+
+    ret = wasm_stream_loader_finish(*p_loader);
+fail:
+    if (chunk)
+        wasm_runtime_free(chunk);
+    if (fd)
+        close(fd);
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
     wasm_runtime_init_env();
@@ -86,7 +157,20 @@ int main(int argc, char *argv[])
     char *wasm_file = NULL;
     uint32 value_stack_size = 1024 * 16;
     uint32 exectution_stack_size = 1024 * 16;
-    for (argc--, argv++; argc > 0 && argv[0][0] == '-'; argc--, argv++)
+    WASMHugePageMode huge_page_mode = WASM_HUGE_PAGE_NONE;
+    bool lazy_validation = false;
+    bool stream_mode = false;
+    WASMStreamLoader *stream_loader = NULL;
+    uint8 *file_buf = NULL;
+    const uint8 *file_map = NULL;
+    uint32 instance_count = 1, i;
+    bool pool_mode = false;
+    WASMInstancePool *pool = NULL;
+    const char *snapshot_file = NULL, *snapshot_save_file = NULL;
+#if WASM_ENABLE_AOT != 0
+    const char *aot_file = NULL;
+#endif
+    for (argc--, argv++; argc > 0 && argv[0][0] == '-' && argv[0][1] != '\0'; argc--, argv++)
     {
         if (!strncmp(argv[0], "-v=", 3))
         {
@@ -110,6 +194,60 @@ int main(int argc, char *argv[])
                 return print_help();
             value_stack_size = atoi(argv[0] + 24);
         }
+        else if (!strncmp(argv[0], "--huge-pages=", 13))
+        {
+            if (!strcmp(argv[0] + 13, "advise"))
+                huge_page_mode = WASM_HUGE_PAGE_ADVISE;
+            else if (!strcmp(argv[0] + 13, "explicit"))
+                huge_page_mode = WASM_HUGE_PAGE_EXPLICIT;
+            else
+                return print_help();
+        }
+        else if (!strcmp(argv[0], "--lazy-validation"))
+        {
+            lazy_validation = true;
+        }
+        else if (!strcmp(argv[0], "--stream"))
+        {
+            stream_mode = true;
+        }
+        else if (!strncmp(argv[0], "--instances=", 12))
+        {
+            if (atoi(argv[0] + 12) <= 0)
+                return print_help();
+            instance_count = (uint32)atoi(argv[0] + 12);
+        }
+        else if (!strcmp(argv[0], "--pool"))
+        {
+            pool_mode = true;
+        }
+        else if (!strncmp(argv[0], "--snapshot-save=", 16))
+        {
+            if (argv[0][16] == '\0')
+                return print_help();
+            snapshot_save_file = argv[0] + 16;
+        }
+        else if (!strncmp(argv[0], "--snapshot=", 11))
+        {
+            if (argv[0][11] == '\0')
+                return print_help();
+            snapshot_file = argv[0] + 11;
+        }
+#if WASM_ENABLE_AOT != 0
+        else if (!strncmp(argv[0], "--aot=", 6))
+        {
+            if (argv[0][6] == '\0')
+                return print_help();
+            aot_file = argv[0] + 6;
+        }
+#endif
+#if WASM_ENABLE_JIT != 0
+        else if (!strncmp(argv[0], "--jit-cache=", 12))
+        {
+            if (argv[0][12] == '\0' || !wasm_jit_set_cache_dir(argv[0] + 12))
+                return print_help();
+        }
+#endif
         else if (!strncmp(argv[0], "--dir=", 6))
         {
             if (argv[0][6] == '\0')
@@ -184,53 +322,164 @@ int main(int argc, char *argv[])
     app_argv = argv;
 
     log_set_verbose_level(log_verbose_level);
-    uint8 *file_buf = platform_read_file(wasm_file, &ret_size);
-    if (!file_buf)
+    // 优先只读映射文件, 同一模块的多个进程共享代码页; 无法映射时读入内存
+    if (!stream_mode && !(file_map = platform_map_file(wasm_file, &ret_size))
+        && !(file_buf = platform_read_file(wasm_file, &ret_size)))
     {
         goto read_file_fail;
     }
 
-    WASMModule *module = wasm_module_create();
+    WASMModule *module = wasm_module_create(), *instance = module;
     if (!module)
         goto create_module_fail;
 
-    if (!wasm_loader(module, file_buf, ret_size))
+    if (lazy_validation && !wasm_set_lazy_validation(module))
         goto fail;
 
-    if (!wasm_validator(module))
+#if WASM_ENABLE_AOT != 0
+    if (aot_file && !wasm_module_set_aot_file(module, aot_file))
         goto fail;
+#endif
 
-    if (!wasm_instantiate(module, value_stack_size, exectution_stack_size))
+    if (stream_mode)
+    {
+        if (!load_module_stream(module, wasm_file, &stream_loader))
+            goto fail;
+    }
+    else
+    {
+        if (file_map ? !wasm_loader_read_only(module, file_map, ret_size)
+                     : !wasm_loader(module, file_buf, ret_size))
+            goto fail;
+
+        if (!wasm_validator(module))
+            goto fail;
+    }
+
+    wasm_set_memory_huge_page_mode(module, huge_page_mode);
+
+    // 多个实例共享同一份编译结果, 只各自分配线性内存, 全局变量和表
+    if ((instance_count > 1 || pool_mode) && !wasm_module_compile(module))
         goto fail;
 
-#if WASM_ENABLE_WASI != 0
-    if (!wasm_runtime_wasi_init(
-            module,
-            dir_list, dir_list_size,
-            NULL, 0,
-            env_list, env_list_size,
-            addr_pool, addr_pool_size,
-            ns_lookup_pool, ns_lookup_pool_size, argv,
-            argc, -1, -1, -1))
+    // 依次执行的实例只需池中的一个实例, 每次执行后重置
+    if (pool_mode && !(pool = wasm_instance_pool_create(module, 1, value_stack_size,
+                                                        exectution_stack_size)))
     {
+        wasm_set_exception(module, "create instance pool failed");
         goto fail;
     }
-#endif
 
-    if (!execute_main(module, argc, argv))
+    for (i = 0; i < instance_count; i++)
     {
-        goto fail;
+        if (pool)
+        {
+            // 上次放回时重新创建实例失败, 池已为空
+            if (!(instance = wasm_instance_pool_acquire(pool)))
+            {
+                wasm_set_exception(module, "acquire pooled instance failed");
+                goto fail;
+            }
+        }
+        else if (instance_count == 1)
+        {
+            if (!wasm_instantiate(module, value_stack_size, exectution_stack_size))
+                goto fail;
+        }
+        else if (!(instance = wasm_instance_create(module, value_stack_size,
+                                                   exectution_stack_size)))
+        {
+            wasm_set_exception(module, "create instance failed");
+            goto fail;
+        }
+
+#if WASM_ENABLE_WASI != 0
+        if (!wasm_runtime_wasi_init(
+                instance,
+                dir_list, dir_list_size,
+                NULL, 0,
+                env_list, env_list_size,
+                addr_pool, addr_pool_size,
+                ns_lookup_pool, ns_lookup_pool_size, argv,
+                argc, -1, -1, -1))
+        {
+            goto instance_fail;
+        }
+#endif
+
+        // 快照中已是初始化后的状态, 不再执行_initialize和start函数
+        if (snapshot_file)
+        {
+            if (!wasm_instance_snapshot_restore(instance, snapshot_file))
+                goto instance_fail;
+        }
+        else if (!execute_post_instantiate_functions(instance))
+        {
+            goto instance_fail;
+        }
+
+        if (snapshot_save_file)
+        {
+            if (!wasm_instance_snapshot_save(instance, snapshot_save_file))
+                goto instance_fail;
+        }
+        else if (!execute_main(instance, argc, argv))
+        {
+            goto instance_fail;
+        }
+
+        if (huge_page_mode != WASM_HUGE_PAGE_NONE)
+        {
+            fprintf(stderr, "linear memory: %" PRIu64 " bytes, %" PRIu64
+                            " bytes backed by huge pages\n",
+                    (uint64)instance->memories->memory_data_size,
+                    wasm_get_memory_huge_page_size(instance));
+        }
+
+        if (pool)
+        {
+            wasm_instance_pool_release(pool, instance);
+            instance = module;
+        }
+        else if (instance != module)
+        {
+            wasm_instance_destroy(instance);
+            instance = module;
+        }
     }
 
+    wasm_instance_pool_destroy(pool);
     wasm_module_destory(module);
-    wasm_runtime_free(file_buf);
+    if (stream_loader)
+        wasm_stream_loader_destroy(stream_loader);
+    if (file_buf)
+        wasm_runtime_free(file_buf);
+    if (file_map)
+        platform_unmap_file(file_map, ret_size);
     return 0;
 
+instance_fail:
+    if (instance != module)
+    {
+        os_printf("%s", wasm_get_exception(instance));
+        if (pool)
+            wasm_instance_pool_release(pool, instance);
+        else
+            wasm_instance_destroy(instance);
+        goto destroy_module;
+    }
 fail:
     os_printf("%s", wasm_get_exception(module));
+destroy_module:
+    wasm_instance_pool_destroy(pool);
     wasm_module_destory(module);
+    if (stream_loader)
+        wasm_stream_loader_destroy(stream_loader);
 create_module_fail:
-    wasm_runtime_free(file_buf);
+    if (file_buf)
+        wasm_runtime_free(file_buf);
+    if (file_map)
+        platform_unmap_file(file_map, ret_size);
 read_file_fail:
     return -1;
 }
\ No newline at end of file
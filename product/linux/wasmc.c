@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "wasm_runtime_api.h"
+#include "wasm_exception.h"
+#include "wasm_memory.h"
+#include "wasm_jit.h"
+
+static int
+print_help()
+{
+    printf("Usage: wasmc [-options] wasm_file\n");
+    printf("Compile wasm_file to native code that the runtime built with AOT\n"
+           "support loads with --aot=<file>, without LLVM and without compiling.\n");
+    printf("options:\n");
+    printf("  -v=n                     Set log verbose level (0 to 5, default is 2) larger\n"
+           "                           level with more log\n");
+    printf("  -o <file>                Write the native code to file, default is\n"
+           "                           wasm_file with the extension .aot\n");
+    printf("The code uses the instruction set of this machine, and only runs with a\n"
+           "runtime of the same version and build options.\n");
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    wasm_runtime_init_env();
+    int log_verbose_level = 2;
+    char *wasm_file, *out_file = NULL, *ext;
+    char out_buf[256];
+    uint8 *file_buf;
+    uint32 file_size;
+    WASMModule *module;
+    int ret = -1;
+
+    for (argc--, argv++; argc > 0 && argv[0][0] == '-'; argc--, argv++)
+    {
+        if (!strncmp(argv[0], "-v=", 3))
+        {
+            log_verbose_level = atoi(argv[0] + 3);
+            if (log_verbose_level < 0 || log_verbose_level > 5)
+                return print_help();
+        }
+        else if (!strcmp(argv[0], "-o"))
+        {
+            if (argc < 2)
+                return print_help();
+            out_file = argv[1];
+            argc--, argv++;
+        }
+        else
+            return print_help();
+    }
+
+    if (argc != 1)
+        return print_help();
+
+    wasm_file = argv[0];
+    if (!out_file)
+    {
+        snprintf(out_buf, sizeof(out_buf), "%s", wasm_file);
+        if ((ext = strrchr(out_buf, '.')) && !strchr(ext, '/'))
+            *ext = '\0';
+        if (strlen(out_buf) + 5 > sizeof(out_buf))
+        {
+            printf("Output file name is too long\n");
+            return 1;
+        }
+        strcat(out_buf, ".aot");
+        out_file = out_buf;
+    }
+
+    log_set_verbose_level(log_verbose_level);
+    if (!(file_buf = platform_read_file(wasm_file, &file_size)))
+        return -1;
+
+    if (!(module = wasm_module_create()))
+        goto fail;
+
+    if (!wasm_loader(module, file_buf, file_size) || !wasm_validator(module))
+    {
+        os_printf("%s\n", wasm_get_exception(module));
+        goto destroy_module;
+    }
+
+    if (!wasm_module_compile_to_file(module, out_file))
+    {
+        os_printf("Compile %s failed: %s\n", wasm_file, wasm_jit_get_last_error());
+        goto destroy_module;
+    }
+
+    ret = 0;
+destroy_module:
+    wasm_module_destory(module);
+fail:
+    wasm_runtime_free(file_buf);
+    return ret;
+}
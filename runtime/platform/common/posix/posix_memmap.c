@@ -1,17 +1,18 @@
 #include "platform_api.h"
 
-#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
-
 void *
 os_mmap(void *hint, size_t size, int prot, int flags)
 {
     int map_prot = PROT_NONE;
     int map_flags = MAP_ANONYMOUS | MAP_PRIVATE;
-    uint64 request_size, page_size;
-    uint8 *addr = MAP_FAILED;
+    uint64 request_size, map_size, page_size;
+    uint8 *addr = MAP_FAILED, *aligned_addr;
     uint32 i;
 
     page_size = (uint64)getpagesize();
+    // 显式大页映射的长度必须是大页的整数倍
+    if (flags & MMAP_MAP_HUGETLB)
+        page_size = HUGE_PAGE_SIZE;
     request_size = (size + page_size - 1) & ~(page_size - 1);
 
     if ((size_t)request_size < size)
@@ -20,6 +21,11 @@ os_mmap(void *hint, size_t size, int prot, int flags)
     if (request_size > 16 * (uint64)UINT32_MAX)
         return NULL;
 
+    // 多映射一个大页, 之后截掉首尾使起始地址按大页对齐
+    map_size = request_size;
+    if ((flags & MMAP_MAP_HUGEPAGE) && !(flags & MMAP_MAP_FIXED))
+        map_size += HUGE_PAGE_SIZE;
+
     if (prot & MMAP_PROT_READ)
         map_prot |= PROT_READ;
 
@@ -35,11 +41,20 @@ os_mmap(void *hint, size_t size, int prot, int flags)
     if (flags & MMAP_MAP_FIXED)
         map_flags |= MAP_FIXED;
 
+#ifdef MAP_HUGETLB
+    // 不预留大页, 由os_mpopulate在提交时分配, 避免访问时因大页不足收到SIGBUS
+    if (flags & MMAP_MAP_HUGETLB)
+        map_flags |= MAP_HUGETLB | MAP_NORESERVE;
+#else
+    if (flags & MMAP_MAP_HUGETLB)
+        return NULL;
+#endif
+
     if (addr == MAP_FAILED)
     {
         for (i = 0; i < 5; i++)
         {
-            addr = mmap(hint, request_size, map_prot, map_flags, -1, 0);
+            addr = mmap(hint, map_size, map_prot, map_flags, -1, 0);
             if (addr != MAP_FAILED)
                 break;
         }
@@ -50,6 +65,24 @@ os_mmap(void *hint, size_t size, int prot, int flags)
         return NULL;
     }
 
+    if (map_size > request_size)
+    {
+        aligned_addr = (uint8 *)(((uintptr_t)addr + HUGE_PAGE_SIZE - 1)
+                                 & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+        if (aligned_addr > addr)
+            munmap(addr, aligned_addr - addr);
+        if (aligned_addr + request_size < addr + map_size)
+            munmap(aligned_addr + request_size,
+                   addr + map_size - (aligned_addr + request_size));
+        addr = aligned_addr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // 内核不支持透明大页时madvise失败, 继续使用普通页面
+    if (flags & MMAP_MAP_HUGEPAGE)
+        madvise(addr, request_size, MADV_HUGEPAGE);
+#endif
+
     return addr;
 }
 
@@ -93,3 +126,61 @@ int os_mprotect(void *addr, size_t size, int prot)
 void os_dcache_flush(void)
 {
 }
+
+int os_mpopulate(void *addr, size_t size)
+{
+    if (!addr || !size)
+        return 0;
+
+#ifdef MADV_POPULATE_WRITE
+    return madvise(addr, size, MADV_POPULATE_WRITE);
+#else
+    return -1;
+#endif
+}
+
+int os_mdiscard(void *addr, size_t size)
+{
+    if (!addr || !size)
+        return 0;
+
+    return madvise(addr, size, MADV_DONTNEED);
+}
+
+uint64
+os_huge_page_backed_size(void *addr, size_t size)
+{
+    uint64 total = 0, vma_total = 0, value;
+    uintptr_t start = (uintptr_t)addr, end = start + size;
+    uintptr_t vma_start, vma_end, overlap = 0;
+    char line[256];
+    FILE *fp;
+
+    if (!addr || !size || !(fp = fopen("/proc/self/smaps", "r")))
+        return 0;
+
+    // 按映射区统计透明大页和显式大页, 部分重叠的映射区最多计入重叠部分
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR, &vma_start, &vma_end) == 2)
+        {
+            total += vma_total < overlap ? vma_total : overlap;
+            vma_total = 0;
+            overlap = 0;
+            if (vma_start < end && vma_end > start)
+                overlap = (vma_end < end ? vma_end : end)
+                          - (vma_start > start ? vma_start : start);
+        }
+        else if (overlap
+                 && (sscanf(line, "AnonHugePages: %" SCNu64, &value) == 1
+                     || sscanf(line, "Private_Hugetlb: %" SCNu64, &value) == 1
+                     || sscanf(line, "Shared_Hugetlb: %" SCNu64, &value) == 1))
+        {
+            vma_total += value * 1024;
+        }
+    }
+    total += vma_total < overlap ? vma_total : overlap;
+
+    fclose(fp);
+    return total;
+}
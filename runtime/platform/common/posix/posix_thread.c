@@ -266,7 +266,7 @@ void os_thread_exit(void *retval)
     return pthread_exit(retval);
 }
 
-#if defined(os_thread_local_attribute)
+#if defined(os_thread_local_attribute) && WASM_DISABLE_STACK_HW_BOUND_CHECK == 0
 static os_thread_local_attribute uint8 *thread_stack_boundary = NULL;
 #endif
 
@@ -4,6 +4,11 @@
 #define EXCEPTION_BUF_LEN 128
 #define APP_THREAD_STACK_SIZE_DEFAULT (16 * 1024)
 
+#ifndef WASM_JIT_THREAD_STACK_SIZE
+/* 后台线程中创建LLVM上下文, 生成IR和编译都需要较大的栈 */
+#define WASM_JIT_THREAD_STACK_SIZE (8 * 1024 * 1024)
+#endif
+
 #ifndef WASM_ORC_JIT_COMPILE_THREAD_NUM
 /* The number of compilation threads created by LLVM JIT */
 #define WASM_ORC_JIT_COMPILE_THREAD_NUM 4
@@ -26,6 +31,15 @@
 #define WASM_VALIDATE_THREAD_NUM 4
 #endif
 
+#ifndef WASM_ENABLE_HW_BOUND_CHECK
+#define WASM_ENABLE_HW_BOUND_CHECK 1
+#endif
+
+#ifndef WASM_DISABLE_STACK_HW_BOUND_CHECK
+/* Native stack overflow is not detected with guard pages */
+#define WASM_DISABLE_STACK_HW_BOUND_CHECK 1
+#endif
+
 #define DEFAULT_VALUE_STACK_SIZE (16 * 1024)
 
 #ifndef WASM_ENABLE_LIBC_WASI
@@ -36,4 +50,18 @@
 #define WASM_ENABLE_JIT 1
 #endif
 
+#ifndef WASM_ENABLE_AOT
+/* 加载wasmc预编译的本地代码 */
+#define WASM_ENABLE_AOT 0
+#endif
+
+#ifndef WASM_ENABLE_TIERED_JIT
+#define WASM_ENABLE_TIERED_JIT 0
+#endif
+
+#ifndef WASM_TIER_UP_THRESHOLD
+/* 函数调用次数与循环回边次数之和达到该值时提交后台编译 */
+#define WASM_TIER_UP_THRESHOLD 1000
+#endif
+
 #endif
\ No newline at end of file
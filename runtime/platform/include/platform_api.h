@@ -10,6 +10,9 @@ enum {
     MMAP_PROT_EXEC = 4
 };
 
+/* Huge page size used by MMAP_MAP_HUGEPAGE and MMAP_MAP_HUGETLB */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 /* Memory map flags */
 enum {
     MMAP_MAP_NONE = 0,
@@ -17,7 +20,13 @@ enum {
     MMAP_MAP_32BIT = 1,
     /* Don't interpret addr as a hint: place the mapping at exactly
        that address. */
-    MMAP_MAP_FIXED = 2
+    MMAP_MAP_FIXED = 2,
+    /* Back the mapping with transparent huge pages (madvise), the start
+       address is aligned to the huge page size */
+    MMAP_MAP_HUGEPAGE = 4,
+    /* Back the mapping with explicit huge pages (MAP_HUGETLB), pages are
+       not reserved until committed with os_mpopulate */
+    MMAP_MAP_HUGETLB = 8
 };
 
 int
@@ -29,6 +38,21 @@ platform_destroy(void);
 unsigned char *
 platform_read_file(const char *filename, unsigned int *ret_size);
 
+//以只读方式映射整个文件, 多个进程映射同一文件时共享页缓存, 用platform_unmap_file释放
+const unsigned char *
+platform_map_file(const char *filename, unsigned int *ret_size);
+
+void
+platform_unmap_file(const unsigned char *buf, unsigned int size);
+
+//将文件中[offset, offset + size)以写时复制方式映射到addr, 替换其原有映射, 成功返回0
+int
+platform_map_file_fixed(void *addr, const char *filename, uint64 offset, uint64 size);
+
+//在进程已加载的库(含C库和数学库)中查找符号的地址, 找不到时返回NULL
+void *
+platform_lookup_symbol(const char *name);
+
 void *
 os_malloc(unsigned size);
 
@@ -38,6 +62,27 @@ os_realloc(void *ptr, unsigned size);
 void
 os_free(void *ptr);
 
+void *
+os_mmap(void *hint, size_t size, int prot, int flags);
+
+void
+os_munmap(void *addr, size_t size);
+
+int
+os_mprotect(void *addr, size_t size, int prot);
+
+//预先分配并写入映射中的页面, 物理页不足时返回非0
+int
+os_mpopulate(void *addr, size_t size);
+
+//丢弃映射中的页面, 私有匿名映射再次访问时得到零页, 失败时返回非0
+int
+os_mdiscard(void *addr, size_t size);
+
+//返回[addr, addr + size)中实际由大页承载的字节数
+uint64
+os_huge_page_backed_size(void *addr, size_t size);
+
 int
 os_printf(const char *format, ...);
 
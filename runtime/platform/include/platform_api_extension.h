@@ -106,6 +106,7 @@ void os_thread_exit(void *retval);
 
 #if defined(BH_HAS_STD_ATOMIC) && !defined(__cplusplus)
 #include <stdatomic.h>
+#define os_memory_order_acquire memory_order_acquire
 #define os_memory_order_release memory_order_release
 #define os_atomic_thread_fence atomic_thread_fence
 #endif
@@ -138,6 +139,42 @@ bool os_thread_env_inited(void);
  */
 int os_usleep(uint32 usec);
 
+/**
+ * This function creates a mutex
+ *
+ * @param mutex [OUTPUT] pointer to mutex initialized.
+ *
+ * @return 0 if success
+ */
+int os_mutex_init(korp_mutex *mutex);
+
+/**
+ * This function destroys a mutex
+ *
+ * @param mutex pointer to mutex need destroy
+ *
+ * @return 0 if success
+ */
+int os_mutex_destroy(korp_mutex *mutex);
+
+/**
+ * Lock the mutex
+ *
+ * @param mutex pointer to mutex need lock
+ *
+ * @return 0 if success
+ */
+int os_mutex_lock(korp_mutex *mutex);
+
+/**
+ * Unlock the mutex
+ *
+ * @param mutex pointer to mutex need unlock
+ *
+ * @return 0 if success
+ */
+int os_mutex_unlock(korp_mutex *mutex);
+
 /**
  * This function creates a condition variable
  *
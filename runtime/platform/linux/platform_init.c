@@ -76,4 +76,76 @@ platform_read_file(const char *filename, unsigned int *ret_size)
 
     *ret_size = file_size;
     return buffer;
-}
\ No newline at end of file
+}
+
+const unsigned char *
+platform_map_file(const char *filename, unsigned int *ret_size)
+{
+    void *buffer;
+    int file;
+    struct stat stat_buf;
+
+    if (!filename || !ret_size)
+    {
+        printf("Map file failed: invalid filename or ret size.\n");
+        return NULL;
+    }
+
+    if ((file = open(filename, O_RDONLY, 0)) == -1)
+    {
+        printf("Map file failed: open file %s failed.\n", filename);
+        return NULL;
+    }
+
+    // 空文件和超过4 GiB的文件无法映射
+    if (fstat(file, &stat_buf) != 0 || stat_buf.st_size <= 0
+        || (uint64)stat_buf.st_size > UINT32_MAX)
+    {
+        close(file);
+        return NULL;
+    }
+
+    buffer = mmap(NULL, (size_t)stat_buf.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (buffer == MAP_FAILED)
+        return NULL;
+
+    *ret_size = (uint32)stat_buf.st_size;
+    return buffer;
+}
+
+void
+platform_unmap_file(const unsigned char *buf, unsigned int size)
+{
+    munmap((void *)buf, size);
+}
+
+int
+platform_map_file_fixed(void *addr, const char *filename, uint64 offset, uint64 size)
+{
+    void *buffer;
+    int file;
+
+    if ((file = open(filename, O_RDONLY, 0)) == -1)
+        return -1;
+
+    // 私有映射的写入不会写回文件, 未写入的页面由各进程共享页缓存
+    buffer = mmap(addr, (size_t)size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_FIXED, file, (off_t)offset);
+    close(file);
+
+    return buffer == MAP_FAILED ? -1 : 0;
+}
+
+void *
+platform_lookup_symbol(const char *name)
+{
+    static void *self_handle = NULL;
+
+    // 主程序的句柄按全局查找顺序搜索所有已加载的库
+    if (!self_handle && !(self_handle = dlopen(NULL, RTLD_LAZY)))
+        return NULL;
+
+    return dlsym(self_handle, name);
+}
@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <dlfcn.h>
 #include <sys/time.h>
 #include <sys/timeb.h>
 #include <sys/uio.h>
@@ -46,4 +47,33 @@ typedef sem_t korp_sem;
 
 #define BH_THREAD_DEFAULT_PRIORITY 0
 
+#define os_thread_local_attribute __thread
+
+#if WASM_ENABLE_HW_BOUND_CHECK != 0
+#if defined(__x86_64__) || defined(__aarch64__)
+
+#include <setjmp.h>
+
+#define OS_ENABLE_HW_BOUND_CHECK
+
+typedef jmp_buf korp_jmpbuf;
+
+#define os_setjmp setjmp
+#define os_longjmp longjmp
+#define os_getpagesize getpagesize
+
+typedef void (*os_signal_handler)(void *sig_addr);
+
+int os_thread_signal_init(os_signal_handler handler);
+
+void os_thread_signal_destroy();
+
+bool os_thread_signal_inited();
+
+void os_signal_unmask();
+
+void os_sigreturn();
+#endif /* end of defined(__x86_64__) || defined(__aarch64__) */
+#endif /* end of WASM_ENABLE_HW_BOUND_CHECK != 0 */
+
 #endif 
@@ -56,6 +56,13 @@ bh_strdup(const char *s);
 char *
 wa_strdup(const char *s);
 
+/* Initial value of bh_hash_bytes */
+#define BH_HASH_INIT 0xcbf29ce484222325ULL
+
+/* FNV-1a hash of buf continued from hash, not suitable for security use */
+uint64
+bh_hash_bytes(uint64 hash, const void *buf, uint32 size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -161,3 +161,15 @@ wa_strdup(const char *s)
     }
     return s1;
 }
+
+uint64
+bh_hash_bytes(uint64 hash, const void *buf, uint32 size)
+{
+    const uint8 *p = (const uint8 *)buf, *p_end = p + size;
+
+    while (p < p_end) {
+        hash ^= *p++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,44 @@
+#ifndef _WASM_AOT_LOADER_H
+#define _WASM_AOT_LOADER_H
+
+#include "wasm_type.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 预编译文件为文件头, 模块各类型的编号和可重定位的ELF目标文件,
+// 目标文件从8字节对齐处开始
+#define WASM_AOT_MAGIC 0x544f4157
+#define WASM_AOT_VERSION 3
+#define WASM_AOT_OBJECT_OFFSET(type_count) \
+    ((sizeof(WASMAOTFileHeader) + sizeof(uint32) * (uint64)(type_count) + 7) & ~(uint64)7)
+
+    typedef struct WASMAOTFileHeader
+    {
+        uint32 magic;
+        uint32 version;
+        uint64 module_hash;
+        uint64 layout_hash;
+        // 目标文件的ELF机器类型
+        uint32 machine;
+        uint32 function_count;
+        uint32 type_count;
+        uint32 object_size;
+    } WASMAOTFileHeader;
+
+#if WASM_ENABLE_AOT != 0
+    // 映射预编译文件, 链接运行时函数后填写func_ptrs,
+    // 文件不对应该模块或该运行时时返回false, 模块保持未编译的状态
+    bool wasm_aot_load(WASMModule *module, const char *file_name);
+
+    // 释放加载的本地代码
+    void wasm_aot_destroy(WASMModule *module);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
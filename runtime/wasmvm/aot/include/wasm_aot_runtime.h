@@ -0,0 +1,56 @@
+#ifndef _WASM_AOT_RUNTIME_H
+#define _WASM_AOT_RUNTIME_H
+
+#include "wasm_type.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef WASM_JIT_FUNC_PREFIX
+#define WASM_JIT_FUNC_PREFIX "wasm_jit_func#"
+#endif
+
+// 导入函数按wasm函数签名进入的入口, 填在func_ptrs中导入函数的位置
+#define WASM_JIT_IMPORT_PREFIX "wasm_jit_import#"
+
+// 每个函数类型一个的入口, 宿主从argv取参数调用编译好的函数, 填在func_entries中
+#define WASM_JIT_ENTRY_PREFIX "wasm_jit_entry#"
+
+    typedef struct WASMRuntimeSymbol
+    {
+        const char *name;
+        void *addr;
+    } WASMRuntimeSymbol;
+
+    // 本地代码按名字调用的运行时函数, JIT在JITDylib中定义这些符号,
+    // AOT加载器用它们解析目标文件中的未定义符号
+    const WASMRuntimeSymbol *
+    wasm_runtime_helper_symbols(uint32 *p_count);
+
+    // 本地代码直接访问的运行时结构布局的哈希, 布局不同的运行时不能共用编译结果
+    uint64
+    wasm_native_code_layout_hash(void);
+
+    void wasm_set_exception_with_id(WASMModule *module_inst, uint32 id);
+
+    // 以下函数由生成的代码按名字调用
+    void jit_set_exception_with_id(WASMModule *module_inst, uint32 id);
+
+    bool llvm_jit_memory_init(WASMModule *module, uint32 seg_index,
+                              uint32 offset, uint32 len, uint32 dst);
+
+    bool llvm_jit_data_drop(WASMModule *module, uint32 seg_index);
+
+    void *
+    wasm_jit_memmove(void *dest, const void *src, size_t n);
+
+    void *
+    jit_memset(void *s, int c, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,645 @@
+#include "wasm_aot_loader.h"
+#include "wasm_aot_runtime.h"
+#include "wasm_memory.h"
+#include "runtime_log.h"
+#include "runtime_utils.h"
+
+#if WASM_ENABLE_AOT != 0
+#include <elf.h>
+
+#if defined(__x86_64__)
+#define AOT_HOST_MACHINE EM_X86_64
+#else
+#define AOT_HOST_MACHINE EM_NONE
+#endif
+
+// 代码, 只读数据和可写数据分段映射, 段按64 KiB对齐, 可覆盖各平台的页大小
+#define AOT_SEGMENT_ALIGN 0x10000
+// 每个符号一个跳转桩: jmp *0(%rip), 之后8字节为目标地址, 远处的运行时函数经此调用
+#define AOT_STUB_SIZE 16
+
+enum
+{
+    AOT_SEG_TEXT = 0,
+    AOT_SEG_RODATA,
+    AOT_SEG_DATA,
+    AOT_SEG_NUM
+};
+
+typedef struct AOTLinker
+{
+    const uint8 *object;
+    uint32 object_size;
+    const Elf64_Shdr *shdrs;
+    uint32 shnum;
+    const Elf64_Sym *syms;
+    uint32 sym_count;
+    uint32 symtab_idx;
+    const char *strtab;
+    uint64 strtab_size;
+    // 各节在映射中的偏移, 不加载的节为UINT64_MAX
+    uint64 *sec_offsets;
+    uint64 *sym_addrs;
+    uint64 seg_offsets[AOT_SEG_NUM];
+    uint64 seg_sizes[AOT_SEG_NUM];
+    uint64 stub_offset;
+    uint64 got_offset;
+    uint8 *image;
+    uint64 image_size;
+} AOTLinker;
+
+static uint64
+align_up(uint64 v, uint64 align)
+{
+    if (align <= 1)
+        return v;
+    return (v + align - 1) / align * align;
+}
+
+static bool
+aot_check_object(AOTLinker *linker)
+{
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)linker->object;
+    const Elf64_Shdr *shdr;
+    uint32 i;
+
+    if (linker->object_size < sizeof(Elf64_Ehdr)
+        || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0
+        || ehdr->e_ident[EI_CLASS] != ELFCLASS64
+        || ehdr->e_ident[EI_DATA] != ELFDATA2LSB
+        || ehdr->e_type != ET_REL)
+    {
+        LOG_ERROR("Load aot file fail: not a relocatable ELF64 object.\n");
+        return false;
+    }
+
+    if (ehdr->e_machine != AOT_HOST_MACHINE)
+    {
+        LOG_ERROR("Load aot file fail: machine %u is not supported.\n", ehdr->e_machine);
+        return false;
+    }
+
+    if (ehdr->e_shentsize != sizeof(Elf64_Shdr) || ehdr->e_shoff > linker->object_size
+        || (uint64)ehdr->e_shnum * sizeof(Elf64_Shdr) > linker->object_size - ehdr->e_shoff)
+    {
+        LOG_ERROR("Load aot file fail: invalid section header table.\n");
+        return false;
+    }
+
+    linker->shdrs = (const Elf64_Shdr *)(linker->object + ehdr->e_shoff);
+    linker->shnum = ehdr->e_shnum;
+
+    for (i = 0; i < linker->shnum; i++)
+    {
+        shdr = linker->shdrs + i;
+        if (shdr->sh_type != SHT_NOBITS
+            && (shdr->sh_offset > linker->object_size
+                || shdr->sh_size > linker->object_size - shdr->sh_offset))
+        {
+            LOG_ERROR("Load aot file fail: section %u is out of range.\n", i);
+            return false;
+        }
+
+        if (shdr->sh_type == SHT_SYMTAB)
+        {
+            if (linker->syms || shdr->sh_entsize != sizeof(Elf64_Sym)
+                || shdr->sh_link >= linker->shnum
+                || linker->shdrs[shdr->sh_link].sh_type != SHT_STRTAB)
+            {
+                LOG_ERROR("Load aot file fail: invalid symbol table.\n");
+                return false;
+            }
+            linker->syms = (const Elf64_Sym *)(linker->object + shdr->sh_offset);
+            linker->sym_count = (uint32)(shdr->sh_size / sizeof(Elf64_Sym));
+            linker->symtab_idx = i;
+            linker->strtab = (const char *)linker->object
+                             + linker->shdrs[shdr->sh_link].sh_offset;
+            linker->strtab_size = linker->shdrs[shdr->sh_link].sh_size;
+        }
+    }
+
+    if (!linker->syms || linker->strtab_size == 0
+        || linker->strtab[linker->strtab_size - 1] != '\0')
+    {
+        LOG_ERROR("Load aot file fail: missing symbol table.\n");
+        return false;
+    }
+    return true;
+}
+
+// 按代码, 只读数据, 可写数据分段排布需要加载的节, 跳转桩放在代码段末尾,
+// 全局偏移表放在只读数据段末尾
+static bool
+aot_layout_sections(AOTLinker *linker)
+{
+    const Elf64_Shdr *shdr;
+    uint64 offset = 0;
+    uint32 i, seg;
+
+    if (!(linker->sec_offsets = wasm_runtime_malloc(sizeof(uint64) * (uint64)linker->shnum)))
+        return false;
+
+    for (seg = 0; seg < AOT_SEG_NUM; seg++)
+    {
+        linker->seg_offsets[seg] = offset;
+
+        for (i = 0; i < linker->shnum; i++)
+        {
+            shdr = linker->shdrs + i;
+            if (seg == 0)
+                linker->sec_offsets[i] = UINT64_MAX;
+            if (!(shdr->sh_flags & SHF_ALLOC))
+                continue;
+            if ((shdr->sh_flags & SHF_EXECINSTR) ? seg != AOT_SEG_TEXT
+                : (shdr->sh_flags & SHF_WRITE)   ? seg != AOT_SEG_DATA
+                                                 : seg != AOT_SEG_RODATA)
+                continue;
+
+            offset = align_up(offset, shdr->sh_addralign);
+            linker->sec_offsets[i] = offset;
+            offset += shdr->sh_size;
+        }
+
+        if (seg == AOT_SEG_TEXT)
+        {
+            offset = align_up(offset, AOT_STUB_SIZE);
+            linker->stub_offset = offset;
+            offset += (uint64)AOT_STUB_SIZE * linker->sym_count;
+        }
+        else if (seg == AOT_SEG_RODATA)
+        {
+            offset = align_up(offset, sizeof(uint64));
+            linker->got_offset = offset;
+            offset += sizeof(uint64) * (uint64)linker->sym_count;
+        }
+
+        offset = align_up(offset, AOT_SEGMENT_ALIGN);
+        linker->seg_sizes[seg] = offset - linker->seg_offsets[seg];
+    }
+
+    if (offset > UINT32_MAX)
+    {
+        LOG_ERROR("Load aot file fail: code is too large.\n");
+        return false;
+    }
+    linker->image_size = offset;
+
+    if (!(linker->image = os_mmap(NULL, (size_t)linker->image_size,
+                                  MMAP_PROT_READ | MMAP_PROT_WRITE, MMAP_MAP_NONE)))
+    {
+        LOG_ERROR("Load aot file fail: map code memory failed.\n");
+        return false;
+    }
+
+    // 匿名映射已清零, NOBITS节无需处理
+    for (i = 0; i < linker->shnum; i++)
+    {
+        shdr = linker->shdrs + i;
+        if (linker->sec_offsets[i] != UINT64_MAX && shdr->sh_type != SHT_NOBITS)
+            memcpy(linker->image + linker->sec_offsets[i],
+                   linker->object + shdr->sh_offset, shdr->sh_size);
+    }
+    return true;
+}
+
+static void *
+aot_lookup_runtime_symbol(const char *name)
+{
+    const WASMRuntimeSymbol *symbols;
+    uint32 i, count;
+
+    symbols = wasm_runtime_helper_symbols(&count);
+    for (i = 0; i < count; i++)
+    {
+        if (!strcmp(symbols[i].name, name))
+            return symbols[i].addr;
+    }
+
+    // 生成的代码可能调用C库和数学库的函数, 例如memcpy和fmod
+    return platform_lookup_symbol(name);
+}
+
+static bool
+aot_resolve_symbols(AOTLinker *linker)
+{
+    const Elf64_Sym *sym;
+    const char *name;
+    uint64 addr, *got = (uint64 *)(linker->image + linker->got_offset);
+    uint8 *stub;
+    uint32 i;
+
+    if (!(linker->sym_addrs = wasm_runtime_malloc(sizeof(uint64) * (uint64)linker->sym_count)))
+        return false;
+
+    for (i = 0; i < linker->sym_count; i++)
+    {
+        sym = linker->syms + i;
+        if (sym->st_name >= linker->strtab_size)
+        {
+            LOG_ERROR("Load aot file fail: invalid symbol name.\n");
+            return false;
+        }
+        name = linker->strtab + sym->st_name;
+
+        if (sym->st_shndx == SHN_UNDEF)
+        {
+            addr = name[0] ? (uint64)(uintptr_t)aot_lookup_runtime_symbol(name) : 0;
+            if (!addr && name[0] && ELF64_ST_BIND(sym->st_info) != STB_WEAK)
+            {
+                LOG_ERROR("Load aot file fail: undefined symbol %s.\n", name);
+                return false;
+            }
+        }
+        else if (sym->st_shndx == SHN_ABS)
+        {
+            addr = sym->st_value;
+        }
+        else if (sym->st_shndx >= linker->shnum || sym->st_shndx >= SHN_LORESERVE)
+        {
+            LOG_ERROR("Load aot file fail: unsupported symbol %s.\n", name);
+            return false;
+        }
+        else if (linker->sec_offsets[sym->st_shndx] != UINT64_MAX)
+        {
+            addr = (uint64)(uintptr_t)(linker->image + linker->sec_offsets[sym->st_shndx])
+                   + sym->st_value;
+        }
+        else
+        {
+            // 调试信息等不加载的节中的符号
+            addr = 0;
+        }
+
+        linker->sym_addrs[i] = addr;
+        got[i] = addr;
+
+        stub = linker->image + linker->stub_offset + (uint64)AOT_STUB_SIZE * i;
+        stub[0] = 0xff;
+        stub[1] = 0x25;
+        memset(stub + 2, 0, 4);
+        memcpy(stub + 6, &addr, sizeof(uint64));
+    }
+    return true;
+}
+
+static bool
+aot_write_pc32(uint8 *p, uint64 value, uint64 p_addr)
+{
+    int64 rel = (int64)(value - p_addr);
+    int32 rel32 = (int32)rel;
+
+    if (rel != (int64)rel32)
+        return false;
+    memcpy(p, &rel32, sizeof(int32));
+    return true;
+}
+
+static bool
+aot_apply_relocation(AOTLinker *linker, uint8 *target, uint64 target_size,
+                     const Elf64_Rela *rela)
+{
+    uint32 sym_idx = (uint32)ELF64_R_SYM(rela->r_info);
+    uint32 type = (uint32)ELF64_R_TYPE(rela->r_info);
+    uint8 *p = target + rela->r_offset;
+    uint64 p_addr = (uint64)(uintptr_t)p, s, value;
+    uint32 width = 4;
+    uint32 value32;
+    int32 value32s;
+
+    if (sym_idx >= linker->sym_count)
+        return false;
+    s = linker->sym_addrs[sym_idx];
+
+    if (type == R_X86_64_64 || type == R_X86_64_PC64)
+        width = 8;
+    if (rela->r_offset > target_size || width > target_size - rela->r_offset)
+        return false;
+
+    switch (type)
+    {
+    case R_X86_64_NONE:
+        return true;
+    case R_X86_64_64:
+        value = s + (uint64)rela->r_addend;
+        memcpy(p, &value, sizeof(uint64));
+        return true;
+    case R_X86_64_PC64:
+        value = s + (uint64)rela->r_addend - p_addr;
+        memcpy(p, &value, sizeof(uint64));
+        return true;
+    case R_X86_64_PC32:
+    case R_X86_64_PLT32:
+        // 外部函数距离可能超过2 GiB, 改为调用跳转桩
+        if (linker->syms[sym_idx].st_shndx == SHN_UNDEF)
+            s = (uint64)(uintptr_t)(linker->image + linker->stub_offset)
+                + (uint64)AOT_STUB_SIZE * sym_idx;
+        return aot_write_pc32(p, s + (uint64)rela->r_addend, p_addr);
+    case R_X86_64_GOTPCREL:
+    case R_X86_64_GOTPCRELX:
+    case R_X86_64_REX_GOTPCRELX:
+        s = (uint64)(uintptr_t)(linker->image + linker->got_offset)
+            + sizeof(uint64) * sym_idx;
+        return aot_write_pc32(p, s + (uint64)rela->r_addend, p_addr);
+    case R_X86_64_32:
+        value = s + (uint64)rela->r_addend;
+        value32 = (uint32)value;
+        if (value != (uint64)value32)
+            return false;
+        memcpy(p, &value32, sizeof(uint32));
+        return true;
+    case R_X86_64_32S:
+        value = s + (uint64)rela->r_addend;
+        value32s = (int32)value;
+        if ((int64)value != (int64)value32s)
+            return false;
+        memcpy(p, &value32s, sizeof(int32));
+        return true;
+    default:
+        LOG_ERROR("Load aot file fail: unsupported relocation type %u.\n", type);
+        return false;
+    }
+}
+
+static bool
+aot_relocate(AOTLinker *linker)
+{
+    const Elf64_Shdr *shdr, *target_shdr;
+    const Elf64_Rela *rela;
+    uint8 *target;
+    uint64 j, count;
+    uint32 i;
+
+    for (i = 0; i < linker->shnum; i++)
+    {
+        shdr = linker->shdrs + i;
+        if (shdr->sh_type != SHT_RELA && shdr->sh_type != SHT_REL)
+            continue;
+        if (shdr->sh_info >= linker->shnum
+            || linker->sec_offsets[shdr->sh_info] == UINT64_MAX)
+            continue;
+
+        if (shdr->sh_type != SHT_RELA || shdr->sh_entsize != sizeof(Elf64_Rela)
+            || shdr->sh_link != linker->symtab_idx)
+        {
+            LOG_ERROR("Load aot file fail: invalid relocation section %u.\n", i);
+            return false;
+        }
+
+        target_shdr = linker->shdrs + shdr->sh_info;
+        target = linker->image + linker->sec_offsets[shdr->sh_info];
+        rela = (const Elf64_Rela *)(linker->object + shdr->sh_offset);
+        count = shdr->sh_size / sizeof(Elf64_Rela);
+
+        for (j = 0; j < count; j++, rela++)
+        {
+            if (!aot_apply_relocation(linker, target, target_shdr->sh_size, rela))
+            {
+                LOG_ERROR("Load aot file fail: relocation %" PRIu64
+                          " of section %u failed.\n",
+                          j, shdr->sh_info);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 符号名为prefix加编号时返回编号, 否则返回-1
+static long
+aot_symbol_index(const char *name, const char *prefix)
+{
+    uint32 prefix_len = (uint32)strlen(prefix);
+    char *end;
+    unsigned long idx;
+
+    if (strncmp(name, prefix, prefix_len) != 0)
+        return -1;
+
+    // 跳过延迟编译用的包装函数
+    idx = strtoul(name + prefix_len, &end, 10);
+    if (end == name + prefix_len || *end != '\0' || idx > INT32_MAX)
+        return -1;
+    return (long)idx;
+}
+
+// 按符号名wasm_jit_import#N和wasm_jit_func#N找到各函数的入口,
+// 按wasm_jit_entry#N找到各函数类型的宿主调用入口
+static bool
+aot_bind_functions(AOTLinker *linker, WASMModule *module)
+{
+    uint32 import_function_count = module->import_function_count;
+    uint32 bound = 0, entry_bound = 0, i;
+    const Elf64_Sym *sym;
+    const char *name;
+    long idx;
+
+    for (i = 0; i < linker->sym_count; i++)
+    {
+        sym = linker->syms + i;
+        name = linker->strtab + sym->st_name;
+        if (ELF64_ST_TYPE(sym->st_info) != STT_FUNC || sym->st_shndx == SHN_UNDEF)
+            continue;
+
+        if ((idx = aot_symbol_index(name, WASM_JIT_ENTRY_PREFIX)) >= 0)
+        {
+            if (idx < module->type_count && !module->func_entries[idx])
+            {
+                module->func_entries[idx] = (void *)(uintptr_t)linker->sym_addrs[i];
+                entry_bound++;
+            }
+            continue;
+        }
+        else if ((idx = aot_symbol_index(name, WASM_JIT_IMPORT_PREFIX)) >= 0)
+        {
+            if (idx >= import_function_count)
+                continue;
+        }
+        else if ((idx = aot_symbol_index(name, WASM_JIT_FUNC_PREFIX)) >= 0)
+            idx += import_function_count;
+        else
+            continue;
+
+        if (idx >= module->function_count || module->func_ptrs[idx])
+            continue;
+
+        module->func_ptrs[idx] = (void *)(uintptr_t)linker->sym_addrs[i];
+        bound++;
+    }
+
+    if (bound != module->function_count || entry_bound != module->type_count)
+    {
+        LOG_ERROR("Load aot file fail: %u of %u functions and %u of %u entries found.\n",
+                  bound, module->function_count, entry_bound, module->type_count);
+        return false;
+    }
+    return true;
+}
+
+static bool
+aot_protect_segments(AOTLinker *linker)
+{
+    static const int prots[AOT_SEG_NUM] = {
+        MMAP_PROT_READ | MMAP_PROT_EXEC,
+        MMAP_PROT_READ,
+        MMAP_PROT_READ | MMAP_PROT_WRITE,
+    };
+    uint32 seg;
+
+    for (seg = 0; seg < AOT_SEG_NUM; seg++)
+    {
+        if (linker->seg_sizes[seg] > 0
+            && os_mprotect(linker->image + linker->seg_offsets[seg],
+                           (size_t)linker->seg_sizes[seg], prots[seg]) != 0)
+        {
+            LOG_ERROR("Load aot file fail: protect code memory failed.\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+aot_check_header(WASMModule *module, const WASMAOTFileHeader *header,
+                 const uint8 *buf, uint32 size)
+{
+    const uint32 *type_ids = (const uint32 *)(buf + sizeof(WASMAOTFileHeader));
+    uint32 i;
+
+    if (header->magic != WASM_AOT_MAGIC || header->version != WASM_AOT_VERSION)
+    {
+        LOG_WARNING("aot file is not produced by this version of wasmc.\n");
+        return false;
+    }
+
+    if (header->module_hash != module->module_hash
+        || header->function_count != module->function_count
+        || header->type_count != module->type_count)
+    {
+        LOG_WARNING("aot file is compiled from another module.\n");
+        return false;
+    }
+
+    if (header->layout_hash != wasm_native_code_layout_hash())
+    {
+        LOG_WARNING("aot file is compiled for another runtime configuration.\n");
+        return false;
+    }
+
+    if (WASM_AOT_OBJECT_OFFSET(header->type_count) + header->object_size > size)
+    {
+        LOG_WARNING("aot file is truncated.\n");
+        return false;
+    }
+
+    // 类型编号写入了call_indirect的比较, 需与本进程中的编号一致
+    for (i = 0; i < header->type_count; i++)
+    {
+        if (type_ids[i] != module->types[i]->type_id)
+        {
+            LOG_WARNING("aot file uses different type ids.\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+aot_init_func_ptrs(WASMModule *module)
+{
+    uint32 i, function_count = module->function_count;
+
+    if (!(module->func_ptrs = wasm_runtime_malloc(sizeof(void *) * (uint64)function_count))
+        || !(module->func_ptrs_compiled = wasm_runtime_malloc(sizeof(bool) * (uint64)function_count))
+        || !(module->func_type_indexes = wasm_runtime_malloc(sizeof(uint32) * (uint64)function_count))
+        || !(module->func_entries = wasm_runtime_malloc(sizeof(void *) * ((uint64)module->type_count + 1))))
+        return false;
+
+    memset(module->func_ptrs, 0, sizeof(void *) * (uint64)function_count);
+    memset(module->func_entries, 0, sizeof(void *) * (uint64)module->type_count);
+    for (i = 0; i < function_count; i++)
+    {
+        module->func_ptrs_compiled[i] = true;
+        module->func_type_indexes[i] = module->functions[i].type_id;
+    }
+
+    return true;
+}
+
+static void
+aot_free_func_ptrs(WASMModule *module)
+{
+    if (module->func_ptrs)
+        wasm_runtime_free(module->func_ptrs);
+    if (module->func_ptrs_compiled)
+        wasm_runtime_free(module->func_ptrs_compiled);
+    if (module->func_type_indexes)
+        wasm_runtime_free(module->func_type_indexes);
+    if (module->func_entries)
+        wasm_runtime_free(module->func_entries);
+    module->func_ptrs = NULL;
+    module->func_ptrs_compiled = NULL;
+    module->func_type_indexes = NULL;
+    module->func_entries = NULL;
+}
+
+bool wasm_aot_load(WASMModule *module, const char *file_name)
+{
+    AOTLinker linker;
+    const WASMAOTFileHeader *header;
+    const uint8 *buf;
+    uint32 size;
+    bool ret = false;
+
+    if (!(buf = platform_map_file(file_name, &size)))
+    {
+        LOG_WARNING("map aot file %s failed.\n", file_name);
+        return false;
+    }
+
+    header = (const WASMAOTFileHeader *)buf;
+    if (size < sizeof(WASMAOTFileHeader) || !aot_check_header(module, header, buf, size))
+    {
+        LOG_WARNING("ignore aot file %s.\n", file_name);
+        platform_unmap_file(buf, size);
+        return false;
+    }
+
+    memset(&linker, 0, sizeof(AOTLinker));
+    linker.object = buf + WASM_AOT_OBJECT_OFFSET(header->type_count);
+    linker.object_size = header->object_size;
+
+    if (!aot_init_func_ptrs(module) || !aot_check_object(&linker)
+        || !aot_layout_sections(&linker) || !aot_resolve_symbols(&linker)
+        || !aot_relocate(&linker) || !aot_bind_functions(&linker, module)
+        || !aot_protect_segments(&linker))
+        goto fail;
+
+    module->aot_image = linker.image;
+    module->aot_image_size = (uint32)linker.image_size;
+    linker.image = NULL;
+    ret = true;
+    LOG_VERBOSE("Load aot file %s success.\n", file_name);
+
+fail:
+    if (!ret)
+        aot_free_func_ptrs(module);
+    if (linker.image)
+        os_munmap(linker.image, (size_t)linker.image_size);
+    if (linker.sec_offsets)
+        wasm_runtime_free(linker.sec_offsets);
+    if (linker.sym_addrs)
+        wasm_runtime_free(linker.sym_addrs);
+    platform_unmap_file(buf, size);
+    return ret;
+}
+
+void wasm_aot_destroy(WASMModule *module)
+{
+    if (!module->aot_image)
+        return;
+
+    os_munmap(module->aot_image, module->aot_image_size);
+    module->aot_image = NULL;
+    aot_free_func_ptrs(module);
+}
+#endif
@@ -0,0 +1,133 @@
+#include "wasm_aot_runtime.h"
+#include "wasm_exception.h"
+#include "wasm_exec_env.h"
+#include "wasm_memory.h"
+#include "wasm_native.h"
+#include "runtime_utils.h"
+
+static const char *exception_msgs[] = {
+    "unreachable",                             /* EXCE_UNREACHABLE */
+    "allocate memory failed",                  /* EXCE_OUT_OF_MEMORY */
+    "out of bounds memory access",             /* EXCE_OUT_OF_BOUNDS_MEMORY_ACCESS */
+    "integer overflow",                        /* EXCE_INTEGER_OVERFLOW */
+    "integer divide by zero",                  /* EXCE_INTEGER_DIVIDE_BY_ZERO */
+    "invalid conversion to integer",           /* EXCE_INVALID_CONVERSION_TO_INTEGER */
+    "indirect call type mismatch",             /* EXCE_INVALID_FUNCTION_TYPE_INDEX */
+    "invalid function index",                  /* EXCE_INVALID_FUNCTION_INDEX */
+    "undefined element",                       /* EXCE_UNDEFINED_ELEMENT */
+    "uninitialized element",                   /* EXCE_UNINITIALIZED_ELEMENT */
+    "failed to call unlinked import function", /* EXCE_CALL_UNLINKED_IMPORT_FUNC */
+    "native stack overflow",                   /* EXCE_NATIVE_STACK_OVERFLOW */
+    "unaligned atomic",                        /* EXCE_UNALIGNED_ATOMIC */
+    "wasm auxiliary stack overflow",           /* EXCE_AUX_STACK_OVERFLOW */
+    "wasm auxiliary stack underflow",          /* EXCE_AUX_STACK_UNDERFLOW */
+    "out of bounds table access",              /* EXCE_OUT_OF_BOUNDS_TABLE_ACCESS */
+    "wasm operand stack overflow",             /* EXCE_OPERAND_STACK_OVERFLOW */
+    "failed to compile fast jit function",     /* EXCE_FAILED_TO_COMPILE_FAST_JIT_FUNC */
+    "",                                        /* EXCE_ALREADY_THROWN */
+};
+
+void wasm_set_exception_with_id(WASMModule *module_inst, uint32 id)
+{
+    if (id < EXCE_NUM)
+        wasm_set_exception(module_inst, exception_msgs[id]);
+    else
+        wasm_set_exception(module_inst, "unknown exception");
+}
+
+void jit_set_exception_with_id(WASMModule *module_inst, uint32 id)
+{
+    if (id != EXCE_ALREADY_THROWN)
+        wasm_set_exception_with_id(module_inst, id);
+}
+
+void *
+wasm_jit_memmove(void *dest, const void *src, size_t n)
+{
+    return memmove(dest, src, n);
+}
+
+void *
+jit_memset(void *s, int c, size_t n)
+{
+    return memset(s, c, n);
+}
+
+bool llvm_jit_memory_init(WASMModule *module, uint32 seg_index,
+                          uint32 offset, uint32 len, uint32 dst)
+{
+    uint8 *data = NULL;
+    uint8 *maddr;
+    uint64 seg_len = 0;
+
+    seg_len = module->data_segments[seg_index].data_length;
+    data = module->data_segments[seg_index].data;
+
+    if (!wasm_runtime_validate_app_addr(module,
+                                        dst, len))
+        return false;
+
+    if ((uint64)offset + (uint64)len > seg_len)
+    {
+        wasm_set_exception(module, "out of bounds memory access");
+        return false;
+    }
+
+    maddr = wasm_runtime_addr_app_to_native(module, dst);
+
+    memcpy(maddr, data + offset, len);
+    return true;
+}
+
+bool llvm_jit_data_drop(WASMModule *module, uint32 seg_index)
+{
+
+    module->data_segments[seg_index].data_length = 0;
+    return true;
+}
+
+// 生成的代码按名字调用的运行时函数, 不在代码中写入函数地址,
+// 编译出的目标文件可以保存后在其他进程中重新链接
+static const WASMRuntimeSymbol runtime_symbols[] = {
+    { "jit_set_exception_with_id", (void *)jit_set_exception_with_id },
+    { "wasm_enlarge_memory", (void *)wasm_enlarge_memory },
+    { "llvm_jit_memory_init", (void *)llvm_jit_memory_init },
+    { "llvm_jit_data_drop", (void *)llvm_jit_data_drop },
+    { "wasm_jit_memmove", (void *)wasm_jit_memmove },
+    { "jit_memset", (void *)jit_memset },
+};
+
+const WASMRuntimeSymbol *
+wasm_runtime_helper_symbols(uint32 *p_count)
+{
+    *p_count = sizeof(runtime_symbols) / sizeof(WASMRuntimeSymbol);
+    return runtime_symbols;
+}
+
+uint64
+wasm_native_code_layout_hash(void)
+{
+    uint32 layout[] = {
+        sizeof(void *),
+        sizeof(WASMTable),
+        offsetof(WASMModule, memories),
+        offsetof(WASMModule, global_data),
+        offsetof(WASMModule, tables),
+        offsetof(WASMModule, cur_exception),
+        offsetof(WASMModule, func_ptrs),
+        offsetof(WASMModule, func_type_indexes),
+        offsetof(WASMModule, functions),
+        sizeof(WASMFunction),
+        offsetof(WASMFunction, func_ptr),
+        offsetof(WASMMemory, memory_data),
+        offsetof(WASMMemory, cur_page_count),
+        offsetof(WASMMemory, memory_data_size),
+        offsetof(WASMTable, cur_size),
+        offsetof(WASMTable, table_data),
+        offsetof(WASMExecEnv, argv_buf),
+        // 依赖保护页检查越界的代码不能在逐次检查的运行时中执行
+        WASM_ENABLE_HW_BOUND_CHECK,
+    };
+
+    return bh_hash_bytes(BH_HASH_INIT, layout, sizeof(layout));
+}
@@ -16,10 +16,39 @@ wasm_runtime_free(void *ptr);
 void *
 wasm_runtime_realloc(void *ptr, uint32 size);
 
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+// 线性内存预留的虚拟地址大小, 32位地址加32位偏移不会超出, 未提交的部分访问时触发信号
+#define WASM_MEMORY_RESERVE_SIZE (8 * (uint64)1024 * 1024 * 1024)
+#endif
+
+//按最大页数预留线性内存的地址空间并提交初始页面, 之后扩容不会移动基址
+bool
+wasm_memory_data_alloc(WASMMemory *memory);
+
+//释放线性内存
+void
+wasm_memory_data_free(WASMMemory *memory);
+
+//清零线性内存并缩回init_memory的初始大小, 保留预留的地址空间
+bool
+wasm_memory_data_reset(WASMMemory *memory, const WASMMemory *init_memory);
+
+//设置线性内存使用大页的方式, 需在wasm_instantiate之前调用
+void
+wasm_set_memory_huge_page_mode(WASMModule *module, WASMHugePageMode mode);
+
+//返回线性内存中实际由大页承载的字节数
+uint64
+wasm_get_memory_huge_page_size(WASMModule *module);
+
 //销毁module
 void
 wasm_module_destory(WASMModule *module);
 
+//销毁wasm_instance_create创建的实例, 只释放实例自身的状态
+void
+wasm_instance_destroy(WASMModule *instance);
+
 //创建module
 WASMModule *
 wasm_module_create();
@@ -243,6 +243,34 @@ typedef enum WASMOpcode
     WASM_OP_REF_IS_NULL = 0xd1, /* ref.is_null */
     WASM_OP_REF_FUNC = 0xd2,    /* ref.func */
 
+    // 槽位模式下调用栈式指令前同步frame_sp
+    EXT_OP_SET_SP = 0xd3,
+
+    // 超级指令, 由相邻的常见指令合并而成, 启用哪些由wasm_superinstr.def决定
+    EXT_OP_GET_LOCAL_GET_LOCAL = 0xd4,
+    EXT_OP_GET_LOCAL_GET_LOCAL_I32_ADD = 0xd5,
+    EXT_OP_I32_CONST_ADD = 0xd6,
+    EXT_OP_GET_LOCAL_I32_LOAD = 0xd7,
+    EXT_OP_GET_LOCAL_I32_CONST = 0xd8,
+    EXT_OP_I32_EQZ_BR_IF = 0xd9,
+    EXT_OP_I32_EQ_BR_IF = 0xda,
+    EXT_OP_I32_NE_BR_IF = 0xdb,
+    EXT_OP_I32_LT_S_BR_IF = 0xdc,
+    EXT_OP_I32_LT_U_BR_IF = 0xdd,
+    EXT_OP_I32_GT_S_BR_IF = 0xde,
+    EXT_OP_I32_GT_U_BR_IF = 0xdf,
+    EXT_OP_I32_LE_S_BR_IF = 0xe0,
+    EXT_OP_I32_LE_U_BR_IF = 0xe1,
+    EXT_OP_I32_GE_S_BR_IF = 0xe2,
+    EXT_OP_I32_GE_U_BR_IF = 0xe3,
+    EXT_OP_I32_ADD_SET_LOCAL = 0xe4,
+    EXT_OP_GET_LOCAL_I32_CONST_ADD = 0xe5,
+
+    // 分层执行时插入在循环头部, 统计回边次数
+    EXT_OP_LOOP_HOTNESS = 0xfa,
+    // 统计指令对时插入在每条指令之前
+    EXT_OP_PROFILE = 0xfb,
+
     WASM_OP_MISC_PREFIX = 0xfc,
     WASM_OP_SIMD_PREFIX = 0xfd,
     WASM_OP_ATOMIC_PREFIX = 0xfe,
@@ -485,10 +513,25 @@ typedef enum WASMMiscEXTOpcode
         HANDLE_OPCODE(WASM_OP_REF_NULL),             /* 0xd0 */ \
         HANDLE_OPCODE(WASM_OP_REF_IS_NULL),          /* 0xd1 */ \
         HANDLE_OPCODE(WASM_OP_REF_FUNC),             /* 0xd2 */ \
-        HANDLE_OPCODE(WASM_OP_UNUSED_0x06),          /* 0xd3 */ \
-        HANDLE_OPCODE(WASM_OP_UNUSED_0x06),          /* 0xd4 */ \
-        HANDLE_OPCODE(WASM_OP_UNUSED_0x06),          /* 0xd5 */ \
-        HANDLE_OPCODE(WASM_OP_UNUSED_0x06),          /* 0xd6 */ \
+        HANDLE_OPCODE(EXT_OP_SET_SP),                /* 0xd3 */ \
+        HANDLE_OPCODE(EXT_OP_GET_LOCAL_GET_LOCAL),   /* 0xd4 */ \
+        HANDLE_OPCODE(EXT_OP_GET_LOCAL_GET_LOCAL_I32_ADD), /* 0xd5 */ \
+        HANDLE_OPCODE(EXT_OP_I32_CONST_ADD),         /* 0xd6 */ \
+        HANDLE_OPCODE(EXT_OP_GET_LOCAL_I32_LOAD),    /* 0xd7 */ \
+        HANDLE_OPCODE(EXT_OP_GET_LOCAL_I32_CONST),   /* 0xd8 */ \
+        HANDLE_OPCODE(EXT_OP_I32_EQZ_BR_IF),         /* 0xd9 */ \
+        HANDLE_OPCODE(EXT_OP_I32_EQ_BR_IF),          /* 0xda */ \
+        HANDLE_OPCODE(EXT_OP_I32_NE_BR_IF),          /* 0xdb */ \
+        HANDLE_OPCODE(EXT_OP_I32_LT_S_BR_IF),        /* 0xdc */ \
+        HANDLE_OPCODE(EXT_OP_I32_LT_U_BR_IF),        /* 0xdd */ \
+        HANDLE_OPCODE(EXT_OP_I32_GT_S_BR_IF),        /* 0xde */ \
+        HANDLE_OPCODE(EXT_OP_I32_GT_U_BR_IF),        /* 0xdf */ \
+        HANDLE_OPCODE(EXT_OP_I32_LE_S_BR_IF),        /* 0xe0 */ \
+        HANDLE_OPCODE(EXT_OP_I32_LE_U_BR_IF),        /* 0xe1 */ \
+        HANDLE_OPCODE(EXT_OP_I32_GE_S_BR_IF),        /* 0xe2 */ \
+        HANDLE_OPCODE(EXT_OP_I32_GE_U_BR_IF),        /* 0xe3 */ \
+        HANDLE_OPCODE(EXT_OP_I32_ADD_SET_LOCAL),     /* 0xe4 */ \
+        HANDLE_OPCODE(EXT_OP_GET_LOCAL_I32_CONST_ADD), /* 0xe5 */ \
     };                                                          \
     do                                                          \
     {                                                           \
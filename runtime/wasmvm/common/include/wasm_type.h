@@ -66,13 +66,17 @@ typedef enum
 {
     Wasm_Func = 0,
     Native_Func,
-    External_Func
+    External_Func,
+    // 延迟验证的函数, 首次调用时验证并生成预解码指令后改为Wasm_Func
+    Lazy_Func
 } FuncKind;
 
 typedef enum
 {
     Load = 0,
     Validate,
+    // 已链接导入并计算各类总数, 只读, 可供多个实例共享
+    Compile,
     Instantiate,
     Execute
 } WASMModuleStage;
@@ -105,6 +109,8 @@ typedef struct WASMType
     uint16 param_cell_num;
     uint16 ret_cell_num;
     uint16 ref_count;
+    // 运行时范围内的类型编号, 见wasm_type_registry.h
+    uint32 type_id;
 } WASMType;
 
 typedef struct WASMExport
@@ -171,6 +177,16 @@ typedef union
     uint32 u32[2];
 } MemBound;
 
+// 线性内存使用大页的方式
+typedef enum WASMHugePageMode
+{
+    WASM_HUGE_PAGE_NONE = 0,
+    // 预留区按2MiB对齐并用madvise建议内核使用透明大页
+    WASM_HUGE_PAGE_ADVISE,
+    // 用MAP_HUGETLB映射显式大页, 按大页提交
+    WASM_HUGE_PAGE_EXPLICIT
+} WASMHugePageMode;
+
 typedef struct WASMMemory
 {
     /* Number bytes per page */
@@ -185,6 +201,12 @@ typedef struct WASMMemory
     uint8 *memory_data;
     /* Memory data end address */
     uint8 *memory_data_end;
+    // 预留的虚拟地址大小, 扩容只在其中提交页面, memory_data不会改变
+    uint64 reserve_size;
+    // 实际使用的大页方式, 请求的方式不可用时会退回
+    WASMHugePageMode huge_page_mode;
+    // 内存映像以写时复制方式映射自快照文件, 丢弃页面后会重新读到文件内容
+    bool image_mapped;
 
 } WASMMemory, WASMMemoryImport;
 
@@ -218,8 +240,13 @@ typedef struct WASMBlock
     struct WASMBlock *pre_block;
     uint8 *end_addr;
     uint8 *else_addr;
+    // 到else和end为止最后记录的ExtInfo, JIT跳过不可达代码后据此继续读取
+    struct ExtInfo *else_op_info;
+    struct ExtInfo *end_op_info;
     uint32 stack_num;
     bool is_set;
+    // if块带有else指令, 空的else分支的else_addr也与end_addr相同
+    bool has_else;
 } WASMBlock;
 
 typedef struct ExtInfo
@@ -227,8 +254,35 @@ typedef struct ExtInfo
     struct ExtInfo *next_op;
     uint32 idx;
 } ExtInfo;
+
+typedef struct WASMFunctionJIT
+{
+    bool has_memory_operations;
+    bool has_op_memory;
+    bool has_op_func_call;
+    bool has_op_call_indirect;
+    // 用于记录JIT需要使用的block数据
+    WASMBlock *blocks;
+    WASMBlock *last_block;
+    // 用于记录重写指令的数据
+    ExtInfo *op_info;
+    ExtInfo *last_op_info;
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 调用次数与循环回边次数之和, 达到阈值后提交后台编译
+    uint32 hotness;
+    // 已提交编译, 由tier_lock保护
+    bool tier_queued;
+#endif
+} WASMFunctionJIT;
 #endif
 
+// 只读映射时复制出来的以0结尾的字符串
+typedef struct WASMStringNode
+{
+    struct WASMStringNode *next;
+    char str[1];
+} WASMStringNode;
+
 typedef struct WASMFunction
 {
 
@@ -238,6 +292,8 @@ typedef struct WASMFunction
 
     WASMType *func_type;
     uint32 type_index;
+    // 即func_type->type_id, 签名检查只需比较整数
+    uint32 type_id;
 
     void *func_ptr;
     FuncKind func_kind;
@@ -253,6 +309,9 @@ typedef struct WASMFunction
     uint16 param_cell_num;
     uint16 ret_cell_num;
     uint16 local_cell_num;
+    // 调用时需要清零的局部变量范围, 相对frame_lp以4字节为单位, 由确定赋值分析得出
+    uint16 zero_cell_offset;
+    uint16 zero_cell_num;
     uint16 *local_offsets;
     uint8 *param_types;
     uint8 *local_types;
@@ -260,20 +319,14 @@ typedef struct WASMFunction
     uint32 max_stack_cell_num;
     uint32 max_block_num;
     uint32 max_stack_num;
-    WASMBranchTable *branch_table;
-
-#if WASM_ENABLE_JIT
-    bool has_memory_operations;
-    bool has_op_memory;
-    bool has_op_func_call;
-    bool has_op_call_indirect;
-    // 用于记录JIT需要使用的block数据
-    WASMBlock *blocks;
-    WASMBlock *last_block;
-    // 用于记录重写指令的数据
-    ExtInfo *op_info;
-    ExtInfo *last_op_info;
-#endif
+    // 验证阶段生成的预解码指令
+    uint64 *ir_code;
+    // 模块文件只读映射时, JIT使用的改写过指令的函数体副本
+    uint8 *code_copy;
+
+    // 只有JIT使用的信息, 验证时分配. 本地代码按固定步长访问functions数组,
+    // WASMFunction不能包含随编译配置变化的字段
+    struct WASMFunctionJIT *jit;
 } WASMFunctionImport, WASMFunction;
 
 typedef struct WASMExportFuncInstance
@@ -318,6 +371,27 @@ typedef struct OrcJitThreadArg
 } OrcJitThreadArg;
 #endif
 
+// 已编译模块与其实例共享的锁和编译队列, 单独分配, 创建实例时只复制指针
+typedef struct WASMModuleShared
+{
+    // 保证每个函数只验证一次, 启用延迟验证时初始化
+    korp_mutex lazy_lock;
+#if WASM_ENABLE_JIT != 0
+    /* whether to stop the compilation of backend threads */
+    bool orcjit_stop_compiling;
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 待编译函数的队列, 后台线程从中取出函数编号, 均由tier_lock保护
+    korp_mutex tier_lock;
+    korp_cond tier_cond;
+    uint32 *tier_queue;
+    uint32 tier_queue_head;
+    uint32 tier_queue_num;
+    // LLVM IR已生成并加入LLLazyJIT, 之后才能查找编译好的函数
+    bool tier_ready;
+#endif
+#endif
+} WASMModuleShared;
+
 typedef struct WASMModule
 {
     // 各种类型
@@ -354,6 +428,24 @@ typedef struct WASMModule
     uint32 default_value_stack_size;
     uint32 default_execution_stack_size;
 
+    // 实例化时线性内存请求的大页方式
+    WASMHugePageMode memory_huge_page_mode;
+
+    // 函数体推迟到首次调用时验证
+    bool lazy_validation;
+
+    // 模块文件只读映射, 原始字节由各进程共享, 改写的指令和字符串放在单独分配的内存中
+    bool code_read_only;
+    WASMStringNode *string_copies;
+
+    // 由wasm_instance_create创建的实例指向其共享的已编译模块, 否则为NULL
+    struct WASMModule *compiled_module;
+    // 由已编译模块分配和释放, 实例与其共用
+    WASMModuleShared *shared;
+
+    // 实例池中的实例预先分配执行环境, 每次执行复用, 否则为NULL
+    struct WASMExecEnv *exec_env;
+
     // 全局数据
     uint8 *global_data;
 
@@ -365,15 +457,10 @@ typedef struct WASMModule
     uint32 export_func_count;
     WASMExportFuncInstance *export_functions;
 
-#if WASM_ENABLE_JIT != 0
-    bool has_op_memory_grow;
-    /* backend compilation threads */
-    korp_tid orcjit_threads[WASM_ORC_JIT_BACKEND_THREAD_NUM];
-    /* backend thread arguments */
-    OrcJitThreadArg orcjit_thread_args[WASM_ORC_JIT_BACKEND_THREAD_NUM];
-    /* whether to stop the compilation of backend threads */
-    bool orcjit_stop_compiling;
-    struct JITCompContext *comp_ctx;
+    // 模块文件内容的哈希, 作为JIT代码缓存的键, 也用于检查预编译文件和快照是否对应该模块
+    uint64 module_hash;
+
+#if WASM_ENABLE_JIT != 0 || WASM_ENABLE_AOT != 0
     /**
      * func pointers of LLVM JITed (un-imported) functions
      * for non Multi-Tier JIT mode:
@@ -388,6 +475,25 @@ typedef struct WASMModule
     /* whether the func pointers are compiled */
     bool *func_ptrs_compiled;
     uint32 *func_type_indexes;
+    // 按类型编号存放的入口, 宿主经入口调用func_ptrs中编译好的函数
+    void **func_entries;
+#endif
+#if WASM_ENABLE_AOT != 0
+    // 预编译的本地代码文件, 编译模块时加载
+    const char *aot_file;
+    // 加载的本地代码映射, 未加载时为NULL
+    uint8 *aot_image;
+    uint32 aot_image_size;
+#endif
+#if WASM_ENABLE_JIT != 0
+    bool has_op_memory_grow;
+    /* backend compilation threads */
+    korp_tid orcjit_threads[WASM_ORC_JIT_BACKEND_THREAD_NUM];
+    /* backend thread arguments */
+    OrcJitThreadArg orcjit_thread_args[WASM_ORC_JIT_BACKEND_THREAD_NUM];
+    struct JITCompContext *comp_ctx;
+    // 从缓存的目标文件加载本地代码的JIT, 未使用缓存时为NULL
+    struct LLVMOrcOpaqueLLJIT *jit_cache;
 #endif
 } WASMModule;
 
@@ -452,18 +558,4 @@ is_value_type(uint8 type)
     return false;
 }
 
-inline static uint32
-wasm_get_cur_type_idx(WASMType **types,
-                      WASMType *cur_type)
-{
-    uint32 i;
-
-    for (i = 0;; i++)
-    {
-        if (cur_type == types[i])
-            return i;
-    }
-    return -1;
-}
-
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef _WASM_TYPE_REGISTRY_H
+#define _WASM_TYPE_REGISTRY_H
+
+#include "platform.h"
+
+// 进程内所有模块和本地函数共用的函数类型编号, 结构相同的类型编号相同, 0表示无效
+#define WASM_TYPE_ID_INVALID 0
+
+//初始化类型注册表
+bool
+wasm_type_registry_init();
+
+//销毁类型注册表
+void
+wasm_type_registry_destroy();
+
+//返回该函数类型的编号, 内存不足时返回WASM_TYPE_ID_INVALID
+uint32
+wasm_type_registry_intern(const uint8 *param, uint32 param_count,
+                          const uint8 *result, uint32 result_count);
+
+//返回本地函数签名(如"(ii*~$)i")对应的编号, 签名无法解析时返回WASM_TYPE_ID_INVALID
+uint32
+wasm_type_registry_intern_signature(const char *signature);
+
+#endif
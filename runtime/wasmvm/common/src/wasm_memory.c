@@ -1,5 +1,16 @@
 #include "wasm_memory.h"
 #include "wasm_exception.h"
+#include "runtime_log.h"
+#include "wasm_runtime_init_api.h"
+#if WASM_ENABLE_TIERED_JIT != 0
+#include "wasm_jit_init.h"
+#endif
+#if WASM_ENABLE_JIT != 0
+#include "wasm_jit_cache.h"
+#endif
+#if WASM_ENABLE_AOT != 0
+#include "wasm_aot_loader.h"
+#endif
 
 void *
 wasm_runtime_malloc(uint64 size)
@@ -18,16 +29,215 @@ wasm_runtime_realloc(void *ptr, uint32 size)
     return os_realloc(ptr, size);
 }
 
+// 线性内存需要预留的虚拟地址大小, 32位地址最多访问4GiB
+static uint64
+memory_reserve_size(const WASMMemory *memory)
+{
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    (void)memory;
+    return WASM_MEMORY_RESERVE_SIZE;
+#else
+    uint32 page_count = memory->max_page_count > memory->cur_page_count
+                            ? memory->max_page_count
+                            : memory->cur_page_count;
+    uint64 size = (uint64)memory->num_bytes_per_page * page_count;
+
+    return size > UINT32_MAX + (uint64)1 ? UINT32_MAX + (uint64)1 : size;
+#endif
+}
+
+#define HUGE_PAGE_ALIGN(size) \
+    (((size) + HUGE_PAGE_SIZE - 1) & ~(uint64)(HUGE_PAGE_SIZE - 1))
+
+// 显式大页按大页提交并立即分配, 大页不足时返回false, 避免之后访问时收到SIGBUS
+static bool
+memory_commit_huge_pages(uint8 *memory_data, uint64 size_old, uint64 size_new)
+{
+    uint64 commit_start = HUGE_PAGE_ALIGN(size_old);
+    uint64 commit_end = HUGE_PAGE_ALIGN(size_new);
+
+    if (commit_end <= commit_start)
+        return true;
+
+    if (os_mprotect(memory_data + commit_start, commit_end - commit_start,
+                    MMAP_PROT_READ | MMAP_PROT_WRITE) != 0)
+        return false;
+
+    if (os_mpopulate(memory_data + commit_start, commit_end - commit_start) != 0)
+    {
+        os_mprotect(memory_data + commit_start, commit_end - commit_start,
+                    MMAP_PROT_NONE);
+        return false;
+    }
+    return true;
+}
+
+// 按请求的大页方式预留地址空间并提交初始页面, 不可用时依次退回透明大页和普通页面
+static uint8 *
+memory_data_map(WASMMemory *memory, uint64 *p_reserve_size, uint64 init_size)
+{
+    uint64 reserve_size = *p_reserve_size;
+    uint8 *memory_data;
+
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    // 显式大页只能按2MiB提交, 末尾不足一个大页的部分访问时不会触发越界陷阱
+    if (memory->huge_page_mode == WASM_HUGE_PAGE_EXPLICIT)
+        memory->huge_page_mode = WASM_HUGE_PAGE_ADVISE;
+#endif
+
+    if (memory->huge_page_mode == WASM_HUGE_PAGE_EXPLICIT)
+    {
+        if ((memory_data = os_mmap(NULL, HUGE_PAGE_ALIGN(reserve_size),
+                                   MMAP_PROT_NONE, MMAP_MAP_HUGETLB)))
+        {
+            if (memory_commit_huge_pages(memory_data, 0, init_size))
+            {
+                *p_reserve_size = HUGE_PAGE_ALIGN(reserve_size);
+                return memory_data;
+            }
+            os_munmap(memory_data, HUGE_PAGE_ALIGN(reserve_size));
+        }
+        LOG_WARNING("explicit huge pages unavailable, "
+                    "fall back to transparent huge pages.\n");
+        memory->huge_page_mode = WASM_HUGE_PAGE_ADVISE;
+    }
+
+    // 匿名映射的页面初始为0, 只把已有的页面设为可读写
+    if (!(memory_data = os_mmap(NULL, reserve_size, MMAP_PROT_NONE,
+                                memory->huge_page_mode == WASM_HUGE_PAGE_ADVISE
+                                    ? MMAP_MAP_HUGEPAGE
+                                    : MMAP_MAP_NONE)))
+        return NULL;
+
+    if (init_size > 0 && os_mprotect(memory_data, init_size,
+                                     MMAP_PROT_READ | MMAP_PROT_WRITE) != 0)
+    {
+        os_munmap(memory_data, reserve_size);
+        return NULL;
+    }
+    return memory_data;
+}
+
+bool wasm_memory_data_alloc(WASMMemory *memory)
+{
+    uint64 init_size = (uint64)memory->num_bytes_per_page * memory->cur_page_count;
+    uint64 reserve_size = memory_reserve_size(memory);
+    uint8 *memory_data = NULL;
+
+    if (init_size > reserve_size)
+        return false;
+
+    if (reserve_size > 0
+        && !(memory_data = memory_data_map(memory, &reserve_size, init_size)))
+        return false;
+
+    // 65536页的内存大小超出uint32, 与扩容时一样截断为UINT32_MAX而不是回绕为0
+    if (init_size > UINT32_MAX)
+        init_size = UINT32_MAX;
+
+    memory->memory_data = memory_data;
+    memory->memory_data_size = (uint32)init_size;
+    memory->memory_data_end = memory_data + (uint32)init_size;
+    memory->reserve_size = reserve_size;
+    memory->image_mapped = false;
+    return true;
+}
+
+void wasm_set_memory_huge_page_mode(WASMModule *module, WASMHugePageMode mode)
+{
+    module->memory_huge_page_mode = mode;
+}
+
+uint64
+wasm_get_memory_huge_page_size(WASMModule *module)
+{
+    WASMMemory *memory = module->memories;
+
+    if (!memory->memory_data || memory->huge_page_mode == WASM_HUGE_PAGE_NONE)
+        return 0;
+
+    return os_huge_page_backed_size(memory->memory_data,
+                                    memory->memory_data_size);
+}
+
+void wasm_memory_data_free(WASMMemory *memory)
+{
+    if (memory->memory_data)
+        os_munmap(memory->memory_data, memory->reserve_size);
+
+    memory->memory_data = NULL;
+    memory->memory_data_end = NULL;
+    memory->memory_data_size = 0;
+    memory->reserve_size = 0;
+    memory->image_mapped = false;
+}
+
+// 清零页面并交还内核, 显式大页保留物理页, 避免再次访问时因大页不足收到SIGBUS
+static void
+memory_data_discard(uint8 *addr, uint64 size, bool keep_pages)
+{
+    if (size == 0)
+        return;
+
+    if (keep_pages || os_mdiscard(addr, size) != 0)
+        memset(addr, 0, size);
+}
+
+bool wasm_memory_data_reset(WASMMemory *memory, const WASMMemory *init_memory)
+{
+    uint64 init_size = (uint64)init_memory->num_bytes_per_page * init_memory->cur_page_count;
+    uint64 commit_size = init_size, used_size = memory->memory_data_size;
+    bool explicit_huge_page = memory->huge_page_mode == WASM_HUGE_PAGE_EXPLICIT;
+
+    if (!memory->memory_data)
+        return true;
+
+    if (explicit_huge_page)
+    {
+        commit_size = HUGE_PAGE_ALIGN(init_size);
+        used_size = HUGE_PAGE_ALIGN(used_size);
+    }
+
+    if (memory->image_mapped)
+    {
+        // 换回匿名映射, 只提交初始页面
+        if (!os_mmap(memory->memory_data, used_size, MMAP_PROT_NONE, MMAP_MAP_FIXED)
+            || (commit_size > 0 && os_mprotect(memory->memory_data, commit_size,
+                                               MMAP_PROT_READ | MMAP_PROT_WRITE) != 0))
+            return false;
+        memory->image_mapped = false;
+    }
+    else
+    {
+        // 扩容后提交的页面取消提交, 之后的memory.grow与新实例的行为一致
+        if (used_size > commit_size)
+        {
+            memory_data_discard(memory->memory_data + commit_size,
+                                used_size - commit_size, false);
+            if (os_mprotect(memory->memory_data + commit_size,
+                            used_size - commit_size, MMAP_PROT_NONE) != 0)
+                return false;
+        }
+
+        // 只有写过的页面占用物理内存, 交还后再次访问时得到零页
+        memory_data_discard(memory->memory_data, commit_size, explicit_huge_page);
+    }
+
+    memory->num_bytes_per_page = init_memory->num_bytes_per_page;
+    memory->cur_page_count = init_memory->cur_page_count;
+    memory->max_page_count = init_memory->max_page_count;
+    memory->memory_data_size = (uint32)init_size;
+    memory->memory_data_end = memory->memory_data + (uint32)init_size;
+    return true;
+}
+
 bool wasm_enlarge_memory(WASMModule *module, uint32 inc_page_count)
 {
     WASMMemory *memory = module->memories;
-    uint8 *memory_data_old, *memory_data_new;
     uint32 num_bytes_per_page, total_size_old;
     uint32 cur_page_count, max_page_count, total_page_count;
     uint64 total_size_new;
-    bool ret = true;
 
-    memory_data_old = memory->memory_data;
     total_size_old = memory->memory_data_size;
 
     num_bytes_per_page = memory->num_bytes_per_page;
@@ -51,24 +261,30 @@ bool wasm_enlarge_memory(WASMModule *module, uint32 inc_page_count)
         total_size_new = UINT32_MAX;
     }
 
-    if (!(memory_data_new =
-              wasm_runtime_realloc(memory_data_old, (uint32)total_size_new)))
+    if (total_size_new > memory->reserve_size)
+        return false;
+
+    // 新增的页面已在预留区内, 设为可读写即可, 基址始终不变
+    if (memory->huge_page_mode == WASM_HUGE_PAGE_EXPLICIT)
+    {
+        if (!memory_commit_huge_pages(memory->memory_data, total_size_old,
+                                      total_size_new))
+            return false;
+    }
+    else if (os_mprotect(memory->memory_data + total_size_old,
+                         (uint32)total_size_new - total_size_old,
+                         MMAP_PROT_READ | MMAP_PROT_WRITE) != 0)
     {
         return false;
     }
 
-    memset(memory_data_new + total_size_old, 0,
-           (uint32)total_size_new - total_size_old);
-
     memory->num_bytes_per_page = num_bytes_per_page;
     memory->cur_page_count = total_page_count;
     memory->max_page_count = max_page_count;
     memory->memory_data_size = (uint32)total_size_new;
+    memory->memory_data_end = memory->memory_data + (uint32)total_size_new;
 
-    memory->memory_data = memory_data_new;
-    memory->memory_data_end = memory_data_new + (uint32)total_size_new;
-
-    return ret;
+    return true;
 }
 
 uint32
@@ -186,6 +402,7 @@ void wasm_module_destory(WASMModule *module)
     {
     case Execute:
     case Instantiate:
+    case Compile:
         define_function_count = module->function_count - import_function_count;
         break;
     case Validate:
@@ -197,6 +414,12 @@ void wasm_module_destory(WASMModule *module)
     if (!module)
         return;
 
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 后台编译线程仍在访问模块, 先停止
+    if (module_stage >= Compile)
+        wasm_jit_tier_up_destroy(module);
+#endif
+
     switch (module_stage)
     {
     case Execute:
@@ -205,14 +428,9 @@ void wasm_module_destory(WASMModule *module)
         {
             wasm_runtime_free(module->global_data);
         }
-        if (module->wasi_ctx)
-        {
-            wasm_runtime_free(module->wasi_ctx);
-        }
-        if (module->export_functions)
-        {
-            wasm_runtime_free(module->export_functions);
-        }
+#if WASM_ENABLE_WASI != 0
+        wasm_runtime_wasi_destroy(module);
+#endif
         if (table_count)
         {
             table = module->tables;
@@ -227,20 +445,50 @@ void wasm_module_destory(WASMModule *module)
         if (memory_count)
         {
             memory = module->memories;
-            if (memory->memory_data)
-            {
-                wasm_runtime_free(memory->memory_data);
-            }
+            wasm_memory_data_free(memory);
+        }
+    case Compile:
+        if (module->export_functions)
+        {
+            wasm_runtime_free(module->export_functions);
         }
+#if WASM_ENABLE_JIT != 0
+        wasm_jit_cache_destroy(module);
+#endif
+#if WASM_ENABLE_AOT != 0
+        wasm_aot_destroy(module);
+#endif
     case Validate:
-        // 清除跳转表
+        // 清除预解码指令
         function = module->functions + import_function_count;
         for (i = 0; i < define_function_count; i++, function++)
         {
-            if (function->branch_table)
+            if (function->ir_code)
+            {
+                wasm_runtime_free(function->ir_code);
+            }
+            if (function->code_copy)
+            {
+                wasm_runtime_free(function->code_copy);
+            }
+#if WASM_ENABLE_JIT != 0
+            if (function->jit)
             {
-                wasm_runtime_free(function->branch_table);
+                WASMBlock *block = function->jit->blocks, *next_block;
+                ExtInfo *op_info = function->jit->op_info, *next_op;
+                for (; block; block = next_block)
+                {
+                    next_block = block->next_block;
+                    wasm_runtime_free(block);
+                }
+                for (; op_info; op_info = next_op)
+                {
+                    next_op = op_info->next_op;
+                    wasm_runtime_free(op_info);
+                }
+                wasm_runtime_free(function->jit);
             }
+#endif
         }
     case Load:
         // 清除type段
@@ -314,12 +562,54 @@ void wasm_module_destory(WASMModule *module)
         {
             wasm_runtime_free(module->data_segments);
         }
+
+        // 清除只读映射时复制的字符串
+        while (module->string_copies)
+        {
+            WASMStringNode *node = module->string_copies;
+            module->string_copies = node->next;
+            wasm_runtime_free(node);
+        }
         break;
     }
 
+    if (module->lazy_validation)
+        os_mutex_destroy(&module->shared->lazy_lock);
+
+    wasm_runtime_free(module->shared);
     wasm_runtime_free(module);
 }
 
+void wasm_instance_destroy(WASMModule *instance)
+{
+    uint32 i;
+    WASMTable *table;
+
+    if (!instance)
+        return;
+
+    if (instance->global_data)
+        wasm_runtime_free(instance->global_data);
+
+#if WASM_ENABLE_WASI != 0
+    wasm_runtime_wasi_destroy(instance);
+#endif
+
+    if (instance->tables)
+    {
+        table = instance->tables;
+        for (i = 0; i < instance->table_count; i++, table++)
+        {
+            if (table->table_data)
+                wasm_runtime_free(table->table_data);
+        }
+        wasm_runtime_free(instance->tables);
+    }
+
+    wasm_memory_data_free(instance->memories);
+    wasm_runtime_free(instance);
+}
+
 WASMModule *
 wasm_module_create()
 {
@@ -332,6 +622,13 @@ wasm_module_create()
 
     memset(module, 0, sizeof(WASMModule));
 
+    if (!(module->shared = wasm_runtime_malloc(sizeof(WASMModuleShared))))
+    {
+        wasm_runtime_free(module);
+        return NULL;
+    }
+    memset(module->shared, 0, sizeof(WASMModuleShared));
+
     module->module_stage = Load;
     module->start_function = (uint32)-1;
 
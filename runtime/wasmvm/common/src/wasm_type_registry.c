@@ -0,0 +1,246 @@
+#include "wasm_type_registry.h"
+#include "wasm_memory.h"
+
+typedef struct WASMTypeRegistryEntry
+{
+    uint32 hash;
+    uint16 param_count;
+    uint16 result_count;
+    // 参数类型后紧跟返回值类型
+    uint8 *types;
+} WASMTypeRegistryEntry;
+
+typedef struct WASMTypeRegistry
+{
+    // 第id-1项为编号id对应的类型
+    WASMTypeRegistryEntry *entries;
+    uint32 entry_count;
+    uint32 entry_capacity;
+    // 开放寻址的哈希表, 存放类型编号, 0为空槽, 大小为2的幂
+    uint32 *buckets;
+    uint32 bucket_count;
+#if WASM_ENABLE_THREAD != 0
+    korp_mutex lock;
+#endif
+} WASMTypeRegistry;
+
+static WASMTypeRegistry g_type_registry;
+
+static uint32
+type_hash(const uint8 *param, uint32 param_count,
+          const uint8 *result, uint32 result_count)
+{
+    uint32 hash = 2166136261u, i;
+
+    hash = (hash ^ param_count) * 16777619u;
+    for (i = 0; i < param_count; i++)
+        hash = (hash ^ param[i]) * 16777619u;
+    hash = (hash ^ result_count) * 16777619u;
+    for (i = 0; i < result_count; i++)
+        hash = (hash ^ result[i]) * 16777619u;
+
+    return hash;
+}
+
+static bool
+registry_rehash(WASMTypeRegistry *registry, uint32 bucket_count)
+{
+    uint32 *buckets, mask = bucket_count - 1, i, j;
+
+    if (!(buckets = wasm_runtime_malloc(sizeof(uint32) * (uint64)bucket_count)))
+        return false;
+    memset(buckets, 0, sizeof(uint32) * bucket_count);
+
+    for (i = 0; i < registry->entry_count; i++)
+    {
+        j = registry->entries[i].hash & mask;
+        while (buckets[j])
+            j = (j + 1) & mask;
+        buckets[j] = i + 1;
+    }
+
+    if (registry->buckets)
+        wasm_runtime_free(registry->buckets);
+    registry->buckets = buckets;
+    registry->bucket_count = bucket_count;
+    return true;
+}
+
+bool wasm_type_registry_init()
+{
+    memset(&g_type_registry, 0, sizeof(WASMTypeRegistry));
+
+    if (!registry_rehash(&g_type_registry, 64))
+        return false;
+
+#if WASM_ENABLE_THREAD != 0
+    if (os_mutex_init(&g_type_registry.lock) != 0)
+    {
+        wasm_runtime_free(g_type_registry.buckets);
+        g_type_registry.buckets = NULL;
+        return false;
+    }
+#endif
+    return true;
+}
+
+void wasm_type_registry_destroy()
+{
+    uint32 i;
+
+    if (!g_type_registry.buckets)
+        return;
+
+    for (i = 0; i < g_type_registry.entry_count; i++)
+    {
+        if (g_type_registry.entries[i].types)
+            wasm_runtime_free(g_type_registry.entries[i].types);
+    }
+    if (g_type_registry.entries)
+        wasm_runtime_free(g_type_registry.entries);
+    wasm_runtime_free(g_type_registry.buckets);
+
+#if WASM_ENABLE_THREAD != 0
+    os_mutex_destroy(&g_type_registry.lock);
+#endif
+    memset(&g_type_registry, 0, sizeof(WASMTypeRegistry));
+}
+
+static uint32
+registry_intern(WASMTypeRegistry *registry, uint32 hash,
+                const uint8 *param, uint32 param_count,
+                const uint8 *result, uint32 result_count)
+{
+    WASMTypeRegistryEntry *entry, *entries;
+    uint32 mask = registry->bucket_count - 1, i, id, capacity;
+    uint8 *types = NULL;
+
+    for (i = hash & mask; (id = registry->buckets[i]); i = (i + 1) & mask)
+    {
+        entry = registry->entries + id - 1;
+        if (entry->hash == hash
+            && entry->param_count == param_count
+            && entry->result_count == result_count
+            && (!param_count || memcmp(entry->types, param, param_count) == 0)
+            && (!result_count || memcmp(entry->types + param_count, result, result_count) == 0))
+            return id;
+    }
+
+    // 新类型, 装载因子超过1/2时扩大哈希表
+    if ((registry->entry_count + 1) * 2 > registry->bucket_count
+        && !registry_rehash(registry, registry->bucket_count * 2))
+        return WASM_TYPE_ID_INVALID;
+
+    if (registry->entry_count == registry->entry_capacity)
+    {
+        capacity = registry->entry_capacity ? registry->entry_capacity * 2 : 32;
+        if (!(entries = wasm_runtime_realloc(registry->entries,
+                                             sizeof(WASMTypeRegistryEntry) * capacity)))
+            return WASM_TYPE_ID_INVALID;
+        registry->entries = entries;
+        registry->entry_capacity = capacity;
+    }
+
+    if (param_count + result_count
+        && !(types = wasm_runtime_malloc(param_count + result_count)))
+        return WASM_TYPE_ID_INVALID;
+    if (param_count)
+        memcpy(types, param, param_count);
+    if (result_count)
+        memcpy(types + param_count, result, result_count);
+
+    entry = registry->entries + registry->entry_count++;
+    entry->hash = hash;
+    entry->param_count = (uint16)param_count;
+    entry->result_count = (uint16)result_count;
+    entry->types = types;
+    id = registry->entry_count;
+
+    mask = registry->bucket_count - 1;
+    for (i = hash & mask; registry->buckets[i]; i = (i + 1) & mask)
+        ;
+    registry->buckets[i] = id;
+    return id;
+}
+
+uint32
+wasm_type_registry_intern(const uint8 *param, uint32 param_count,
+                          const uint8 *result, uint32 result_count)
+{
+    uint32 hash = type_hash(param, param_count, result, result_count), id;
+
+    if (!g_type_registry.buckets || param_count > UINT16_MAX || result_count > UINT16_MAX)
+        return WASM_TYPE_ID_INVALID;
+
+#if WASM_ENABLE_THREAD != 0
+    os_mutex_lock(&g_type_registry.lock);
+#endif
+    id = registry_intern(&g_type_registry, hash, param, param_count, result, result_count);
+#if WASM_ENABLE_THREAD != 0
+    os_mutex_unlock(&g_type_registry.lock);
+#endif
+    return id;
+}
+
+static bool
+signature_value_type(char sig, uint8 *p_type)
+{
+    switch (sig)
+    {
+    case 'i':
+        *p_type = VALUE_TYPE_I32;
+        return true;
+    case 'I':
+        *p_type = VALUE_TYPE_I64;
+        return true;
+    case 'f':
+        *p_type = VALUE_TYPE_F32;
+        return true;
+    case 'F':
+        *p_type = VALUE_TYPE_F64;
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32
+wasm_type_registry_intern_signature(const char *signature)
+{
+    const char *p = signature;
+    uint8 *param, result;
+    uint32 param_count = 0, result_count = 0, id = WASM_TYPE_ID_INVALID;
+
+    if (!p || *p++ != '(')
+        return WASM_TYPE_ID_INVALID;
+
+    // 参数个数不超过签名长度
+    if (!(param = wasm_runtime_malloc(strlen(p) + 1)))
+        return WASM_TYPE_ID_INVALID;
+
+    for (; *p && *p != ')'; p++)
+    {
+        // 指针, 紧跟指针的缓冲区长度以及字符串在wasm中都是i32
+        if (*p == '*' || *p == '$' || (*p == '~' && p[-1] == '*'))
+            param[param_count++] = VALUE_TYPE_I32;
+        else if (!signature_value_type(*p, &param[param_count++]))
+            goto fail;
+    }
+
+    if (*p++ != ')')
+        goto fail;
+
+    if (*p)
+    {
+        if (!signature_value_type(*p++, &result))
+            goto fail;
+        result_count = 1;
+    }
+
+    if (*p == '\0')
+        id = wasm_type_registry_intern(param, param_count, &result, result_count);
+
+fail:
+    wasm_runtime_free(param);
+    return id;
+}
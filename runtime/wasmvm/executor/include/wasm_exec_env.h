@@ -9,7 +9,7 @@ typedef struct WASMExecEnv
     struct WASMExecEnv *prev;
     WASMModule *module_inst;
 
-#if WASM_ENABLE_JIT != 0
+#if WASM_ENABLE_JIT != 0 || WASM_ENABLE_AOT != 0
     uint32 argv_buf[64];
 #endif
 
@@ -17,13 +17,17 @@ typedef struct WASMExecEnv
     {
         uint8 *top_boundary;
 
-        uint8 *func_frame_top;
-
+        // 下一次从外部进入解释器时栈帧的起始位置
         uint8 *top;
 
         uint8 *bottom;
     } exec_stack;
 
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    // 最内层wasm调用的跳转点, 线性内存保护区内的访问故障由信号处理跳回此处
+    korp_jmpbuf *jmpbuf;
+#endif
+
 } WASMExecEnv;
 
 WASMExecEnv *
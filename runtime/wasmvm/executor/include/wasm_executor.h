@@ -4,6 +4,10 @@
 #include "wasm_type.h"
 #include "wasm_exec_env.h"
 
+//执行_initialize和start函数
+bool
+execute_post_instantiate_functions(WASMModule *module);
+
 //执行wasm模块
 bool
 execute_main(WASMModule *module_inst, int32 argc, char *argv[]);
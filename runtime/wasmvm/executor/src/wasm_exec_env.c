@@ -26,8 +26,19 @@ wasm_exec_env_create(WASMModule *module_inst)
 
     exec_env->exec_stack.top_boundary =
         exec_env->exec_stack.bottom + value_stack_size;
-    exec_env->exec_stack.func_frame_top = exec_env->exec_stack.top_boundary;
     exec_env->exec_stack.top = exec_env->exec_stack.bottom;
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    exec_env->jmpbuf = NULL;
+#endif
 
     return exec_env;
-}
\ No newline at end of file
+}
+
+void wasm_exec_env_destroy(WASMExecEnv *exec_env)
+{
+    if (!exec_env)
+        return;
+
+    wasm_runtime_free(exec_env->exec_stack.bottom);
+    wasm_runtime_free(exec_env);
+}
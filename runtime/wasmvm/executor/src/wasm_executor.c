@@ -73,8 +73,7 @@ check_main_func_type(const WASMType *type)
     return true;
 }
 
-static bool
-execute_post_instantiate_functions(WASMModule *module)
+bool execute_post_instantiate_functions(WASMModule *module)
 {
     WASMFunction *start_func = NULL;
     WASMFunction *initialize_func = NULL;
@@ -94,8 +93,8 @@ execute_post_instantiate_functions(WASMModule *module)
         return true;
     }
 
-    if (!exec_env && !(exec_env =
-                           wasm_exec_env_create(module)))
+    if (!(exec_env = module->exec_env) && !(exec_env =
+                                                wasm_exec_env_create(module)))
     {
         wasm_set_exception(module, "allocate memory failed");
         return false;
@@ -124,7 +123,8 @@ bool execute_main(WASMModule *module_inst, int32 argc, char *argv[])
     WASMExecEnv *exec_env = NULL;
     bool ret;
 
-    exec_env = wasm_exec_env_create(module_inst);
+    if (!(exec_env = module_inst->exec_env))
+        exec_env = wasm_exec_env_create(module_inst);
     if (!exec_env)
     {
         wasm_set_exception(module_inst,
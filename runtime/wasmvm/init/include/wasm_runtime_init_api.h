@@ -20,4 +20,8 @@ wasm_runtime_wasi_init(WASMModule *module_inst,
                        char *argv[], uint32 argc, int stdinfd, int stdoutfd,
                        int stderrfd);
 
+//释放wasi环境, 关闭其中打开的文件
+void
+wasm_runtime_wasi_destroy(WASMModule *module_inst);
+
 #endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "wasm_native.h"
 #include "wasm_memory.h"
 #include "wasm_exception.h"
+#include "wasm_interp.h"
+#include "wasm_type_registry.h"
 
 #if WASM_ENABLE_WASI != 0
 #include "wasm_wasi.h"
@@ -80,6 +82,7 @@ bool wasm_runtime_wasi_init(WASMModule *module,
     {
         return false;
     }
+    memset(wasi_ctx, 0, sizeof(WASIContext));
 
     if (!copy_string_array((const char **)argv, argc, &argv_buf, &argv_list,
                            &argv_buf_size))
@@ -253,9 +256,56 @@ fail:
         wasm_runtime_free(ns_lookup_buf);
     if (ns_lookup_list)
         wasm_runtime_free(ns_lookup_list);
+    wasm_runtime_free(wasi_ctx);
+    module->wasi_ctx = NULL;
     return false;
 }
 
+void wasm_runtime_wasi_destroy(WASMModule *module)
+{
+    WASIContext *wasi_ctx = module->wasi_ctx;
+
+    if (!wasi_ctx)
+        return;
+
+    // 关闭预打开的目录和客户程序未关闭的文件, 标准输入输出不会被关闭
+    if (wasi_ctx->argv_environ)
+    {
+        argv_environ_destroy(wasi_ctx->argv_environ);
+        wasm_runtime_free(wasi_ctx->argv_environ);
+    }
+    if (wasi_ctx->curfds)
+    {
+        fd_table_destroy(wasi_ctx->curfds);
+        wasm_runtime_free(wasi_ctx->curfds);
+    }
+    if (wasi_ctx->prestats)
+    {
+        fd_prestats_destroy(wasi_ctx->prestats);
+        wasm_runtime_free(wasi_ctx->prestats);
+    }
+    if (wasi_ctx->addr_pool)
+    {
+        addr_pool_destroy(wasi_ctx->addr_pool);
+        wasm_runtime_free(wasi_ctx->addr_pool);
+    }
+    if (wasi_ctx->argv_buf)
+        wasm_runtime_free(wasi_ctx->argv_buf);
+    if (wasi_ctx->argv_list)
+        wasm_runtime_free(wasi_ctx->argv_list);
+    if (wasi_ctx->env_buf)
+        wasm_runtime_free(wasi_ctx->env_buf);
+    if (wasi_ctx->env_list)
+        wasm_runtime_free(wasi_ctx->env_list);
+    if (wasi_ctx->ns_lookup_buf)
+        wasm_runtime_free(wasi_ctx->ns_lookup_buf);
+    if (wasi_ctx->ns_lookup_list)
+        wasm_runtime_free(wasi_ctx->ns_lookup_list);
+
+    wasm_runtime_free(wasi_ctx);
+    module->wasi_ctx = NULL;
+}
+
 #endif
 
 bool wasm_runtime_init_env()
@@ -263,14 +313,30 @@ bool wasm_runtime_init_env()
     if (platform_init() != 0)
         goto fail;
 
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    if (!wasm_interp_signal_init())
+        goto fail;
+#endif
+
+    // 本地函数注册时需要得到签名的类型编号, 先于wasm_native_init
+    if (!wasm_type_registry_init())
+        goto fail;
+
     if (wasm_native_init() == false)
     {
         goto fail;
     }
 
+    // 预解码指令依赖解释器的处理地址表
+    wasm_interp_init();
+
     return true;
 
 fail:
+    wasm_type_registry_destroy();
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    wasm_interp_signal_destroy();
+#endif
     platform_destroy();
 
     return false;
@@ -3,18 +3,46 @@
 
 #include "instantiate_common.h"
 
+//计算全局变量的总数等不依赖实例的信息
+bool
+globals_compile(WASMModule *module);
+
 //实例化全局变量
 bool
 globals_instantiate(WASMModule *module);
 
+//将全局变量恢复为初始值
+bool
+globals_reset(WASMModule *module);
+
+//计算内存的总数等不依赖实例的信息
+bool
+memories_compile(WASMModule *module);
+
 //实例化内存
 bool
 memories_instantiate(WASMModule *module);
 
+//清空实例的线性内存并恢复初始大小, 再重新复制数据段
+bool
+memories_reset(WASMModule *module);
+
+//计算表的总数等不依赖实例的信息
+bool
+tables_compile(WASMModule *module);
+
 //实例化表
 bool
 tables_instantiate(WASMModule *module);
 
+//用元素段重新填充已分配的表
+bool
+tables_reset(WASMModule *module);
+
+//表的元素个数, 可能增长的表按最大大小分配
+uint32
+table_data_size(const WASMTable *table);
+
 //实例化导出
 bool 
 export_instantiate(WASMModule *module);
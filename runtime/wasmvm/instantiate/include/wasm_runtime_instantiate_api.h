@@ -3,7 +3,67 @@
 
 #include "wasm_type.h"
 
+//编译模块: 链接导入, 生成导出表和JIT代码, 之后模块只读, 可供多个实例共享
+bool
+wasm_module_compile(WASMModule *module);
+
+//编译模块并在模块自身上分配实例状态, 模块即为唯一的实例
 bool
 wasm_instantiate(WASMModule *module, uint32 stack_size, uint32 execution_stack_size);
 
+//在已编译的模块上创建实例, 实例只持有线性内存, 全局变量, 表和WASI等状态,
+//可在多个线程中同时调用, 实例需在模块销毁前用wasm_instance_destroy销毁
+WASMModule *
+wasm_instance_create(WASMModule *module, uint32 stack_size, uint32 execution_stack_size);
+
+//将实例的线性内存, 全局变量和表恢复到刚创建时的状态, 不重新分配
+bool
+wasm_instance_reset(WASMModule *instance);
+
+//将实例的全局变量, 表和线性内存写入快照文件, 通常在执行_initialize和start函数之后调用
+bool
+wasm_instance_snapshot_save(WASMModule *instance, const char *filename);
+
+//用快照文件覆盖刚实例化的实例的状态, 之后无需再执行初始化函数,
+//WASI上下文不在快照中, 仍需单独初始化
+bool
+wasm_instance_snapshot_restore(WASMModule *instance, const char *filename);
+
+typedef struct WASMInstancePool WASMInstancePool;
+
+//在已编译的模块上预先创建slot_count个实例, 每个实例带有执行环境
+WASMInstancePool *
+wasm_instance_pool_create(WASMModule *module, uint32 slot_count,
+                          uint32 stack_size, uint32 execution_stack_size);
+
+//从池中取出一个空闲实例, 没有空闲实例时返回NULL, 可在多个线程中同时调用
+WASMModule *
+wasm_instance_pool_acquire(WASMInstancePool *pool);
+
+//重置实例并放回池中, 重置失败的实例被销毁后重新创建
+void
+wasm_instance_pool_release(WASMInstancePool *pool, WASMModule *instance);
+
+//销毁池及其中的实例, 所有实例需已放回
+void
+wasm_instance_pool_destroy(WASMInstancePool *pool);
+
+#if WASM_ENABLE_AOT != 0
+//编译模块时加载wasmc生成的本地代码文件, 需在wasm_module_compile之前调用,
+//文件需在模块编译前保持有效, 文件不对应该模块时仍按原方式执行
+bool
+wasm_module_set_aot_file(WASMModule *module, const char *file_name);
+#endif
+
+#if WASM_ENABLE_JIT != 0
+//编译整个模块并把本地代码写入文件, 供启用了AOT的运行时加载, 之后模块不能再实例化
+bool
+wasm_module_compile_to_file(WASMModule *module, const char *file_name);
+
+//设置JIT代码缓存目录, 之后编译的模块先按模块内容查找缓存的本地代码,
+//未命中时编译整个模块并写入缓存, dir为NULL时关闭缓存
+bool
+wasm_jit_set_cache_dir(const char *dir);
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "instantiate.h"
+#include "wasm_runtime_instantiate_api.h"
+#include "wasm_exec_env.h"
+
+struct WASMInstancePool
+{
+    WASMModule *module;
+    uint32 value_stack_size;
+    uint32 execution_stack_size;
+
+    // 空闲实例按栈存放, 最近放回的实例最先取出, 其页面更可能仍在缓存中
+    WASMModule **free_instances;
+    uint32 free_count;
+
+    // 池中的实例总数, 重新创建失败的实例不再计入
+    uint32 instance_count;
+
+    korp_mutex lock;
+};
+
+// 创建池中的实例, 线性内存, 表, 全局变量和执行环境在实例的整个生命周期中复用
+static WASMModule *
+pool_instance_create(WASMInstancePool *pool)
+{
+    WASMModule *instance;
+
+    if (!(instance = wasm_instance_create(pool->module, pool->value_stack_size,
+                                          pool->execution_stack_size)))
+    {
+        return NULL;
+    }
+
+    if (!(instance->exec_env = wasm_exec_env_create(instance)))
+    {
+        wasm_instance_destroy(instance);
+        return NULL;
+    }
+
+    return instance;
+}
+
+static void
+pool_instance_destroy(WASMModule *instance)
+{
+    wasm_exec_env_destroy(instance->exec_env);
+    instance->exec_env = NULL;
+    wasm_instance_destroy(instance);
+}
+
+WASMInstancePool *
+wasm_instance_pool_create(WASMModule *module, uint32 slot_count,
+                          uint32 value_stack_size, uint32 execution_stack_size)
+{
+    WASMInstancePool *pool;
+    WASMModule *instance;
+    uint32 i;
+
+    if (slot_count == 0)
+    {
+        LOG_ERROR("Create instance pool fail: slot count is zero.\n");
+        return NULL;
+    }
+
+    if (!(pool = wasm_runtime_malloc(sizeof(WASMInstancePool))))
+    {
+        return NULL;
+    }
+
+    memset(pool, 0, sizeof(WASMInstancePool));
+    pool->module = module;
+    pool->value_stack_size = value_stack_size;
+    pool->execution_stack_size = execution_stack_size;
+
+    if (os_mutex_init(&pool->lock) != 0)
+    {
+        wasm_runtime_free(pool);
+        return NULL;
+    }
+
+    if (!(pool->free_instances = wasm_runtime_malloc(sizeof(WASMModule *) * (uint64)slot_count)))
+    {
+        goto fail;
+    }
+
+    for (i = 0; i < slot_count; i++)
+    {
+        if (!(instance = pool_instance_create(pool)))
+        {
+            goto fail;
+        }
+        pool->free_instances[pool->free_count++] = instance;
+        pool->instance_count++;
+    }
+
+    LOG_VERBOSE("Create instance pool success.\n");
+    return pool;
+
+fail:
+    LOG_VERBOSE("Create instance pool fail.\n");
+    wasm_instance_pool_destroy(pool);
+    return NULL;
+}
+
+WASMModule *
+wasm_instance_pool_acquire(WASMInstancePool *pool)
+{
+    WASMModule *instance = NULL;
+
+    os_mutex_lock(&pool->lock);
+    if (pool->free_count > 0)
+    {
+        instance = pool->free_instances[--pool->free_count];
+    }
+    os_mutex_unlock(&pool->lock);
+
+    return instance;
+}
+
+void wasm_instance_pool_release(WASMInstancePool *pool, WASMModule *instance)
+{
+    WASMExecEnv *exec_env = instance->exec_env;
+
+    // 重置在锁外进行, 其他线程可以同时取出和放回实例
+    exec_env->exec_stack.top = exec_env->exec_stack.bottom;
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    exec_env->jmpbuf = NULL;
+#endif
+
+    if (!wasm_instance_reset(instance))
+    {
+        LOG_WARNING("reset pooled instance failed, create a new one.\n");
+        pool_instance_destroy(instance);
+        instance = pool_instance_create(pool);
+    }
+
+    os_mutex_lock(&pool->lock);
+    if (instance)
+    {
+        pool->free_instances[pool->free_count++] = instance;
+    }
+    else
+    {
+        pool->instance_count--;
+    }
+    os_mutex_unlock(&pool->lock);
+}
+
+void wasm_instance_pool_destroy(WASMInstancePool *pool)
+{
+    uint32 i;
+
+    if (!pool)
+        return;
+
+    if (pool->free_count != pool->instance_count)
+    {
+        LOG_WARNING("destroy instance pool with %u instances in use.\n",
+                    pool->instance_count - pool->free_count);
+    }
+
+    for (i = 0; i < pool->free_count; i++)
+    {
+        pool_instance_destroy(pool->free_instances[i]);
+    }
+
+    if (pool->free_instances)
+    {
+        wasm_runtime_free(pool->free_instances);
+    }
+
+    os_mutex_destroy(&pool->lock);
+    wasm_runtime_free(pool);
+}
@@ -1,24 +1,42 @@
 #include "instantiate.h"
 #include "wasm_runtime_instantiate_api.h"
+#include "wasm_runtime_init_api.h"
 
 #if WASM_ENABLE_JIT != 0
 #include "wasm_jit_init.h"
 #endif
+#if WASM_ENABLE_AOT != 0
+#include "wasm_aot_loader.h"
+#endif
 
-bool wasm_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execution_stack_size)
+// 链接导入并计算不依赖实例的信息, 之后才能生成或加载本地代码
+static bool
+module_info_compile(WASMModule *module)
 {
-    module->module_stage = Instantiate;
+    module->module_stage = Compile;
+
+    return globals_compile(module) && memories_compile(module) && tables_compile(module)
+           && export_instantiate(module) && functions_instantiate(module);
+}
 
-    if (!globals_instantiate(module) || !memories_instantiate(module) || !tables_instantiate(module) || !export_instantiate(module) || !functions_instantiate(module))
+bool wasm_module_compile(WASMModule *module)
+{
+    if (module->module_stage >= Compile)
+        return true;
+
+    if (!module_info_compile(module))
     {
         goto fail;
     }
 
-    if (value_stack_size == 0)
-        value_stack_size = DEFAULT_VALUE_STACK_SIZE;
-
-    module->default_value_stack_size = value_stack_size;
-    module->default_execution_stack_size = execution_stack_size;
+#if WASM_ENABLE_AOT != 0
+    // 预编译文件与模块不对应时退回到JIT或解释执行
+    if (module->aot_file && wasm_aot_load(module, module->aot_file))
+    {
+        LOG_VERBOSE("Compile success.\n");
+        return true;
+    }
+#endif
 
 #if WASM_ENABLE_JIT != 0
     if (!init_llvm_jit_functions_stage1(module))
@@ -26,6 +44,13 @@ bool wasm_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execut
         return false;
     }
 
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 先由解释器执行, LLVM IR的生成和热点函数的编译都在后台线程中进行
+    if (!wasm_jit_tier_up_start(module))
+    {
+        return false;
+    }
+#else
     if (!init_llvm_jit_functions_stage2(module))
     {
         return false;
@@ -36,6 +61,81 @@ bool wasm_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execut
         return false;
     }
 #endif
+#endif
+
+    LOG_VERBOSE("Compile success.\n");
+    return true;
+
+fail:
+    LOG_VERBOSE("Compile fail.\n");
+    return false;
+}
+
+#if WASM_ENABLE_AOT != 0
+bool wasm_module_set_aot_file(WASMModule *module, const char *file_name)
+{
+    if (module->module_stage >= Compile)
+    {
+        LOG_ERROR("Set aot file fail: module is already compiled.\n");
+        return false;
+    }
+
+    module->aot_file = file_name;
+    return true;
+}
+#endif
+
+#if WASM_ENABLE_JIT != 0
+bool wasm_module_compile_to_file(WASMModule *module, const char *file_name)
+{
+    if (module->module_stage >= Compile)
+    {
+        LOG_ERROR("Compile to file fail: module is already compiled.\n");
+        return false;
+    }
+
+    if (!module_info_compile(module) || !init_llvm_jit_functions_stage1(module)
+        || !wasm_jit_compile_to_file(module, file_name))
+    {
+        LOG_VERBOSE("Compile to file fail.\n");
+        return false;
+    }
+
+    LOG_VERBOSE("Compile to file success.\n");
+    return true;
+}
+#endif
+
+// 分配线性内存, 全局变量和表, 并用数据段和元素段初始化
+static bool
+instance_state_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execution_stack_size)
+{
+    module->module_stage = Instantiate;
+
+    if (!globals_instantiate(module) || !memories_instantiate(module) || !tables_instantiate(module))
+    {
+        return false;
+    }
+
+    if (value_stack_size == 0)
+        value_stack_size = DEFAULT_VALUE_STACK_SIZE;
+
+    module->default_value_stack_size = value_stack_size;
+    module->default_execution_stack_size = execution_stack_size;
+    return true;
+}
+
+bool wasm_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execution_stack_size)
+{
+    if (!wasm_module_compile(module))
+    {
+        goto fail;
+    }
+
+    if (!instance_state_instantiate(module, value_stack_size, execution_stack_size))
+    {
+        goto fail;
+    }
 
     LOG_VERBOSE("Instantiate success.\n");
     return true;
@@ -43,4 +143,85 @@ bool wasm_instantiate(WASMModule *module, uint32 value_stack_size, uint32 execut
 fail:
     LOG_VERBOSE("Instantiate fail.\n");
     return false;
-}
\ No newline at end of file
+}
+
+WASMModule *
+wasm_instance_create(WASMModule *module, uint32 value_stack_size, uint32 execution_stack_size)
+{
+    WASMModule *instance;
+    uint64 total_size;
+
+    // 已实例化的模块的线性内存和表可能已被修改, 不能再作为模板
+    if (module->module_stage != Compile)
+    {
+        LOG_ERROR("Create instance fail: module is not compiled or already instantiated.\n");
+        return NULL;
+    }
+
+    if (!(instance = wasm_runtime_malloc(sizeof(WASMModule))))
+    {
+        return NULL;
+    }
+
+    // 类型, 函数, 预解码指令, 导出和JIT代码等只读部分直接引用已编译模块,
+    // 锁和后台编译队列不在WASMModule中, 实例经shared与已编译模块共用
+    memcpy(instance, module, sizeof(WASMModule));
+    instance->compiled_module = module;
+    instance->cur_exception[0] = '\0';
+    instance->wasi_ctx = NULL;
+    instance->global_data = NULL;
+    instance->tables = NULL;
+    instance->exec_env = NULL;
+
+    // 表的描述在实例中各有一份, 元素由tables_instantiate分配
+    total_size = sizeof(WASMTable) * (uint64)module->table_count;
+    if (total_size > 0)
+    {
+        if (!(instance->tables = wasm_runtime_malloc(total_size)))
+        {
+            goto fail;
+        }
+        memcpy(instance->tables, module->tables, total_size);
+    }
+
+    if (!instance_state_instantiate(instance, value_stack_size, execution_stack_size))
+    {
+        goto fail;
+    }
+
+    LOG_VERBOSE("Create instance success.\n");
+    return instance;
+
+fail:
+    LOG_VERBOSE("Create instance fail.\n");
+    wasm_instance_destroy(instance);
+    return NULL;
+}
+
+bool wasm_instance_reset(WASMModule *instance)
+{
+    if (!instance->compiled_module)
+    {
+        LOG_ERROR("Reset instance fail: not created by wasm_instance_create.\n");
+        return false;
+    }
+
+#if WASM_ENABLE_WASI != 0
+    // WASI上下文在每次执行前重新初始化
+    wasm_runtime_wasi_destroy(instance);
+#endif
+
+    instance->cur_exception[0] = '\0';
+
+    if (!globals_reset(instance) || !memories_reset(instance) || !tables_reset(instance))
+    {
+        goto fail;
+    }
+
+    LOG_VERBOSE("Reset instance success.\n");
+    return true;
+
+fail:
+    LOG_VERBOSE("Reset instance fail.\n");
+    return false;
+}
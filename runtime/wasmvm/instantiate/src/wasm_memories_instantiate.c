@@ -2,49 +2,32 @@
 
 bool memory_instantiate(WASMMemory *memory)
 {
-    uint32 num_bytes_per_page, init_page_count;
-    uint64 memory_data_size;
-
-    num_bytes_per_page = memory->num_bytes_per_page;
-    init_page_count = memory->cur_page_count;
-
-    memory_data_size = (uint64)num_bytes_per_page * init_page_count;
-    if (memory_data_size > 0 && !(memory->memory_data = wasm_runtime_malloc(memory_data_size)))
+    if (!wasm_memory_data_alloc(memory))
     {
         goto fail;
     }
 
-    memset(memory->memory_data, 0, memory_data_size);
-
-    memory->memory_data_size = (uint32)memory_data_size;
-    memory->memory_data_end = memory->memory_data + (uint32)memory_data_size;
-
     return true;
 
 fail:
     return false;
 }
 
-bool memories_instantiate(WASMModule *module)
+bool memories_compile(WASMModule *module)
 {
-    uint32 i, base_offset, length,
-        memory_count = module->import_memory_count + module->memory_count;
-    WASMMemory *memory, *memories;
-    WASMDataSeg *data_seg;
-    WASMGlobal *globals;
-
-    globals = module->globals;
-    memory = memories = module->memories;
+    module->memory_count += module->import_memory_count;
+    return true;
+}
 
-    for (i = 0; i < memory_count; i++, memory++)
-    {
-        if (!memory_instantiate(memory))
-        {
-            goto fail;
-        }
-    }
+// 用数据段初始化线性内存
+static bool
+memories_init_data(WASMModule *module)
+{
+    uint32 i, base_offset, length;
+    WASMMemory *memory, *memories = module->memories;
+    WASMDataSeg *data_seg;
+    WASMGlobal *globals = module->globals;
 
-    module->memory_count = memory_count;
     data_seg = module->data_segments;
 
     for (i = 0; i < module->data_seg_count; i++, data_seg++)
@@ -65,13 +48,60 @@ bool memories_instantiate(WASMModule *module)
 
         length = data_seg->data_length;
 
+        // 实例化不在wasm调用中进行, 越界的数据段需要显式检查
+        if ((uint64)base_offset + length > memory->memory_data_size)
+        {
+            wasm_set_exception(module, "data segment does not fit");
+            return false;
+        }
+
         memcpy(memory_data + base_offset, data_seg->data, length);
     }
 
+    return true;
+}
+
+bool memories_instantiate(WASMModule *module)
+{
+    uint32 i, memory_count = module->memory_count;
+    WASMMemory *memory = module->memories;
+
+    for (i = 0; i < memory_count; i++, memory++)
+    {
+        memory->huge_page_mode = module->memory_huge_page_mode;
+        if (!memory_instantiate(memory))
+        {
+            goto fail;
+        }
+    }
+
+    if (!memories_init_data(module))
+    {
+        return false;
+    }
+
     LOG_VERBOSE("Instantiate memory success.\n");
     return true;
 fail:
     LOG_VERBOSE("Instantiate memory fail.\n");
     wasm_set_exception(module, "Instantiate memory fail.\n");
     return false;
-}
\ No newline at end of file
+}
+
+bool memories_reset(WASMModule *module)
+{
+    uint32 i, memory_count = module->memory_count;
+    WASMMemory *memory = module->memories;
+    WASMMemory *init_memory = module->compiled_module->memories;
+
+    for (i = 0; i < memory_count; i++, memory++, init_memory++)
+    {
+        if (!wasm_memory_data_reset(memory, init_memory))
+        {
+            wasm_set_exception(module, "Reset memory fail.\n");
+            return false;
+        }
+    }
+
+    return memories_init_data(module);
+}
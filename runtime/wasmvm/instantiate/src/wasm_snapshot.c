@@ -0,0 +1,268 @@
+#include "instantiate.h"
+#include "wasm_runtime_instantiate_api.h"
+
+// 快照文件依次为文件头, 全局数据, 各表的元素和线性内存映像,
+// 内存映像按wasm页对齐, 恢复时可以直接映射到线性内存
+#define SNAPSHOT_MAGIC 0x504e5357
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_MEMORY_ALIGN 65536
+#define SNAPSHOT_PAGE_SIZE 4096
+
+typedef struct WASMSnapshotHeader
+{
+    uint32 magic;
+    uint32 version;
+
+    // 模块文件内容的哈希和模块的结构, 恢复时必须与实例一致
+    uint64 module_hash;
+    uint32 type_count;
+    uint32 function_count;
+    uint32 global_count;
+    uint32 global_data_size;
+    uint32 table_count;
+    uint32 table_elem_count;
+    uint32 memory_count;
+
+    // 初始化后的线性内存
+    uint32 num_bytes_per_page;
+    uint32 cur_page_count;
+    uint32 memory_data_size;
+    uint64 memory_offset;
+} WASMSnapshotHeader;
+
+#define SNAPSHOT_MODULE_INFO_SIZE offsetof(WASMSnapshotHeader, num_bytes_per_page)
+
+static void
+snapshot_header_init(const WASMModule *instance, WASMSnapshotHeader *header)
+{
+    const WASMMemory *memory = instance->memories;
+    const WASMGlobal *global = instance->globals;
+    const WASMTable *table = instance->tables;
+    uint64 data_size;
+    uint32 i;
+
+    memset(header, 0, sizeof(WASMSnapshotHeader));
+    header->magic = SNAPSHOT_MAGIC;
+    header->version = SNAPSHOT_VERSION;
+    header->module_hash = instance->module_hash;
+    header->type_count = instance->type_count;
+    header->function_count = instance->function_count;
+    header->global_count = instance->global_count;
+    header->table_count = instance->table_count;
+    header->memory_count = instance->memory_count;
+
+    for (i = 0; i < instance->global_count; i++, global++)
+    {
+        header->global_data_size += wasm_value_type_size(global->type);
+    }
+
+    for (i = 0; i < instance->table_count; i++, table++)
+    {
+        header->table_elem_count += table_data_size(table);
+    }
+
+    if (instance->memory_count > 0)
+    {
+        header->num_bytes_per_page = memory->num_bytes_per_page;
+        header->cur_page_count = memory->cur_page_count;
+        header->memory_data_size = memory->memory_data_size;
+    }
+
+    data_size = sizeof(WASMSnapshotHeader) + (uint64)header->global_data_size
+                + sizeof(uint32) * (uint64)header->table_elem_count;
+    header->memory_offset = (data_size + SNAPSHOT_MEMORY_ALIGN - 1)
+                            & ~(uint64)(SNAPSHOT_MEMORY_ALIGN - 1);
+}
+
+static bool
+page_is_zero(const uint8 *page, uint32 size)
+{
+    uint32 i;
+
+    for (i = 0; i < size; i++)
+    {
+        if (page[i])
+            return false;
+    }
+    return true;
+}
+
+// 全零的页面跳过不写, 在文件中留下空洞
+static bool
+snapshot_write_memory(FILE *file, const WASMSnapshotHeader *header, const uint8 *memory_data)
+{
+    uint32 offset, size;
+
+    for (offset = 0; offset < header->memory_data_size; offset += size)
+    {
+        size = header->memory_data_size - offset;
+        if (size > SNAPSHOT_PAGE_SIZE)
+            size = SNAPSHOT_PAGE_SIZE;
+
+        // 最后一页总是写入, 保证文件长度覆盖整个内存映像
+        if (offset + size < header->memory_data_size
+            && page_is_zero(memory_data + offset, size))
+            continue;
+
+        if (fseek(file, (long)(header->memory_offset + offset), SEEK_SET) != 0
+            || fwrite(memory_data + offset, 1, size, file) != size)
+            return false;
+    }
+    return true;
+}
+
+bool wasm_instance_snapshot_save(WASMModule *instance, const char *filename)
+{
+    WASMSnapshotHeader header;
+    WASMTable *table = instance->tables;
+    FILE *file;
+    uint32 i, elem_count;
+
+    if (instance->module_stage < Instantiate)
+    {
+        wasm_set_exception(instance, "save snapshot failed: module not instantiated");
+        return false;
+    }
+
+    snapshot_header_init(instance, &header);
+
+    if (!(file = fopen(filename, "wb")))
+    {
+        wasm_set_exception(instance, "save snapshot failed: open snapshot file failed");
+        return false;
+    }
+
+    if (fwrite(&header, sizeof(WASMSnapshotHeader), 1, file) != 1)
+    {
+        goto fail;
+    }
+
+    if (header.global_data_size > 0
+        && fwrite(instance->global_data, header.global_data_size, 1, file) != 1)
+    {
+        goto fail;
+    }
+
+    for (i = 0; i < instance->table_count; i++, table++)
+    {
+        elem_count = table_data_size(table);
+        if (elem_count > 0
+            && fwrite(table->table_data, sizeof(uint32), elem_count, file) != elem_count)
+        {
+            goto fail;
+        }
+    }
+
+    if (!snapshot_write_memory(file, &header, instance->memories->memory_data))
+    {
+        goto fail;
+    }
+
+    if (fclose(file) != 0)
+    {
+        file = NULL;
+        goto fail;
+    }
+
+    LOG_VERBOSE("Save snapshot success.\n");
+    return true;
+
+fail:
+    if (file)
+        fclose(file);
+    remove(filename);
+    wasm_set_exception(instance, "save snapshot failed: write snapshot file failed");
+    return false;
+}
+
+bool wasm_instance_snapshot_restore(WASMModule *instance, const char *filename)
+{
+    WASMSnapshotHeader header;
+    const WASMSnapshotHeader *saved;
+    WASMMemory *memory = instance->memories;
+    WASMTable *table = instance->tables;
+    const uint8 *buf, *p;
+    uint32 size, i, elem_count;
+
+    if (instance->module_stage < Instantiate)
+    {
+        wasm_set_exception(instance, "restore snapshot failed: module not instantiated");
+        return false;
+    }
+
+    if (!(buf = platform_map_file(filename, &size)))
+    {
+        wasm_set_exception(instance, "restore snapshot failed: open snapshot file failed");
+        return false;
+    }
+
+    snapshot_header_init(instance, &header);
+    saved = (const WASMSnapshotHeader *)buf;
+
+    if (size < sizeof(WASMSnapshotHeader)
+        || memcmp(saved, &header, SNAPSHOT_MODULE_INFO_SIZE) != 0)
+    {
+        wasm_set_exception(instance, "restore snapshot failed: snapshot does not match the module");
+        goto fail;
+    }
+
+    // 表和全局数据的大小已与实例比较过, 只需检查内存映像的位置
+    if (saved->memory_offset != header.memory_offset
+        || saved->memory_offset + saved->memory_data_size > size
+        || (uint64)saved->num_bytes_per_page * saved->cur_page_count != saved->memory_data_size)
+    {
+        wasm_set_exception(instance, "restore snapshot failed: snapshot file is corrupted");
+        goto fail;
+    }
+
+    p = buf + sizeof(WASMSnapshotHeader);
+    if (header.global_data_size > 0)
+    {
+        memcpy(instance->global_data, p, header.global_data_size);
+        p += header.global_data_size;
+    }
+
+    for (i = 0; i < instance->table_count; i++, table++)
+    {
+        elem_count = table_data_size(table);
+        memcpy(table->table_data, p, sizeof(uint32) * elem_count);
+        p += sizeof(uint32) * elem_count;
+    }
+
+    if (instance->memory_count > 0)
+    {
+        // 初始化期间memory.grow增加的页面, 需先在实例的预留区中提交
+        if (saved->num_bytes_per_page != memory->num_bytes_per_page
+            || saved->cur_page_count < memory->cur_page_count
+            || !wasm_enlarge_memory(instance, saved->cur_page_count - memory->cur_page_count))
+        {
+            wasm_set_exception(instance, "restore snapshot failed: memory size mismatch");
+            goto fail;
+        }
+
+        // 普通页面直接以写时复制方式映射内存映像, 未写入的页面由各实例共享;
+        // 大页的映射不能被部分替换, 复制内存映像
+        if (memory->memory_data_size > 0)
+        {
+            if (memory->huge_page_mode == WASM_HUGE_PAGE_NONE
+                && platform_map_file_fixed(memory->memory_data, filename,
+                                           saved->memory_offset, memory->memory_data_size) == 0)
+            {
+                memory->image_mapped = true;
+            }
+            else
+            {
+                memcpy(memory->memory_data, buf + saved->memory_offset,
+                       memory->memory_data_size);
+            }
+        }
+    }
+
+    platform_unmap_file(buf, size);
+    LOG_VERBOSE("Restore snapshot success.\n");
+    return true;
+
+fail:
+    platform_unmap_file(buf, size);
+    return false;
+}
@@ -1,22 +1,13 @@
 #include "instantiate.h"
 
-bool tables_instantiate(WASMModule *module)
+bool tables_compile(WASMModule *module)
 {
-    uint32 i, length, default_max_size, cur_size, max_size;
+    uint32 i, default_max_size, cur_size, max_size;
     uint32 table_count = module->import_table_count + module->table_count;
-    uint64 total_size = 0;
-    WASMTable *table, *tables;
-    WASMElement *elements, *element;
-    uint32 *table_data;
-    WASMGlobal *globals;
-
-    globals = module->globals;
-    table = tables = module->tables;
-    elements = module->elements;
+    WASMTable *table = module->tables;
 
     for (i = 0; i < table_count; i++, table++)
     {
-        total_size = 0;
         cur_size = table->cur_size;
         max_size = table->max_size;
         default_max_size = cur_size * 2 > TABLE_MAX_SIZE ? cur_size * 2 : TABLE_MAX_SIZE;
@@ -30,23 +21,36 @@ bool tables_instantiate(WASMModule *module)
             max_size = max_size < default_max_size ? max_size : default_max_size;
         }
 
-        total_size = sizeof(uint32) * (table->possible_grow
-                                           ? max_size
-                                           : cur_size);
+        table->max_size = max_size;
+    }
 
-        if (!(table_data = wasm_runtime_malloc(total_size)))
-        {
-            goto fail;
-        }
+    module->table_count = table_count;
+    return true;
+}
 
-        memset(table_data, -1, (uint32)total_size);
+uint32 table_data_size(const WASMTable *table)
+{
+    return table->possible_grow ? table->max_size : table->cur_size;
+}
 
-        // 赋值
-        table->max_size = max_size;
-        table->table_data = table_data;
+bool tables_reset(WASMModule *module)
+{
+    uint32 i, length, base_offset;
+    uint32 table_count = module->table_count;
+    WASMTable *table, *tables;
+    WASMElement *element;
+    uint32 *table_data;
+    WASMGlobal *globals;
+
+    globals = module->globals;
+    table = tables = module->tables;
+
+    for (i = 0; i < table_count; i++, table++)
+    {
+        memset(table->table_data, -1, sizeof(uint32) * table_data_size(table));
     }
 
-    element = elements;
+    element = module->elements;
 
     for (i = 0; i < module->element_count; i++, element++)
     {
@@ -54,37 +58,66 @@ bool tables_instantiate(WASMModule *module)
         length = element->function_count;
         table_data = table->table_data;
 
+        // 元素段由各实例共享, 不能改写其中的偏移
         if (element->base_offset.init_expr_type == INIT_EXPR_TYPE_GET_GLOBAL)
         {
-            element->base_offset.u.i32 =
-                globals[element->base_offset.u.global_index]
-                    .initial_value.i32;
+            base_offset = (uint32)globals[element->base_offset.u.global_index]
+                              .initial_value.i32;
+        }
+        else
+        {
+            base_offset = (uint32)element->base_offset.u.i32;
         }
 
-        if ((uint32)element->base_offset.u.i32 > table->cur_size)
+        if (base_offset > table->cur_size)
         {
             LOG_DEBUG("base_offset(%d) > table->cur_size(%d)",
-                      element->base_offset.u.i32, table->cur_size);
+                      base_offset, table->cur_size);
             wasm_set_exception(module,
                                "elements segment does not fit");
-            goto fail;
+            return false;
         }
 
-        if ((uint32)element->base_offset.u.i32 + length > table->cur_size)
+        if (base_offset + length > table->cur_size)
         {
             LOG_DEBUG("base_offset(%d) + length(%d)> table->cur_size(%d)",
-                      element->base_offset.u.i32, length, table->cur_size);
+                      base_offset, length, table->cur_size);
             wasm_set_exception(module,
                                "elements segment does not fit");
-            goto fail;
+            return false;
         }
 
         memcpy(
-            table_data + element->base_offset.u.i32,
+            table_data + base_offset,
             element->func_indexes, (uint32)(length * sizeof(uint32)));
     }
 
-    module->table_count = table_count;
+    return true;
+}
+
+bool tables_instantiate(WASMModule *module)
+{
+    uint32 i, table_count = module->table_count;
+    WASMTable *table = module->tables;
+
+    for (i = 0; i < table_count; i++, table++)
+    {
+        table->table_data = NULL;
+    }
+
+    table = module->tables;
+    for (i = 0; i < table_count; i++, table++)
+    {
+        if (!(table->table_data = wasm_runtime_malloc(sizeof(uint32) * (uint64)table_data_size(table))))
+        {
+            goto fail;
+        }
+    }
+
+    if (!tables_reset(module))
+    {
+        goto fail;
+    }
 
     LOG_VERBOSE("Instantiate table success.\n");
     return true;
@@ -92,4 +125,4 @@ fail:
     LOG_VERBOSE("Instantiate table fail.\n");
     wasm_set_exception(module, "Instantiate table fail.\n");
     return false;
-}
\ No newline at end of file
+}
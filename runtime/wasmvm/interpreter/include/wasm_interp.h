@@ -5,18 +5,39 @@
 #include "wasm_exception.h"
 #include "wasm_exec_env.h"
 
+// 栈帧与数值栈连续存放, 依次为参数, 局部变量, 栈帧头部和操作数栈,
+// 头部只记录返回时需要恢复的调用者状态, 调用者的frame_sp即被调用者的frame_lp
 typedef struct WASMFuncFrame
 {
-    WASMFunction *function;
+    // 调用者的预解码指令地址, 为NULL时返回到wasm_interp_call_wasm
+    uint64 *prev_ip;
+    uint32 *prev_lp;
+} WASMFuncFrame;
 
-    uint8 *ip;
+// 栈帧头部占用的4字节单元数
+#define WASM_FRAME_HEADER_CELLS (sizeof(WASMFuncFrame) / sizeof(uint32))
 
-    uint32 *sp;
-    uint32 *lp;
+// 解释器各指令的处理地址, 预解码指令中的每条指令都以其中之一开头
+extern const void **wasm_interp_handle_table;
 
-    WASMBranchTable *cur_branch_table;
+#if WASM_ENABLE_SLOT_INTERP != 0
+// 槽位模式下各指令的处理地址, 以WASM操作码为索引, 为空时使用栈式处理
+extern const void **wasm_interp_slot_handle_table;
+#endif
 
-} WASMFuncFrame;
+#if WASM_ENABLE_TOS_CACHE != 0
+// 栈顶缓存的处理地址, 以[操作码][进入状态][离开状态]为索引, 状态为1表示栈顶的i32缓存在寄存器中
+extern const void *(*wasm_interp_tos_handle_table)[2][2];
+#endif
+
+void wasm_interp_init();
+
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+// 为当前线程安装信号处理, 线性内存保护区内的访问故障转换为越界陷入
+bool wasm_interp_signal_init();
+
+void wasm_interp_signal_destroy();
+#endif
 
 void wasm_interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
                            WASMFunction *function, uint32 argc,
@@ -2,10 +2,40 @@
 #include "wasm_opcode.h"
 #include "wasm_native.h"
 #include "wasm_memory.h"
-#include "wasm_fast_readleb.h"
+#include "wasm_runtime_validator_api.h"
+#if WASM_ENABLE_TIERED_JIT != 0
+#include "wasm_jit_init.h"
+#endif
 
 #define WASM_ENABLE_DEBUG_INTERP 0
 
+#if WASM_ENABLE_OPCODE_PROFILE != 0
+// 相邻执行的两条指令的次数, 以各自处理对应的操作码为索引
+static uint64 opcode_pairs[WASM_INSTRUCTION_NUM][WASM_INSTRUCTION_NUM];
+static uint8 last_profile_opcode;
+
+// 退出时写出统计结果, 供build-scripts/gen_superinstr.py选择超级指令
+static void
+dump_opcode_profile()
+{
+    FILE *profile = fopen("opcode_pairs.log", "w");
+    uint32 i, j;
+
+    if (!profile)
+        return;
+
+    for (i = 0; i < WASM_INSTRUCTION_NUM; i++)
+    {
+        for (j = 0; j < WASM_INSTRUCTION_NUM; j++)
+        {
+            if (opcode_pairs[i][j])
+                fprintf(profile, "0x%02x 0x%02x %llu\n", i, j, (unsigned long long)opcode_pairs[i][j]);
+        }
+    }
+    fclose(profile);
+}
+#endif
+
 #if WASM_ENABLE_DEBUG_INTERP != 0
 
 static FILE *call_info;
@@ -91,18 +121,34 @@ void print_opcode(uint8 opcode, uint32 fidx)
 #define GET_I32_FROM_ADDR(addr) (*(int32 *)(addr))
 #define GET_F32_FROM_ADDR(addr) (*(float32 *)addr)
 
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+// 有效地址总在线性内存的保留区内, 越界访问由保护页触发信号后转换为陷入
 #define CHECK_MEMORY_OVERFLOW(bytes)                    \
     do                                                  \
     {                                                   \
         uint64 offset1 = (uint64)offset + (uint64)addr; \
-        maddr = memory->memory_data + offset1;          \
+        maddr = memory_data + offset1;                  \
+    } while (0)
+#else
+#define CHECK_MEMORY_OVERFLOW(bytes)                           \
+    do                                                         \
+    {                                                          \
+        uint64 offset1 = (uint64)offset + (uint64)addr;        \
+        if (offset1 + bytes > LINEAR_MEMORY->memory_data_size) \
+            HANDLE_OUT_OF_BOUNDS();                            \
+        maddr = memory_data + offset1;                         \
     } while (0)
+#endif
 
-#define CHECK_BULK_MEMORY_OVERFLOW(start, bytes, maddr) \
-    do                                                  \
-    {                                                   \
-        uint64 offset1 = (uint32)(start);               \
-        maddr = memory->memory_data + offset1;          \
+// 批量操作必须在写入任何字节之前陷入, 因此总是显式检查.
+// 宿主函数或JIT代码可能扩容内存, 大小每次从memory读取而不缓存
+#define CHECK_BULK_MEMORY_OVERFLOW(start, bytes, maddr)          \
+    do                                                           \
+    {                                                            \
+        uint64 offset1 = (uint32)(start);                        \
+        if (offset1 + (bytes) > LINEAR_MEMORY->memory_data_size) \
+            HANDLE_OUT_OF_BOUNDS();                              \
+        maddr = memory_data + offset1;                           \
     } while (0)
 
 static inline uint32
@@ -523,7 +569,7 @@ trunc_f64_to_int(WASMModule *module, uint32 *frame_sp, float64 src_min,
     {                                                                    \
         if (!trunc_f32_to_int(module, frame_sp, min, max, false, is_i32, \
                               is_sign))                                  \
-            goto got_exception;                                          \
+            HANDLE_EXCEPTION();                                          \
     } while (0)
 
 #define DEF_OP_TRUNC_F64(min, max, is_i32, is_sign)                      \
@@ -531,7 +577,7 @@ trunc_f64_to_int(WASMModule *module, uint32 *frame_sp, float64 src_min,
     {                                                                    \
         if (!trunc_f64_to_int(module, frame_sp, min, max, false, is_i32, \
                               is_sign))                                  \
-            goto got_exception;                                          \
+            HANDLE_EXCEPTION();                                          \
     } while (0)
 
 #define DEF_OP_TRUNC_SAT_F32(min, max, is_i32, is_sign)                  \
@@ -555,18 +601,6 @@ trunc_f64_to_int(WASMModule *module, uint32 *frame_sp, float64 src_min,
         PUSH_##dst_op_type(value);                                   \
     } while (0)
 
-#define GET_LOCAL_INDEX_TYPE_AND_OFFSET()                                \
-    do                                                                   \
-    {                                                                    \
-        uint32 param_count = cur_func->param_count;                      \
-        local_idx = leb_u32_2;                                           \
-        local_offset = cur_func->local_offsets[local_idx];               \
-        if (local_idx < param_count)                                     \
-            local_type = cur_func->param_types[local_idx];               \
-        else                                                             \
-            local_type = cur_func->local_types[local_idx - param_count]; \
-    } while (0)
-
 static inline int32
 sign_ext_8_32(int8 val)
 {
@@ -617,54 +651,228 @@ word_copy(uint32 *dest, uint32 *src, unsigned num)
     }
 }
 
-static inline WASMFuncFrame *
-ALLOC_FRAME(WASMExecEnv *exec_env)
+// 在frame_lp处建立被调用函数的栈帧, 参数已由调用者放在frame_lp开始处,
+// 返回被调用函数操作数栈的起始位置, 数值栈不足时返回NULL
+static inline uint32 *
+wasm_interp_push_frame(WASMExecEnv *exec_env, WASMFunction *func,
+                       uint32 *frame_lp, uint64 *prev_ip, uint32 *prev_lp)
 {
-    // if (exec_env->exectution_stack.top + sizeof(WASMFuncFrame) >= exec_env->exectution_stack.top_boundary)
-    // {
-    //     wasm_set_exception(exec_env->module_inst,
-    //                        "wasm exectution stack overflow");
-    //     return NULL;
-    // }
+    uint32 *frame_sp = frame_lp + func->param_cell_num + func->local_cell_num;
+    WASMFuncFrame *frame = (WASMFuncFrame *)frame_sp;
 
-    exec_env->exec_stack.func_frame_top -= sizeof(WASMFuncFrame);
+    if ((uint8 *)(frame_sp + WASM_FRAME_HEADER_CELLS + func->max_stack_cell_num) > exec_env->exec_stack.top_boundary)
+    {
+        wasm_set_exception(exec_env->module_inst, "wasm operand stack overflow");
+        return NULL;
+    }
 
-    WASMFuncFrame *frame = (WASMFuncFrame *)exec_env->exec_stack.func_frame_top;
+    // 只清零可能在赋值前被读取的局部变量
+    if (func->zero_cell_num)
+        memset(frame_lp + func->zero_cell_offset, 0,
+               func->zero_cell_num * sizeof(uint32));
 
-    return frame;
+    frame->prev_ip = prev_ip;
+    frame->prev_lp = prev_lp;
+    return frame_sp + WASM_FRAME_HEADER_CELLS;
 }
 
-static inline void
-FREE_FRAME(WASMExecEnv *exec_env)
+// call_indirect的内联缓存占一个单元, 高32位为元素下标, 低32位为已通过检查的被调用
+// 函数的下标. 预解码指令在实例和线程间共享, 缓存只以原子操作整体读写, 命中时再核对
+// 本实例表中的元素, 表被修改后自然不再命中
+#define INDIRECT_CACHE_ENTRY(elem, fidx) (((uint64)(elem) << 32) | (uint32)(fidx))
+
+static inline WASMFunction *
+wasm_interp_lookup_indirect(WASMModule *module, WASMTable *tbl_inst,
+                            uint32 elem, uint64 *cache)
 {
-    exec_env->exec_stack.func_frame_top += sizeof(WASMFuncFrame);
+    uint64 entry = __atomic_load_n(cache, __ATOMIC_RELAXED);
+    uint32 fidx = (uint32)entry;
+
+    if ((uint32)(entry >> 32) != elem || elem >= tbl_inst->cur_size
+        || tbl_inst->table_data[elem] != fidx)
+        return NULL;
+    return module->functions + fidx;
 }
 
-#define CONTROL_TRANSFER()                                       \
-    do                                                           \
-    {                                                            \
-        uint32 push = cur_branch_table->push;                    \
-        uint32 pop = cur_branch_table->pop;                      \
-        frame_ip = cur_branch_table->ip;                         \
-        word_copy(frame_sp - pop, frame_sp - push, push);        \
-        frame_sp = frame_sp - pop + push;                        \
-        cur_branch_table = branch_table + cur_branch_table->idx; \
+// 缓存未命中时查找被调用函数并检查类型, 成功后更新缓存
+static WASMFunction *
+wasm_interp_resolve_indirect(WASMModule *module, uint32 type_id,
+                             WASMTable *tbl_inst, uint32 elem, uint64 *cache)
+{
+    WASMFunction *func;
+    uint32 fidx;
+
+    if (elem >= tbl_inst->cur_size)
+    {
+        wasm_set_exception(module, "undefined element");
+        return NULL;
+    }
+
+    fidx = tbl_inst->table_data[elem];
+    if (fidx == NULL_REF)
+    {
+        wasm_set_exception(module, "uninitialized element");
+        return NULL;
+    }
+
+    if (fidx >= module->function_count)
+    {
+        wasm_set_exception(module, "unknown function");
+        return NULL;
+    }
+
+    // 类型编号在整个运行时内唯一, 结构相同的类型编号相同
+    func = module->functions + fidx;
+    if (type_id != func->type_id)
+    {
+        wasm_set_exception(module, "indirect call type mismatch");
+        return NULL;
+    }
+
+    __atomic_store_n(cache, INDIRECT_CACHE_ENTRY(elem, fidx), __ATOMIC_RELAXED);
+    return func;
+}
+
+// 预解码指令由处理地址和紧随其后的操作数组成, 每项占用一个uint64
+#define READ_IR_OPERAND(type) ((type)(*frame_ip++))
+#define READ_IR_POINTER(type) ((type)(uintptr_t)(*frame_ip++))
+
+// 跳转目标后紧跟一个单元, 高32位为pop, 低32位为push
+#define CONTROL_TRANSFER()                                    \
+    do                                                        \
+    {                                                         \
+        uint64 *target = READ_IR_POINTER(uint64 *);           \
+        uint64 pop_push = *frame_ip;                          \
+        uint32 push = (uint32)pop_push;                       \
+        uint32 pop = (uint32)(pop_push >> 32);                \
+        word_copy(frame_sp - pop, frame_sp - push, push);     \
+        frame_sp = frame_sp - pop + push;                     \
+        frame_ip = target;                                    \
     } while (0)
 
-static void
+// 比较结果直接决定是否跳转, 不再经过操作数栈
+#define DEF_OP_CMP_BR_IF(src_type, cond)    \
+    do                                      \
+    {                                       \
+        src_type val1, val2;                \
+        val2 = (src_type)POP_I32();         \
+        val1 = (src_type)POP_I32();         \
+        if (val1 cond val2)                 \
+        {                                   \
+            CONTROL_TRANSFER();             \
+        }                                   \
+        else                                \
+        {                                   \
+            frame_ip += 2;                  \
+        }                                   \
+    } while (0)
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+// 槽位模式的操作数为相对frame_lp的16位偏移, 依次打包在同一个单元中
+#define SLOT_ADDR(operands, n) (frame_lp + (uint16)((operands) >> ((n)*16)))
+
+// 跳转目标后紧跟的单元依次为dst, src和需要复制的单元数
+#define SLOT_CONTROL_TRANSFER()                                                  \
+    do                                                                           \
+    {                                                                            \
+        uint64 *target = READ_IR_POINTER(uint64 *);                              \
+        uint64 copy = *frame_ip;                                                 \
+        word_copy(SLOT_ADDR(copy, 0), SLOT_ADDR(copy, 1), (uint16)(copy >> 32)); \
+        frame_ip = target;                                                       \
+    } while (0)
+
+#define DEF_SLOT_BINOP(src_type, dst_type, expr)                \
+    do                                                          \
+    {                                                           \
+        uint64 operands = READ_IR_OPERAND(uint64);              \
+        src_type a = *(src_type *)SLOT_ADDR(operands, 1);       \
+        src_type b = *(src_type *)SLOT_ADDR(operands, 2);       \
+        *(dst_type *)SLOT_ADDR(operands, 0) = (dst_type)(expr); \
+    } while (0)
+
+#define DEF_SLOT_UNOP(src_type, dst_type, expr)                 \
+    do                                                          \
+    {                                                           \
+        uint64 operands = READ_IR_OPERAND(uint64);              \
+        src_type a = *(src_type *)SLOT_ADDR(operands, 1);       \
+        *(dst_type *)SLOT_ADDR(operands, 0) = (dst_type)(expr); \
+    } while (0)
+#endif
+
+#if WASM_ENABLE_TIERED_JIT != 0
+static bool
+llvm_jit_call_func_bytecode(WASMModule *module_inst,
+                            WASMExecEnv *exec_env,
+                            WASMFunction *function,
+                            uint32 argv[]);
+
+// 累计函数的热度, 越过阈值时提交后台编译
+static inline void
+wasm_interp_count_hotness(WASMModule *module, WASMFunction *func)
+{
+    if (func->jit->hotness < WASM_TIER_UP_THRESHOLD
+        && ++func->jit->hotness == WASM_TIER_UP_THRESHOLD)
+        wasm_jit_tier_up_request(module, (uint32)(func - module->functions));
+}
+
+// 函数已编译时返回true, 之后可经func_ptrs调用, 否则计入一次调用
+static inline bool
+wasm_interp_tier_up(WASMModule *module, WASMFunction *func)
+{
+    bool compiled = module->func_ptrs_compiled[func - module->functions];
+
+    // 与后台线程发布验证或编译结果时的release配对
+    os_atomic_thread_fence(os_memory_order_acquire);
+    if (compiled)
+        return true;
+    wasm_interp_count_hotness(module, func);
+    return false;
+}
+
+#define CALLEE_IS_COMPILED(callee) wasm_interp_tier_up(module, (callee))
+#elif WASM_ENABLE_THREAD != 0
+// 其他线程可能刚完成延迟验证, 与其发布时的release配对后再读取验证结果
+#define CALLEE_IS_COMPILED(callee) (os_atomic_thread_fence(os_memory_order_acquire), false)
+#else
+#define CALLEE_IS_COMPILED(callee) false
+#endif
+
+// 延迟验证的函数在首次调用时验证, 失败时返回true, 由wasm_interp_call_func_native报告异常
+static inline bool
+wasm_interp_resolve_callee(WASMModule *module, WASMFunction *callee)
+{
+    return callee->func_kind != Lazy_Func || !wasm_validator_resolve_lazy(module, callee);
+}
+
+// 导入函数和已编译的函数都经wasm_interp_call_func_native调用
+#define CALLEE_IS_NATIVE(callee)                                         \
+    ((callee)->func_kind ? wasm_interp_resolve_callee(module, (callee)) \
+                         : CALLEE_IS_COMPILED(callee))
+
+// 参数从argv开始存放, 结果写回argv开始处
+static bool
 wasm_interp_call_func_native(WASMExecEnv *exec_env,
                              uint32 func_idx,
-                             WASMFuncFrame *prev_frame)
+                             uint32 *argv)
 {
     WASMModule *module = exec_env->module_inst;
     WASMFunction *func_import = module->functions + func_idx;
+    uint8 *prev_top = exec_env->exec_stack.top;
     bool ret = false;
 
+    // 导入函数可能重新进入解释器, 新的栈帧需建立在参数之上
+    exec_env->exec_stack.top = (uint8 *)(argv + func_import->param_cell_num);
+
     switch (func_import->func_kind)
     {
+#if WASM_ENABLE_TIERED_JIT != 0
+    case Wasm_Func:
+        ret = llvm_jit_call_func_bytecode(module, exec_env, func_import, argv);
+        break;
+#endif
     case Native_Func:
         ret = wasm_runtime_invoke_native(
-            exec_env, func_idx, prev_frame->sp, prev_frame->sp);
+            exec_env, func_idx, argv, argv);
         break;
     case External_Func:
         break;
@@ -672,2207 +880,2136 @@ wasm_interp_call_func_native(WASMExecEnv *exec_env,
         break;
     }
 
-    if (!ret)
-        return;
+    exec_env->exec_stack.top = prev_top;
 
-    if (func_import->ret_cell_num == 1)
-    {
-        prev_frame->sp++;
-    }
-    else if (func_import->ret_cell_num == 2)
-    {
-        prev_frame->sp += 2;
-    }
+    if (!ret && !wasm_get_exception(module))
+        wasm_set_exception(module, "failed to call native function");
+    return ret;
 }
 
+const void **wasm_interp_handle_table;
+#if WASM_ENABLE_SLOT_INTERP != 0
+const void **wasm_interp_slot_handle_table;
+#endif
+#if WASM_ENABLE_TOS_CACHE != 0
+const void *(*wasm_interp_tos_handle_table)[2][2];
+#endif
+
+// 计算跳转分发: 所有指令的处理都位于同一个函数中, 以goto进入下一条指令
+#if WASM_ENABLE_TAIL_CALL_DISPATCH == 0
 #define HANDLE_OP(opcode) HANDLE_##opcode:
-#define EXEC_OP(opcode) EXEC_##opcode:
-#define HANDLE_OP_END()             \
-    do                              \
-    {                               \
-        opcode = *frame_ip++;       \
-        goto *opcode_table[opcode]; \
+#define HANDLE_OP_ALIAS(opcode, target) HANDLE_##opcode:
+#define SLOT_HANDLE_OP(opcode) SLOT_HANDLE_##opcode:
+// 栈顶缓存的处理以进入和离开时的状态区分, 1表示栈顶的i32位于tos中而不在frame_sp之下
+#define TOS_HANDLE_OP(opcode, in, out) TOS_HANDLE_##opcode##_##in##out:
+#define HANDLE_OP_END()                              \
+    do                                               \
+    {                                                \
+        goto *READ_IR_POINTER(const void *);         \
+    } while (0)
+#define HANDLE_EXCEPTION() goto got_exception
+#define HANDLE_OUT_OF_BOUNDS() goto out_of_bounds
+
+// 全局变量和线性内存的地址在函数开始时取出
+#define GLOBAL_DATA global_data
+#define LINEAR_MEMORY memory
+
+// 调用在函数末尾统一处理
+#define CALL_FUNCTION(func)           \
+    do                                \
+    {                                 \
+        callee = (func);              \
+        goto call_func_from_interp;   \
+    } while (0)
+#define RETURN_CALL_FUNCTION(func)    \
+    do                                \
+    {                                 \
+        callee = (func);              \
+        goto return_call_func;        \
     } while (0)
-
-static inline uint8 *
-get_global_addr(uint8 *global_data, WASMGlobal *global)
-{
-    return global_data + global->data_offset;
-}
 
 static void
 wasm_interp_call_func_bytecode(WASMModule *module,
                                WASMExecEnv *exec_env,
                                WASMFunction *function,
-                               WASMFuncFrame *prev_frame)
+                               uint32 *lp)
 {
+#define HANDLE_OPCODE(op) &&HANDLE_##op
+    DEFINE_GOTO_TABLE(const void *, handle_table);
+#if WASM_ENABLE_OPCODE_PROFILE != 0
+    handle_table[EXT_OP_PROFILE] = HANDLE_OPCODE(EXT_OP_PROFILE);
+#endif
+#if WASM_ENABLE_TIERED_JIT != 0
+    handle_table[EXT_OP_LOOP_HOTNESS] = HANDLE_OPCODE(EXT_OP_LOOP_HOTNESS);
+#endif
+#undef HANDLE_OPCODE
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+    // 不在表中的指令在槽位模式下仍使用栈式处理
+#define SLOT_HANDLE_OPCODE(op) [op] = &&SLOT_HANDLE_##op
+    static const void *slot_handle_table[WASM_INSTRUCTION_NUM] = {
+        SLOT_HANDLE_OPCODE(WASM_OP_IF),
+        SLOT_HANDLE_OPCODE(WASM_OP_BR),
+        SLOT_HANDLE_OPCODE(WASM_OP_BR_IF),
+        SLOT_HANDLE_OPCODE(WASM_OP_BR_TABLE),
+        SLOT_HANDLE_OPCODE(WASM_OP_RETURN),
+        SLOT_HANDLE_OPCODE(WASM_OP_SELECT),
+        SLOT_HANDLE_OPCODE(WASM_OP_SELECT_64),
+        SLOT_HANDLE_OPCODE(EXT_OP_SET_LOCAL_FAST),
+        SLOT_HANDLE_OPCODE(EXT_OP_SET_LOCAL_FAST_64),
+        SLOT_HANDLE_OPCODE(WASM_OP_GET_GLOBAL),
+        SLOT_HANDLE_OPCODE(WASM_OP_GET_GLOBAL_64),
+        SLOT_HANDLE_OPCODE(WASM_OP_SET_GLOBAL),
+        SLOT_HANDLE_OPCODE(WASM_OP_SET_GLOBAL_64),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_CONST),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_CONST),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_EQZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_EQ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_NE),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LT_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LT_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_GT_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_GT_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LE_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LE_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_GE_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_GE_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EQZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EQ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_NE),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LT_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LT_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_GT_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_GT_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LE_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LE_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_GE_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_GE_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_EQ),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_NE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_LT),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_GT),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_LE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_GE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_EQ),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_NE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_LT),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_GT),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_LE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_GE),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_CLZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_CTZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_POPCNT),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_ADD),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_SUB),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_MUL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_AND),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_OR),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_XOR),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_SHL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_SHR_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_SHR_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_ROTL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_ROTR),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_CLZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_CTZ),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_POPCNT),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_ADD),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_SUB),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_MUL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_AND),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_OR),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_XOR),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_SHL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_SHR_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_SHR_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_ROTL),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_ROTR),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_ADD),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_SUB),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_MUL),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_DIV),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_ADD),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_SUB),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_MUL),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_DIV),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_WRAP_I64),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EXTEND_S_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EXTEND_U_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_CONVERT_S_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_CONVERT_U_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_DEMOTE_F64),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_CONVERT_S_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_CONVERT_U_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_PROMOTE_F32),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_REINTERPRET_F32),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_REINTERPRET_F64),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_REINTERPRET_I32),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_REINTERPRET_I64),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_EXTEND8_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_EXTEND16_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EXTEND8_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EXTEND16_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_EXTEND32_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LOAD),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_LOAD),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_LOAD),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LOAD8_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LOAD8_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LOAD16_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_LOAD16_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD8_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD8_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD16_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD16_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD32_S),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_LOAD32_U),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_STORE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F32_STORE),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_STORE),
+        SLOT_HANDLE_OPCODE(WASM_OP_F64_STORE),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_STORE8),
+        SLOT_HANDLE_OPCODE(WASM_OP_I32_STORE16),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_STORE8),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_STORE16),
+        SLOT_HANDLE_OPCODE(WASM_OP_I64_STORE32),
+    };
+#undef SLOT_HANDLE_OPCODE
+#endif
+
+#if WASM_ENABLE_TOS_CACHE != 0
+    // 以[操作码][进入状态][离开状态]为索引, 两个状态均为0时使用栈式处理
+#define TOS_HANDLE_OPCODE(op, src)                                    \
+    [op] = {{NULL, &&TOS_HANDLE_##src##_01},                          \
+            {&&TOS_HANDLE_##src##_10, &&TOS_HANDLE_##src##_11}}
+    // 只消耗栈顶而不产生值的指令
+#define TOS_HANDLE_OPCODE_CONSUME(op, src) \
+    [op] = {{NULL, NULL}, {&&TOS_HANDLE_##src##_10, NULL}}
+    static const void *tos_handle_table[WASM_INSTRUCTION_NUM][2][2] = {
+        TOS_HANDLE_OPCODE(EXT_OP_GET_LOCAL_FAST, EXT_OP_GET_LOCAL_FAST),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_CONST, WASM_OP_I32_CONST),
+        TOS_HANDLE_OPCODE(WASM_OP_F32_CONST, WASM_OP_I32_CONST),
+        TOS_HANDLE_OPCODE(WASM_OP_GET_GLOBAL, WASM_OP_GET_GLOBAL),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_EQZ, WASM_OP_I32_EQZ),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_EXTEND8_S, WASM_OP_I32_EXTEND8_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_EXTEND16_S, WASM_OP_I32_EXTEND16_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LOAD, WASM_OP_I32_LOAD),
+        TOS_HANDLE_OPCODE(WASM_OP_F32_LOAD, WASM_OP_I32_LOAD),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LOAD8_S, WASM_OP_I32_LOAD8_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LOAD8_U, WASM_OP_I32_LOAD8_U),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LOAD16_S, WASM_OP_I32_LOAD16_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LOAD16_U, WASM_OP_I32_LOAD16_U),
+        TOS_HANDLE_OPCODE(EXT_OP_TEE_LOCAL_FAST, EXT_OP_TEE_LOCAL_FAST),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_ADD, WASM_OP_I32_ADD),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_SUB, WASM_OP_I32_SUB),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_MUL, WASM_OP_I32_MUL),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_AND, WASM_OP_I32_AND),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_OR, WASM_OP_I32_OR),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_XOR, WASM_OP_I32_XOR),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_SHL, WASM_OP_I32_SHL),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_SHR_S, WASM_OP_I32_SHR_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_SHR_U, WASM_OP_I32_SHR_U),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_ROTL, WASM_OP_I32_ROTL),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_ROTR, WASM_OP_I32_ROTR),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_EQ, WASM_OP_I32_EQ),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_NE, WASM_OP_I32_NE),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LT_S, WASM_OP_I32_LT_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LT_U, WASM_OP_I32_LT_U),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_GT_S, WASM_OP_I32_GT_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_GT_U, WASM_OP_I32_GT_U),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LE_S, WASM_OP_I32_LE_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_LE_U, WASM_OP_I32_LE_U),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_GE_S, WASM_OP_I32_GE_S),
+        TOS_HANDLE_OPCODE(WASM_OP_I32_GE_U, WASM_OP_I32_GE_U),
+        TOS_HANDLE_OPCODE_CONSUME(EXT_OP_SET_LOCAL_FAST, EXT_OP_SET_LOCAL_FAST),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_SET_GLOBAL, WASM_OP_SET_GLOBAL),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_DROP, WASM_OP_DROP),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_IF, WASM_OP_IF),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_BR_IF, WASM_OP_BR_IF),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_I32_STORE, WASM_OP_I32_STORE),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_F32_STORE, WASM_OP_I32_STORE),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_I32_STORE8, WASM_OP_I32_STORE8),
+        TOS_HANDLE_OPCODE_CONSUME(WASM_OP_I32_STORE16, WASM_OP_I32_STORE16),
+    };
+#undef TOS_HANDLE_OPCODE
+#undef TOS_HANDLE_OPCODE_CONSUME
+#endif
+
+    // 仅用于导出处理地址表
+    if (!module)
+    {
+        wasm_interp_handle_table = handle_table;
+#if WASM_ENABLE_SLOT_INTERP != 0
+        wasm_interp_slot_handle_table = slot_handle_table;
+#endif
+#if WASM_ENABLE_TOS_CACHE != 0
+        wasm_interp_tos_handle_table = tos_handle_table;
+#endif
+        return;
+    }
+
     WASMMemory *memory = module->memories;
     uint8 *global_data = module->global_data;
-    uint32 num_bytes_per_page = memory ? memory->num_bytes_per_page : 0;
-    uint32 linear_mem_size =
-        memory ? num_bytes_per_page * memory->cur_page_count : 0;
-    WASMType **wasm_types = module->types;
-    WASMGlobal *globals = module->globals, *global;
-    uint32 *value_stack = (uint32 *)exec_env->exec_stack.top;
-    WASMFunction *cur_func = function;
-
-    // 初始化栈帧
-    WASMFuncFrame *frame = ALLOC_FRAME(exec_env);
-    frame->lp = value_stack - cur_func->param_cell_num;
-    frame->sp = value_stack + cur_func->local_cell_num;
-    frame->ip = (uint8 *)cur_func->func_ptr;
-    frame->function = function;
-
-    WASMBranchTable *branch_table = cur_func->branch_table;
-    WASMBranchTable *cur_branch_table = branch_table;
-
-    register uint8 *frame_ip = frame->ip;
-    register uint32 *frame_lp = frame->lp;
-    register uint32 *frame_sp = frame->sp;
-    uint8 *frame_ip_end = cur_func->code_end;
-
-    uint8 opcode;
-    uint32 i, cond, fidx, tidx, lidx;
-    int32 val;
-    uint8 *maddr = NULL;
-    uint32 local_idx, local_offset;
-    uint8 local_type, *global_addr;
-    register uint32 leb_u32_2, leb_u32_1;
-    register int32 leb_i32;
-    register int64 leb_i64;
+    // 线性内存预留了全部地址空间, 扩容不会移动基址
+    uint8 *memory_data = memory ? memory->memory_data : NULL;
+    WASMFunction *callee;
+
+    // 初始化栈帧, 参数已由调用者放在lp开始处
+    register uint64 *frame_ip = function->ir_code;
+    register uint32 *frame_lp = lp;
+    register uint32 *frame_sp = wasm_interp_push_frame(exec_env, function, lp,
+                                                       NULL, NULL);
+
+    if (!frame_sp)
+        return;
+
+    uint32 fidx;
+#if WASM_ENABLE_TOS_CACHE != 0
+    // 缓存的栈顶值, 只在栈顶缓存的处理之间传递
+    register uint32 tos = 0;
+#endif
 
 #if WASM_ENABLE_DEBUG_INTERP != 0
     call_info = fopen("call_info.log", "w");
 
 #endif
 
-#define HANDLE_OPCODE(op) &&HANDLE_##op
-    DEFINE_GOTO_TABLE(const void *, handle_table);
-#undef HANDLE_OPCODE
+    HANDLE_OP_END();
 
-#define HANDLE_OPCODE(op) &&EXEC_##op
-    DEFINE_GOTO_TABLE(const void *, opcode_table);
-#undef HANDLE_OPCODE
+#include "wasm_interp_handlers.def"
 
-    opcode = *frame_ip++;
-    goto *opcode_table[opcode];
-    // 不支持的指令
-    EXEC_OP(WASM_OP_UNUSED_0x06)          /* 0x06 */
-    EXEC_OP(WASM_OP_UNUSED_0x07)          /* 0x07 */
-    EXEC_OP(WASM_OP_UNUSED_0x08)          /* 0x08 */
-    EXEC_OP(WASM_OP_UNUSED_0x09)          /* 0x09 */
-    EXEC_OP(WASM_OP_UNUSED_0x0a)          /* 0x0a */
-    EXEC_OP(WASM_OP_RETURN_CALL)          /* 0x12 */
-    EXEC_OP(WASM_OP_RETURN_CALL_INDIRECT) /* 0x13 */
-    EXEC_OP(WASM_OP_UNUSED_0x14)          /* 0x14 */
-    EXEC_OP(WASM_OP_UNUSED_0x15)          /* 0x15 */
-    EXEC_OP(WASM_OP_UNUSED_0x16)          /* 0x16 */
-    EXEC_OP(WASM_OP_UNUSED_0x17)          /* 0x17 */
-    EXEC_OP(WASM_OP_UNUSED_0x18)          /* 0x18 */
-    EXEC_OP(WASM_OP_TABLE_GET)            /* 0x25 */
-    EXEC_OP(WASM_OP_TABLE_SET)            /* 0x26 */
-    EXEC_OP(WASM_OP_REF_NULL)             /* 0xd0 */
-    EXEC_OP(WASM_OP_REF_IS_NULL)          /* 0xd1 */
-    EXEC_OP(WASM_OP_REF_FUNC)             /* 0xd2 */
-    EXEC_OP(WASM_OP_SELECT_T)
-    {
-    }
-
-    // 读2个lebu32
-    EXEC_OP(WASM_OP_CALL_INDIRECT)
-    {
-        uint8 _val = *frame_ip;
-        if (!(_val & 0x80))
+#if WASM_ENABLE_SLOT_INTERP != 0
+    SLOT_HANDLE_OP(WASM_OP_IF)
+    {
+        if (!*SLOT_ADDR(frame_ip[1], 0))
         {
-            leb_u32_1 = _val;
-            frame_ip++;
+            frame_ip = (uint64 *)(uintptr_t)*frame_ip;
         }
         else
         {
-            leb_u32_1 = 0;
-            uint64 byte;
-            uint32 shift = 0;
-            while (true)
-            {
-                byte = *frame_ip++;
-                leb_u32_1 |= ((byte & 0x7f) << shift);
-                shift += 7;
-                if ((byte & 0x80) == 0)
-                {
-                    break;
-                }
-            }
+            frame_ip += 2;
         }
-        goto read_next_lebu32;
-    }
-    EXEC_OP(WASM_OP_I32_LOAD)     /* 0x28 */
-    EXEC_OP(WASM_OP_I64_LOAD)     /* 0x29 */
-    EXEC_OP(WASM_OP_F32_LOAD)     /* 0x2a */
-    EXEC_OP(WASM_OP_F64_LOAD)     /* 0x2b */
-    EXEC_OP(WASM_OP_I32_LOAD8_S)  /* 0x2c */
-    EXEC_OP(WASM_OP_I32_LOAD8_U)  /* 0x2d */
-    EXEC_OP(WASM_OP_I32_LOAD16_S) /* 0x2e */
-    EXEC_OP(WASM_OP_I32_LOAD16_U) /* 0x2f */
-    EXEC_OP(WASM_OP_I64_LOAD8_S)  /* 0x30 */
-    EXEC_OP(WASM_OP_I64_LOAD8_U)  /* 0x31 */
-    EXEC_OP(WASM_OP_I64_LOAD16_S) /* 0x32 */
-    EXEC_OP(WASM_OP_I64_LOAD16_U) /* 0x33 */
-    EXEC_OP(WASM_OP_I64_LOAD32_S) /* 0x34 */
-    EXEC_OP(WASM_OP_I64_LOAD32_U) /* 0x35 */
-    EXEC_OP(WASM_OP_I32_STORE)    /* 0x36 */
-    EXEC_OP(WASM_OP_I64_STORE)    /* 0x37 */
-    EXEC_OP(WASM_OP_F32_STORE)    /* 0x38 */
-    EXEC_OP(WASM_OP_F64_STORE)    /* 0x39 */
-    EXEC_OP(WASM_OP_I32_STORE8)   /* 0x3a */
-    EXEC_OP(WASM_OP_I32_STORE16)  /* 0x3b */
-    EXEC_OP(WASM_OP_I64_STORE8)   /* 0x3c */
-    EXEC_OP(WASM_OP_I64_STORE16)  /* 0x3d */
-    EXEC_OP(WASM_OP_I64_STORE32)  /* 0x3e */
-    {
-        skip_leb_uint32(frame_ip, frame_ip_end);
-    }
-    // 读1个lebu32
-    EXEC_OP(WASM_OP_MEMORY_SIZE) /* 0x3f */
-    EXEC_OP(WASM_OP_MEMORY_GROW)
-    EXEC_OP(WASM_OP_BR_TABLE)
-    EXEC_OP(WASM_OP_CALL)
-    EXEC_OP(WASM_OP_GET_GLOBAL_64)
-    EXEC_OP(WASM_OP_SET_GLOBAL_64)
-    EXEC_OP(WASM_OP_GET_LOCAL)  /* 0x20 */
-    EXEC_OP(WASM_OP_SET_LOCAL)  /* 0x21 */
-    EXEC_OP(WASM_OP_TEE_LOCAL)  /* 0x22 */
-    EXEC_OP(WASM_OP_GET_GLOBAL) /* 0x23 */
-    EXEC_OP(WASM_OP_SET_GLOBAL) /* 0x24 */
-read_next_lebu32:
-{
-    uint8 _val = *frame_ip;
-    if (!(_val & 0x80))
-    {
-        leb_u32_2 = _val;
-        frame_ip++;
+        HANDLE_OP_END();
     }
-    else
+
+    SLOT_HANDLE_OP(WASM_OP_BR)
     {
-        leb_u32_2 = 0;
-        uint64 byte;
-        uint32 shift = 0;
-        while (true)
-        {
-            byte = *frame_ip++;
-            leb_u32_2 |= ((byte & 0x7f) << shift);
-            shift += 7;
-            if ((byte & 0x80) == 0)
-            {
-                break;
-            }
-        }
+        SLOT_CONTROL_TRANSFER();
+        HANDLE_OP_END();
     }
-    goto *handle_table[opcode];
-}
 
-    // 读1个lebint32
-    EXEC_OP(WASM_OP_I32_CONST)
+    // 条件位于复制信息的最高16位
+    SLOT_HANDLE_OP(WASM_OP_BR_IF)
     {
-        uint8 _val = *frame_ip;
-        if (!(_val & 0x80))
+        if (*SLOT_ADDR(frame_ip[1], 3))
         {
-            leb_i32 = (int32)_val;
-            if (_val & 0x40) /* sign extend */
-                leb_i32 |= 0xFFFFFF80;
-            frame_ip++;
+            SLOT_CONTROL_TRANSFER();
         }
         else
         {
-            uint64 result = 0, byte;
-            uint32 shift = 0;
-            while (true)
-            {
-                byte = *frame_ip++;
-                result |= ((byte & 0x7f) << shift);
-                shift += 7;
-                if ((byte & 0x80) == 0)
-                {
-                    break;
-                }
-            }
-            if ((shift < 32) && (byte & 0x40))
-            {
-                result |= (~((uint64)0)) << shift;
-            }
-            leb_i32 = (int32)result;
+            frame_ip += 2;
         }
-        goto *handle_table[opcode];
+        HANDLE_OP_END();
     }
-    // 读1个lebint64
-    EXEC_OP(WASM_OP_I64_CONST)
+
+    SLOT_HANDLE_OP(WASM_OP_BR_TABLE)
     {
-        uint8 _val = *frame_ip;
-        if (!(_val & 0x80))
-        {
-            leb_i64 = (int64)_val;
-            if (_val & 0x40) /* sign extend */
-                leb_i64 |= 0xFFFFFFFFFFFFFF80LL;
-            frame_ip++;
-        }
-        else
-        {
-            uint64 result = 0, byte;
-            uint32 shift = 0;
-            while (true)
-            {
-                byte = *frame_ip++;
-                result |= ((byte & 0x7f) << shift);
-                shift += 7;
-                if ((byte & 0x80) == 0)
-                {
-                    break;
-                }
-            }
-            if ((shift < 64) && (byte & 0x40))
-            {
-                result |= (~((uint64)0)) << shift;
-            }
-            leb_i64 = (int64)result;
-        }
-        goto *handle_table[opcode];
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 count = (uint32)operands;
+        uint32 lidx = *SLOT_ADDR(operands, 2);
+        if (lidx > count)
+            lidx = count;
+        frame_ip += lidx * 2;
+        SLOT_CONTROL_TRANSFER();
+        HANDLE_OP_END();
     }
 
-    // 附加指令
-    EXEC_OP(WASM_OP_MISC_PREFIX)
+    // 返回值所在槽位之后的单元与栈式的return相同
+    SLOT_HANDLE_OP(WASM_OP_RETURN)
     {
-        goto *handle_table[opcode];
+        uint32 *ret = frame_lp + READ_IR_OPERAND(uint32);
+        frame_sp = ret + (uint32)*frame_ip;
+        goto HANDLE_WASM_OP_RETURN;
     }
 
-    HANDLE_OP(WASM_OP_UNREACHABLE)
-    EXEC_OP(WASM_OP_UNREACHABLE)
+    SLOT_HANDLE_OP(WASM_OP_SELECT)
     {
-        wasm_set_exception(module, "unreachable");
-        goto got_exception;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        *SLOT_ADDR(operands, 0) = *SLOT_ADDR(operands, *SLOT_ADDR(operands, 3) ? 1 : 2);
+        HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_NOP)
-    EXEC_OP(WASM_OP_NOP)
+    SLOT_HANDLE_OP(WASM_OP_SELECT_64)
     {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        PUT_I64_TO_ADDR(SLOT_ADDR(operands, 0),
+                        GET_I64_FROM_ADDR(SLOT_ADDR(operands, *SLOT_ADDR(operands, 3) ? 1 : 2)));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_BLOCK)
-    HANDLE_OP(WASM_OP_LOOP)
-    EXEC_OP(WASM_OP_BLOCK)
-    EXEC_OP(WASM_OP_LOOP)
+    // 局部变量与栈槽之间的复制
+    SLOT_HANDLE_OP(EXT_OP_SET_LOCAL_FAST)
     {
-        skip_leb_uint32(frame_ip, frame_ip_end);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        *SLOT_ADDR(operands, 0) = *SLOT_ADDR(operands, 1);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_IF)
-    EXEC_OP(WASM_OP_IF)
+    SLOT_HANDLE_OP(EXT_OP_SET_LOCAL_FAST_64)
     {
-        skip_leb_uint32(frame_ip, frame_ip_end);
-        cond = (uint32)POP_I32();
-
-        if (!cond)
-        {
-            frame_ip = cur_branch_table->ip;
-            cur_branch_table = branch_table + cur_branch_table->idx;
-        }
-        else
-        {
-            cur_branch_table++;
-        }
+        uint64 operands = READ_IR_OPERAND(uint64);
+        PUT_I64_TO_ADDR(SLOT_ADDR(operands, 0),
+                        GET_I64_FROM_ADDR(SLOT_ADDR(operands, 1)));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_ELSE)
-    EXEC_OP(WASM_OP_ELSE)
+    SLOT_HANDLE_OP(WASM_OP_GET_GLOBAL)
     {
-        frame_ip = cur_branch_table->ip;
-        cur_branch_table = branch_table + cur_branch_table->idx;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint8 *global_addr = global_data + (uint32)(operands >> 32);
+        *SLOT_ADDR(operands, 0) = GET_I32_FROM_ADDR(global_addr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_END)
-    EXEC_OP(WASM_OP_END)
+    SLOT_HANDLE_OP(WASM_OP_GET_GLOBAL_64)
     {
-        if (frame_ip == frame_ip_end)
-        {
-            frame_sp -= cur_func->ret_cell_num;
-            for (i = 0; i < cur_func->ret_cell_num; i++)
-            {
-                *prev_frame->sp++ = frame_sp[i];
-            }
-            goto return_func;
-        }
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint8 *global_addr = global_data + (uint32)(operands >> 32);
+        PUT_I64_TO_ADDR(SLOT_ADDR(operands, 0), GET_I64_FROM_ADDR(global_addr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_BR)
-    EXEC_OP(WASM_OP_BR)
+    SLOT_HANDLE_OP(WASM_OP_SET_GLOBAL)
     {
-        skip_leb_uint32(frame_ip, frame_ip_end);
-        CONTROL_TRANSFER();
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint8 *global_addr = global_data + (uint32)(operands >> 32);
+        PUT_I32_TO_ADDR(global_addr, *SLOT_ADDR(operands, 0));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_BR_IF)
-    EXEC_OP(WASM_OP_BR_IF)
+    SLOT_HANDLE_OP(WASM_OP_SET_GLOBAL_64)
     {
-        skip_leb_uint32(frame_ip, frame_ip_end);
-        cond = (uint32)POP_I32();
-        if (cond)
-        {
-            CONTROL_TRANSFER();
-        }
-        else
-        {
-            cur_branch_table++;
-        }
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint8 *global_addr = global_data + (uint32)(operands >> 32);
+        PUT_I64_TO_ADDR(global_addr, GET_I64_FROM_ADDR(SLOT_ADDR(operands, 0)));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_BR_TABLE)
+    // i32常量位于高32位, i64常量单独占用一个单元
+    SLOT_HANDLE_OP(WASM_OP_I32_CONST)
     {
-        lidx = POP_I32();
-        if (lidx > leb_u32_2)
-            lidx = leb_u32_2;
-        cur_branch_table += lidx;
-        CONTROL_TRANSFER();
+        uint64 operands = READ_IR_OPERAND(uint64);
+        *SLOT_ADDR(operands, 0) = (uint32)(operands >> 32);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_RETURN)
-    EXEC_OP(WASM_OP_RETURN)
+    SLOT_HANDLE_OP(WASM_OP_I64_CONST)
     {
-        frame_sp -= cur_func->ret_cell_num;
-        for (i = 0; i < cur_func->ret_cell_num; i++)
-        {
-            *prev_frame->sp++ = frame_sp[i];
-        }
-        goto return_func;
+        uint32 *dst = frame_lp + READ_IR_OPERAND(uint32);
+        PUT_I64_TO_ADDR(dst, READ_IR_OPERAND(uint64));
+        HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_CALL)
+    SLOT_HANDLE_OP(WASM_OP_I32_EQZ)
     {
-        fidx = leb_u32_2;
-
-        frame->function = cur_func;
-
-        cur_func = module->functions + fidx;
-        goto call_func_from_interp;
+        DEF_SLOT_UNOP(uint32, uint32, a == 0);
+        HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_CALL_INDIRECT)
+    SLOT_HANDLE_OP(WASM_OP_I32_EQ)
     {
-        WASMType *cur_type, *cur_func_type;
-        WASMTable *tbl_inst;
-        uint32 tbl_idx;
-        tidx = leb_u32_1;
-        cur_type = wasm_types[tidx];
-        tbl_idx = leb_u32_2;
-
-        tbl_inst = module->tables + tbl_idx;
-
-        val = POP_I32();
-        if ((uint32)val >= tbl_inst->cur_size)
-        {
-            wasm_set_exception(module, "undefined element");
-            goto got_exception;
-        }
-
-        fidx = tbl_inst->table_data[val];
-        if (fidx == NULL_REF)
-        {
-            wasm_set_exception(module, "uninitialized element");
-            goto got_exception;
-        }
-
-        if (fidx >= module->function_count)
-        {
-            wasm_set_exception(module, "unknown function");
-            goto got_exception;
-        }
-
-        frame->function = cur_func;
-        cur_func = module->functions + fidx;
-
-        cur_func_type = cur_func->func_type;
-
-        if (cur_type != cur_func_type)
-        {
-            wasm_set_exception(module, "indirect call type mismatch");
-            goto got_exception;
-        }
-
-        goto call_func_from_interp;
+        DEF_SLOT_BINOP(uint32, uint32, a == b);
+        HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_DROP)
-    EXEC_OP(WASM_OP_DROP)
+    SLOT_HANDLE_OP(WASM_OP_I32_NE)
     {
-        frame_sp--;
+        DEF_SLOT_BINOP(uint32, uint32, a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_DROP_64)
-    EXEC_OP(WASM_OP_DROP_64)
+    SLOT_HANDLE_OP(WASM_OP_I32_LT_S)
     {
-        frame_sp -= 2;
+        DEF_SLOT_BINOP(int32, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_SELECT)
-    EXEC_OP(WASM_OP_SELECT)
+    SLOT_HANDLE_OP(WASM_OP_I32_LT_U)
     {
-        cond = (uint32)POP_I32();
-        frame_sp--;
-        if (!cond)
-            *(frame_sp - 1) = *frame_sp;
+        DEF_SLOT_BINOP(uint32, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_SELECT_64)
-    EXEC_OP(WASM_OP_SELECT_64)
+    SLOT_HANDLE_OP(WASM_OP_I32_GT_S)
     {
-        cond = (uint32)POP_I32();
-        frame_sp -= 2;
-        if (!cond)
-        {
-            *(frame_sp - 2) = *frame_sp;
-            *(frame_sp - 1) = *(frame_sp + 1);
-        }
+        DEF_SLOT_BINOP(int32, uint32, a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_GET_LOCAL)
+    SLOT_HANDLE_OP(WASM_OP_I32_GT_U)
     {
-        GET_LOCAL_INDEX_TYPE_AND_OFFSET();
-
-        switch (local_type)
-        {
-        case VALUE_TYPE_I32:
-        case VALUE_TYPE_F32:
-            PUSH_I32(GET_I32_FROM_ADDR(frame_lp + local_offset));
-            break;
-        case VALUE_TYPE_I64:
-        case VALUE_TYPE_F64:
-            PUSH_I64(GET_I64_FROM_ADDR(frame_lp + local_offset));
-            break;
-        default:
-            wasm_set_exception(module, "invalid local type");
-            goto got_exception;
-        }
-
+        DEF_SLOT_BINOP(uint32, uint32, a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_GET_LOCAL_FAST)
-    EXEC_OP(EXT_OP_GET_LOCAL_FAST)
+    SLOT_HANDLE_OP(WASM_OP_I32_LE_S)
     {
-        local_offset = *frame_ip++;
-        PUSH_I32(GET_I32_FROM_ADDR(frame_lp + local_offset));
+        DEF_SLOT_BINOP(int32, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_GET_LOCAL_FAST_64)
-    EXEC_OP(EXT_OP_GET_LOCAL_FAST_64)
+    SLOT_HANDLE_OP(WASM_OP_I32_LE_U)
     {
-        local_offset = *frame_ip++;
-        PUSH_I64(GET_I64_FROM_ADDR(frame_lp + local_offset));
+        DEF_SLOT_BINOP(uint32, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_SET_LOCAL)
+    SLOT_HANDLE_OP(WASM_OP_I32_GE_S)
     {
-        GET_LOCAL_INDEX_TYPE_AND_OFFSET();
-
-        switch (local_type)
-        {
-        case VALUE_TYPE_I32:
-        case VALUE_TYPE_F32:
-            PUT_I32_TO_ADDR(frame_lp + local_offset, POP_I32());
-            break;
-        case VALUE_TYPE_I64:
-        case VALUE_TYPE_F64:
-            PUT_I64_TO_ADDR(frame_lp + local_offset, POP_I64());
-            break;
-        default:
-            wasm_set_exception(module, "invalid local type");
-            goto got_exception;
-        }
-
+        DEF_SLOT_BINOP(int32, uint32, a >= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_SET_LOCAL_FAST)
-    EXEC_OP(EXT_OP_SET_LOCAL_FAST)
+    SLOT_HANDLE_OP(WASM_OP_I32_GE_U)
     {
-        local_offset = *frame_ip++;
-        PUT_I32_TO_ADDR(frame_lp + local_offset, POP_I32());
+        DEF_SLOT_BINOP(uint32, uint32, a >= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_SET_LOCAL_FAST_64)
-    EXEC_OP(EXT_OP_SET_LOCAL_FAST_64)
+    SLOT_HANDLE_OP(WASM_OP_I64_EQZ)
     {
-        local_offset = *frame_ip++;
-        PUT_I64_TO_ADDR(frame_lp + local_offset, POP_I64());
+        DEF_SLOT_UNOP(uint64, uint32, a == 0);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_TEE_LOCAL)
+    SLOT_HANDLE_OP(WASM_OP_I64_EQ)
     {
-        GET_LOCAL_INDEX_TYPE_AND_OFFSET();
-
-        switch (local_type)
-        {
-        case VALUE_TYPE_I32:
-        case VALUE_TYPE_F32:
-            PUT_I32_TO_ADDR(frame_lp + local_offset, GET_I32_FROM_ADDR(frame_sp - 1));
-            break;
-        case VALUE_TYPE_I64:
-        case VALUE_TYPE_F64:
-            PUT_I64_TO_ADDR((frame_lp + local_offset), GET_I64_FROM_ADDR(frame_sp - 2));
-            break;
-        default:
-            wasm_set_exception(module, "invalid local type");
-            goto got_exception;
-        }
-
+        DEF_SLOT_BINOP(uint64, uint32, a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_TEE_LOCAL_FAST)
-    EXEC_OP(EXT_OP_TEE_LOCAL_FAST)
+    SLOT_HANDLE_OP(WASM_OP_I64_NE)
     {
-        local_offset = *frame_ip++;
-        PUT_I32_TO_ADDR(
-            frame_lp + local_offset,
-            GET_I32_FROM_ADDR(frame_sp - 1));
+        DEF_SLOT_BINOP(uint64, uint32, a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_TEE_LOCAL_FAST_64)
-    EXEC_OP(EXT_OP_TEE_LOCAL_FAST_64)
+    SLOT_HANDLE_OP(WASM_OP_I64_LT_S)
     {
-        local_offset = *frame_ip++;
-        PUT_I64_TO_ADDR(
-            frame_lp + local_offset,
-            GET_I64_FROM_ADDR(frame_sp - 2));
+        DEF_SLOT_BINOP(int64, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_GET_GLOBAL)
+    SLOT_HANDLE_OP(WASM_OP_I64_LT_U)
     {
-        global = globals + leb_u32_2;
-        global_addr = get_global_addr(global_data, global);
-        PUSH_I32(GET_I32_FROM_ADDR(global_addr));
+        DEF_SLOT_BINOP(uint64, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_GET_GLOBAL)
-    EXEC_OP(EXT_OP_GET_GLOBAL)
+    SLOT_HANDLE_OP(WASM_OP_I64_GT_S)
     {
-        PUSH_I32(GET_I32_FROM_ADDR(global_data));
+        DEF_SLOT_BINOP(int64, uint32, a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_GET_GLOBAL_64)
+    SLOT_HANDLE_OP(WASM_OP_I64_GT_U)
     {
-        global = globals + leb_u32_2;
-        global_addr = get_global_addr(global_data, global);
-        PUSH_I64(GET_I64_FROM_ADDR(global_addr));
+        DEF_SLOT_BINOP(uint64, uint32, a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_GET_GLOBAL_64)
-    EXEC_OP(EXT_OP_GET_GLOBAL_64)
+    SLOT_HANDLE_OP(WASM_OP_I64_LE_S)
     {
-        PUSH_I64(GET_I64_FROM_ADDR(global_data));
+        DEF_SLOT_BINOP(int64, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_SET_GLOBAL)
+    SLOT_HANDLE_OP(WASM_OP_I64_LE_U)
     {
-        global = globals + leb_u32_2;
-        global_addr = get_global_addr(global_data, global);
-        *(int32 *)global_addr = POP_I32();
+        DEF_SLOT_BINOP(uint64, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_SET_GLOBAL)
-    EXEC_OP(EXT_OP_SET_GLOBAL)
+    SLOT_HANDLE_OP(WASM_OP_I64_GE_S)
     {
-        PUT_I32_TO_ADDR(global_data, POP_I32());
+        DEF_SLOT_BINOP(int64, uint32, a >= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_SET_GLOBAL_64)
+    SLOT_HANDLE_OP(WASM_OP_I64_GE_U)
     {
-
-        global = globals + leb_u32_2;
-        global_addr = get_global_addr(global_data, global);
-        PUT_I64_TO_ADDR(global_addr, POP_I64());
+        DEF_SLOT_BINOP(uint64, uint32, a >= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(EXT_OP_SET_GLOBAL_64)
-    EXEC_OP(EXT_OP_SET_GLOBAL_64)
+    SLOT_HANDLE_OP(WASM_OP_F32_EQ)
     {
-        PUT_I64_TO_ADDR(global_data, POP_I64());
+        DEF_SLOT_BINOP(float32, uint32, a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LOAD)
-    HANDLE_OP(WASM_OP_F32_LOAD)
+    SLOT_HANDLE_OP(WASM_OP_F32_NE)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(4);
-        PUSH_I32(LOAD_I32(maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float32, uint32, a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LOAD)
-    HANDLE_OP(WASM_OP_F64_LOAD)
+    SLOT_HANDLE_OP(WASM_OP_F32_LT)
     {
-        uint32 offset, flags, addr;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(8);
-        PUSH_I64(LOAD_I64(maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float32, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LOAD8_S)
+    SLOT_HANDLE_OP(WASM_OP_F32_GT)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(1);
-        PUSH_I32(sign_ext_8_32(*(int8 *)maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float32, uint32, a > b);
         HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I32_LOAD8_U)
+
+    SLOT_HANDLE_OP(WASM_OP_F32_LE)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(1);
-        PUSH_I32((uint32)(*(uint8 *)maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float32, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LOAD16_S)
+    SLOT_HANDLE_OP(WASM_OP_F32_GE)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(2);
-        PUSH_I32(sign_ext_16_32(LOAD_I16(maddr)));
-        (void)flags;
+        DEF_SLOT_BINOP(float32, uint32, a >= b);
+        HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I32_LOAD16_U)
+
+    SLOT_HANDLE_OP(WASM_OP_F64_EQ)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(2);
-        PUSH_I32((uint32)(LOAD_U16(maddr)));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LOAD8_S)
+    SLOT_HANDLE_OP(WASM_OP_F64_NE)
     {
-        uint32 offset, flags, addr;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(1);
-        PUSH_I64(sign_ext_8_64(*(int8 *)maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LOAD8_U)
+    SLOT_HANDLE_OP(WASM_OP_F64_LT)
     {
-        uint32 offset, flags, addr;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(1);
-        PUSH_I64((uint64)(*(uint8 *)maddr));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LOAD16_S)
+    SLOT_HANDLE_OP(WASM_OP_F64_GT)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(2);
-        PUSH_I64(sign_ext_16_64(LOAD_I16(maddr)));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a > b);
         HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I64_LOAD16_U)
+
+    SLOT_HANDLE_OP(WASM_OP_F64_LE)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(2);
-        PUSH_I64((uint64)(LOAD_U16(maddr)));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LOAD32_S)
+    SLOT_HANDLE_OP(WASM_OP_F64_GE)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(4);
-        PUSH_I64(sign_ext_32_64(LOAD_I32(maddr)));
-        (void)flags;
+        DEF_SLOT_BINOP(float64, uint32, a >= b);
         HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I64_LOAD32_U)
+
+    SLOT_HANDLE_OP(WASM_OP_I32_CLZ)
     {
-        uint32 offset, flags, addr;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(4);
-        PUSH_I64((uint64)(LOAD_U32(maddr)));
-        (void)flags;
+        DEF_SLOT_UNOP(uint32, uint32, clz32(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_STORE)
-    HANDLE_OP(WASM_OP_F32_STORE)
+    SLOT_HANDLE_OP(WASM_OP_I32_CTZ)
     {
-        uint32 offset, flags, addr;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        frame_sp--;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(4);
-        STORE_U32(maddr, frame_sp[1]);
-        (void)flags;
+        DEF_SLOT_UNOP(uint32, uint32, ctz32(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_STORE)
-    HANDLE_OP(WASM_OP_F64_STORE)
+    SLOT_HANDLE_OP(WASM_OP_I32_POPCNT)
     {
-        uint32 offset, flags, addr;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        frame_sp -= 2;
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(8);
-        PUT_I64_TO_ADDR(maddr, GET_I64_FROM_ADDR(frame_sp + 1));
-        (void)flags;
+        DEF_SLOT_UNOP(uint32, uint32, popcount32(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_STORE8)
+    SLOT_HANDLE_OP(WASM_OP_I32_ADD)
     {
-        uint32 offset, flags, addr;
-        uint32 sval;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        sval = (uint32)POP_I32();
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(1);
-        *(uint8 *)maddr = (uint8)sval;
-        (void)flags;
+        DEF_SLOT_BINOP(uint32, uint32, a + b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_STORE16)
+    SLOT_HANDLE_OP(WASM_OP_I32_SUB)
     {
-        uint32 offset, flags, addr;
-        uint32 sval;
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        sval = (uint32)POP_I32();
-        addr = POP_I32();
-        CHECK_MEMORY_OVERFLOW(2);
-        STORE_U16(maddr, (uint16)sval);
-
-        (void)flags;
+        DEF_SLOT_BINOP(uint32, uint32, a - b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_STORE8)
+    SLOT_HANDLE_OP(WASM_OP_I32_MUL)
     {
-        uint32 offset, flags, addr;
-        uint64 sval;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        sval = (uint64)POP_I64();
-        addr = POP_I32();
-
-        CHECK_MEMORY_OVERFLOW(1);
-        *(uint8 *)maddr = (uint8)sval;
-        (void)flags;
+        DEF_SLOT_BINOP(uint32, uint32, a * b);
         HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I64_STORE16)
-    {
-        uint32 offset, flags, addr;
-        uint64 sval;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        sval = (uint64)POP_I64();
-        addr = POP_I32();
-
-        CHECK_MEMORY_OVERFLOW(2);
-        STORE_U16(maddr, (uint16)sval);
 
-        (void)flags;
+    SLOT_HANDLE_OP(WASM_OP_I32_AND)
+    {
+        DEF_SLOT_BINOP(uint32, uint32, a & b);
         HANDLE_OP_END();
     }
-    HANDLE_OP(WASM_OP_I64_STORE32)
-    {
-        uint32 offset, flags, addr;
-        uint64 sval;
-
-        flags = leb_u32_1;
-        offset = leb_u32_2;
-        sval = (uint64)POP_I64();
-        addr = POP_I32();
-
-        CHECK_MEMORY_OVERFLOW(4);
-        STORE_U32(maddr, (uint32)sval);
 
-        (void)flags;
+    SLOT_HANDLE_OP(WASM_OP_I32_OR)
+    {
+        DEF_SLOT_BINOP(uint32, uint32, a | b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_MEMORY_SIZE)
+    SLOT_HANDLE_OP(WASM_OP_I32_XOR)
     {
-        uint32 reserved;
-        reserved = leb_u32_2;
-        PUSH_I32(memory->cur_page_count);
-        (void)reserved;
+        DEF_SLOT_BINOP(uint32, uint32, a ^ b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_MEMORY_GROW)
+    SLOT_HANDLE_OP(WASM_OP_I32_SHL)
     {
-        uint32 reserved, delta,
-            prev_page_count = memory->cur_page_count;
-
-        reserved = leb_u32_2;
-        delta = (uint32)POP_I32();
+        DEF_SLOT_BINOP(uint32, uint32, a << (b % 32));
+        HANDLE_OP_END();
+    }
 
-        if (!wasm_enlarge_memory(module, delta))
-        {
-            PUSH_I32(-1);
-        }
-        else
-        {
-            PUSH_I32(prev_page_count);
-            linear_mem_size =
-                num_bytes_per_page * memory->cur_page_count;
-        }
+    SLOT_HANDLE_OP(WASM_OP_I32_SHR_S)
+    {
+        DEF_SLOT_BINOP(int32, int32, a >> ((uint32)b % 32));
+        HANDLE_OP_END();
+    }
 
-        (void)reserved;
+    SLOT_HANDLE_OP(WASM_OP_I32_SHR_U)
+    {
+        DEF_SLOT_BINOP(uint32, uint32, a >> (b % 32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_CONST)
-    PUSH_I32(leb_i32);
-    HANDLE_OP_END();
+    SLOT_HANDLE_OP(WASM_OP_I32_ROTL)
+    {
+        DEF_SLOT_BINOP(uint32, uint32, rotl32(a, b));
+        HANDLE_OP_END();
+    }
 
-    HANDLE_OP(WASM_OP_I64_CONST)
-    PUSH_I64(leb_i64);
-    HANDLE_OP_END();
+    SLOT_HANDLE_OP(WASM_OP_I32_ROTR)
+    {
+        DEF_SLOT_BINOP(uint32, uint32, rotr32(a, b));
+        HANDLE_OP_END();
+    }
 
-    HANDLE_OP(WASM_OP_F32_CONST)
-    EXEC_OP(WASM_OP_F32_CONST)
+    SLOT_HANDLE_OP(WASM_OP_I64_CLZ)
     {
-        uint8 *p_float = (uint8 *)frame_sp++;
-        for (i = 0; i < sizeof(float32); i++)
-            *p_float++ = *frame_ip++;
+        DEF_SLOT_UNOP(uint64, uint64, clz64(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CONST)
-    EXEC_OP(WASM_OP_F64_CONST)
+    SLOT_HANDLE_OP(WASM_OP_I64_CTZ)
     {
-        uint8 *p_float = (uint8 *)frame_sp++;
-        frame_sp++;
-        for (i = 0; i < sizeof(float64); i++)
-            *p_float++ = *frame_ip++;
+        DEF_SLOT_UNOP(uint64, uint64, ctz64(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_EQZ)
-    EXEC_OP(WASM_OP_I32_EQZ)
+    SLOT_HANDLE_OP(WASM_OP_I64_POPCNT)
     {
-        DEF_OP_EQZ(I32);
+        DEF_SLOT_UNOP(uint64, uint64, popcount64(a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_EQ)
-    EXEC_OP(WASM_OP_I32_EQ)
+    SLOT_HANDLE_OP(WASM_OP_I64_ADD)
     {
-        DEF_OP_CMP(uint32, I32, ==);
+        DEF_SLOT_BINOP(uint64, uint64, a + b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_NE)
-    EXEC_OP(WASM_OP_I32_NE)
+    SLOT_HANDLE_OP(WASM_OP_I64_SUB)
     {
-        DEF_OP_CMP(uint32, I32, !=);
+        DEF_SLOT_BINOP(uint64, uint64, a - b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LT_S)
-    EXEC_OP(WASM_OP_I32_LT_S)
+    SLOT_HANDLE_OP(WASM_OP_I64_MUL)
     {
-        DEF_OP_CMP(int32, I32, <);
+        DEF_SLOT_BINOP(uint64, uint64, a * b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LT_U)
-    EXEC_OP(WASM_OP_I32_LT_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_AND)
     {
-        DEF_OP_CMP(uint32, I32, <);
+        DEF_SLOT_BINOP(uint64, uint64, a & b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_GT_S)
-    EXEC_OP(WASM_OP_I32_GT_S)
+    SLOT_HANDLE_OP(WASM_OP_I64_OR)
     {
-        DEF_OP_CMP(int32, I32, >);
+        DEF_SLOT_BINOP(uint64, uint64, a | b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_GT_U)
-    EXEC_OP(WASM_OP_I32_GT_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_XOR)
     {
-        DEF_OP_CMP(uint32, I32, >);
+        DEF_SLOT_BINOP(uint64, uint64, a ^ b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LE_S)
-    EXEC_OP(WASM_OP_I32_LE_S)
+    SLOT_HANDLE_OP(WASM_OP_I64_SHL)
     {
-        DEF_OP_CMP(int32, I32, <=);
+        DEF_SLOT_BINOP(uint64, uint64, a << (b % 64));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_LE_U)
-    EXEC_OP(WASM_OP_I32_LE_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_SHR_S)
     {
-        DEF_OP_CMP(uint32, I32, <=);
+        DEF_SLOT_BINOP(int64, int64, a >> ((uint64)b % 64));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_GE_S)
-    EXEC_OP(WASM_OP_I32_GE_S)
+    SLOT_HANDLE_OP(WASM_OP_I64_SHR_U)
     {
-        DEF_OP_CMP(int32, I32, >=);
+        DEF_SLOT_BINOP(uint64, uint64, a >> (b % 64));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_GE_U)
-    EXEC_OP(WASM_OP_I32_GE_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_ROTL)
     {
-        DEF_OP_CMP(uint32, I32, >=);
+        DEF_SLOT_BINOP(uint64, uint64, rotl64(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EQZ)
-    EXEC_OP(WASM_OP_I64_EQZ)
+    SLOT_HANDLE_OP(WASM_OP_I64_ROTR)
     {
-        DEF_OP_EQZ(I64);
+        DEF_SLOT_BINOP(uint64, uint64, rotr64(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EQ)
-    EXEC_OP(WASM_OP_I64_EQ)
+    SLOT_HANDLE_OP(WASM_OP_F32_ADD)
     {
-        DEF_OP_CMP(uint64, I64, ==);
+        DEF_SLOT_BINOP(float32, float32, a + b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_NE)
-    EXEC_OP(WASM_OP_I64_NE)
+    SLOT_HANDLE_OP(WASM_OP_F32_SUB)
     {
-        DEF_OP_CMP(uint64, I64, !=);
+        DEF_SLOT_BINOP(float32, float32, a - b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LT_S)
-    EXEC_OP(WASM_OP_I64_LT_S)
+    SLOT_HANDLE_OP(WASM_OP_F32_MUL)
     {
-        DEF_OP_CMP(int64, I64, <);
+        DEF_SLOT_BINOP(float32, float32, a * b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LT_U)
-    EXEC_OP(WASM_OP_I64_LT_U)
+    SLOT_HANDLE_OP(WASM_OP_F32_DIV)
     {
-        DEF_OP_CMP(uint64, I64, <);
+        DEF_SLOT_BINOP(float32, float32, a / b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_GT_S)
-    EXEC_OP(WASM_OP_I64_GT_S)
+    SLOT_HANDLE_OP(WASM_OP_F64_ADD)
     {
-        DEF_OP_CMP(int64, I64, >);
+        DEF_SLOT_BINOP(float64, float64, a + b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_GT_U)
-    EXEC_OP(WASM_OP_I64_GT_U)
+    SLOT_HANDLE_OP(WASM_OP_F64_SUB)
     {
-        DEF_OP_CMP(uint64, I64, >);
+        DEF_SLOT_BINOP(float64, float64, a - b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LE_S)
-    EXEC_OP(WASM_OP_I64_LE_S)
+    SLOT_HANDLE_OP(WASM_OP_F64_MUL)
     {
-        DEF_OP_CMP(int64, I64, <=);
+        DEF_SLOT_BINOP(float64, float64, a * b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_LE_U)
-    EXEC_OP(WASM_OP_I64_LE_U)
+    SLOT_HANDLE_OP(WASM_OP_F64_DIV)
     {
-        DEF_OP_CMP(uint64, I64, <=);
+        DEF_SLOT_BINOP(float64, float64, a / b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_GE_S)
-    EXEC_OP(WASM_OP_I64_GE_S)
+    SLOT_HANDLE_OP(WASM_OP_I32_WRAP_I64)
     {
-        DEF_OP_CMP(int64, I64, >=);
+        DEF_SLOT_UNOP(uint64, uint32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_GE_U)
-    EXEC_OP(WASM_OP_I64_GE_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_EXTEND_S_I32)
     {
-        DEF_OP_CMP(uint64, I64, >=);
+        DEF_SLOT_UNOP(int32, int64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_EQ)
-    EXEC_OP(WASM_OP_F32_EQ)
+    SLOT_HANDLE_OP(WASM_OP_I64_EXTEND_U_I32)
     {
-        DEF_OP_CMP(float32, F32, ==);
+        DEF_SLOT_UNOP(uint32, uint64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_NE)
-    EXEC_OP(WASM_OP_F32_NE)
+    SLOT_HANDLE_OP(WASM_OP_F32_CONVERT_S_I32)
     {
-        DEF_OP_CMP(float32, F32, !=);
+        DEF_SLOT_UNOP(int32, float32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_LT)
-    EXEC_OP(WASM_OP_F32_LT)
+    SLOT_HANDLE_OP(WASM_OP_F32_CONVERT_U_I32)
     {
-        DEF_OP_CMP(float32, F32, <);
+        DEF_SLOT_UNOP(uint32, float32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_GT)
-    EXEC_OP(WASM_OP_F32_GT)
+    SLOT_HANDLE_OP(WASM_OP_F32_DEMOTE_F64)
     {
-        DEF_OP_CMP(float32, F32, >);
+        DEF_SLOT_UNOP(float64, float32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_LE)
-    EXEC_OP(WASM_OP_F32_LE)
+    SLOT_HANDLE_OP(WASM_OP_F64_CONVERT_S_I32)
     {
-        DEF_OP_CMP(float32, F32, <=);
+        DEF_SLOT_UNOP(int32, float64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_GE)
-    EXEC_OP(WASM_OP_F32_GE)
+    SLOT_HANDLE_OP(WASM_OP_F64_CONVERT_U_I32)
     {
-        DEF_OP_CMP(float32, F32, >=);
+        DEF_SLOT_UNOP(uint32, float64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_EQ)
-    EXEC_OP(WASM_OP_F64_EQ)
+    SLOT_HANDLE_OP(WASM_OP_F64_PROMOTE_F32)
     {
-        DEF_OP_CMP(float64, F64, ==);
+        DEF_SLOT_UNOP(float32, float64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_NE)
-    EXEC_OP(WASM_OP_F64_NE)
+    SLOT_HANDLE_OP(WASM_OP_I32_REINTERPRET_F32)
     {
-        DEF_OP_CMP(float64, F64, !=);
+        DEF_SLOT_UNOP(uint32, uint32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_LT)
-    EXEC_OP(WASM_OP_F64_LT)
+    SLOT_HANDLE_OP(WASM_OP_I64_REINTERPRET_F64)
     {
-        DEF_OP_CMP(float64, F64, <);
+        DEF_SLOT_UNOP(uint64, uint64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_GT)
-    EXEC_OP(WASM_OP_F64_GT)
+    SLOT_HANDLE_OP(WASM_OP_F32_REINTERPRET_I32)
     {
-        DEF_OP_CMP(float64, F64, >);
+        DEF_SLOT_UNOP(uint32, uint32, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_LE)
-    EXEC_OP(WASM_OP_F64_LE)
+    SLOT_HANDLE_OP(WASM_OP_F64_REINTERPRET_I64)
     {
-        DEF_OP_CMP(float64, F64, <=);
+        DEF_SLOT_UNOP(uint64, uint64, a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_GE)
-    EXEC_OP(WASM_OP_F64_GE)
+    SLOT_HANDLE_OP(WASM_OP_I32_EXTEND8_S)
     {
-        DEF_OP_CMP(float64, F64, >=);
+        DEF_SLOT_UNOP(uint32, int32, sign_ext_8_32((int8)a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_CLZ)
-    EXEC_OP(WASM_OP_I32_CLZ)
+    SLOT_HANDLE_OP(WASM_OP_I32_EXTEND16_S)
     {
-        DEF_OP_BIT_COUNT(uint32, I32, clz32);
+        DEF_SLOT_UNOP(uint32, int32, sign_ext_16_32((int16)a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_CTZ)
-    EXEC_OP(WASM_OP_I32_CTZ)
+    SLOT_HANDLE_OP(WASM_OP_I64_EXTEND8_S)
     {
-        DEF_OP_BIT_COUNT(uint32, I32, ctz32);
+        DEF_SLOT_UNOP(uint64, int64, sign_ext_8_64((int8)a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_POPCNT)
-    EXEC_OP(WASM_OP_I32_POPCNT)
+    SLOT_HANDLE_OP(WASM_OP_I64_EXTEND16_S)
     {
-        DEF_OP_BIT_COUNT(uint32, I32, popcount32);
+        DEF_SLOT_UNOP(uint64, int64, sign_ext_16_64((int16)a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_ADD)
-    EXEC_OP(WASM_OP_I32_ADD)
+    SLOT_HANDLE_OP(WASM_OP_I64_EXTEND32_S)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, +);
+        DEF_SLOT_UNOP(uint64, int64, sign_ext_32_64((int32)a));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_SUB)
-    EXEC_OP(WASM_OP_I32_SUB)
+    SLOT_HANDLE_OP(WASM_OP_F32_LOAD)
+    SLOT_HANDLE_OP(WASM_OP_I32_LOAD)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, -);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(4);
+        *(int32 *)SLOT_ADDR(operands, 0) = LOAD_I32(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_MUL)
-    EXEC_OP(WASM_OP_I32_MUL)
+    SLOT_HANDLE_OP(WASM_OP_F64_LOAD)
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, *);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(8);
+        *(int64 *)SLOT_ADDR(operands, 0) = LOAD_I64(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_DIV_S)
-    EXEC_OP(WASM_OP_I32_DIV_S)
+    SLOT_HANDLE_OP(WASM_OP_I32_LOAD8_S)
     {
-        int32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(int32 *)SLOT_ADDR(operands, 0) = sign_ext_8_32(*(int8 *)maddr);
+        HANDLE_OP_END();
+    }
 
-        b = POP_I32();
-        a = POP_I32();
-        if (a == (int32)0x80000000 && b == -1)
-        {
-            wasm_set_exception(module, "integer overflow");
-            goto got_exception;
-        }
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I32(a / b);
+    SLOT_HANDLE_OP(WASM_OP_I32_LOAD8_U)
+    {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(uint32 *)SLOT_ADDR(operands, 0) = (uint32)(*(uint8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_DIV_U)
-    EXEC_OP(WASM_OP_I32_DIV_U)
+    SLOT_HANDLE_OP(WASM_OP_I32_LOAD16_S)
     {
-        uint32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        *(int32 *)SLOT_ADDR(operands, 0) = sign_ext_16_32(LOAD_I16(maddr));
+        HANDLE_OP_END();
+    }
 
-        b = (uint32)POP_I32();
-        a = (uint32)POP_I32();
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I32(a / b);
+    SLOT_HANDLE_OP(WASM_OP_I32_LOAD16_U)
+    {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        *(uint32 *)SLOT_ADDR(operands, 0) = (uint32)(LOAD_U16(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_REM_S)
-    EXEC_OP(WASM_OP_I32_REM_S)
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD8_S)
     {
-        int32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(int64 *)SLOT_ADDR(operands, 0) = sign_ext_8_64(*(int8 *)maddr);
+        HANDLE_OP_END();
+    }
 
-        b = POP_I32();
-        a = POP_I32();
-        if (a == (int32)0x80000000 && b == -1)
-        {
-            PUSH_I32(0);
-            HANDLE_OP_END();
-        }
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I32(a % b);
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD8_U)
+    {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(uint64 *)SLOT_ADDR(operands, 0) = (uint64)(*(uint8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_REM_U)
-    EXEC_OP(WASM_OP_I32_REM_U)
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD16_S)
     {
-        uint32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        *(int64 *)SLOT_ADDR(operands, 0) = sign_ext_16_64(LOAD_I16(maddr));
+        HANDLE_OP_END();
+    }
 
-        b = (uint32)POP_I32();
-        a = (uint32)POP_I32();
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I32(a % b);
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD16_U)
+    {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        *(uint64 *)SLOT_ADDR(operands, 0) = (uint64)(LOAD_U16(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_AND)
-    EXEC_OP(WASM_OP_I32_AND)
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD32_S)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, &);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(4);
+        *(int64 *)SLOT_ADDR(operands, 0) = sign_ext_32_64(LOAD_I32(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_OR)
-    EXEC_OP(WASM_OP_I32_OR)
+    SLOT_HANDLE_OP(WASM_OP_I64_LOAD32_U)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, |);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(4);
+        *(uint64 *)SLOT_ADDR(operands, 0) = (uint64)(LOAD_U32(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_XOR)
-    EXEC_OP(WASM_OP_I32_XOR)
+    SLOT_HANDLE_OP(WASM_OP_F32_STORE)
+    SLOT_HANDLE_OP(WASM_OP_I32_STORE)
     {
-        DEF_OP_NUMERIC(uint32, uint32, I32, ^);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint32 sval = *(uint32 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(4);
+        STORE_U32(maddr, sval);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_SHL)
-    EXEC_OP(WASM_OP_I32_SHL)
+    SLOT_HANDLE_OP(WASM_OP_F64_STORE)
+    SLOT_HANDLE_OP(WASM_OP_I64_STORE)
     {
-        DEF_OP_NUMERIC2(uint32, uint32, I32, <<);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        int64 sval = *(int64 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(8);
+        PUT_I64_TO_ADDR(maddr, sval);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_SHR_S)
-    EXEC_OP(WASM_OP_I32_SHR_S)
+    SLOT_HANDLE_OP(WASM_OP_I32_STORE8)
     {
-        DEF_OP_NUMERIC2(int32, uint32, I32, >>);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint32 sval = *(uint32 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(uint8 *)maddr = (uint8)sval;
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_SHR_U)
-    EXEC_OP(WASM_OP_I32_SHR_U)
+    SLOT_HANDLE_OP(WASM_OP_I32_STORE16)
     {
-        DEF_OP_NUMERIC2(uint32, uint32, I32, >>);
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint32 sval = *(uint32 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        STORE_U16(maddr, (uint16)sval);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_ROTL)
-    EXEC_OP(WASM_OP_I32_ROTL)
+    SLOT_HANDLE_OP(WASM_OP_I64_STORE8)
     {
-        uint32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint64 sval = *(uint64 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(uint8 *)maddr = (uint8)sval;
+        HANDLE_OP_END();
+    }
 
-        b = (uint32)POP_I32();
-        a = (uint32)POP_I32();
-        PUSH_I32(rotl32(a, b));
+    SLOT_HANDLE_OP(WASM_OP_I64_STORE16)
+    {
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint64 sval = *(uint64 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(2);
+        STORE_U16(maddr, (uint16)sval);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_ROTR)
-    EXEC_OP(WASM_OP_I32_ROTR)
+    SLOT_HANDLE_OP(WASM_OP_I64_STORE32)
     {
-        uint32 a, b;
+        uint64 operands = READ_IR_OPERAND(uint64);
+        uint32 offset = (uint32)(operands >> 32);
+        uint32 addr = *(uint32 *)SLOT_ADDR(operands, 1);
+        uint64 sval = *(uint64 *)SLOT_ADDR(operands, 0);
+        uint8 *maddr;
+        CHECK_MEMORY_OVERFLOW(4);
+        STORE_U32(maddr, (uint32)sval);
+        HANDLE_OP_END();
+    }
+#endif
 
-        b = (uint32)POP_I32();
-        a = (uint32)POP_I32();
-        PUSH_I32(rotr32(a, b));
+#if WASM_ENABLE_TOS_CACHE != 0
+    TOS_HANDLE_OP(EXT_OP_GET_LOCAL_FAST, 0, 1)
+    {
+        tos = frame_lp[READ_IR_OPERAND(uint32)];
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_CLZ)
-    EXEC_OP(WASM_OP_I64_CLZ)
+    TOS_HANDLE_OP(EXT_OP_GET_LOCAL_FAST, 1, 0)
     {
-        DEF_OP_BIT_COUNT(uint64, I64, clz64);
+        *frame_sp++ = tos;
+        *frame_sp++ = frame_lp[READ_IR_OPERAND(uint32)];
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_CTZ)
-    EXEC_OP(WASM_OP_I64_CTZ)
+    TOS_HANDLE_OP(EXT_OP_GET_LOCAL_FAST, 1, 1)
     {
-        DEF_OP_BIT_COUNT(uint64, I64, ctz64);
+        *frame_sp++ = tos;
+        tos = frame_lp[READ_IR_OPERAND(uint32)];
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_POPCNT)
-    EXEC_OP(WASM_OP_I64_POPCNT)
+    TOS_HANDLE_OP(WASM_OP_I32_CONST, 0, 1)
     {
-        DEF_OP_BIT_COUNT(uint64, I64, popcount64);
+        tos = READ_IR_OPERAND(uint32);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_ADD)
-    EXEC_OP(WASM_OP_I64_ADD)
+    TOS_HANDLE_OP(WASM_OP_I32_CONST, 1, 0)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, +);
+        *frame_sp++ = tos;
+        *frame_sp++ = READ_IR_OPERAND(uint32);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_SUB)
-    EXEC_OP(WASM_OP_I64_SUB)
+    TOS_HANDLE_OP(WASM_OP_I32_CONST, 1, 1)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, -);
+        *frame_sp++ = tos;
+        tos = READ_IR_OPERAND(uint32);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_MUL)
-    EXEC_OP(WASM_OP_I64_MUL)
+    TOS_HANDLE_OP(WASM_OP_GET_GLOBAL, 0, 1)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, *);
+        tos = *(uint32 *)(global_data + READ_IR_OPERAND(uint32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_DIV_S)
-    EXEC_OP(WASM_OP_I64_DIV_S)
+    TOS_HANDLE_OP(WASM_OP_GET_GLOBAL, 1, 0)
     {
-        int64 a, b;
+        *frame_sp++ = tos;
+        *frame_sp++ = *(uint32 *)(global_data + READ_IR_OPERAND(uint32));
+        HANDLE_OP_END();
+    }
 
-        b = POP_I64();
-        a = POP_I64();
-        if (a == (int64)0x8000000000000000LL && b == -1)
-        {
-            wasm_set_exception(module, "integer overflow");
-            goto got_exception;
-        }
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I64(a / b);
+    TOS_HANDLE_OP(WASM_OP_GET_GLOBAL, 1, 1)
+    {
+        *frame_sp++ = tos;
+        tos = *(uint32 *)(global_data + READ_IR_OPERAND(uint32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_DIV_U)
-    EXEC_OP(WASM_OP_I64_DIV_U)
+    TOS_HANDLE_OP(WASM_OP_I32_EQZ, 0, 1)
     {
-        uint64 a, b;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a == 0);
+        HANDLE_OP_END();
+    }
 
-        b = (uint64)POP_I64();
-        a = (uint64)POP_I64();
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I64(a / b);
+    TOS_HANDLE_OP(WASM_OP_I32_EQZ, 1, 0)
+    {
+        uint32 a = (uint32)tos;
+        *frame_sp++ = (uint32)(a == 0);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_REM_S)
-    EXEC_OP(WASM_OP_I64_REM_S)
+    TOS_HANDLE_OP(WASM_OP_I32_EQZ, 1, 1)
     {
-        int64 a, b;
+        uint32 a = (uint32)tos;
+        tos = (uint32)(a == 0);
+        HANDLE_OP_END();
+    }
 
-        b = POP_I64();
-        a = POP_I64();
-        if (a == (int64)0x8000000000000000LL && b == -1)
-        {
-            PUSH_I64(0);
-            HANDLE_OP_END();
-        }
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I64(a % b);
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND8_S, 0, 1)
+    {
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)((int32)(int8)a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_REM_U)
-    EXEC_OP(WASM_OP_I64_REM_U)
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND8_S, 1, 0)
     {
-        uint64 a, b;
+        int32 a = (int32)tos;
+        *frame_sp++ = (uint32)((int32)(int8)a);
+        HANDLE_OP_END();
+    }
 
-        b = (uint64)POP_I64();
-        a = (uint64)POP_I64();
-        if (b == 0)
-        {
-            wasm_set_exception(module, "integer divide by zero");
-            goto got_exception;
-        }
-        PUSH_I64(a % b);
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND8_S, 1, 1)
+    {
+        int32 a = (int32)tos;
+        tos = (uint32)((int32)(int8)a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_AND)
-    EXEC_OP(WASM_OP_I64_AND)
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND16_S, 0, 1)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, &);
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)((int32)(int16)a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_OR)
-    EXEC_OP(WASM_OP_I64_OR)
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND16_S, 1, 0)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, |);
+        int32 a = (int32)tos;
+        *frame_sp++ = (uint32)((int32)(int16)a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_XOR)
-    EXEC_OP(WASM_OP_I64_XOR)
+    TOS_HANDLE_OP(WASM_OP_I32_EXTEND16_S, 1, 1)
     {
-        DEF_OP_NUMERIC_64(uint64, uint64, I64, ^);
+        int32 a = (int32)tos;
+        tos = (uint32)((int32)(int16)a);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_SHL)
-    EXEC_OP(WASM_OP_I64_SHL)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD, 0, 1)
     {
-        DEF_OP_NUMERIC2_64(uint64, uint64, I64, <<);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(4);
+        tos = LOAD_U32(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_SHR_S)
-    EXEC_OP(WASM_OP_I64_SHR_S)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD, 1, 0)
     {
-        DEF_OP_NUMERIC2_64(int64, uint64, I64, >>);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(4);
+        *frame_sp++ = LOAD_U32(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_SHR_U)
-    EXEC_OP(WASM_OP_I64_SHR_U)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD, 1, 1)
     {
-        DEF_OP_NUMERIC2_64(uint64, uint64, I64, >>);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(4);
+        tos = LOAD_U32(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_ROTL)
-    EXEC_OP(WASM_OP_I64_ROTL)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_S, 0, 1)
     {
-        uint64 a, b;
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(1);
+        tos = (uint32)sign_ext_8_32(*(int8 *)maddr);
+        HANDLE_OP_END();
+    }
 
-        b = (uint64)POP_I64();
-        a = (uint64)POP_I64();
-        PUSH_I64(rotl64(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_S, 1, 0)
+    {
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(1);
+        *frame_sp++ = (uint32)sign_ext_8_32(*(int8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_ROTR)
-    EXEC_OP(WASM_OP_I64_ROTR)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_S, 1, 1)
     {
-        uint64 a, b;
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(1);
+        tos = (uint32)sign_ext_8_32(*(int8 *)maddr);
+        HANDLE_OP_END();
+    }
 
-        b = (uint64)POP_I64();
-        a = (uint64)POP_I64();
-        PUSH_I64(rotr64(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_U, 0, 1)
+    {
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(1);
+        tos = (uint32)(*(uint8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_ABS)
-    EXEC_OP(WASM_OP_F32_ABS)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_U, 1, 0)
     {
-        DEF_OP_MATH(float32, F32, fabsf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(1);
+        *frame_sp++ = (uint32)(*(uint8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_NEG)
-    EXEC_OP(WASM_OP_F32_NEG)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD8_U, 1, 1)
     {
-        uint32 u32 = frame_sp[-1];
-        uint32 sign_bit = u32 & ((uint32)1 << 31);
-        if (sign_bit)
-            frame_sp[-1] = u32 & ~((uint32)1 << 31);
-        else
-            frame_sp[-1] = u32 | ((uint32)1 << 31);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(1);
+        tos = (uint32)(*(uint8 *)maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_CEIL)
-    EXEC_OP(WASM_OP_F32_CEIL)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_S, 0, 1)
     {
-        DEF_OP_MATH(float32, F32, ceilf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(2);
+        tos = (uint32)sign_ext_16_32(LOAD_I16(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_FLOOR)
-    EXEC_OP(WASM_OP_F32_FLOOR)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_S, 1, 0)
     {
-        DEF_OP_MATH(float32, F32, floorf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(2);
+        *frame_sp++ = (uint32)sign_ext_16_32(LOAD_I16(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_TRUNC)
-    EXEC_OP(WASM_OP_F32_TRUNC)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_S, 1, 1)
     {
-        DEF_OP_MATH(float32, F32, truncf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(2);
+        tos = (uint32)sign_ext_16_32(LOAD_I16(maddr));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_NEAREST)
-    EXEC_OP(WASM_OP_F32_NEAREST)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_U, 0, 1)
     {
-        DEF_OP_MATH(float32, F32, rintf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(2);
+        tos = (uint32)LOAD_U16(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_SQRT)
-    EXEC_OP(WASM_OP_F32_SQRT)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_U, 1, 0)
     {
-        DEF_OP_MATH(float32, F32, sqrtf);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(2);
+        *frame_sp++ = (uint32)LOAD_U16(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_ADD)
-    EXEC_OP(WASM_OP_F32_ADD)
+    TOS_HANDLE_OP(WASM_OP_I32_LOAD16_U, 1, 1)
     {
-        DEF_OP_NUMERIC(float32, float32, F32, +);
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = tos;
+        CHECK_MEMORY_OVERFLOW(2);
+        tos = (uint32)LOAD_U16(maddr);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_SUB)
-    EXEC_OP(WASM_OP_F32_SUB)
+    TOS_HANDLE_OP(EXT_OP_TEE_LOCAL_FAST, 0, 1)
     {
-        DEF_OP_NUMERIC(float32, float32, F32, -);
+        tos = *--frame_sp;
+        frame_lp[READ_IR_OPERAND(uint32)] = tos;
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_MUL)
-    EXEC_OP(WASM_OP_F32_MUL)
+    TOS_HANDLE_OP(EXT_OP_TEE_LOCAL_FAST, 1, 0)
     {
-        DEF_OP_NUMERIC(float32, float32, F32, *);
+        frame_lp[READ_IR_OPERAND(uint32)] = tos;
+        *frame_sp++ = tos;
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_DIV)
-    EXEC_OP(WASM_OP_F32_DIV)
+    TOS_HANDLE_OP(EXT_OP_TEE_LOCAL_FAST, 1, 1)
     {
-        DEF_OP_NUMERIC(float32, float32, F32, /);
+        frame_lp[READ_IR_OPERAND(uint32)] = tos;
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_MIN)
-    EXEC_OP(WASM_OP_F32_MIN)
+    TOS_HANDLE_OP(WASM_OP_I32_ADD, 0, 1)
     {
-        float32 a, b;
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a + b);
+        HANDLE_OP_END();
+    }
 
-        b = POP_F32();
-        a = POP_F32();
+    TOS_HANDLE_OP(WASM_OP_I32_ADD, 1, 0)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a + b);
+        HANDLE_OP_END();
+    }
 
-        PUSH_F32(f32_min(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_ADD, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a + b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_MAX)
-    EXEC_OP(WASM_OP_F32_MAX)
+    TOS_HANDLE_OP(WASM_OP_I32_SUB, 0, 1)
     {
-        float32 a, b;
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a - b);
+        HANDLE_OP_END();
+    }
 
-        b = POP_F32();
-        a = POP_F32();
+    TOS_HANDLE_OP(WASM_OP_I32_SUB, 1, 0)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a - b);
+        HANDLE_OP_END();
+    }
 
-        PUSH_F32(f32_max(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_SUB, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a - b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_COPYSIGN)
-    EXEC_OP(WASM_OP_F32_COPYSIGN)
+    TOS_HANDLE_OP(WASM_OP_I32_MUL, 0, 1)
     {
-        float32 a, b;
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a * b);
+        HANDLE_OP_END();
+    }
 
-        b = POP_F32();
-        a = POP_F32();
-        PUSH_F32(local_copysignf(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_MUL, 1, 0)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a * b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_ABS)
-    EXEC_OP(WASM_OP_F64_ABS)
+    TOS_HANDLE_OP(WASM_OP_I32_MUL, 1, 1)
     {
-        DEF_OP_MATH(float64, F64, fabs);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a * b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_NEG)
-    EXEC_OP(WASM_OP_F64_NEG)
+    TOS_HANDLE_OP(WASM_OP_I32_AND, 0, 1)
     {
-        uint64 u64 = GET_I64_FROM_ADDR(frame_sp - 2);
-        uint64 sign_bit = u64 & (((uint64)1) << 63);
-        if (sign_bit)
-            PUT_I64_TO_ADDR(frame_sp - 2, (u64 & ~(((uint64)1) << 63)));
-        else
-            PUT_I64_TO_ADDR(frame_sp - 2, (u64 | (((uint64)1) << 63)));
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a & b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CEIL)
-    EXEC_OP(WASM_OP_F64_CEIL)
+    TOS_HANDLE_OP(WASM_OP_I32_AND, 1, 0)
     {
-        DEF_OP_MATH(float64, F64, ceil);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a & b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_FLOOR)
-    EXEC_OP(WASM_OP_F64_FLOOR)
+    TOS_HANDLE_OP(WASM_OP_I32_AND, 1, 1)
     {
-        DEF_OP_MATH(float64, F64, floor);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a & b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_TRUNC)
-    EXEC_OP(WASM_OP_F64_TRUNC)
+    TOS_HANDLE_OP(WASM_OP_I32_OR, 0, 1)
     {
-        DEF_OP_MATH(float64, F64, trunc);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a | b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_NEAREST)
-    EXEC_OP(WASM_OP_F64_NEAREST)
+    TOS_HANDLE_OP(WASM_OP_I32_OR, 1, 0)
     {
-        DEF_OP_MATH(float64, F64, rint);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a | b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_SQRT)
-    EXEC_OP(WASM_OP_F64_SQRT)
+    TOS_HANDLE_OP(WASM_OP_I32_OR, 1, 1)
     {
-        DEF_OP_MATH(float64, F64, sqrt);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a | b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_ADD)
-    EXEC_OP(WASM_OP_F64_ADD)
+    TOS_HANDLE_OP(WASM_OP_I32_XOR, 0, 1)
     {
-        DEF_OP_NUMERIC_64(float64, float64, F64, +);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a ^ b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_SUB)
-    EXEC_OP(WASM_OP_F64_SUB)
+    TOS_HANDLE_OP(WASM_OP_I32_XOR, 1, 0)
     {
-        DEF_OP_NUMERIC_64(float64, float64, F64, -);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a ^ b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_MUL)
-    EXEC_OP(WASM_OP_F64_MUL)
+    TOS_HANDLE_OP(WASM_OP_I32_XOR, 1, 1)
     {
-        DEF_OP_NUMERIC_64(float64, float64, F64, *);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a ^ b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_DIV)
-    EXEC_OP(WASM_OP_F64_DIV)
+    TOS_HANDLE_OP(WASM_OP_I32_SHL, 0, 1)
     {
-        DEF_OP_NUMERIC_64(float64, float64, F64, /);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a << (b % 32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_MIN)
-    EXEC_OP(WASM_OP_F64_MIN)
+    TOS_HANDLE_OP(WASM_OP_I32_SHL, 1, 0)
     {
-        float64 a, b;
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a << (b % 32));
+        HANDLE_OP_END();
+    }
 
-        b = POP_F64();
-        a = POP_F64();
+    TOS_HANDLE_OP(WASM_OP_I32_SHL, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a << (b % 32));
+        HANDLE_OP_END();
+    }
 
-        PUSH_F64(f64_min(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_S, 0, 1)
+    {
+        int32 b = (int32)*--frame_sp;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a >> ((uint32)b % 32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_MAX)
-    EXEC_OP(WASM_OP_F64_MAX)
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_S, 1, 0)
     {
-        float64 a, b;
+        int32 b = (int32)tos;
+        int32 a = (int32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a >> ((uint32)b % 32));
+        HANDLE_OP_END();
+    }
 
-        b = POP_F64();
-        a = POP_F64();
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_S, 1, 1)
+    {
+        int32 b = (int32)tos;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a >> ((uint32)b % 32));
+        HANDLE_OP_END();
+    }
 
-        PUSH_F64(f64_max(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_U, 0, 1)
+    {
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a >> (b % 32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_COPYSIGN)
-    EXEC_OP(WASM_OP_F64_COPYSIGN)
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_U, 1, 0)
     {
-        float64 a, b;
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a >> (b % 32));
+        HANDLE_OP_END();
+    }
 
-        b = POP_F64();
-        a = POP_F64();
-        PUSH_F64(local_copysign(a, b));
+    TOS_HANDLE_OP(WASM_OP_I32_SHR_U, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a >> (b % 32));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_WRAP_I64)
-    EXEC_OP(WASM_OP_I32_WRAP_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTL, 0, 1)
     {
-        int32 value = (int32)(POP_I64() & 0xFFFFFFFFLL);
-        PUSH_I32(value);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(rotl32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_TRUNC_S_F32)
-    EXEC_OP(WASM_OP_I32_TRUNC_S_F32)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTL, 1, 0)
     {
-        DEF_OP_TRUNC_F32(-2147483904.0f, 2147483648.0f, true, true);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(rotl32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_TRUNC_U_F32)
-    EXEC_OP(WASM_OP_I32_TRUNC_U_F32)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTL, 1, 1)
     {
-        DEF_OP_TRUNC_F32(-1.0f, 4294967296.0f, true, false);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(rotl32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_TRUNC_S_F64)
-    EXEC_OP(WASM_OP_I32_TRUNC_S_F64)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTR, 0, 1)
     {
-        DEF_OP_TRUNC_F64(-2147483649.0, 2147483648.0, true, true);
-        frame_sp--;
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(rotr32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_TRUNC_U_F64)
-    EXEC_OP(WASM_OP_I32_TRUNC_U_F64)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTR, 1, 0)
     {
-        DEF_OP_TRUNC_F64(-1.0, 4294967296.0, true, false);
-        frame_sp--;
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(rotr32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EXTEND_S_I32)
-    EXEC_OP(WASM_OP_I64_EXTEND_S_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_ROTR, 1, 1)
     {
-        DEF_OP_CONVERT(int64, I64, int32, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(rotr32(a, b));
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EXTEND_U_I32)
-    EXEC_OP(WASM_OP_I64_EXTEND_U_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_EQ, 0, 1)
     {
-        DEF_OP_CONVERT(int64, I64, uint32, I32);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_TRUNC_S_F32)
-    EXEC_OP(WASM_OP_I64_TRUNC_S_F32)
+    TOS_HANDLE_OP(WASM_OP_I32_EQ, 1, 0)
     {
-        DEF_OP_TRUNC_F32(-9223373136366403584.0f,
-                         9223372036854775808.0f, false, true);
-        frame_sp++;
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_TRUNC_U_F32)
-    EXEC_OP(WASM_OP_I64_TRUNC_U_F32)
+    TOS_HANDLE_OP(WASM_OP_I32_EQ, 1, 1)
     {
-        DEF_OP_TRUNC_F32(-1.0f, 18446744073709551616.0f, false, false);
-        frame_sp++;
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a == b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_TRUNC_S_F64)
-    EXEC_OP(WASM_OP_I64_TRUNC_S_F64)
+    TOS_HANDLE_OP(WASM_OP_I32_NE, 0, 1)
     {
-        DEF_OP_TRUNC_F64(-9223372036854777856.0, 9223372036854775808.0,
-                         false, true);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_TRUNC_U_F64)
-    EXEC_OP(WASM_OP_I64_TRUNC_U_F64)
+    TOS_HANDLE_OP(WASM_OP_I32_NE, 1, 0)
     {
-        DEF_OP_TRUNC_F64(-1.0, 18446744073709551616.0, false, false);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_CONVERT_S_I32)
-    EXEC_OP(WASM_OP_F32_CONVERT_S_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_NE, 1, 1)
     {
-        DEF_OP_CONVERT(float32, F32, int32, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a != b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_CONVERT_U_I32)
-    EXEC_OP(WASM_OP_F32_CONVERT_U_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_S, 0, 1)
     {
-        DEF_OP_CONVERT(float32, F32, uint32, I32);
+        int32 b = (int32)*--frame_sp;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_CONVERT_S_I64)
-    EXEC_OP(WASM_OP_F32_CONVERT_S_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_S, 1, 0)
     {
-        DEF_OP_CONVERT(float32, F32, int64, I64);
+        int32 b = (int32)tos;
+        int32 a = (int32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_CONVERT_U_I64)
-    EXEC_OP(WASM_OP_F32_CONVERT_U_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_S, 1, 1)
     {
-        DEF_OP_CONVERT(float32, F32, uint64, I64);
+        int32 b = (int32)tos;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F32_DEMOTE_F64)
-    EXEC_OP(WASM_OP_F32_DEMOTE_F64)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_U, 0, 1)
     {
-        DEF_OP_CONVERT(float32, F32, float64, F64);
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CONVERT_S_I32)
-    EXEC_OP(WASM_OP_F64_CONVERT_S_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_U, 1, 0)
     {
-        DEF_OP_CONVERT(float64, F64, int32, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CONVERT_U_I32)
-    EXEC_OP(WASM_OP_F64_CONVERT_U_I32)
+    TOS_HANDLE_OP(WASM_OP_I32_LT_U, 1, 1)
     {
-        DEF_OP_CONVERT(float64, F64, uint32, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a < b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CONVERT_S_I64)
-    EXEC_OP(WASM_OP_F64_CONVERT_S_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_S, 0, 1)
     {
-        DEF_OP_CONVERT(float64, F64, int64, I64);
+        int32 b = (int32)*--frame_sp;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_CONVERT_U_I64)
-    EXEC_OP(WASM_OP_F64_CONVERT_U_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_S, 1, 0)
     {
-        DEF_OP_CONVERT(float64, F64, uint64, I64);
+        int32 b = (int32)tos;
+        int32 a = (int32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_F64_PROMOTE_F32)
-    EXEC_OP(WASM_OP_F64_PROMOTE_F32)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_S, 1, 1)
     {
-        DEF_OP_CONVERT(float64, F64, float32, F32);
+        int32 b = (int32)tos;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_REINTERPRET_F32)
-    HANDLE_OP(WASM_OP_I64_REINTERPRET_F64)
-    HANDLE_OP(WASM_OP_F32_REINTERPRET_I32)
-    HANDLE_OP(WASM_OP_F64_REINTERPRET_I64)
-    EXEC_OP(WASM_OP_I32_REINTERPRET_F32)
-    EXEC_OP(WASM_OP_I64_REINTERPRET_F64)
-    EXEC_OP(WASM_OP_F32_REINTERPRET_I32)
-    EXEC_OP(WASM_OP_F64_REINTERPRET_I64)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_U, 0, 1)
     {
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_EXTEND8_S)
-    EXEC_OP(WASM_OP_I32_EXTEND8_S)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_U, 1, 0)
     {
-        DEF_OP_CONVERT(int32, I32, int8, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I32_EXTEND16_S)
-    EXEC_OP(WASM_OP_I32_EXTEND16_S)
+    TOS_HANDLE_OP(WASM_OP_I32_GT_U, 1, 1)
     {
-        DEF_OP_CONVERT(int32, I32, int16, I32);
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a > b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EXTEND8_S)
-    EXEC_OP(WASM_OP_I64_EXTEND8_S)
+    TOS_HANDLE_OP(WASM_OP_I32_LE_S, 0, 1)
     {
-        DEF_OP_CONVERT(int64, I64, int8, I64);
+        int32 b = (int32)*--frame_sp;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EXTEND16_S)
-    EXEC_OP(WASM_OP_I64_EXTEND16_S)
+    TOS_HANDLE_OP(WASM_OP_I32_LE_S, 1, 0)
     {
-        DEF_OP_CONVERT(int64, I64, int16, I64);
+        int32 b = (int32)tos;
+        int32 a = (int32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_I64_EXTEND32_S)
-    EXEC_OP(WASM_OP_I64_EXTEND32_S)
+    TOS_HANDLE_OP(WASM_OP_I32_LE_S, 1, 1)
     {
-        DEF_OP_CONVERT(int64, I64, int32, I64);
+        int32 b = (int32)tos;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a <= b);
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_MISC_PREFIX)
+    TOS_HANDLE_OP(WASM_OP_I32_LE_U, 0, 1)
     {
-        uint32 opcode1;
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a <= b);
+        HANDLE_OP_END();
+    }
 
-        read_leb_uint32(frame_ip, frame_ip_end, opcode1);
-        opcode = (uint8)opcode1;
+    TOS_HANDLE_OP(WASM_OP_I32_LE_U, 1, 0)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a <= b);
+        HANDLE_OP_END();
+    }
 
-        switch (opcode)
-        {
-        case WASM_OP_I32_TRUNC_SAT_S_F32:
-            DEF_OP_TRUNC_SAT_F32(-2147483904.0f, 2147483648.0f,
-                                 true, true);
-            break;
-        case WASM_OP_I32_TRUNC_SAT_U_F32:
-            DEF_OP_TRUNC_SAT_F32(-1.0f, 4294967296.0f, true, false);
-            break;
-        case WASM_OP_I32_TRUNC_SAT_S_F64:
-            DEF_OP_TRUNC_SAT_F64(-2147483649.0, 2147483648.0, true,
-                                 true);
-            frame_sp--;
-            break;
-        case WASM_OP_I32_TRUNC_SAT_U_F64:
-            DEF_OP_TRUNC_SAT_F64(-1.0, 4294967296.0, true, false);
-            frame_sp--;
-            break;
-        case WASM_OP_I64_TRUNC_SAT_S_F32:
-            DEF_OP_TRUNC_SAT_F32(-9223373136366403584.0f,
-                                 9223372036854775808.0f, false,
-                                 true);
-            frame_sp++;
-            break;
-        case WASM_OP_I64_TRUNC_SAT_U_F32:
-            DEF_OP_TRUNC_SAT_F32(-1.0f, 18446744073709551616.0f,
-                                 false, false);
-            frame_sp++;
-            break;
-        case WASM_OP_I64_TRUNC_SAT_S_F64:
-            DEF_OP_TRUNC_SAT_F64(-9223372036854777856.0,
-                                 9223372036854775808.0, false,
-                                 true);
-            break;
-        case WASM_OP_I64_TRUNC_SAT_U_F64:
-            DEF_OP_TRUNC_SAT_F64(-1.0f, 18446744073709551616.0,
-                                 false, false);
-            break;
-        case WASM_OP_MEMORY_INIT:
-        {
-            uint32 addr, segment;
-            uint64 bytes, offset, seg_len;
-            uint8 *data;
+    TOS_HANDLE_OP(WASM_OP_I32_LE_U, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a <= b);
+        HANDLE_OP_END();
+    }
 
-            read_leb_uint32(frame_ip, frame_ip_end, segment);
-            frame_ip++;
+    TOS_HANDLE_OP(WASM_OP_I32_GE_S, 0, 1)
+    {
+        int32 b = (int32)*--frame_sp;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            bytes = (uint64)(uint32)POP_I32();
-            offset = (uint64)(uint32)POP_I32();
-            addr = (uint32)POP_I32();
+    TOS_HANDLE_OP(WASM_OP_I32_GE_S, 1, 0)
+    {
+        int32 b = (int32)tos;
+        int32 a = (int32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            CHECK_BULK_MEMORY_OVERFLOW(addr, bytes, maddr);
+    TOS_HANDLE_OP(WASM_OP_I32_GE_S, 1, 1)
+    {
+        int32 b = (int32)tos;
+        int32 a = (int32)*--frame_sp;
+        tos = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            seg_len = (uint64)module->data_segments[segment].data_length;
-            data = module->data_segments[segment].data;
-            if (offset + bytes > seg_len)
-                goto out_of_bounds;
+    TOS_HANDLE_OP(WASM_OP_I32_GE_U, 0, 1)
+    {
+        uint32 b = (uint32)*--frame_sp;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            memcpy(maddr,
-                   data + offset, (uint32)bytes);
-            break;
-        }
-        case WASM_OP_DATA_DROP:
-        {
-            uint32 segment;
+    TOS_HANDLE_OP(WASM_OP_I32_GE_U, 1, 0)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)frame_sp[-1];
+        frame_sp[-1] = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            read_leb_uint32(frame_ip, frame_ip_end, segment);
-            module->data_segments[segment].data_length = 0;
-            break;
-        }
-        case WASM_OP_MEMORY_COPY:
-        {
-            uint32 dst, src, len;
-            uint8 *mdst, *msrc;
+    TOS_HANDLE_OP(WASM_OP_I32_GE_U, 1, 1)
+    {
+        uint32 b = (uint32)tos;
+        uint32 a = (uint32)*--frame_sp;
+        tos = (uint32)(a >= b);
+        HANDLE_OP_END();
+    }
 
-            frame_ip += 2;
+    TOS_HANDLE_OP(EXT_OP_SET_LOCAL_FAST, 1, 0)
+    {
+        frame_lp[READ_IR_OPERAND(uint32)] = tos;
+        HANDLE_OP_END();
+    }
 
-            len = POP_I32();
-            src = POP_I32();
-            dst = POP_I32();
+    TOS_HANDLE_OP(WASM_OP_SET_GLOBAL, 1, 0)
+    {
+        *(uint32 *)(global_data + READ_IR_OPERAND(uint32)) = tos;
+        HANDLE_OP_END();
+    }
 
-            CHECK_BULK_MEMORY_OVERFLOW(src, len, msrc);
-            CHECK_BULK_MEMORY_OVERFLOW(dst, len, mdst);
+    TOS_HANDLE_OP(WASM_OP_DROP, 1, 0)
+    {
+        HANDLE_OP_END();
+    }
 
-            memmove(mdst, msrc, len);
-            break;
+    TOS_HANDLE_OP(WASM_OP_IF, 1, 0)
+    {
+        if (!tos)
+        {
+            frame_ip = (uint64 *)(uintptr_t)*frame_ip;
         }
-        case WASM_OP_MEMORY_FILL:
+        else
         {
-            uint32 dst, len;
-            uint8 fill_val, *mdst;
             frame_ip++;
-
-            len = POP_I32();
-            fill_val = POP_I32();
-            dst = POP_I32();
-            CHECK_BULK_MEMORY_OVERFLOW(dst, len, mdst);
-
-            memset(mdst, fill_val, len);
-            break;
         }
+        HANDLE_OP_END();
+    }
 
-        default:
-            wasm_set_exception(module, "unsupported opcode");
-            goto got_exception;
+    TOS_HANDLE_OP(WASM_OP_BR_IF, 1, 0)
+    {
+        if (tos)
+        {
+            CONTROL_TRANSFER();
+        }
+        else
+        {
+            frame_ip += 2;
         }
         HANDLE_OP_END();
     }
 
-    HANDLE_OP(WASM_OP_UNUSED_0x06)
-    HANDLE_OP(WASM_OP_UNUSED_0x07)
-    HANDLE_OP(WASM_OP_UNUSED_0x08)
-    HANDLE_OP(WASM_OP_UNUSED_0x09)
-    HANDLE_OP(WASM_OP_UNUSED_0x0a)
-    HANDLE_OP(WASM_OP_RETURN_CALL)
-    HANDLE_OP(WASM_OP_RETURN_CALL_INDIRECT)
-    HANDLE_OP(WASM_OP_ATOMIC_PREFIX)
-    HANDLE_OP(WASM_OP_SELECT_T)
-    HANDLE_OP(WASM_OP_TABLE_GET)
-    HANDLE_OP(WASM_OP_TABLE_SET)
-    HANDLE_OP(WASM_OP_REF_NULL)
-    HANDLE_OP(WASM_OP_REF_IS_NULL)
-    HANDLE_OP(WASM_OP_REF_FUNC)
-    HANDLE_OP(WASM_OP_UNUSED_0x14)
-    HANDLE_OP(WASM_OP_UNUSED_0x15)
-    HANDLE_OP(WASM_OP_UNUSED_0x16)
-    HANDLE_OP(WASM_OP_UNUSED_0x17)
-    HANDLE_OP(WASM_OP_UNUSED_0x18)
-    {
-        wasm_set_exception(module, "unsupported opcode");
-        goto got_exception;
+    TOS_HANDLE_OP(WASM_OP_I32_STORE, 1, 0)
+    {
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(4);
+        STORE_U32(maddr, tos);
+        HANDLE_OP_END();
     }
 
-return_func:
-{
-    FREE_FRAME(exec_env);
-
-    if (!prev_frame->ip)
-        return;
+    TOS_HANDLE_OP(WASM_OP_I32_STORE8, 1, 0)
+    {
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(1);
+        *(uint8 *)maddr = (uint8)tos;
+        HANDLE_OP_END();
+    }
 
-    // 恢复栈帧
-    frame = prev_frame;
-    cur_func = frame->function;
-    prev_frame = frame + 1;
-    frame_ip = frame->ip;
-    frame_ip_end = cur_func->code_end;
-    frame_lp = frame->lp;
-    frame_sp = frame->sp;
-    cur_branch_table = frame->cur_branch_table;
-    branch_table = cur_func->branch_table;
-    HANDLE_OP_END();
-}
+    TOS_HANDLE_OP(WASM_OP_I32_STORE16, 1, 0)
+    {
+        uint32 offset, addr;
+        uint8 *maddr;
+        offset = READ_IR_OPERAND(uint32);
+        addr = *--frame_sp;
+        CHECK_MEMORY_OVERFLOW(2);
+        STORE_U16(maddr, (uint16)tos);
+        HANDLE_OP_END();
+    }
+#endif
 
 call_func_from_interp:
 {
-    // 保存函数栈帧
-    frame->ip = frame_ip;
-    frame->sp = frame_sp - cur_func->param_cell_num;
-    frame->lp = frame_lp;
-    frame->cur_branch_table = cur_branch_table;
-
-    prev_frame = frame;
+    uint32 *callee_lp = frame_sp - callee->param_cell_num;
 
-    if (cur_func->func_kind)
+    if (CALLEE_IS_NATIVE(callee))
     {
-        wasm_interp_call_func_native(exec_env, fidx,
-                                     prev_frame);
+        fidx = (uint32)(callee - module->functions);
+        if (!wasm_interp_call_func_native(exec_env, fidx, callee_lp))
+            goto got_exception;
 
-        // 在该情况下只有这些变量发生变化
-        prev_frame = frame + 1;
-        cur_func = frame->function;
-        frame_sp = frame->sp;
+        frame_sp = callee_lp + callee->ret_cell_num;
 
-        if (memory)
-            linear_mem_size = num_bytes_per_page * memory->cur_page_count;
         if (wasm_get_exception(module))
             goto got_exception;
     }
     else
     {
-
-        if (!(frame = ALLOC_FRAME(exec_env)))
-        {
-            frame = prev_frame;
+        if (!(frame_sp = wasm_interp_push_frame(exec_env, callee, callee_lp,
+                                                frame_ip, frame_lp)))
             goto got_exception;
-        }
 
-        frame_lp = frame->lp = frame_sp - cur_func->param_cell_num;
+        frame_lp = callee_lp;
+        frame_ip = callee->ir_code;
+    }
+    HANDLE_OP_END();
+}
 
-        frame_ip = (uint8 *)cur_func->func_ptr;
-        frame_ip_end = cur_func->code_end;
+// 尾调用之后的单元与return相同, 被调用函数复用当前栈帧, 返回时直接回到当前函数的调用者
+return_call_func:
+{
+    uint32 *callee_lp = frame_sp - callee->param_cell_num;
+    WASMFuncFrame *frame;
+    uint64 *prev_ip;
+    uint32 *prev_lp;
 
-        frame_sp = frame->sp = frame_sp + cur_func->local_cell_num;
+    // 导入函数不占用wasm栈帧, 调用后按return处理
+    if (CALLEE_IS_NATIVE(callee))
+    {
+        fidx = (uint32)(callee - module->functions);
+        if (!wasm_interp_call_func_native(exec_env, fidx, callee_lp))
+            goto got_exception;
 
-        // 切换跳转表
-        cur_branch_table = cur_func->branch_table;
-        branch_table = cur_func->branch_table;
+        frame_sp = callee_lp + callee->ret_cell_num;
 
-        memset(frame_lp + cur_func->param_cell_num, 0,
-               (uint32)(cur_func->local_cell_num * 4));
+        if (wasm_get_exception(module))
+            goto got_exception;
+        goto HANDLE_WASM_OP_RETURN;
     }
+
+    // 参数会覆盖当前栈帧的头部, 先取出调用者的状态
+    frame = (WASMFuncFrame *)(frame_lp + (uint32)(*frame_ip >> 32));
+    prev_ip = frame->prev_ip;
+    prev_lp = frame->prev_lp;
+
+    word_copy(frame_lp, callee_lp, callee->param_cell_num);
+    if (!(frame_sp = wasm_interp_push_frame(exec_env, callee, frame_lp,
+                                            prev_ip, prev_lp)))
+        goto got_exception;
+
+    frame_ip = callee->ir_code;
     HANDLE_OP_END();
 }
 
@@ -2883,99 +3020,190 @@ got_exception:
     return;
 }
 
-#if WASM_ENABLE_JIT != 0
-static bool
-llvm_jit_call_func_bytecode(WASMModule *module_inst,
-                            WASMExecEnv *exec_env,
-                            WASMFunction *function, uint32 argc,
-                            uint32 argv[])
-{
-    WASMType *func_type = function->func_type;
-    uint32 result_count = func_type->result_count;
-    uint32 ext_ret_count = result_count > 1 ? result_count - 1 : 0;
-    uint32 func_idx = (uint32)(function - module_inst->functions);
-    bool ret;
+#else
+// 尾调用分发: 每条指令的处理是一个独立的函数, 解释器状态全部通过参数传递,
+// 处理结束时以尾调用进入下一条指令, 使这些状态始终位于参数寄存器中
+#if WASM_ENABLE_SLOT_INTERP != 0 || WASM_ENABLE_TOS_CACHE != 0
+#error "tail-call dispatch only implements the stack-based handlers"
+#endif
 
-    if (ext_ret_count > 0)
-    {
-        uint32 cell_num = 0, i;
-        uint8 *ext_ret_types = func_type->result + 1;
-        uint32 argv1_buf[32], *argv1 = argv1_buf, *ext_rets = NULL;
-        uint32 *argv_ret = argv;
-        uint32 ext_ret_cell = wasm_get_cell_num(ext_ret_types, ext_ret_count);
-        uint64 size;
+#if defined(__has_attribute)
+#if __has_attribute(musttail)
+#define TAIL_CALL_ATTR __attribute__((musttail))
+#endif
+#endif
+#ifndef TAIL_CALL_ATTR
+// 编译器不支持musttail时依赖优化阶段的尾调用消除, 否则每条指令都会占用一层C栈
+#ifndef __OPTIMIZE__
+#error "tail-call dispatch requires musttail or an optimized build"
+#endif
+#define TAIL_CALL_ATTR
+#endif
 
-        size =
-            sizeof(uint32) * (uint64)argc + sizeof(void *) * (uint64)ext_ret_count + sizeof(uint32) * (uint64)ext_ret_cell;
-        if (size > sizeof(argv1_buf))
-        {
-            if (size > UINT32_MAX || !(argv1 = wasm_runtime_malloc((uint32)size)))
-            {
-                wasm_set_exception(module_inst, "allocate memory failed");
-                return false;
-            }
-        }
+#define TAIL_HANDLER_PARAMS                                            \
+    uint64 *frame_ip, uint32 *frame_sp, uint32 *frame_lp,              \
+        uint8 *memory_data, WASMModule *module, WASMExecEnv *exec_env
+#define TAIL_HANDLER_ARGS \
+    frame_ip, frame_sp, frame_lp, memory_data, module, exec_env
 
-        memcpy(argv1, argv, sizeof(uint32) * argc);
+typedef void (*TailHandler)(TAIL_HANDLER_PARAMS);
 
-        ext_rets =
-            argv1 + argc + sizeof(void *) / sizeof(uint32) * ext_ret_count;
+#define HANDLE_OP(opcode) static void TAIL_HANDLE_##opcode(TAIL_HANDLER_PARAMS)
+// 共用处理的指令以一次尾调用转入目标指令的处理函数
+#define HANDLE_OP_ALIAS(opcode, target)                                    \
+    static void TAIL_HANDLE_##target(TAIL_HANDLER_PARAMS);                 \
+    static void TAIL_HANDLE_##opcode(TAIL_HANDLER_PARAMS)                  \
+    {                                                                      \
+        TAIL_CALL_ATTR return TAIL_HANDLE_##target(TAIL_HANDLER_ARGS);     \
+    }
+#define HANDLE_OP_END()                                          \
+    do                                                           \
+    {                                                            \
+        TailHandler next = READ_IR_POINTER(TailHandler);         \
+        TAIL_CALL_ATTR return next(TAIL_HANDLER_ARGS);           \
+    } while (0)
 
-        for (i = 0; i < ext_ret_count; i++)
-        {
-            *(uintptr_t *)(argv1 + argc + sizeof(void *) / sizeof(uint32) * i) =
-                (uintptr_t)(ext_rets + cell_num);
-            cell_num += wasm_value_type_cell_num(ext_ret_types[i]);
-        }
+// 异常信息已记录在module中, 直接返回即结束整条尾调用链. 只抛出异常的处理不会用到其余状态
+#define HANDLE_EXCEPTION() \
+    do                     \
+    {                      \
+        (void)frame_ip;    \
+        (void)frame_sp;    \
+        (void)frame_lp;    \
+        (void)memory_data; \
+        (void)exec_env;    \
+        return;            \
+    } while (0)
+#define HANDLE_OUT_OF_BOUNDS()                                         \
+    do                                                                 \
+    {                                                                  \
+        wasm_set_exception(module, "out of bounds memory access");     \
+        HANDLE_EXCEPTION();                                            \
+    } while (0)
 
-        ret = wasm_runtime_invoke_native(
-            exec_env, func_idx,
-            argv1, argv);
-        if (!ret)
-        {
-            if (argv1 != argv1_buf)
-                wasm_runtime_free(argv1);
-            return ret;
-        }
+// 线性内存基址在实例的生命周期内不变, 作为参数传递, 其余状态经module访问
+#define GLOBAL_DATA (module->global_data)
+#define LINEAR_MEMORY (module->memories)
+
+// 在调用者的操作数栈顶建立栈帧后进入被调用函数, 导入函数在此直接执行完毕
+#define CALL_FUNCTION(func)                                                          \
+    do                                                                               \
+    {                                                                                \
+        WASMFunction *callee = (func);                                               \
+        uint32 *callee_lp = frame_sp - callee->param_cell_num;                       \
+        if (CALLEE_IS_NATIVE(callee))                                                \
+        {                                                                            \
+            if (!wasm_interp_call_func_native(exec_env,                              \
+                                              (uint32)(callee - module->functions),  \
+                                              callee_lp)                             \
+                || wasm_get_exception(module))                                       \
+                return;                                                              \
+            frame_sp = callee_lp + callee->ret_cell_num;                             \
+        }                                                                            \
+        else                                                                         \
+        {                                                                            \
+            if (!(frame_sp = wasm_interp_push_frame(exec_env, callee, callee_lp,     \
+                                                    frame_ip, frame_lp)))            \
+                return;                                                              \
+            frame_lp = callee_lp;                                                    \
+            frame_ip = callee->ir_code;                                              \
+        }                                                                            \
+        HANDLE_OP_END();                                                             \
+    } while (0)
 
-        switch (func_type->result[0])
-        {
-        case VALUE_TYPE_I32:
-        case VALUE_TYPE_F32:
-            argv_ret++;
-            break;
-        case VALUE_TYPE_I64:
-        case VALUE_TYPE_F64:
-            argv_ret += 2;
-            break;
-        default:
-            break;
-        }
+// 被调用函数复用当前栈帧, 导入函数调用后直接进入return的处理
+#define RETURN_CALL_FUNCTION(func)                                                       \
+    do                                                                                   \
+    {                                                                                    \
+        WASMFunction *callee = (func);                                                   \
+        uint32 *callee_lp = frame_sp - callee->param_cell_num;                           \
+        WASMFuncFrame *frame;                                                            \
+        uint64 *prev_ip;                                                                 \
+        uint32 *prev_lp;                                                                 \
+        if (CALLEE_IS_NATIVE(callee))                                                    \
+        {                                                                                \
+            if (!wasm_interp_call_func_native(exec_env,                                  \
+                                              (uint32)(callee - module->functions),      \
+                                              callee_lp)                                 \
+                || wasm_get_exception(module))                                           \
+                return;                                                                  \
+            frame_sp = callee_lp + callee->ret_cell_num;                                 \
+            TAIL_CALL_ATTR return TAIL_HANDLE_WASM_OP_RETURN(TAIL_HANDLER_ARGS);         \
+        }                                                                                \
+        frame = (WASMFuncFrame *)(frame_lp + (uint32)(*frame_ip >> 32));                 \
+        prev_ip = frame->prev_ip;                                                        \
+        prev_lp = frame->prev_lp;                                                        \
+        word_copy(frame_lp, callee_lp, callee->param_cell_num);                          \
+        if (!(frame_sp = wasm_interp_push_frame(exec_env, callee, frame_lp,              \
+                                                prev_ip, prev_lp)))                      \
+            return;                                                                      \
+        frame_ip = callee->ir_code;                                                      \
+        HANDLE_OP_END();                                                                 \
+    } while (0)
 
-        ext_rets =
-            argv1 + argc + sizeof(void *) / sizeof(uint32) * ext_ret_count;
-        memcpy(argv_ret, ext_rets,
-               sizeof(uint32) * cell_num);
+#include "wasm_interp_handlers.def"
 
-        if (argv1 != argv1_buf)
-            wasm_runtime_free(argv1);
-        return true;
-    }
-    else
-    {
-        ret = wasm_runtime_invoke_native(
-            exec_env, func_idx, argv, argv);
+static void
+wasm_interp_call_func_bytecode(WASMModule *module,
+                               WASMExecEnv *exec_env,
+                               WASMFunction *function,
+                               uint32 *lp)
+{
+#define HANDLE_OPCODE(op) (const void *)TAIL_HANDLE_##op
+    DEFINE_GOTO_TABLE(const void *, handle_table);
+#if WASM_ENABLE_OPCODE_PROFILE != 0
+    handle_table[EXT_OP_PROFILE] = HANDLE_OPCODE(EXT_OP_PROFILE);
+#endif
+#if WASM_ENABLE_TIERED_JIT != 0
+    handle_table[EXT_OP_LOOP_HOTNESS] = HANDLE_OPCODE(EXT_OP_LOOP_HOTNESS);
+#endif
+#undef HANDLE_OPCODE
 
-        return ret;
+    // 仅用于导出处理函数表
+    if (!module)
+    {
+        wasm_interp_handle_table = handle_table;
+        return;
     }
+
+    uint64 *frame_ip = function->ir_code;
+    uint32 *frame_sp;
+    TailHandler first;
+
+    // 初始化栈帧, 参数已由调用者放在lp开始处
+    if (!(frame_sp = wasm_interp_push_frame(exec_env, function, lp, NULL, NULL)))
+        return;
+
+    // 整条尾调用链在函数返回或出现异常时才回到这里
+    first = READ_IR_POINTER(TailHandler);
+    first(frame_ip, frame_sp, lp, module->memories->memory_data,
+          module, exec_env);
 }
 #endif
 
-void wasm_interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
-                           WASMFunction *function, uint32 argc,
-                           uint32 argv[])
+#if WASM_ENABLE_JIT != 0 || WASM_ENABLE_AOT != 0
+typedef void (*WASMJitEntry)(WASMExecEnv *exec_env, void *func_ptr, uint32 *argv);
+
+// 经函数类型的入口调用编译好的函数, 参数从argv开始存放, 结果写回argv开始处
+static bool
+llvm_jit_call_func_bytecode(WASMModule *module_inst,
+                            WASMExecEnv *exec_env,
+                            WASMFunction *function,
+                            uint32 argv[])
 {
-    WASMFuncFrame *frame;
+    uint32 func_idx = (uint32)(function - module_inst->functions);
+    WASMJitEntry entry = (WASMJitEntry)module_inst->func_entries[function->type_index];
+
+    entry(exec_env, module_inst->func_ptrs[func_idx], argv);
+    return !wasm_get_exception(module_inst);
+}
+#endif
+
+static void
+interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
+                 WASMFunction *function, uint32 argc, uint32 argv[])
+{
+    uint32 *lp = (uint32 *)exec_env->exec_stack.top;
     unsigned i;
 
     if (argc < function->param_cell_num)
@@ -2990,28 +3218,49 @@ void wasm_interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
     }
     argc = function->param_cell_num;
 
-    if (!(frame = ALLOC_FRAME(exec_env)))
+    // 延迟验证的函数在首次调用前验证
+    if (function->func_kind == Lazy_Func
+        && !wasm_validator_resolve_lazy(module_inst, function))
         return;
 
-    frame->ip = NULL;
-    frame->sp = (uint32 *)exec_env->exec_stack.top;
+#if WASM_ENABLE_JIT != 0 || WASM_ENABLE_AOT != 0
+    // 编译后的代码直接把结果写回argv
+#if WASM_ENABLE_TIERED_JIT != 0
+    if (function->func_kind == Wasm_Func
+        && wasm_interp_tier_up(module_inst, function))
+#elif WASM_ENABLE_JIT != 0
+    if (function->func_kind == Wasm_Func)
+#else
+    // 只有加载了预编译文件的模块才有本地代码, 此时所有函数都已编译
+    if (function->func_kind == Wasm_Func && module_inst->func_ptrs)
+#endif
+    {
+        llvm_jit_call_func_bytecode(module_inst, exec_env, function, argv);
+        return;
+    }
+#endif
+
+    // 参数和返回值都位于数值栈当前的栈顶
+    if ((uint8 *)(lp + (argc > function->ret_cell_num ? argc : function->ret_cell_num)) > exec_env->exec_stack.top_boundary)
+    {
+        wasm_set_exception(module_inst, "wasm operand stack overflow");
+        return;
+    }
 
     if (argc > 0)
-        word_copy(frame->sp, argv, argc);
+        word_copy(lp, argv, argc);
 
     switch (function->func_kind)
     {
+#if WASM_ENABLE_JIT == 0 || WASM_ENABLE_TIERED_JIT != 0
     case Wasm_Func:
-#if WASM_ENABLE_JIT == 0
-        wasm_interp_call_func_bytecode(module_inst, exec_env, function, frame);
-#else
-        llvm_jit_call_func_bytecode(module_inst, exec_env, function, argc, argv);
-#endif
+        wasm_interp_call_func_bytecode(module_inst, exec_env, function, lp);
         break;
+#endif
     case Native_Func:
     {
         uint32 func_idx = (uint32)(function - module_inst->functions);
-        wasm_interp_call_func_native(exec_env, func_idx, frame);
+        wasm_interp_call_func_native(exec_env, func_idx, lp);
         break;
     }
     default:
@@ -3022,8 +3271,82 @@ void wasm_interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
     {
         for (i = 0; i < function->ret_cell_num; i++)
         {
-            argv[i] = *(frame->sp + i - function->ret_cell_num);
+            argv[i] = lp[i];
         }
     }
-    FREE_FRAME(exec_env);
+}
+
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+// 当前线程正在执行wasm代码的运行环境
+static os_thread_local_attribute WASMExecEnv *exec_env_tls = NULL;
+
+// 故障地址位于当前实例线性内存的保留区内时转换为越界陷入, 否则交给之前的信号处理
+static void
+wasm_interp_signal_handler(void *sig_addr)
+{
+    WASMExecEnv *exec_env = exec_env_tls;
+    WASMModule *module;
+    uint8 *memory_data, *addr = (uint8 *)sig_addr;
+
+    if (!exec_env || !exec_env->jmpbuf)
+        return;
+
+    module = exec_env->module_inst;
+    if (!module->memory_count || !(memory_data = module->memories->memory_data))
+        return;
+
+    if (memory_data <= addr && addr < memory_data + WASM_MEMORY_RESERVE_SIZE)
+    {
+        wasm_set_exception(module, "out of bounds memory access");
+        os_longjmp(*exec_env->jmpbuf, 1);
+    }
+}
+
+bool wasm_interp_signal_init()
+{
+    return os_thread_signal_init(wasm_interp_signal_handler) == 0;
+}
+
+void wasm_interp_signal_destroy()
+{
+    os_thread_signal_destroy();
+}
+#endif
+
+void wasm_interp_call_wasm(WASMModule *module_inst, WASMExecEnv *exec_env,
+                           WASMFunction *function, uint32 argc,
+                           uint32 argv[])
+{
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    korp_jmpbuf jmpbuf, *prev_jmpbuf = exec_env->jmpbuf;
+    WASMExecEnv *prev_exec_env = exec_env_tls;
+    uint8 *exec_stack_top = exec_env->exec_stack.top;
+
+    // 嵌套调用时保存外层的跳转点, 返回后恢复
+    exec_env->jmpbuf = &jmpbuf;
+    exec_env_tls = exec_env;
+    if (os_setjmp(jmpbuf) == 0)
+    {
+        interp_call_wasm(module_inst, exec_env, function, argc, argv);
+    }
+    else
+    {
+        // 从信号处理跳回, 异常信息已经设置, 调用导入函数时可能修改过栈顶
+        os_sigreturn();
+        os_signal_unmask();
+        exec_env->exec_stack.top = exec_stack_top;
+    }
+    exec_env->jmpbuf = prev_jmpbuf;
+    exec_env_tls = prev_exec_env;
+#else
+    interp_call_wasm(module_inst, exec_env, function, argc, argv);
+#endif
+}
+
+void wasm_interp_init()
+{
+    wasm_interp_call_func_bytecode(NULL, NULL, NULL, NULL);
+#if WASM_ENABLE_OPCODE_PROFILE != 0
+    atexit(dump_opcode_profile);
+#endif
 }
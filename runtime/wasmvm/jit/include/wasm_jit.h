@@ -2,10 +2,7 @@
 #define WASM_JIT_H
 
 #include "wasm_jit_llvm.h"
-
-#ifndef WASM_JIT_FUNC_PREFIX
-#define WASM_JIT_FUNC_PREFIX "wasm_jit_func#"
-#endif
+#include "wasm_aot_runtime.h"
 
 char *
 wasm_jit_get_last_error();
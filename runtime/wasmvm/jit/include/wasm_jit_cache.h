@@ -0,0 +1,18 @@
+#ifndef _WASM_JIT_CACHE_H
+#define _WASM_JIT_CACHE_H
+
+#include "wasm_type.h"
+
+// 是否设置了缓存目录
+bool wasm_jit_cache_enabled(void);
+
+// 从缓存目录加载模块的目标文件并填写func_ptrs, 缓存不存在或不匹配时返回false
+bool wasm_jit_cache_load(WASMModule *module);
+
+// 将已优化的整个模块编译成目标文件, 写入缓存目录并加载
+bool wasm_jit_cache_save(WASMModule *module);
+
+// 释放加载缓存代码的JIT
+void wasm_jit_cache_destroy(WASMModule *module);
+
+#endif
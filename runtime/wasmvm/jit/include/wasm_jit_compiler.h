@@ -150,14 +150,8 @@ typedef enum IntArithmetic
             goto fail;                                                                                          \
         }                                                                                                       \
                                                                                                                 \
-        if (!(func_ptr_type = LLVMPointerType(func_type, 0)))                                                   \
+        if (!(func = wasm_jit_get_runtime_func(comp_ctx, #name, func_type)))                                    \
         {                                                                                                       \
-            wasm_jit_set_last_error("llvm add pointer type failed.");                                           \
-            goto fail;                                                                                          \
-        }                                                                                                       \
-        if (!(value = I64_CONST((uint64)(uintptr_t)name)) || !(func = LLVMConstIntToPtr(value, func_ptr_type))) \
-        {                                                                                                       \
-            wasm_jit_set_last_error("create LLVM value failed.");                                               \
             goto fail;                                                                                          \
         }                                                                                                       \
     } while (0)
@@ -23,6 +23,8 @@ bool wasm_jit_compile_op_br_table(JITCompContext *comp_ctx, JITFuncContext *func
 
 bool wasm_jit_compile_op_return(JITCompContext *comp_ctx, JITFuncContext *func_ctx, uint8 **frame_ip);
 
+bool wasm_jit_compile_op_tail_return(JITFuncContext *func_ctx, uint8 **frame_ip);
+
 bool wasm_jit_compile_op_unreachable(JITCompContext *comp_ctx, JITFuncContext *func_ctx, uint8 **frame_ip);
 
 #endif
@@ -3,10 +3,18 @@
 
 #include "wasm_jit_compiler.h"
 
+// 生成导入函数的入口, 签名与wasm函数相同
+bool wasm_jit_compile_import_func(WASMModule *wasm_module, JITCompContext *comp_ctx,
+                                  uint32 import_idx);
+
+// 生成宿主调用type_idx类型的函数时使用的入口
+bool wasm_jit_compile_func_entry(WASMModule *wasm_module, JITCompContext *comp_ctx,
+                                 uint32 type_idx);
+
 bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx, JITFuncContext *func_ctx,
-                              uint32 func_idx);
+                              uint32 func_idx, uint8 **frame_ip);
 
 bool wasm_jit_compile_op_call_indirect(WASMModule *wasm_module, JITCompContext *comp_ctx, JITFuncContext *func_ctx,
-                                       uint32 type_idx, uint32 tbl_idx);
+                                       uint32 type_idx, uint32 tbl_idx, uint8 **frame_ip);
 
 #endif
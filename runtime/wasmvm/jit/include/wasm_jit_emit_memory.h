@@ -2,6 +2,7 @@
 #define _WASM_JIT_EMIT_MEMORY_H_
 
 #include "wasm_jit_compiler.h"
+#include "wasm_aot_runtime.h"
 
 #ifdef __cplusplus
 extern "C"
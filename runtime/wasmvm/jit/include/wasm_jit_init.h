@@ -9,4 +9,18 @@ bool init_llvm_jit_functions_stage2(WASMModule *module);
 
 bool compile_jit_functions(WASMModule *module);
 
+// 一次编译整个模块, 把本地代码和校验信息写入预编译文件, 不加入JIT
+bool wasm_jit_compile_to_file(WASMModule *module, const char *file_name);
+
+#if WASM_ENABLE_TIERED_JIT != 0
+// 启动后台编译线程, 第一个线程先生成LLVM IR, 之后按提交顺序编译热点函数
+bool wasm_jit_tier_up_start(WASMModule *module);
+
+// 提交函数(全局编号)的后台编译, 重复提交会被忽略
+void wasm_jit_tier_up_request(WASMModule *module, uint32 func_idx);
+
+// 停止并等待后台编译线程
+void wasm_jit_tier_up_destroy(WASMModule *module);
+#endif
+
 #endif
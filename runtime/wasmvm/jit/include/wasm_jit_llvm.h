@@ -31,6 +31,9 @@ extern "C"
 #endif
 
 #define OPQ_PTR_TYPE INT8_TYPE_PTR
+
+// 标记显式越界检查的分支, 优化时据此合并, 外提和删除检查
+#define WASM_JIT_BOUND_CHECK_MD "wasm.bound_check"
     typedef struct JITValue
     {
         LLVMValueRef value;
@@ -53,6 +56,7 @@ extern "C"
 
         uint8 *else_addr;
         uint8 *end_addr;
+        WASMBlock *wasm_block;
 
         LLVMBasicBlockRef llvm_entry_block;
         LLVMBasicBlockRef llvm_else_block;
@@ -176,6 +180,9 @@ extern "C"
         uint32 opt_level;
         uint32 size_level;
 
+        // 线性内存没有保护页时, 访存前显式比较地址与内存大小
+        bool enable_bound_check;
+
         LLVMValueRef fp_rounding_mode;
 
         LLVMValueRef fp_exception_behavior;
@@ -188,6 +195,9 @@ extern "C"
         JITFuncContext **jit_func_ctxes;
         JITFuncType *jit_func_types;
         uint32 func_ctx_count;
+        // 各导入函数的入口
+        LLVMValueRef *import_funcs;
+        uint32 import_func_count;
     } JITCompContext;
 
     JITCompContext *
@@ -226,10 +236,22 @@ extern "C"
 
     void wasm_jit_add_simple_loop_unswitch_pass(LLVMPassManagerRef pass);
 
+    // 调用后紧跟ret, 且调用者与被调用者原型相同时使用
+    void wasm_jit_set_musttail(LLVMValueRef call);
+
     void wasm_jit_apply_llvm_new_pass_manager(JITCompContext *comp_ctx, LLVMModuleRef module);
 
     void wasm_jit_handle_llvm_errmsg(const char *string, LLVMErrorRef err);
 
+    // 取得按名字引用的运行时函数的声明, 首次使用时加入模块
+    LLVMValueRef
+    wasm_jit_get_runtime_func(JITCompContext *comp_ctx, const char *name,
+                              LLVMTypeRef func_type);
+
+    // 在JITDylib中定义生成代码引用的运行时函数
+    bool wasm_jit_define_runtime_symbols(LLVMOrcExecutionSessionRef session,
+                                         LLVMOrcJITDylibRef dylib);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,304 @@
+#include "wasm_jit_cache.h"
+#include "wasm_jit.h"
+#include "runtime_log.h"
+#include "runtime_utils.h"
+#include "wasm_runtime_instantiate_api.h"
+
+// 缓存文件为文件头加上整个模块编译出的目标文件, 文件名为缓存键
+#define JIT_CACHE_MAGIC 0x4a43534d
+#define JIT_CACHE_VERSION 3
+#define JIT_CACHE_DIR_MAX 256
+
+typedef struct JITCacheHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint64 key;
+    uint64 module_hash;
+    uint32 function_count;
+    uint32 object_size;
+} JITCacheHeader;
+
+static char jit_cache_dir[JIT_CACHE_DIR_MAX];
+
+bool wasm_jit_set_cache_dir(const char *dir)
+{
+    if (!dir)
+    {
+        jit_cache_dir[0] = '\0';
+        return true;
+    }
+
+    if (strlen(dir) + 1 > sizeof(jit_cache_dir))
+    {
+        LOG_ERROR("Set jit cache dir fail: path is too long.\n");
+        return false;
+    }
+
+    snprintf(jit_cache_dir, sizeof(jit_cache_dir), "%s", dir);
+    return true;
+}
+
+bool wasm_jit_cache_enabled(void)
+{
+    return jit_cache_dir[0] != '\0';
+}
+
+static uint64
+hash_string(uint64 hash, const char *str)
+{
+    return bh_hash_bytes(hash, str, (uint32)strlen(str) + 1);
+}
+
+// 生成的代码依赖模块内容, 全局的类型编号, 主机CPU, LLVM版本和运行时结构的布局,
+// 任一变化都使用不同的缓存文件
+static uint64
+jit_cache_key(WASMModule *module)
+{
+    uint64 hash = BH_HASH_INIT;
+    // 结构布局与AOT加载器使用同一个哈希, 生成的代码新访问的字段只需加入一处
+    uint64 layout_hash = wasm_native_code_layout_hash();
+    uint32 version = JIT_CACHE_VERSION;
+    char *cpu, *features;
+    uint32 i;
+
+    hash = bh_hash_bytes(hash, &module->module_hash, sizeof(uint64));
+    hash = bh_hash_bytes(hash, &version, sizeof(uint32));
+    hash = bh_hash_bytes(hash, &layout_hash, sizeof(uint64));
+
+    for (i = 0; i < module->type_count; i++)
+    {
+        hash = bh_hash_bytes(hash, &module->types[i]->type_id, sizeof(uint32));
+    }
+
+    cpu = LLVMGetHostCPUName();
+    features = LLVMGetHostCPUFeatures();
+    hash = hash_string(hash, cpu ? cpu : "");
+    hash = hash_string(hash, features ? features : "");
+    hash = hash_string(hash, LLVM_VERSION_STRING);
+    if (cpu)
+        LLVMDisposeMessage(cpu);
+    if (features)
+        LLVMDisposeMessage(features);
+
+    return hash;
+}
+
+static void
+jit_cache_header_init(WASMModule *module, JITCacheHeader *header, uint32 object_size)
+{
+    memset(header, 0, sizeof(JITCacheHeader));
+    header->magic = JIT_CACHE_MAGIC;
+    header->version = JIT_CACHE_VERSION;
+    header->key = jit_cache_key(module);
+    header->module_hash = module->module_hash;
+    header->function_count = module->function_count;
+    header->object_size = object_size;
+}
+
+static void
+jit_cache_path(const JITCacheHeader *header, char *buf, uint32 size)
+{
+    snprintf(buf, size, "%s/%016llx.o", jit_cache_dir,
+             (unsigned long long)header->key);
+}
+
+// 用LLJIT链接目标文件, 查找各函数的地址, 运行时函数和libc符号在链接时解析
+static bool
+jit_cache_add_object(WASMModule *module, const char *object, uint32 object_size)
+{
+    uint32 i, import_function_count = module->import_function_count;
+    LLVMOrcLLJITRef jit = NULL;
+    LLVMOrcJITDylibRef dylib;
+    LLVMOrcDefinitionGeneratorRef generator;
+    LLVMMemoryBufferRef object_buf;
+    LLVMErrorRef err;
+
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+
+    if ((err = LLVMOrcCreateLLJIT(&jit, NULL)))
+    {
+        wasm_jit_handle_llvm_errmsg("failed to create llvm orcjit instance", err);
+        return false;
+    }
+
+    dylib = LLVMOrcLLJITGetMainJITDylib(jit);
+
+    if ((err = LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+             &generator, LLVMOrcLLJITGetGlobalPrefix(jit), NULL, NULL)))
+    {
+        wasm_jit_handle_llvm_errmsg("failed to create process symbol generator", err);
+        goto fail;
+    }
+    LLVMOrcJITDylibAddGenerator(dylib, generator);
+
+    if (!wasm_jit_define_runtime_symbols(LLVMOrcLLJITGetExecutionSession(jit), dylib))
+        goto fail;
+
+    // 内存缓冲区的所有权转移给JIT
+    object_buf = LLVMCreateMemoryBufferWithMemoryRangeCopy(object, object_size,
+                                                           "wasm_jit_cache");
+    if ((err = LLVMOrcLLJITAddObjectFile(jit, dylib, object_buf)))
+    {
+        wasm_jit_handle_llvm_errmsg("failed to add object file", err);
+        goto fail;
+    }
+
+    for (i = 0; i < module->function_count; i++)
+    {
+        LLVMOrcExecutorAddress func_addr = 0;
+        char func_name[48];
+
+        if (i < import_function_count)
+            snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_IMPORT_PREFIX, i);
+        else
+            snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_FUNC_PREFIX,
+                     i - import_function_count);
+        if ((err = LLVMOrcLLJITLookup(jit, &func_addr, func_name)))
+        {
+            wasm_jit_handle_llvm_errmsg("failed to lookup jit function", err);
+            goto fail;
+        }
+        module->func_ptrs[i] = (void *)(uintptr_t)func_addr;
+    }
+
+    for (i = 0; i < module->type_count; i++)
+    {
+        LLVMOrcExecutorAddress entry_addr = 0;
+        char entry_name[48];
+
+        snprintf(entry_name, sizeof(entry_name), "%s%d", WASM_JIT_ENTRY_PREFIX, i);
+        if ((err = LLVMOrcLLJITLookup(jit, &entry_addr, entry_name)))
+        {
+            wasm_jit_handle_llvm_errmsg("failed to lookup jit function entry", err);
+            goto fail;
+        }
+        module->func_entries[i] = (void *)(uintptr_t)entry_addr;
+    }
+
+    // 解释器看到该标志后才会经func_ptrs调用编译好的代码
+    os_atomic_thread_fence(os_memory_order_release);
+    for (i = import_function_count; i < module->function_count; i++)
+    {
+        module->func_ptrs_compiled[i] = true;
+    }
+
+    module->jit_cache = jit;
+    return true;
+
+fail:
+    LLVMOrcDisposeLLJIT(jit);
+    return false;
+}
+
+bool wasm_jit_cache_load(WASMModule *module)
+{
+    JITCacheHeader header, saved;
+    char path[JIT_CACHE_DIR_MAX + 32];
+    char *object = NULL;
+    FILE *file;
+    bool ret = false;
+
+    if (!wasm_jit_cache_enabled())
+        return false;
+
+    jit_cache_header_init(module, &header, 0);
+    jit_cache_path(&header, path, sizeof(path));
+
+    // 缓存未命中是正常情况, 不输出错误
+    if (!(file = fopen(path, "rb")))
+        return false;
+
+    if (fread(&saved, sizeof(JITCacheHeader), 1, file) != 1
+        || memcmp(&saved, &header, offsetof(JITCacheHeader, object_size)) != 0
+        || saved.object_size == 0)
+    {
+        LOG_WARNING("jit cache %s does not match the module, ignore it.\n", path);
+        goto fail;
+    }
+
+    if (!(object = wasm_runtime_malloc(saved.object_size)))
+        goto fail;
+
+    if (fread(object, saved.object_size, 1, file) != 1)
+    {
+        LOG_WARNING("jit cache %s is truncated, ignore it.\n", path);
+        goto fail;
+    }
+
+    if (!(ret = jit_cache_add_object(module, object, saved.object_size)))
+    {
+        LOG_WARNING("load jit cache %s failed: %s\n", path, wasm_jit_get_last_error());
+        goto fail;
+    }
+
+    LOG_VERBOSE("Load jit cache %s success.\n", path);
+
+fail:
+    if (object)
+        wasm_runtime_free(object);
+    fclose(file);
+    return ret;
+}
+
+// 先写入临时文件再改名, 并发的进程不会读到写了一半的缓存
+static void
+jit_cache_write(const JITCacheHeader *header, const char *object)
+{
+    char path[JIT_CACHE_DIR_MAX + 32], tmp_path[JIT_CACHE_DIR_MAX + 48];
+    FILE *file;
+
+    jit_cache_path(header, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int)getpid());
+
+    if (!(file = fopen(tmp_path, "wb")))
+    {
+        LOG_WARNING("create jit cache %s failed.\n", tmp_path);
+        return;
+    }
+
+    if (fwrite(header, sizeof(JITCacheHeader), 1, file) != 1
+        || fwrite(object, header->object_size, 1, file) != 1)
+    {
+        fclose(file);
+        goto fail;
+    }
+
+    if (fclose(file) != 0 || rename(tmp_path, path) != 0)
+        goto fail;
+
+    LOG_VERBOSE("Save jit cache %s success.\n", path);
+    return;
+
+fail:
+    LOG_WARNING("write jit cache %s failed.\n", path);
+    remove(tmp_path);
+}
+
+bool wasm_jit_cache_save(WASMModule *module)
+{
+    JITCacheHeader header;
+    uint8 *object;
+    uint32 object_size;
+    bool ret;
+
+    if (!(object = wasm_jit_emit_elf_file(module->comp_ctx, &object_size)))
+        return false;
+
+    jit_cache_header_init(module, &header, object_size);
+    jit_cache_write(&header, (const char *)object);
+
+    ret = jit_cache_add_object(module, (const char *)object, object_size);
+    wasm_jit_destroy_elf_file(object);
+    return ret;
+}
+
+void wasm_jit_cache_destroy(WASMModule *module)
+{
+    if (module->jit_cache)
+    {
+        LLVMOrcDisposeLLJIT(module->jit_cache);
+        module->jit_cache = NULL;
+    }
+}
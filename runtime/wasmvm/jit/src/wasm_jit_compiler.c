@@ -5,66 +5,69 @@
 #include "wasm_jit_emit_numberic.h"
 #include "wasm_jit_emit_control.h"
 #include "wasm_jit_emit_function.h"
+#include "wasm_jit_cache.h"
+#include "wasm_aot_loader.h"
 #include "wasm_fast_readleb.h"
 #include "wasm_opcode.h"
 #include <errno.h>
-
-#define DEF_OP_STORE(type)                                                             \
-    do                                                                                 \
-    {                                                                                  \
-        LLVMValueRef _maddr, _value, _res;                                             \
-        POP(_value);                                                                   \
-        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, 8))) \
-            return false;                                                              \
-        LLVMOPBitCast(_maddr, type##_PTR);                                             \
-        LLVMOPStore(_res, _value, _maddr);                                             \
+#include <elf.h>
+
+#define DEF_OP_STORE(type, bytes)                                                          \
+    do                                                                                     \
+    {                                                                                      \
+        LLVMValueRef _maddr, _value, _res;                                                 \
+        POP(_value);                                                                       \
+        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, bytes))) \
+            return false;                                                                  \
+        LLVMOPBitCast(_maddr, type##_PTR);                                                 \
+        LLVMOPStore(_res, _value, _maddr);                                                 \
     } while (0)
 
-#define DEF_OP_TRUNCSTORE(type)                                                        \
-    do                                                                                 \
-    {                                                                                  \
-        LLVMValueRef _maddr, _value, _res;                                             \
-        POP(_value);                                                                   \
-        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, 8))) \
-            return false;                                                              \
-        LLVMOPBitCast(_maddr, type##_PTR);                                             \
-        LLVMOPTrunc(_value, type);                                                     \
-        LLVMOPStore(_res, _value, _maddr);                                             \
+#define DEF_OP_TRUNCSTORE(type, bytes)                                                     \
+    do                                                                                     \
+    {                                                                                      \
+        LLVMValueRef _maddr, _value, _res;                                                 \
+        POP(_value);                                                                       \
+        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, bytes))) \
+            return false;                                                                  \
+        LLVMOPBitCast(_maddr, type##_PTR);                                                 \
+        LLVMOPTrunc(_value, type);                                                         \
+        LLVMOPStore(_res, _value, _maddr);                                                 \
     } while (0)
 
-#define DEF_OP_LOAD(type)                                                              \
-    do                                                                                 \
-    {                                                                                  \
-        LLVMValueRef _maddr, _value;                                                   \
-        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, 8))) \
-            return false;                                                              \
-        LLVMOPBitCast(_maddr, type##_PTR);                                             \
-        LLVMOPLoad(_value, _maddr, type);                                              \
-        PUSH(_value);                                                                  \
+#define DEF_OP_LOAD(type, bytes)                                                           \
+    do                                                                                     \
+    {                                                                                      \
+        LLVMValueRef _maddr, _value;                                                       \
+        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, bytes))) \
+            return false;                                                                  \
+        LLVMOPBitCast(_maddr, type##_PTR);                                                 \
+        LLVMOPLoad(_value, _maddr, type);                                                  \
+        PUSH(_value);                                                                      \
     } while (0)
 
-#define DEF_OP_SCASTLOAD(cast_type, type)                                              \
-    do                                                                                 \
-    {                                                                                  \
-        LLVMValueRef _maddr, _value;                                                   \
-        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, 8))) \
-            return false;                                                              \
-        LLVMOPBitCast(_maddr, type##_PTR);                                             \
-        LLVMOPLoad(_value, _maddr, type);                                              \
-        LLVMOPSExt(_value, cast_type);                                                 \
-        PUSH(_value);                                                                  \
+#define DEF_OP_SCASTLOAD(cast_type, type, bytes)                                           \
+    do                                                                                     \
+    {                                                                                      \
+        LLVMValueRef _maddr, _value;                                                       \
+        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, bytes))) \
+            return false;                                                                  \
+        LLVMOPBitCast(_maddr, type##_PTR);                                                 \
+        LLVMOPLoad(_value, _maddr, type);                                                  \
+        LLVMOPSExt(_value, cast_type);                                                     \
+        PUSH(_value);                                                                      \
     } while (0)
 
-#define DEF_OP_UCASTLOAD(cast_type, type)                                              \
-    do                                                                                 \
-    {                                                                                  \
-        LLVMValueRef _maddr, _value;                                                   \
-        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, 8))) \
-            return false;                                                              \
-        LLVMOPBitCast(_maddr, type##_PTR);                                             \
-        LLVMOPLoad(_value, _maddr, type);                                              \
-        LLVMOPZExt(_value, cast_type);                                                 \
-        PUSH(_value);                                                                  \
+#define DEF_OP_UCASTLOAD(cast_type, type, bytes)                                           \
+    do                                                                                     \
+    {                                                                                      \
+        LLVMValueRef _maddr, _value;                                                       \
+        if (!(_maddr = wasm_jit_check_memory_overflow(comp_ctx, func_ctx, offset, bytes))) \
+            return false;                                                                  \
+        LLVMOPBitCast(_maddr, type##_PTR);                                                 \
+        LLVMOPLoad(_value, _maddr, type);                                                  \
+        LLVMOPZExt(_value, cast_type);                                                     \
+        PUSH(_value);                                                                      \
     } while (0)
 
 #define DEF_OP_REINTERPRET(llvm_value, dst_type) \
@@ -197,6 +200,17 @@ static inline LLVMTypeRef GET_LLVM_PTRTYPE(JITCompContext *comp_ctx, uint8 value
         op_info = op_info->next_op; \
     } while (0)
 
+// br等指令之后跳过了到else或end的不可达代码, 其中的block和ExtInfo未被读取,
+// 从当前块记录的位置继续读取
+#define SKIP_UNREACHABLE(block_op_info)                                  \
+    do                                                                   \
+    {                                                                    \
+        WASMBlock *_cur_block = (func_ctx->block_stack - 1)->wasm_block; \
+        op_info = _cur_block->block_op_info->next_op;                    \
+        while (wasm_block && wasm_block->end_addr < frame_ip)            \
+            wasm_block = wasm_block->next_block;                         \
+    } while (0)
+
 static bool
 wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32 func_index)
 {
@@ -204,8 +218,8 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
     WASMFunction *wasm_func = func_ctx->wasm_func;
     WASMGlobal *global;
     WASMGlobal *globals = wasm_module->globals;
-    WASMBlock *wasm_block = wasm_func->blocks->next_block;
-    ExtInfo *op_info = wasm_func->op_info->next_op;
+    WASMBlock *wasm_block = wasm_func->jit->blocks->next_block;
+    ExtInfo *op_info = wasm_func->jit->op_info->next_op;
     uint8 *frame_ip = (uint8 *)wasm_func->func_ptr, opcode, *p_f32, *p_f64;
     uint8 *frame_ip_end = wasm_func->code_end;
     uint8 *func_param_types = wasm_func->param_types;
@@ -235,6 +249,8 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
     WASMType *wasm_type = NULL;
     JITBlock *start_block = func_ctx->block_stack - 1;
     start_block->end_addr = wasm_block->end_addr;
+    start_block->stack_num = wasm_block->stack_num;
+    start_block->wasm_block = wasm_block;
     wasm_block = wasm_block->next_block;
 
     LLVMPositionBuilderAtEnd(
@@ -294,11 +310,13 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
             break;
         }
         case WASM_OP_ELSE:
+            SKIP_UNREACHABLE(else_op_info);
             if (!wasm_jit_compile_op_else(comp_ctx, func_ctx))
                 return false;
             break;
 
         case WASM_OP_END:
+            SKIP_UNREACHABLE(end_op_info);
             if (!wasm_jit_compile_op_end(comp_ctx, func_ctx))
                 return false;
             break;
@@ -342,7 +360,13 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
 
         case WASM_OP_CALL:
             read_leb_uint32(frame_ip, frame_ip_end, func_idx);
-            if (!wasm_jit_compile_op_call(wasm_module, comp_ctx, func_ctx, func_idx))
+            if (!wasm_jit_compile_op_call(wasm_module, comp_ctx, func_ctx, func_idx, NULL))
+                return false;
+            break;
+
+        case WASM_OP_RETURN_CALL:
+            read_leb_uint32(frame_ip, frame_ip_end, func_idx);
+            if (!wasm_jit_compile_op_call(wasm_module, comp_ctx, func_ctx, func_idx, &frame_ip))
                 return false;
             break;
 
@@ -354,7 +378,20 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
             read_leb_uint32(frame_ip, frame_ip_end, tbl_idx);
 
             if (!wasm_jit_compile_op_call_indirect(wasm_module, comp_ctx, func_ctx, type_idx,
-                                                   tbl_idx))
+                                                   tbl_idx, NULL))
+                return false;
+            break;
+        }
+
+        case WASM_OP_RETURN_CALL_INDIRECT:
+        {
+            uint32 tbl_idx;
+
+            read_leb_uint32(frame_ip, frame_ip_end, type_idx);
+            read_leb_uint32(frame_ip, frame_ip_end, tbl_idx);
+
+            if (!wasm_jit_compile_op_call_indirect(wasm_module, comp_ctx, func_ctx, type_idx,
+                                                   tbl_idx, &frame_ip))
                 return false;
             break;
         }
@@ -479,116 +516,116 @@ wasm_jit_compile_func(WASMModule *wasm_module, JITCompContext *comp_ctx, uint32
         case WASM_OP_I32_LOAD:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_LOAD(I32_TYPE);
+            DEF_OP_LOAD(I32_TYPE, 4);
             break;
         case WASM_OP_I32_LOAD8_S:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_SCASTLOAD(I32_TYPE, INT8_TYPE);
+            DEF_OP_SCASTLOAD(I32_TYPE, INT8_TYPE, 1);
             break;
         case WASM_OP_I32_LOAD8_U:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_UCASTLOAD(I32_TYPE, INT8_TYPE);
+            DEF_OP_UCASTLOAD(I32_TYPE, INT8_TYPE, 1);
             break;
         case WASM_OP_I32_LOAD16_S:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_SCASTLOAD(I32_TYPE, INT16_TYPE);
+            DEF_OP_SCASTLOAD(I32_TYPE, INT16_TYPE, 2);
             break;
         case WASM_OP_I32_LOAD16_U:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_UCASTLOAD(I32_TYPE, INT16_TYPE);
+            DEF_OP_UCASTLOAD(I32_TYPE, INT16_TYPE, 2);
             break;
 
         case WASM_OP_I64_LOAD:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_LOAD(I64_TYPE);
+            DEF_OP_LOAD(I64_TYPE, 8);
             break;
         case WASM_OP_I64_LOAD8_S:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_SCASTLOAD(I64_TYPE, INT8_TYPE);
+            DEF_OP_SCASTLOAD(I64_TYPE, INT8_TYPE, 1);
             break;
         case WASM_OP_I64_LOAD8_U:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_UCASTLOAD(I64_TYPE, INT8_TYPE);
+            DEF_OP_UCASTLOAD(I64_TYPE, INT8_TYPE, 1);
             break;
         case WASM_OP_I64_LOAD16_S:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_SCASTLOAD(I64_TYPE, INT16_TYPE);
+            DEF_OP_SCASTLOAD(I64_TYPE, INT16_TYPE, 2);
             break;
         case WASM_OP_I64_LOAD16_U:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_UCASTLOAD(I64_TYPE, INT16_TYPE);
+            DEF_OP_UCASTLOAD(I64_TYPE, INT16_TYPE, 2);
             break;
         case WASM_OP_I64_LOAD32_S:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_SCASTLOAD(I64_TYPE, I32_TYPE);
+            DEF_OP_SCASTLOAD(I64_TYPE, I32_TYPE, 4);
             break;
         case WASM_OP_I64_LOAD32_U:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_UCASTLOAD(I64_TYPE, I32_TYPE);
+            DEF_OP_UCASTLOAD(I64_TYPE, I32_TYPE, 4);
             break;
 
         case WASM_OP_F32_LOAD:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_LOAD(F32_TYPE);
+            DEF_OP_LOAD(F32_TYPE, 4);
             break;
 
         case WASM_OP_F64_LOAD:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_LOAD(F64_TYPE);
+            DEF_OP_LOAD(F64_TYPE, 8);
             break;
 
         case WASM_OP_I32_STORE:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_STORE(I32_TYPE);
+            DEF_OP_STORE(I32_TYPE, 4);
             break;
         case WASM_OP_I32_STORE8:
         case WASM_OP_I64_STORE8:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_TRUNCSTORE(INT8_TYPE);
+            DEF_OP_TRUNCSTORE(INT8_TYPE, 1);
             break;
         case WASM_OP_I32_STORE16:
         case WASM_OP_I64_STORE16:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_TRUNCSTORE(INT16_TYPE);
+            DEF_OP_TRUNCSTORE(INT16_TYPE, 2);
             break;
 
         case WASM_OP_I64_STORE:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_STORE(I64_TYPE);
+            DEF_OP_STORE(I64_TYPE, 8);
             break;
         case WASM_OP_I64_STORE32:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_TRUNCSTORE(I32_TYPE);
+            DEF_OP_TRUNCSTORE(I32_TYPE, 4);
             break;
 
         case WASM_OP_F32_STORE:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_STORE(F32_TYPE);
+            DEF_OP_STORE(F32_TYPE, 4);
             break;
 
         case WASM_OP_F64_STORE:
             read_leb_uint32(frame_ip, frame_ip_end, align);
             read_leb_uint32(frame_ip, frame_ip_end, offset);
-            DEF_OP_STORE(F64_TYPE);
+            DEF_OP_STORE(F64_TYPE, 8);
             break;
 
         case WASM_OP_MEMORY_SIZE:
@@ -1134,10 +1171,27 @@ fail:
     return false;
 }
 
-bool wasm_jit_compile_wasm(WASMModule *module)
+// 生成并优化整个模块的LLVM IR
+static bool
+wasm_jit_compile_funcs(WASMModule *module, JITCompContext *comp_ctx)
 {
     uint32 i;
-    JITCompContext *comp_ctx = module->comp_ctx;
+
+    for (i = 0; i < comp_ctx->import_func_count; i++)
+    {
+        if (!wasm_jit_compile_import_func(module, comp_ctx, i))
+        {
+            return false;
+        }
+    }
+
+    for (i = 0; i < module->type_count; i++)
+    {
+        if (!wasm_jit_compile_func_entry(module, comp_ctx, i))
+        {
+            return false;
+        }
+    }
 
     for (i = 0; i < comp_ctx->func_ctx_count; i++)
     {
@@ -1148,6 +1202,19 @@ bool wasm_jit_compile_wasm(WASMModule *module)
     }
 
     wasm_jit_apply_llvm_new_pass_manager(comp_ctx, comp_ctx->module);
+    return true;
+}
+
+bool wasm_jit_compile_wasm(WASMModule *module)
+{
+    JITCompContext *comp_ctx = module->comp_ctx;
+
+    if (!wasm_jit_compile_funcs(module, comp_ctx))
+        return false;
+
+    // 使用缓存时一次生成整个模块的本地代码, 不再延迟编译
+    if (wasm_jit_cache_enabled())
+        return wasm_jit_cache_save(module);
 
     LLVMErrorRef err;
     LLVMOrcJITDylibRef orc_main_dylib;
@@ -1196,4 +1263,72 @@ bool wasm_jit_emit_llvm_file(JITCompContext *comp_ctx, const char *file_name)
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+bool wasm_jit_emit_WASM_JIT_file(JITCompContext *comp_ctx, WASMModule *wasm_module,
+                                 const char *file_name)
+{
+    WASMAOTFileHeader header;
+    uint8 *object, padding[8] = { 0 };
+    uint32 object_size, i;
+    uint64 offset;
+    FILE *file;
+    bool ret = false;
+
+    if (!(object = wasm_jit_emit_elf_file(comp_ctx, &object_size)))
+        return false;
+
+    memset(&header, 0, sizeof(WASMAOTFileHeader));
+    header.magic = WASM_AOT_MAGIC;
+    header.version = WASM_AOT_VERSION;
+    header.module_hash = wasm_module->module_hash;
+    header.layout_hash = wasm_native_code_layout_hash();
+    header.machine = ((const Elf64_Ehdr *)object)->e_machine;
+    header.function_count = wasm_module->function_count;
+    header.type_count = wasm_module->type_count;
+    header.object_size = object_size;
+
+    if (!(file = fopen(file_name, "wb")))
+    {
+        wasm_jit_set_last_error_v("create file %s failed.", file_name);
+        goto fail;
+    }
+
+    ret = fwrite(&header, sizeof(WASMAOTFileHeader), 1, file) == 1;
+    for (i = 0; ret && i < wasm_module->type_count; i++)
+        ret = fwrite(&wasm_module->types[i]->type_id, sizeof(uint32), 1, file) == 1;
+
+    offset = sizeof(WASMAOTFileHeader) + sizeof(uint32) * (uint64)wasm_module->type_count;
+    if (ret && WASM_AOT_OBJECT_OFFSET(wasm_module->type_count) > offset)
+        ret = fwrite(padding, WASM_AOT_OBJECT_OFFSET(wasm_module->type_count) - offset,
+                     1, file) == 1;
+
+    if (ret)
+        ret = fwrite(object, object_size, 1, file) == 1;
+
+    if (fclose(file) != 0 || !ret)
+    {
+        wasm_jit_set_last_error_v("write file %s failed.", file_name);
+        remove(file_name);
+        ret = false;
+    }
+
+fail:
+    wasm_jit_destroy_elf_file(object);
+    return ret;
+}
+
+bool wasm_jit_compile_to_file(WASMModule *module, const char *file_name)
+{
+    bool ret;
+
+    if (!(module->comp_ctx = wasm_jit_create_comp_context(module)))
+        return false;
+
+    ret = wasm_jit_compile_funcs(module, module->comp_ctx)
+          && wasm_jit_emit_WASM_JIT_file(module->comp_ctx, module, file_name);
+
+    wasm_jit_destroy_comp_context(module->comp_ctx);
+    module->comp_ctx = NULL;
+    return ret;
+}
@@ -40,18 +40,21 @@ static inline void destory_jit_block(JITBlock *block)
 
 #define BR_TARGET_JITBLOCK(br_depth) func_ctx->block_stack - br_depth - 1
 
-#define HANDLE_POLYMORPHIC()                  \
-    do                                        \
-    {                                         \
-        cur_block->is_polymorphic = true;     \
-        if (cur_block->is_translate_else)     \
-        {                                     \
-            *frame_ip = cur_block->else_addr; \
-        }                                     \
-        else                                  \
-        {                                     \
-            *frame_ip = cur_block->end_addr;  \
-        }                                     \
+// 之后到else或end的指令不可达, 直接跳过. then分支跳到else指令处继续翻译else分支,
+// 没有else的if与其他块跳到end指令处
+#define HANDLE_POLYMORPHIC()                                                        \
+    do                                                                              \
+    {                                                                               \
+        cur_block->is_polymorphic = true;                                           \
+        if (cur_block->label_type == LABEL_TYPE_IF && !cur_block->is_translate_else \
+            && cur_block->wasm_block->has_else)                                     \
+        {                                                                           \
+            *frame_ip = cur_block->else_addr - 1;                                   \
+        }                                                                           \
+        else                                                                        \
+        {                                                                           \
+            *frame_ip = cur_block->end_addr;                                        \
+        }                                                                           \
     } while (0)
 
 enum
@@ -192,6 +195,7 @@ bool wasm_compile_op_block(JITCompContext *comp_ctx, JITFuncContext *func_ctx, W
     block->stack_num = wasm_block->stack_num;
     block->else_addr = wasm_block->else_addr;
     block->end_addr = wasm_block->end_addr;
+    block->wasm_block = wasm_block;
     block->else_param_phis = NULL;
     block->param_phis = NULL;
     block->result_phis = NULL;
@@ -218,7 +222,8 @@ bool wasm_compile_op_block(JITCompContext *comp_ctx, JITFuncContext *func_ctx, W
     {
         POP_COND(value);
 
-        if (block->else_addr)
+        // 没有else时条件不成立直接跳到结束块
+        if (wasm_block->has_else)
         {
             format_block_name(name, sizeof(name), block_indexes[label_type],
                               label_type, LABEL_ELSE);
@@ -289,6 +294,10 @@ bool wasm_compile_op_block(JITCompContext *comp_ctx, JITFuncContext *func_ctx, W
         }
         SET_BUILDER_POS(block_curr);
 
+        // 没有else的if参数与结果类型相同, 条件不成立时参数直接作为结果
+        if (label_type == LABEL_TYPE_IF && !block->llvm_else_block)
+            CREATE_RESULT_VALUE_PHIS(block);
+
         for (i = 0; i < block->param_count; i++)
         {
             param_index = block->param_count - 1 - i;
@@ -300,6 +309,11 @@ bool wasm_compile_op_block(JITCompContext *comp_ctx, JITFuncContext *func_ctx, W
                 LLVMAddIncoming(block->else_param_phis[param_index], &value,
                                 &block_curr, 1);
             }
+            else if (label_type == LABEL_TYPE_IF)
+            {
+                LLVMAddIncoming(block->result_phis[param_index], &value,
+                                &block_curr, 1);
+            }
         }
     }
 
@@ -326,20 +340,23 @@ bool wasm_jit_compile_op_else(JITCompContext *comp_ctx, JITFuncContext *func_ctx
     LLVMValueRef value;
     uint32 i, result_index;
 
-    block->is_translate_else = true;
-    block->is_polymorphic = false;
-
-    CREATE_RESULT_VALUE_PHIS(block);
-    for (i = 0; i < block->result_count; i++)
+    // then分支以br等指令结束时已跳出, 不再进入结束块
+    if (!block->is_polymorphic)
     {
-        result_index = block->result_count - 1 - i;
-        POP(value);
-        ADD_TO_RESULT_PHIS(block, value, result_index);
+        CREATE_RESULT_VALUE_PHIS(block);
+        for (i = 0; i < block->result_count; i++)
+        {
+            result_index = block->result_count - 1 - i;
+            POP(value);
+            ADD_TO_RESULT_PHIS(block, value, result_index);
+        }
+
+        BUILD_BR(block->llvm_end_block);
     }
 
-    BUILD_BR(block->llvm_end_block);
+    block->is_translate_else = true;
+    block->is_polymorphic = false;
 
-    // 理论上要清理
     RESAT_VALUE_BLOCK();
     for (i = 0; i < block->param_count; i++)
         PUSH(block->else_param_phis[i]);
@@ -360,43 +377,37 @@ bool wasm_jit_compile_op_end(JITCompContext *comp_ctx, JITFuncContext *func_ctx)
 
     result_count = block->result_count;
 
-    if (block->is_polymorphic)
-    {
-        SET_BUILDER_POS(block->llvm_end_block);
-        POP_JITBLOCK();
-        return true;
-    }
-
-    if (block->label_type == LABEL_TYPE_FUNCTION)
-    {
-        ret = wasm_jit_compile_op_return(comp_ctx, func_ctx, NULL);
-        POP_JITBLOCK();
-        return ret;
-    }
-
     // 将结束块移动到当前块后
     MOVE_BLOCK_AFTER_CURR(block->llvm_end_block);
 
+    // 以br等指令结束时当前块已有终结指令, 结果只来自跳转到结束块的分支
     CREATE_RESULT_VALUE_PHIS(block);
-    for (i = 0; i < result_count; i++)
+    if (!block->is_polymorphic)
     {
-        value = NULL;
-        result_index = result_count - 1 - i;
-        POP(value);
-        ADD_TO_RESULT_PHIS(block, value, result_index);
+        for (i = 0; i < result_count; i++)
+        {
+            result_index = result_count - 1 - i;
+            POP(value);
+            ADD_TO_RESULT_PHIS(block, value, result_index);
+        }
+        BUILD_BR(block->llvm_end_block);
     }
 
+    RESAT_VALUE_BLOCK();
     for (i = 0; i < result_count; i++)
     {
         PUSH(block->result_phis[i]);
     }
 
-    BUILD_BR(block->llvm_end_block);
     SET_BUILDER_POS(block->llvm_end_block);
 
+    ret = true;
+    if (block->label_type == LABEL_TYPE_FUNCTION)
+        ret = wasm_jit_compile_op_return(comp_ctx, func_ctx, NULL);
+
     POP_JITBLOCK();
 
-    return true;
+    return ret;
 fail:
     return false;
 }
@@ -696,6 +707,14 @@ fail:
     return false;
 }
 
+// 尾调用已生成返回指令, 只需跳过之后的不可达代码
+bool wasm_jit_compile_op_tail_return(JITFuncContext *func_ctx, uint8 **frame_ip)
+{
+    JITBlock *cur_block = GET_CUR_JITBLOCK();
+    HANDLE_POLYMORPHIC();
+    return true;
+}
+
 bool wasm_jit_compile_op_unreachable(JITCompContext *comp_ctx, JITFuncContext *func_ctx, uint8 **frame_ip)
 {
     JITBlock *cur_block = GET_CUR_JITBLOCK();
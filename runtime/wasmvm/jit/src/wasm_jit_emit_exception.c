@@ -1,52 +1,13 @@
 #include "wasm_jit_emit_exception.h"
 #include "wasm_exception.h"
 
-static const char *exception_msgs[] = {
-    "unreachable",                             /* EXCE_UNREACHABLE */
-    "allocate memory failed",                  /* EXCE_OUT_OF_MEMORY */
-    "out of bounds memory access",             /* EXCE_OUT_OF_BOUNDS_MEMORY_ACCESS */
-    "integer overflow",                        /* EXCE_INTEGER_OVERFLOW */
-    "integer divide by zero",                  /* EXCE_INTEGER_DIVIDE_BY_ZERO */
-    "invalid conversion to integer",           /* EXCE_INVALID_CONVERSION_TO_INTEGER */
-    "indirect call type mismatch",             /* EXCE_INVALID_FUNCTION_TYPE_INDEX */
-    "invalid function index",                  /* EXCE_INVALID_FUNCTION_INDEX */
-    "undefined element",                       /* EXCE_UNDEFINED_ELEMENT */
-    "uninitialized element",                   /* EXCE_UNINITIALIZED_ELEMENT */
-    "failed to call unlinked import function", /* EXCE_CALL_UNLINKED_IMPORT_FUNC */
-    "native stack overflow",                   /* EXCE_NATIVE_STACK_OVERFLOW */
-    "unaligned atomic",                        /* EXCE_UNALIGNED_ATOMIC */
-    "wasm auxiliary stack overflow",           /* EXCE_AUX_STACK_OVERFLOW */
-    "wasm auxiliary stack underflow",          /* EXCE_AUX_STACK_UNDERFLOW */
-    "out of bounds table access",              /* EXCE_OUT_OF_BOUNDS_TABLE_ACCESS */
-    "wasm operand stack overflow",             /* EXCE_OPERAND_STACK_OVERFLOW */
-    "failed to compile fast jit function",     /* EXCE_FAILED_TO_COMPILE_FAST_JIT_FUNC */
-    "",                                        /* EXCE_ALREADY_THROWN */
-};
-
-void wasm_set_exception_with_id(WASMModule *module_inst, uint32 id)
-{
-    if (id < EXCE_NUM)
-        wasm_set_exception(module_inst, exception_msgs[id]);
-    else
-        wasm_set_exception(module_inst, "unknown exception");
-}
-
-void jit_set_exception_with_id(WASMModule *module_inst, uint32 id)
-{
-    if (id != EXCE_ALREADY_THROWN)
-        wasm_set_exception_with_id(module_inst, id);
-#ifdef OS_ENABLE_HW_BOUND_CHECK
-    wasm_runtime_access_exce_check_guard_page();
-#endif
-}
-
 bool wasm_jit_emit_exception(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
                              int32 exception_id, bool is_cond_br, LLVMValueRef cond_br_if,
                              LLVMBasicBlockRef cond_br_else_block)
 {
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
-    LLVMValueRef exce_id = I32_CONST((uint32)exception_id), func_const, func;
-    LLVMTypeRef param_types[2], ret_type, func_type, func_ptr_type;
+    LLVMValueRef exce_id = I32_CONST((uint32)exception_id), func;
+    LLVMTypeRef param_types[2], ret_type, func_type;
     LLVMValueRef param_values[2];
 
     if (!func_ctx->got_exception_block)
@@ -78,16 +39,9 @@ bool wasm_jit_emit_exception(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
             return false;
         }
 
-        if (!(func_ptr_type = LLVMPointerType(func_type, 0)))
-        {
-            wasm_jit_set_last_error("create LLVM function type failed.");
-            return false;
-        }
-        if (!(func_const =
-                  I64_CONST((uint64)(uintptr_t)jit_set_exception_with_id)) ||
-            !(func = LLVMConstIntToPtr(func_const, func_ptr_type)))
+        if (!(func = wasm_jit_get_runtime_func(comp_ctx, "jit_set_exception_with_id",
+                                               func_type)))
         {
-            wasm_jit_set_last_error("create LLVM value failed.");
             return false;
         }
 
@@ -26,97 +26,337 @@ get_tbl_inst_offset(uint32 tbl_idx)
     return offset;
 }
 
-// 参数和返回值的内存由调用者提供
-static bool jit_call_indirect(JITCompContext *comp_ctx, JITFuncContext *func_ctx, WASMType *wasm_type,
-                              JITFuncType *jit_func_type, LLVMValueRef llvm_func_idx, LLVMValueRef *llvm_param_values, LLVMValueRef *llvm_ret_values)
+// 从base偏移offset字节处读取type类型的值, 用于读取运行时结构的字段
+static LLVMValueRef
+jit_load_field(JITCompContext *comp_ctx, LLVMValueRef base, uint64 offset,
+               LLVMTypeRef type, const char *name)
 {
-    LLVMTypeRef llvm_func_type, llvm_ret_type, *llvm_param_types, *llvm_result_types;
-    LLVMTypeRef import_func_param_types[4];
     LLVMBuilderRef builder = comp_ctx->builder;
-    LLVMValueRef import_func_param_values[4], llvm_func;
-    LLVMTypeRef func_ptr_type, ret_ptr_type, llvm_param_ptr_type;
-    LLVMValueRef llvm_res, llvm_ret_idx, llvm_ret_ptr, llvm_param_idx, llvm_param_ptr;
-    LLVMTypeRef llvm_param_type;
-    uint32 cell_num, param_count, result_count, i;
-    uint8 *wasm_param_types, *wasm_result_types;
-    char buf[32];
+    LLVMValueRef llvm_offset = I64_CONST(offset), field_ptr, value;
 
-    param_count = wasm_type->param_count;
-    result_count = wasm_type->result_count;
-    wasm_result_types = wasm_type->result;
-    wasm_param_types = wasm_type->param;
-    llvm_param_types = jit_func_type->llvm_param_types;
-    llvm_result_types = jit_func_type->llvm_result_types;
+    LLVMBuildGEP(field_ptr, INT8_TYPE, base, llvm_offset, "field_offset");
+    if (!(field_ptr = LLVMBuildBitCast(builder, field_ptr, LLVMPointerType(type, 0), "field_ptr"))
+        || !(value = LLVMBuildLoad2(builder, type, field_ptr, name)))
+    {
+        wasm_jit_set_last_error("llvm build load failed.");
+        return NULL;
+    }
+    return value;
+}
 
-    import_func_param_types[0] = comp_ctx->exec_env_type; /* exec_env */
-    import_func_param_types[1] = I32_TYPE;                /* func_idx */
-    import_func_param_types[2] = I32_TYPE_PTR;            /* argv */
-    import_func_param_types[3] = I32_TYPE_PTR;            /* argv_ret */
+// 导入函数的入口与wasm函数的签名相同, 直接调用和call_indirect都按本地调用进入.
+// 入口从functions[import_idx].func_ptr取出宿主函数后按签名直接调用, 结果在寄存器中返回,
+// 签名中为'*'的参数在此换算为mem_base + offset, 与wasm_runtime_addr_app_to_native一样,
+// 越界时传入NULL由宿主函数检查. 额外结果的指针跟在参数之后, 由宿主函数直接写回
+bool wasm_jit_compile_import_func(WASMModule *wasm_module, JITCompContext *comp_ctx,
+                                  uint32 import_idx)
+{
+    WASMFunction *wasm_func = wasm_module->functions + import_idx;
+    WASMType *wasm_type = wasm_func->func_type;
+    JITFuncType *jit_func_type = comp_ctx->jit_func_types + wasm_func->type_index;
+    LLVMValueRef llvm_func = comp_ctx->import_funcs[import_idx];
+    LLVMBuilderRef builder = comp_ctx->builder;
+    const char *signature = wasm_func->signature;
+    LLVMTypeRef *native_param_types = NULL, native_func_type;
+    LLVMValueRef *native_param_values = NULL;
+    LLVMValueRef exec_env, module_inst, module_inst_addr, functions, native_func, llvm_idx;
+    LLVMValueRef mem_base = NULL, mem_data_size = NULL, offset, native_addr, in_bound, res;
+    LLVMBasicBlockRef func_begin;
+    uint32 param_count = wasm_type->param_count;
+    uint32 result_count = wasm_type->result_count;
+    uint32 total_count = 1 + param_count + (result_count > 1 ? result_count - 1 : 0);
+    uint32 i;
+    uint64 total_size;
+    bool ret = false;
 
-    llvm_func_type = LLVMFunctionType(INT8_TYPE, import_func_param_types, 4, false);
+    if (!(func_begin = LLVMAppendBasicBlockInContext(comp_ctx->context, llvm_func,
+                                                     "func_begin")))
+    {
+        wasm_jit_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+    LLVMPositionBuilderAtEnd(builder, func_begin);
 
-    func_ptr_type = LLVMPointerType(llvm_func_type, 0);
+    total_size = sizeof(LLVMTypeRef) * (uint64)total_count;
+    if (!(native_param_types = wasm_runtime_malloc(total_size))
+        || !(native_param_values = wasm_runtime_malloc(total_size)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        goto fail;
+    }
 
-    llvm_func = I64_CONST((uint64)(uintptr_t)wasm_runtime_invoke_native);
-    llvm_func = LLVMConstIntToPtr(llvm_func, func_ptr_type);
+    for (i = 0; i < total_count; i++)
+    {
+        native_param_types[i] = jit_func_type->llvm_param_types[i];
+        native_param_values[i] = LLVMGetParam(llvm_func, i);
+    }
+
+    exec_env = native_param_values[0];
+    llvm_idx = I32_TWO;
+    LLVMBuildGEP(module_inst_addr, OPQ_PTR_TYPE, exec_env, llvm_idx, "module_inst_addr");
+    if (!(module_inst = LLVMBuildLoad2(builder, OPQ_PTR_TYPE, module_inst_addr, "module_inst")))
+    {
+        wasm_jit_set_last_error("llvm build load failed.");
+        goto fail;
+    }
 
-    cell_num = 0;
     for (i = 0; i < param_count; i++)
     {
-        llvm_param_type = llvm_param_types[i + 1];
-        llvm_param_idx = I32_CONST(cell_num);
-        llvm_param_ptr_type = LLVMPointerType(llvm_param_type, 0);
+        if (!signature || signature[i + 1] != '*')
+            continue;
+
+        // 线性内存扩容不移动基址, 入口处读取一次即可
+        if (!mem_base
+            && (!(mem_base = jit_load_field(comp_ctx, module_inst,
+                                            offsetof(WASMModule, memories) + offsetof(WASMMemory, memory_data),
+                                            OPQ_PTR_TYPE, "mem_base"))
+                || !(mem_data_size = jit_load_field(comp_ctx, module_inst,
+                                                    offsetof(WASMModule, memories) + offsetof(WASMMemory, memory_data_size),
+                                                    I32_TYPE, "mem_data_size"))))
+            goto fail;
 
-        snprintf(buf, sizeof(buf), "%s%d", "elem", i);
-        LLVMBuildGEP(llvm_param_ptr, I32_TYPE,
-                     func_ctx->argv_buf, llvm_param_idx, buf);
-        llvm_param_ptr = LLVMBuildBitCast(comp_ctx->builder, llvm_param_ptr,
-                                          llvm_param_ptr_type, buf);
+        offset = native_param_values[i + 1];
+        in_bound = LLVMBuildICmp(builder, LLVMIntULT, offset, mem_data_size, "in_bound");
+        offset = LLVMBuildZExt(builder, offset, I64_TYPE, "app_offset");
+        LLVMBuildGEP(native_addr, INT8_TYPE, mem_base, offset, "native_addr");
+        if (!in_bound || !native_addr
+            || !(native_addr = LLVMBuildSelect(builder, in_bound, native_addr,
+                                               LLVMConstNull(OPQ_PTR_TYPE), "native_ptr")))
+        {
+            wasm_jit_set_last_error("llvm build address translation failed.");
+            goto fail;
+        }
+        native_param_types[i + 1] = OPQ_PTR_TYPE;
+        native_param_values[i + 1] = native_addr;
+    }
 
-        llvm_res = LLVMBuildStore(comp_ctx->builder, llvm_param_values[i + 1],
-                                  llvm_param_ptr);
+    native_func_type = LLVMFunctionType(result_count > 0 ? jit_func_type->llvm_result_types[0] : VOID_TYPE,
+                                        native_param_types, total_count, false);
 
-        LLVMSetAlignment(llvm_res, 1);
+    // 宿主函数的地址不写入代码, 缓存和预编译的代码链接到当前进程中的宿主函数
+    if (!(functions = jit_load_field(comp_ctx, module_inst, offsetof(WASMModule, functions),
+                                     OPQ_PTR_TYPE, "functions"))
+        || !(native_func = jit_load_field(comp_ctx, functions,
+                                          import_idx * (uint64)sizeof(WASMFunction) + offsetof(WASMFunction, func_ptr),
+                                          OPQ_PTR_TYPE, "native_func")))
+        goto fail;
 
-        cell_num += wasm_value_type_cell_num(wasm_param_types[i]);
+    if (!(native_func = LLVMBuildBitCast(builder, native_func, LLVMPointerType(native_func_type, 0),
+                                         "native_func_ptr")))
+    {
+        wasm_jit_set_last_error("llvm build bit cast failed.");
+        goto fail;
     }
 
-    // 都使用argv_buf
-    import_func_param_values[0] = func_ctx->exec_env;
-    import_func_param_values[1] = llvm_func_idx;
-    import_func_param_values[2] = func_ctx->argv_buf;
-    import_func_param_values[3] = func_ctx->argv_buf;
-    llvm_res = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, llvm_func,
-                              import_func_param_values, 4, "res");
+    if (!(res = LLVMBuildCall2(builder, native_func_type, native_func, native_param_values,
+                               total_count, result_count > 0 ? "ret" : "")))
+    {
+        wasm_jit_set_last_error("llvm build call failed.");
+        goto fail;
+    }
 
-    // 返回参数全存在argv_buf中
+    if (!(result_count > 0 ? LLVMBuildRet(builder, res) : LLVMBuildRetVoid(builder)))
+    {
+        wasm_jit_set_last_error("llvm build return failed.");
+        goto fail;
+    }
+
+    ret = true;
+fail:
+    if (native_param_types)
+        wasm_runtime_free(native_param_types);
+    if (native_param_values)
+        wasm_runtime_free(native_param_values);
+    return ret;
+}
+
+// argv中第cell_num个单元的地址, 转换为指向type的指针
+static LLVMValueRef
+jit_argv_cell_ptr(JITCompContext *comp_ctx, LLVMValueRef argv, uint32 cell_num,
+                  LLVMTypeRef type)
+{
+    LLVMBuilderRef builder = comp_ctx->builder;
+    LLVMValueRef cell_idx = I32_CONST(cell_num), cell_ptr;
+
+    LLVMBuildGEP(cell_ptr, I32_TYPE, argv, cell_idx, "cell_ptr");
+    if (!cell_ptr || !(cell_ptr = LLVMBuildBitCast(builder, cell_ptr, LLVMPointerType(type, 0),
+                                                   "cell_ptr_cast")))
+    {
+        wasm_jit_set_last_error("llvm build bit cast failed.");
+        return NULL;
+    }
+    return cell_ptr;
+}
+
+// 宿主调用编译好的函数时经过的入口, 形如void entry(exec_env, func_ptr, argv).
+// 参数从argv的单元中取出, 结果按顺序写回argv开始处, 额外结果的指针直接指向其在argv中的位置
+bool wasm_jit_compile_func_entry(WASMModule *wasm_module, JITCompContext *comp_ctx,
+                                 uint32 type_idx)
+{
+    WASMType *wasm_type = wasm_module->types[type_idx];
+    JITFuncType *jit_func_type = comp_ctx->jit_func_types + type_idx;
+    LLVMBuilderRef builder = comp_ctx->builder;
+    LLVMTypeRef entry_param_types[3], entry_func_type;
+    LLVMValueRef entry_func, *param_values = NULL, func_ptr, argv, value_ptr, res;
+    LLVMBasicBlockRef func_begin;
+    uint32 param_count = wasm_type->param_count;
+    uint32 result_count = wasm_type->result_count;
+    uint32 total_count = 1 + param_count + (result_count > 1 ? result_count - 1 : 0);
+    uint32 cell_num, i;
+    bool ret = false;
+    char func_name[48];
+
+    entry_param_types[0] = comp_ctx->exec_env_type; /* exec_env */
+    entry_param_types[1] = OPQ_PTR_TYPE;            /* func_ptr */
+    entry_param_types[2] = I32_TYPE_PTR;            /* argv */
+    entry_func_type = LLVMFunctionType(VOID_TYPE, entry_param_types, 3, false);
+
+    snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_ENTRY_PREFIX, type_idx);
+    if (!(entry_func = LLVMAddFunction(comp_ctx->module, func_name, entry_func_type)))
+    {
+        wasm_jit_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    if (!(func_begin = LLVMAppendBasicBlockInContext(comp_ctx->context, entry_func,
+                                                     "func_begin")))
+    {
+        wasm_jit_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+    LLVMPositionBuilderAtEnd(builder, func_begin);
+
+    if (!(param_values = wasm_runtime_malloc(sizeof(LLVMValueRef) * (uint64)total_count)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        return false;
+    }
+
+    param_values[0] = LLVMGetParam(entry_func, 0);
+    argv = LLVMGetParam(entry_func, 2);
+
+    // 参数都在调用前读出, 之后argv只用于存放结果
     cell_num = 0;
-    for (i = 0; i < result_count; i++)
+    for (i = 0; i < param_count; i++)
+    {
+        if (!(value_ptr = jit_argv_cell_ptr(comp_ctx, argv, cell_num,
+                                            jit_func_type->llvm_param_types[i + 1])))
+            goto fail;
+        if (!(param_values[i + 1] = LLVMBuildLoad2(builder, jit_func_type->llvm_param_types[i + 1],
+                                                   value_ptr, "param")))
+        {
+            wasm_jit_set_last_error("llvm build load failed.");
+            goto fail;
+        }
+        LLVMSetAlignment(param_values[i + 1], 4);
+        cell_num += wasm_value_type_cell_num(wasm_type->param[i]);
+    }
+
+    cell_num = result_count > 0 ? wasm_value_type_cell_num(wasm_type->result[0]) : 0;
+    for (i = 1; i < result_count; i++)
     {
-        llvm_ret_type = llvm_result_types[i];
-        llvm_ret_idx = I32_CONST(cell_num);
-        ret_ptr_type = LLVMPointerType(llvm_ret_type, 0);
-        snprintf(buf, sizeof(buf), "argv_ret%d", i);
+        if (!(param_values[param_count + i] =
+                  jit_argv_cell_ptr(comp_ctx, argv, cell_num, jit_func_type->llvm_result_types[i])))
+            goto fail;
+        cell_num += wasm_value_type_cell_num(wasm_type->result[i]);
+    }
 
-        LLVMBuildGEP(llvm_ret_ptr, I32_TYPE,
-                     func_ctx->argv_buf, llvm_ret_idx, buf);
+    if (!(func_ptr = LLVMBuildBitCast(builder, LLVMGetParam(entry_func, 1),
+                                      LLVMPointerType(jit_func_type->llvm_func_type, 0),
+                                      "func_ptr")))
+    {
+        wasm_jit_set_last_error("llvm build bit cast failed.");
+        goto fail;
+    }
 
-        llvm_ret_ptr = LLVMBuildBitCast(comp_ctx->builder, llvm_ret_ptr,
-                                        ret_ptr_type, buf);
+    if (!(res = LLVMBuildCall2(builder, jit_func_type->llvm_func_type, func_ptr, param_values,
+                               total_count, result_count > 0 ? "ret" : "")))
+    {
+        wasm_jit_set_last_error("llvm build call failed.");
+        goto fail;
+    }
 
-        snprintf(buf, sizeof(buf), "ret%d", i);
-        llvm_ret_values[i] = LLVMBuildLoad2(comp_ctx->builder, llvm_ret_type, llvm_ret_ptr, buf);
-        cell_num += wasm_value_type_cell_num(wasm_result_types[i]);
+    if (result_count > 0)
+    {
+        if (!(value_ptr = jit_argv_cell_ptr(comp_ctx, argv, 0, jit_func_type->llvm_result_types[0])))
+            goto fail;
+        if (!(res = LLVMBuildStore(builder, res, value_ptr)))
+        {
+            wasm_jit_set_last_error("llvm build store failed.");
+            goto fail;
+        }
+        LLVMSetAlignment(res, 4);
+    }
+
+    if (!LLVMBuildRetVoid(builder))
+    {
+        wasm_jit_set_last_error("llvm build return failed.");
+        goto fail;
     }
 
+    ret = true;
+fail:
+    wasm_runtime_free(param_values);
+    return ret;
+}
+
+// 被调用函数(或导入的宿主函数)抛出异常时只设置cur_exception并返回,
+// 调用返回后检查异常, 有异常则跳到func_return_block直接返回
+static bool
+jit_check_call_exception(JITCompContext *comp_ctx, JITFuncContext *func_ctx)
+{
+    LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
+    LLVMBasicBlockRef check_succ;
+    LLVMValueRef exce, cmp;
+
+    if (!func_ctx->func_return_block)
+    {
+        ADD_BASIC_BLOCK(func_ctx->func_return_block, "func_ret");
+        LLVMPositionBuilderAtEnd(comp_ctx->builder, func_ctx->func_return_block);
+        if (!wasm_jit_build_zero_function_ret(comp_ctx, func_ctx,
+                                              func_ctx->wasm_func->func_type))
+            goto fail;
+        LLVMPositionBuilderAtEnd(comp_ctx->builder, block_curr);
+    }
+
+    if (!(exce = LLVMBuildLoad2(comp_ctx->builder, INT8_TYPE,
+                                func_ctx->cur_exception, "exce")))
+    {
+        wasm_jit_set_last_error("llvm build load failed.");
+        goto fail;
+    }
+
+    if (!(cmp = LLVMBuildICmp(comp_ctx->builder, LLVMIntNE, exce, I8_ZERO,
+                              "cmp_exce")))
+    {
+        wasm_jit_set_last_error("llvm build icmp failed.");
+        goto fail;
+    }
+
+    ADD_BASIC_BLOCK(check_succ, "check_exce_succ");
+    LLVMMoveBasicBlockAfter(check_succ, block_curr);
+
+    if (!LLVMBuildCondBr(comp_ctx->builder, cmp, func_ctx->func_return_block,
+                         check_succ))
+    {
+        wasm_jit_set_last_error("llvm build cond br failed.");
+        goto fail;
+    }
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, check_succ);
     return true;
+fail:
+    return false;
 }
 
+// 尾调用时被调用函数的结果直接作为当前函数的结果返回, 额外结果已通过当前函数的结果指针写回,
+// llvm_func为NULL时经func_ptrs[llvm_func_idx]调用
 static bool
 jit_call_direct(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
-                WASMType *wasm_type, JITFuncType *jit_func_type, LLVMValueRef llvm_func_idx, LLVMValueRef *llvm_param_values, LLVMValueRef *llvm_ret_values, uint32 func_idx)
+                WASMType *wasm_type, JITFuncType *jit_func_type, LLVMValueRef llvm_func_idx, LLVMValueRef *llvm_param_values, LLVMValueRef *llvm_ret_values, LLVMValueRef llvm_func,
+                bool tail_call)
 {
-    LLVMValueRef llvm_ret, ext_ret, llvm_func_ptr, llvm_func;
+    LLVMValueRef llvm_ret, ext_ret, llvm_func_ptr;
     LLVMBuilderRef builder = comp_ctx->builder;
     LLVMTypeRef llvm_func_type, *llvm_ext_result_types, llvm_func_ptr_type;
     uint32 i;
@@ -127,7 +367,7 @@ jit_call_direct(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
 
     llvm_func_type = jit_func_type->llvm_func_type;
 
-    if (func_idx == -1)
+    if (!llvm_func)
     {
         LLVMBuildGEP(llvm_func_ptr, OPQ_PTR_TYPE,
                      func_ctx->func_ptrs, llvm_func_idx, "func_ptr_tmp");
@@ -142,23 +382,35 @@ jit_call_direct(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
             wasm_jit_set_last_error("llvm build bit cast failed.");
             return false;
         }
+    }
+
+    if (!(llvm_ret = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, llvm_func,
+                                    llvm_param_values, param_count + 1 + ext_ret_count,
+                                    result_count > 0 ? "ret" : "")))
+    {
+        wasm_jit_set_last_error("llvm build call failed.");
+        return false;
+    }
 
-        if (!(llvm_ret = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, llvm_func,
-                                        llvm_param_values, param_count + 1 + ext_ret_count,
-                                        result_count > 0 ? "ret" : "")))
+    if (tail_call)
+    {
+        // 签名相同时必须复用当前栈帧, 深度递归的尾调用不会耗尽栈.
+        // musttail要求调用者与被调用者的原型一致, 签名不同时只能提示LLVM尽量尾调用
+        if (llvm_func_type == func_ctx->llvm_func_type)
+            wasm_jit_set_musttail(llvm_ret);
+        else
+            LLVMSetTailCall(llvm_ret, true);
+        if (!(result_count > 0 ? LLVMBuildRet(builder, llvm_ret) : LLVMBuildRetVoid(builder)))
         {
-            wasm_jit_set_last_error("llvm build call failed.");
+            wasm_jit_set_last_error("llvm build return failed.");
             return false;
         }
-    }
-    else
-    {
-        llvm_func = comp_ctx->jit_func_ctxes[func_idx]->func;
-        llvm_ret = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, llvm_func,
-                                  llvm_param_values, param_count + 1 + ext_ret_count,
-                                  result_count > 0 ? "ret" : "");
+        return true;
     }
 
+    if (!jit_check_call_exception(comp_ctx, func_ctx))
+        return false;
+
     if (wasm_type->result_count > 0)
     {
         llvm_ret_values[0] = llvm_ret;
@@ -179,8 +431,9 @@ jit_call_direct(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
     return true;
 }
 
+// frame_ip不为NULL时编译为尾调用
 bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx, JITFuncContext *func_ctx,
-                              uint32 func_idx)
+                              uint32 func_idx, uint8 **frame_ip)
 {
     uint32 import_func_count = wasm_module->import_function_count;
     WASMFunction *wasm_func = wasm_module->functions + func_idx;
@@ -190,7 +443,7 @@ bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx,
     LLVMTypeRef ext_ret_ptr_type;
     LLVMValueRef *llvm_param_values = NULL;
     LLVMValueRef *llvm_ret_values = NULL;
-    LLVMValueRef ext_ret_ptr, ext_ret_idx, llvm_func_idx;
+    LLVMValueRef ext_ret_ptr, ext_ret_idx, llvm_func_idx, llvm_func;
     LLVMBuilderRef builder = comp_ctx->builder;
     int32 i, j = 0, param_count, result_count, ext_ret_count;
     uint64 total_size;
@@ -204,12 +457,19 @@ bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx,
     result_count = (int32)func_type->result_count;
     ext_ret_count = result_count > 1 ? result_count - 1 : 0;
     total_size = sizeof(LLVMValueRef) * (uint64)(param_count + 1 + ext_ret_count);
-    llvm_param_values = wasm_runtime_malloc(total_size);
+    if (!(llvm_param_values = wasm_runtime_malloc(total_size)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        goto fail;
+    }
     total_size = sizeof(LLVMValueRef) * result_count;
     llvm_func_idx = I32_CONST(func_idx);
 
-    if (total_size > 0)
-        llvm_ret_values = wasm_runtime_malloc(total_size);
+    if (total_size > 0 && !(llvm_ret_values = wasm_runtime_malloc(total_size)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        goto fail;
+    }
 
     // 第一个参数
     llvm_param_values[j++] = func_ctx->exec_env;
@@ -232,6 +492,14 @@ bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx,
 
         for (i = 0; i < ext_ret_count; i++)
         {
+            // 尾调用直接使用当前函数的结果指针
+            if (frame_ip && func_idx >= import_func_count)
+            {
+                llvm_param_values[param_count + 1 + i] =
+                    LLVMGetParam(func_ctx->func, func_ctx->wasm_func->func_type->param_count + 1 + i);
+                continue;
+            }
+
             if (!(ext_ret_idx = I32_CONST(cell_num)) || !(ext_ret_ptr_type = llvm_param_types[param_count + 1 + i]))
             {
                 wasm_jit_set_last_error("llvm add const or pointer type failed.");
@@ -255,16 +523,30 @@ bool wasm_jit_compile_op_call(WASMModule *wasm_module, JITCompContext *comp_ctx,
     }
 
     if (func_idx < import_func_count)
+        llvm_func = comp_ctx->import_funcs[func_idx];
+    else
+        llvm_func = comp_ctx->jit_func_ctxes[func_idx - import_func_count]->func;
+
+    if (frame_ip && func_idx >= import_func_count)
     {
-        ret = jit_call_indirect(comp_ctx, func_ctx, wasm_func->func_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values);
+        if (!jit_call_direct(comp_ctx, func_ctx, func_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values,
+                             llvm_func, true)
+            || !wasm_jit_compile_op_tail_return(func_ctx, frame_ip))
+            goto fail;
     }
     else
     {
-        ret = jit_call_direct(comp_ctx, func_ctx, wasm_func->func_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values, func_idx - import_func_count);
+        if (!jit_call_direct(comp_ctx, func_ctx, func_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values,
+                             llvm_func, false))
+            goto fail;
+        for (i = 0; i < result_count; i++)
+            PUSH(llvm_ret_values[i]);
+        // 导入函数不占用wasm栈帧, 调用后按return处理
+        if (frame_ip && !wasm_jit_compile_op_return(comp_ctx, func_ctx, frame_ip))
+            goto fail;
     }
-    for (i = 0; i < result_count; i++)
-        PUSH(llvm_ret_values[i]);
-    return true;
+
+    ret = true;
 fail:
     if (param_types)
         wasm_runtime_free(param_types);
@@ -275,23 +557,22 @@ fail:
     return ret;
 }
 
+// frame_ip不为NULL时编译为尾调用
 bool wasm_jit_compile_op_call_indirect(WASMModule *wasm_module, JITCompContext *comp_ctx, JITFuncContext *func_ctx,
-                                       uint32 type_idx, uint32 tbl_idx)
+                                       uint32 type_idx, uint32 tbl_idx, uint8 **frame_ip)
 {
     WASMType *wasm_type;
     LLVMBuilderRef builder = comp_ctx->builder;
     LLVMValueRef llvm_elem_idx, llvm_table_elem, llvm_func_idx;
-    LLVMValueRef ftype_idx_ptr, ftype_idx, ftype_idx_const, llvm_import_func_count;
+    LLVMValueRef ftype_idx_ptr, ftype_idx, ftype_idx_const;
     LLVMValueRef cmp_elem_idx, cmp_func_idx, cmp_ftype_idx;
     LLVMValueRef table_size_const;
     LLVMValueRef ext_ret_offset, ext_ret_ptr;
     LLVMValueRef *llvm_param_values = NULL, *llvm_ret_values = NULL;
-    LLVMValueRef *result_phis = NULL;
     LLVMTypeRef *llvm_param_types = NULL;
     LLVMTypeRef ext_ret_ptr_type;
     LLVMBasicBlockRef check_elem_idx_succ, check_ftype_idx_succ;
-    LLVMBasicBlockRef check_func_idx_succ, block_return, block_curr;
-    LLVMBasicBlockRef block_call_import, block_call_non_import;
+    LLVMBasicBlockRef check_func_idx_succ;
     LLVMValueRef llvm_offset;
     LLVMValueRef llvm_tables_base_addr = func_ctx->tables_base_addr;
     JITFuncType *jit_func_type;
@@ -308,9 +589,8 @@ bool wasm_jit_compile_op_call_indirect(WASMModule *wasm_module, JITCompContext *
     param_count = wasm_type->param_count;
     result_count = wasm_type->result_count;
 
-    type_idx = wasm_get_cur_type_idx(wasm_module->types, wasm_type);
-
-    ftype_idx_const = I32_CONST(type_idx);
+    // 表中函数的类型编号与期望的编号相同即签名一致
+    ftype_idx_const = I32_CONST(wasm_type->type_id);
 
     POP_I32(llvm_elem_idx);
 
@@ -468,6 +748,14 @@ bool wasm_jit_compile_op_call_indirect(WASMModule *wasm_module, JITCompContext *
     ext_cell_num = 0;
     for (i = 1; i < result_count; i++)
     {
+        // 尾调用直接使用当前函数的结果指针
+        if (frame_ip)
+        {
+            llvm_param_values[param_count + i] =
+                LLVMGetParam(func_ctx->func, func_ctx->wasm_func->func_type->param_count + i);
+            continue;
+        }
+
         ext_ret_offset = I32_CONST(ext_cell_num);
 
         snprintf(buf, sizeof(buf), "ext_ret%d_ptr", i - 1);
@@ -494,109 +782,30 @@ bool wasm_jit_compile_op_call_indirect(WASMModule *wasm_module, JITCompContext *
         goto fail;
     }
 
-    block_call_import = LLVMAppendBasicBlockInContext(
-        comp_ctx->context, func_ctx->func, "call_indirect");
-    block_call_non_import = LLVMAppendBasicBlockInContext(
-        comp_ctx->context, func_ctx->func, "call_non_import");
-    block_return = LLVMAppendBasicBlockInContext(comp_ctx->context,
-                                                 func_ctx->func, "func_return");
-    if (!block_call_import || !block_call_non_import || !block_return)
-    {
-        wasm_jit_set_last_error("llvm add basic block failed.");
-        goto fail;
-    }
-
-    LLVMMoveBasicBlockAfter(block_call_import,
-                            LLVMGetInsertBlock(comp_ctx->builder));
-    LLVMMoveBasicBlockAfter(block_call_non_import, block_call_import);
-    LLVMMoveBasicBlockAfter(block_return, block_call_non_import);
-
-    llvm_import_func_count = I32_CONST(wasm_module->import_function_count);
-
-    if (!(cmp_func_idx = LLVMBuildICmp(comp_ctx->builder, LLVMIntULT, llvm_func_idx,
-                                       llvm_import_func_count, "cmp_func_idx")))
+    // 导入函数在func_ptrs中也是与wasm函数签名相同的入口, 所有目标都按本地调用进入
+    if (frame_ip)
     {
-        wasm_jit_set_last_error("llvm build icmp failed.");
-        goto fail;
-    }
-
-    if (!LLVMBuildCondBr(comp_ctx->builder, cmp_func_idx, block_call_import,
-                         block_call_non_import))
-    {
-        wasm_jit_set_last_error("llvm build cond br failed.");
-        goto fail;
+        if (!jit_call_direct(comp_ctx, func_ctx, wasm_type, jit_func_type, llvm_func_idx, llvm_param_values, NULL, NULL, true)
+            || !wasm_jit_compile_op_tail_return(func_ctx, frame_ip))
+            goto fail;
     }
-
-    LLVMPositionBuilderAtEnd(comp_ctx->builder, block_return);
-
-    if (result_count > 0)
+    else
     {
-        total_size = sizeof(LLVMValueRef) * (uint64)result_count;
-        if (!(result_phis = wasm_runtime_malloc(total_size)))
-        {
-            wasm_jit_set_last_error("allocate memory failed.");
-            goto fail;
-        }
-        memset(result_phis, 0, (uint32)total_size);
-        for (i = 0; i < result_count; i++)
+        if (result_count > 0)
         {
-            LLVMTypeRef tmp_type = TO_LLVM_TYPE(wasm_result_types[i]);
-            if (!(result_phis[i] =
-                      LLVMBuildPhi(comp_ctx->builder, tmp_type, "phi")))
+            total_size = sizeof(LLVMValueRef) * (uint64)result_count;
+            if (!(llvm_ret_values = wasm_runtime_malloc(total_size)))
             {
-                wasm_jit_set_last_error("llvm build phi failed.");
+                wasm_jit_set_last_error("allocate memory failed.");
                 goto fail;
             }
         }
-    }
-
-    LLVMPositionBuilderAtEnd(comp_ctx->builder, block_call_import);
 
-    if (result_count > 0)
-    {
-        total_size = sizeof(LLVMValueRef) * (uint64)result_count;
-        if (!(llvm_ret_values = wasm_runtime_malloc(total_size)))
-        {
-            wasm_jit_set_last_error("allocate memory failed.");
+        if (!jit_call_direct(comp_ctx, func_ctx, wasm_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values, NULL, false))
             goto fail;
-        }
-    }
 
-    jit_call_indirect(comp_ctx, func_ctx, wasm_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values);
-
-    block_curr = LLVMGetInsertBlock(comp_ctx->builder);
-    for (i = 0; i < result_count; i++)
-    {
-        LLVMAddIncoming(result_phis[i], &llvm_ret_values[i], &block_curr, 1);
-    }
-
-    if (!LLVMBuildBr(comp_ctx->builder, block_return))
-    {
-        wasm_jit_set_last_error("llvm build br failed.");
-        goto fail;
-    }
-
-    LLVMPositionBuilderAtEnd(comp_ctx->builder, block_call_non_import);
-
-    jit_call_direct(comp_ctx, func_ctx, wasm_type, jit_func_type, llvm_func_idx, llvm_param_values, llvm_ret_values, -1);
-
-    block_curr = LLVMGetInsertBlock(comp_ctx->builder);
-    for (i = 0; i < result_count; i++)
-    {
-        LLVMAddIncoming(result_phis[i], &llvm_ret_values[i], &block_curr, 1);
-    }
-
-    if (!LLVMBuildBr(comp_ctx->builder, block_return))
-    {
-        wasm_jit_set_last_error("llvm build br failed.");
-        goto fail;
-    }
-
-    LLVMPositionBuilderAtEnd(comp_ctx->builder, block_return);
-
-    for (i = 0; i < result_count; i++)
-    {
-        PUSH(result_phis[i]);
+        for (i = 0; i < result_count; i++)
+            PUSH(llvm_ret_values[i]);
     }
 
     ret = true;
@@ -606,7 +815,5 @@ fail:
         wasm_runtime_free(llvm_param_values);
     if (llvm_ret_values)
         wasm_runtime_free(llvm_ret_values);
-    if (result_phis)
-        wasm_runtime_free(result_phis);
     return ret;
 }
\ No newline at end of file
@@ -28,65 +28,71 @@
 
 #define SET_BUILD_POS(block) LLVMPositionBuilderAtEnd(comp_ctx->builder, block)
 
-void *
-wasm_jit_memmove(void *dest, const void *src, size_t n)
+// 检查addr + end不超过当前内存大小, 越界时跳到got_exception_block,
+// 分支带有标记, 优化时按同一基址合并, 外提或删除被支配的检查
+static bool
+check_memory_access_end(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
+                        LLVMValueRef addr, uint64 end)
 {
-    return memmove(dest, src, n);
-}
-
-bool llvm_jit_memory_init(WASMModule *module, uint32 seg_index,
-                          uint32 offset, uint32 len, uint32 dst)
-{
-    uint8 *data = NULL;
-    uint8 *maddr;
-    uint64 seg_len = 0;
-
-    seg_len = module->data_segments[seg_index].data_length;
-    data = module->data_segments[seg_index].data;
-
-    if (!wasm_runtime_validate_app_addr(module,
-                                        dst, len))
-        return false;
+    LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
+    LLVMBasicBlockRef check_succ;
+    LLVMValueRef mem_size, max_addr, cmp;
+    unsigned md_kind;
 
-    if ((uint64)offset + (uint64)len > seg_len)
+    if (func_ctx->mem_space_unchanged)
     {
-        wasm_set_exception(module, "out of bounds memory access");
-        return false;
+        mem_size = func_ctx->mem_info.mem_data_size_addr;
+    }
+    else
+    {
+        LLVMOPLoad(mem_size, func_ctx->mem_info.mem_data_size_addr, I32_TYPE);
     }
+    LLVMOPZExt(mem_size, I64_TYPE);
 
-    maddr = wasm_runtime_addr_app_to_native(module, dst);
+    // 32位地址加32位偏移和访问长度不会超出64位
+    if (!(max_addr = LLVMBuildNUWAdd(comp_ctx->builder, addr, I64_CONST(end),
+                                     "max_addr")))
+    {
+        wasm_jit_set_last_error("llvm build add failed.");
+        goto fail;
+    }
+    BUILD_ICMP(LLVMIntUGT, max_addr, mem_size, cmp, "cmp_max_mem_addr");
 
-    memcpy(maddr, data + offset, len);
-    return true;
-}
+    ADD_BASIC_BLOCK(check_succ, "check_succ");
+    LLVMMoveBasicBlockAfter(check_succ, block_curr);
 
-bool llvm_jit_data_drop(WASMModule *module, uint32 seg_index)
-{
+    if (!wasm_jit_emit_exception(comp_ctx, func_ctx,
+                                 EXCE_OUT_OF_BOUNDS_MEMORY_ACCESS, true, cmp,
+                                 check_succ))
+        goto fail;
 
-    module->data_segments[seg_index].data_length = 0;
+    md_kind = LLVMGetMDKindIDInContext(comp_ctx->context, WASM_JIT_BOUND_CHECK_MD,
+                                       strlen(WASM_JIT_BOUND_CHECK_MD));
+    LLVMSetMetadata(LLVMGetBasicBlockTerminator(block_curr), md_kind,
+                    LLVMMDNodeInContext(comp_ctx->context, NULL, 0));
     return true;
+fail:
+    return false;
 }
 
 LLVMValueRef
 wasm_jit_check_memory_overflow(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
                                uint32 offset, uint32 bytes)
 {
-    LLVMValueRef offset_const = I32_CONST(offset);
+    LLVMValueRef offset_const = I64_CONST(offset);
     LLVMValueRef addr, maddr, offset1;
-    LLVMValueRef mem_base_addr;
-
-    if (func_ctx->mem_space_unchanged)
-    {
-        mem_base_addr = func_ctx->mem_info.mem_base_addr;
-    }
-    else
-    {
-        LLVMOPLoad(mem_base_addr,
-                   func_ctx->mem_info.mem_base_addr, OPQ_PTR_TYPE);
-    }
+    LLVMValueRef mem_base_addr = func_ctx->mem_info.mem_base_addr;
 
     POP_I32(addr);
 
+    // 地址与偏移零扩展后相加, 有效地址不会回绕, 总在线性内存的保留区内
+    LLVMOPZExt(addr, I64_TYPE);
+
+    if (comp_ctx->enable_bound_check
+        && !check_memory_access_end(comp_ctx, func_ctx, addr,
+                                    (uint64)offset + bytes))
+        goto fail;
+
     LLVMOPAdd(offset_const, addr, offset1, "offset1");
 
     if (!(maddr = LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE,
@@ -129,8 +135,8 @@ bool wasm_jit_compile_op_memory_size(JITCompContext *comp_ctx, JITFuncContext *f
 bool wasm_jit_compile_op_memory_grow(JITCompContext *comp_ctx, JITFuncContext *func_ctx)
 {
     LLVMValueRef mem_size = get_memory_curr_page_count(comp_ctx, func_ctx);
-    LLVMValueRef delta, param_values[2], ret_value, func, value;
-    LLVMTypeRef param_types[2], ret_type, func_type, func_ptr_type;
+    LLVMValueRef delta, param_values[2], ret_value, func;
+    LLVMTypeRef param_types[2], ret_type, func_type;
 
     if (!mem_size)
         return false;
@@ -147,14 +153,8 @@ bool wasm_jit_compile_op_memory_grow(JITCompContext *comp_ctx, JITFuncContext *f
         return false;
     }
 
-    if (!(func_ptr_type = LLVMPointerType(func_type, 0)))
-    {
-        wasm_jit_set_last_error("llvm add pointer type failed.");
-        return false;
-    }
-    if (!(value = I64_CONST((uint64)(uintptr_t)wasm_enlarge_memory)) || !(func = LLVMConstIntToPtr(value, func_ptr_type)))
+    if (!(func = wasm_jit_get_runtime_func(comp_ctx, "wasm_enlarge_memory", func_type)))
     {
-        wasm_jit_set_last_error("create LLVM value failed.");
         return false;
     }
 
@@ -187,22 +187,11 @@ check_bulk_memory_overflow(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
                            LLVMValueRef offset, LLVMValueRef bytes)
 {
     LLVMValueRef maddr, max_addr, cmp;
-    LLVMValueRef mem_base_addr;
+    LLVMValueRef mem_base_addr = func_ctx->mem_info.mem_base_addr;
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
     LLVMBasicBlockRef check_succ;
     LLVMValueRef mem_size;
 
-    if (func_ctx->mem_space_unchanged)
-    {
-        mem_base_addr = func_ctx->mem_info.mem_base_addr;
-    }
-    else
-    {
-        LLVMOPLoad(mem_base_addr,
-                   func_ctx->mem_info.mem_base_addr,
-                   OPQ_PTR_TYPE);
-    }
-
     if (func_ctx->mem_space_unchanged)
     {
         mem_size = func_ctx->mem_info.mem_data_size_addr;
@@ -245,8 +234,8 @@ fail:
 bool wasm_jit_compile_op_memory_init(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
                                      uint32 seg_index)
 {
-    LLVMValueRef seg, offset, dst, len, param_values[5], ret_value, func, value;
-    LLVMTypeRef param_types[5], ret_type, func_type, func_ptr_type;
+    LLVMValueRef seg, offset, dst, len, param_values[5], ret_value, func;
+    LLVMTypeRef param_types[5], ret_type, func_type;
     WASMType *wasm_jit_func_type = func_ctx->wasm_func->func_type;
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
     LLVMBasicBlockRef mem_init_fail, init_success;
@@ -309,8 +298,8 @@ fail:
 bool wasm_jit_compile_op_data_drop(JITCompContext *comp_ctx, JITFuncContext *func_ctx,
                                    uint32 seg_index)
 {
-    LLVMValueRef seg, param_values[2], ret_value, func, value;
-    LLVMTypeRef param_types[2], ret_type, func_type, func_ptr_type;
+    LLVMValueRef seg, param_values[2], ret_value, func;
+    LLVMTypeRef param_types[2], ret_type, func_type;
 
     seg = I32_CONST(seg_index);
     CHECK_LLVM_CONST(seg);
@@ -348,7 +337,7 @@ bool wasm_jit_compile_op_memory_copy(JITCompContext *comp_ctx, JITFuncContext *f
     if (!(dst_addr = check_bulk_memory_overflow(comp_ctx, func_ctx, dst, len)))
         return false;
 
-    LLVMTypeRef param_types[3], ret_type, func_type, func_ptr_type;
+    LLVMTypeRef param_types[3], ret_type, func_type;
     LLVMValueRef func, params[3];
 
     param_types[0] = INT8_TYPE_PTR;
@@ -362,15 +351,8 @@ bool wasm_jit_compile_op_memory_copy(JITCompContext *comp_ctx, JITFuncContext *f
         return false;
     }
 
-    if (!(func_ptr_type = LLVMPointerType(func_type, 0)))
-    {
-        wasm_jit_set_last_error("create LLVM function pointer type failed.");
-        return false;
-    }
-
-    if (!(func = I64_CONST((uint64)(uintptr_t)wasm_jit_memmove)) || !(func = LLVMConstIntToPtr(func, func_ptr_type)))
+    if (!(func = wasm_jit_get_runtime_func(comp_ctx, "wasm_jit_memmove", func_type)))
     {
-        wasm_jit_set_last_error("create LLVM value failed.");
         return false;
     }
 
@@ -387,16 +369,10 @@ bool wasm_jit_compile_op_memory_copy(JITCompContext *comp_ctx, JITFuncContext *f
     return true;
 }
 
-static void *
-jit_memset(void *s, int c, size_t n)
-{
-    return memset(s, c, n);
-}
-
 bool wasm_jit_compile_op_memory_fill(JITCompContext *comp_ctx, JITFuncContext *func_ctx)
 {
     LLVMValueRef val, dst, dst_addr, len, res;
-    LLVMTypeRef param_types[3], ret_type, func_type, func_ptr_type;
+    LLVMTypeRef param_types[3], ret_type, func_type;
     LLVMValueRef func, params[3];
 
     POP_I32(len);
@@ -417,15 +393,8 @@ bool wasm_jit_compile_op_memory_fill(JITCompContext *comp_ctx, JITFuncContext *f
         return false;
     }
 
-    if (!(func_ptr_type = LLVMPointerType(func_type, 0)))
-    {
-        wasm_jit_set_last_error("create LLVM function pointer type failed.");
-        return false;
-    }
-
-    if (!(func = I64_CONST((uint64)(uintptr_t)jit_memset)) || !(func = LLVMConstIntToPtr(func, func_ptr_type)))
+    if (!(func = wasm_jit_get_runtime_func(comp_ctx, "jit_memset", func_type)))
     {
-        wasm_jit_set_last_error("create LLVM value failed.");
         return false;
     }
 
@@ -1,5 +1,8 @@
 #include "wasm_jit.h"
 #include "wasm_jit_compiler.h"
+#include "wasm_jit_cache.h"
+#include "runtime_log.h"
+#include "wasm_runtime_validator_api.h"
 
 static bool
 init_func_type_indexes(WASMModule *module)
@@ -7,7 +10,6 @@ init_func_type_indexes(WASMModule *module)
     uint32 i;
     uint32 all_function_count = module->function_count;
     uint64 total_size = (uint64)sizeof(uint32) * all_function_count;
-    WASMType **wasm_types = module->types;
 
     if (!(module->func_type_indexes =
               wasm_runtime_malloc(total_size)))
@@ -15,12 +17,9 @@ init_func_type_indexes(WASMModule *module)
         return false;
     }
 
+    // 存放运行时范围的类型编号, call_indirect只需比较整数
     for (i = 0; i < all_function_count; i++)
-    {
-        WASMFunction *func_inst = module->functions + i;
-        WASMType *func_type = func_inst->func_type;
-        module->func_type_indexes[i] = wasm_get_cur_type_idx(wasm_types, func_type);
-    }
+        module->func_type_indexes[i] = module->functions[i].type_id;
 
     return true;
 }
@@ -49,17 +48,23 @@ bool init_llvm_jit_functions_stage1(WASMModule *module)
     }
     memset(module->func_ptrs_compiled, 0, size);
 
-    // 导入的函数是编译好的
-    for (i = 0; i < module->import_function_count; i++)
+    size = sizeof(void *) * (uint64)module->type_count;
+    if (size > 0 && !(module->func_entries = wasm_runtime_malloc(size)))
     {
-        module->func_ptrs[i] = module->functions[i].func_ptr;
-        module->func_ptrs_compiled[i] = true;
+        return false;
     }
 
-    module->comp_ctx = wasm_jit_create_comp_context(module);
-    if (!module->comp_ctx)
+    // 导入的函数是编译好的, 其入口在生成代码后填入
+    for (i = 0; i < module->import_function_count; i++)
+        module->func_ptrs_compiled[i] = true;
+
+    // 整个模块的LLVM IR一次生成, 需要所有函数验证时记录的块信息,
+    // 延迟验证的函数在实例化时一并验证, 分层执行的后台线程不能设置模块的异常
+    for (i = module->import_function_count; i < module->function_count; i++)
     {
-        return false;
+        if (module->functions[i].func_kind == Lazy_Func
+            && !wasm_validator_resolve_lazy(module, module->functions + i))
+            return false;
     }
 
     return true;
@@ -76,20 +81,44 @@ bool init_llvm_jit_functions_stage2(WASMModule *module)
     if (define_function_count == 0)
         return true;
 
+    // 命中缓存时不需要生成LLVM IR
+    if (wasm_jit_cache_load(module))
+        return true;
+
+    // 创建LLVM上下文的开销较大, 分层执行时在后台线程中完成
+    module->comp_ctx = wasm_jit_create_comp_context(module);
+    if (!module->comp_ctx)
+    {
+        return false;
+    }
+
     if (!wasm_jit_compile_wasm(module))
     {
         return false;
     }
 
+    // 代码已从目标文件加载, 释放LLVM上下文
+    if (module->jit_cache)
+    {
+        wasm_jit_destroy_comp_context(module->comp_ctx);
+        module->comp_ctx = NULL;
+        return true;
+    }
+
     // wasm_jit_emit_llvm_file(module->comp_ctx, "test.text");
 
-    for (i = 0; i < define_function_count; i++)
+    // 导入函数的位置填入生成的入口, 编译好的代码按wasm函数签名调用所有函数
+    for (i = 0; i < module->function_count; i++)
     {
         LLVMOrcJITTargetAddress func_addr = 0;
         LLVMErrorRef error;
         char func_name[48];
 
-        snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_FUNC_PREFIX, i);
+        if (i < import_function_count)
+            snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_IMPORT_PREFIX, i);
+        else
+            snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_FUNC_PREFIX,
+                     i - import_function_count);
         error = LLVMOrcLLLazyJITLookup(module->comp_ctx->orc_jit, &func_addr,
                                        func_name);
         if (error != LLVMErrorSuccess)
@@ -98,7 +127,25 @@ bool init_llvm_jit_functions_stage2(WASMModule *module)
             LLVMDisposeErrorMessage(err_msg);
             return false;
         }
-        module->func_ptrs[i + import_function_count] = (void *)func_addr;
+        module->func_ptrs[i] = (void *)func_addr;
+    }
+
+    for (i = 0; i < module->type_count; i++)
+    {
+        LLVMOrcJITTargetAddress entry_addr = 0;
+        LLVMErrorRef error;
+        char entry_name[48];
+
+        snprintf(entry_name, sizeof(entry_name), "%s%d", WASM_JIT_ENTRY_PREFIX, i);
+        error = LLVMOrcLLLazyJITLookup(module->comp_ctx->orc_jit, &entry_addr,
+                                       entry_name);
+        if (error != LLVMErrorSuccess)
+        {
+            char *err_msg = LLVMGetErrorMessage(error);
+            LLVMDisposeErrorMessage(err_msg);
+            return false;
+        }
+        module->func_entries[i] = (void *)entry_addr;
     }
 
     return true;
@@ -162,6 +209,10 @@ bool compile_jit_functions(WASMModule *module)
     uint32 define_function_count = module->function_count - module->import_function_count;
     uint32 i, j;
 
+    // 缓存的代码已全部编译
+    if (module->jit_cache)
+        return true;
+
     for (i = 0; i < thread_num && i < define_function_count; i++)
     {
         module->orcjit_thread_args[i].comp_ctx = module->comp_ctx;
@@ -170,9 +221,9 @@ bool compile_jit_functions(WASMModule *module)
 
         if (os_thread_create(&module->orcjit_threads[i], orcjit_thread_callback,
                              (void *)&module->orcjit_thread_args[i],
-                             APP_THREAD_STACK_SIZE_DEFAULT) != 0)
+                             WASM_JIT_THREAD_STACK_SIZE) != 0)
         {
-            module->orcjit_stop_compiling = true;
+            module->shared->orcjit_stop_compiling = true;
             for (j = 0; j < i; j++)
             {
                 os_thread_join(module->orcjit_threads[j], NULL);
@@ -196,4 +247,196 @@ bool compile_jit_functions(WASMModule *module)
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+#if WASM_ENABLE_TIERED_JIT != 0
+// 查找并调用包装函数, 迫使LLLazyJIT编译该函数
+static bool
+tier_up_compile_func(WASMModule *module, uint32 func_idx)
+{
+    LLVMOrcJITTargetAddress func_addr = 0;
+    LLVMErrorRef error;
+    char func_name[48];
+    typedef void (*F)(void);
+    union
+    {
+        F f;
+        void *v;
+    } u;
+
+    snprintf(func_name, sizeof(func_name), "%s%d%s", WASM_JIT_FUNC_PREFIX,
+             func_idx - module->import_function_count, "_wrapper");
+    error = LLVMOrcLLLazyJITLookup(module->comp_ctx->orc_jit, &func_addr, func_name);
+    if (error != LLVMErrorSuccess)
+    {
+        char *err_msg = LLVMGetErrorMessage(error);
+        LOG_WARNING("failed to compile llvm jit function %u: %s", func_idx, err_msg);
+        LLVMDisposeErrorMessage(err_msg);
+        return false;
+    }
+
+    u.v = (void *)func_addr;
+    u.f();
+    return true;
+}
+
+static void *
+tier_up_thread_callback(void *arg)
+{
+    OrcJitThreadArg *thread_arg = (OrcJitThreadArg *)arg;
+    WASMModule *module = thread_arg->module;
+    WASMModuleShared *shared = module->shared;
+    uint32 func_idx;
+    bool ret;
+
+    // 第一个线程负责生成整个模块的LLVM IR, 其余线程等待其完成
+    if (thread_arg->group_idx == 0)
+    {
+        ret = init_llvm_jit_functions_stage2(module);
+
+        os_mutex_lock(&shared->tier_lock);
+        if (ret)
+            shared->tier_ready = true;
+        else
+            shared->orcjit_stop_compiling = true;
+        os_cond_broadcast(&shared->tier_cond);
+        os_mutex_unlock(&shared->tier_lock);
+
+        if (!ret)
+            LOG_WARNING("failed to create llvm jit functions, keep interpreting");
+    }
+
+    while (true)
+    {
+        os_mutex_lock(&shared->tier_lock);
+        while (!shared->orcjit_stop_compiling
+               && (!shared->tier_ready || shared->tier_queue_num == 0))
+            os_cond_wait(&shared->tier_cond, &shared->tier_lock);
+
+        if (shared->orcjit_stop_compiling)
+        {
+            os_mutex_unlock(&shared->tier_lock);
+            break;
+        }
+
+        func_idx = shared->tier_queue[shared->tier_queue_head++];
+        shared->tier_queue_num--;
+        os_mutex_unlock(&shared->tier_lock);
+
+        // 从缓存加载的函数已经编译好
+        if (module->func_ptrs_compiled[func_idx])
+            continue;
+
+        // 编译失败的函数继续解释执行
+        if (!tier_up_compile_func(module, func_idx))
+            continue;
+
+        // 解释器看到该标志后才会经func_ptrs调用编译好的代码
+        os_atomic_thread_fence(os_memory_order_release);
+        module->func_ptrs_compiled[func_idx] = true;
+    }
+
+    return NULL;
+}
+
+bool wasm_jit_tier_up_start(WASMModule *module)
+{
+    WASMModuleShared *shared = module->shared;
+    uint32 thread_num = WASM_ORC_JIT_BACKEND_THREAD_NUM;
+    uint32 define_function_count = module->function_count - module->import_function_count;
+    uint32 i;
+
+    if (define_function_count == 0)
+        return true;
+
+    // 每个函数至多入队一次, 队列不会回绕
+    if (!(shared->tier_queue =
+              wasm_runtime_malloc(sizeof(uint32) * (uint64)define_function_count)))
+        return false;
+    shared->tier_queue_head = shared->tier_queue_num = 0;
+    shared->tier_ready = false;
+    shared->orcjit_stop_compiling = false;
+
+    if (os_mutex_init(&shared->tier_lock) != 0)
+        goto fail1;
+    if (os_cond_init(&shared->tier_cond) != 0)
+        goto fail2;
+
+    for (i = 0; i < thread_num && i < define_function_count; i++)
+    {
+        module->orcjit_thread_args[i].comp_ctx = NULL;
+        module->orcjit_thread_args[i].module = module;
+        module->orcjit_thread_args[i].group_idx = i;
+
+        if (os_thread_create(&module->orcjit_threads[i], tier_up_thread_callback,
+                             (void *)&module->orcjit_thread_args[i],
+                             WASM_JIT_THREAD_STACK_SIZE) != 0)
+        {
+            module->orcjit_threads[i] = 0;
+            // 生成IR的线程已经启动时, 少几个编译线程仍可工作
+            if (i > 0)
+                break;
+            goto fail3;
+        }
+    }
+
+    return true;
+
+fail3:
+    os_cond_destroy(&shared->tier_cond);
+fail2:
+    os_mutex_destroy(&shared->tier_lock);
+fail1:
+    wasm_runtime_free(shared->tier_queue);
+    shared->tier_queue = NULL;
+    return false;
+}
+
+void wasm_jit_tier_up_request(WASMModule *module, uint32 func_idx)
+{
+    // 实例共享已编译模块的编译线程和队列
+    WASMModuleShared *shared = module->shared;
+    WASMFunction *func = module->functions + func_idx;
+
+    if (!shared->tier_queue)
+        return;
+
+    os_mutex_lock(&shared->tier_lock);
+    if (!func->jit->tier_queued && !shared->orcjit_stop_compiling)
+    {
+        func->jit->tier_queued = true;
+        shared->tier_queue[shared->tier_queue_head + shared->tier_queue_num++] = func_idx;
+        os_cond_signal(&shared->tier_cond);
+    }
+    os_mutex_unlock(&shared->tier_lock);
+}
+
+void wasm_jit_tier_up_destroy(WASMModule *module)
+{
+    WASMModuleShared *shared = module->shared;
+    uint32 i;
+
+    if (!shared->tier_queue)
+        return;
+
+    os_mutex_lock(&shared->tier_lock);
+    shared->orcjit_stop_compiling = true;
+    os_cond_broadcast(&shared->tier_cond);
+    os_mutex_unlock(&shared->tier_lock);
+
+    // 正在编译的函数完成后线程才会退出
+    for (i = 0; i < WASM_ORC_JIT_BACKEND_THREAD_NUM; i++)
+    {
+        if (module->orcjit_threads[i])
+        {
+            os_thread_join(module->orcjit_threads[i], NULL);
+            module->orcjit_threads[i] = 0;
+        }
+    }
+
+    os_cond_destroy(&shared->tier_cond);
+    os_mutex_destroy(&shared->tier_lock);
+    wasm_runtime_free(shared->tier_queue);
+    shared->tier_queue = NULL;
+}
+#endif
@@ -1,6 +1,7 @@
 #include "wasm_jit_llvm.h"
 #include "wasm_jit_compiler.h"
 #include "wasm_jit_emit_exception.h"
+#include "wasm_jit_emit_memory.h"
 #include "runtime_log.h"
 
 LLVMTypeRef
@@ -57,6 +58,10 @@ wasm_jit_add_llvm_func(JITCompContext *comp_ctx, LLVMModuleRef module,
 
     backend_thread_num = WASM_ORC_JIT_BACKEND_THREAD_NUM;
     compile_thread_num = WASM_ORC_JIT_COMPILE_THREAD_NUM;
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 分层执行时热点函数逐个编译, 每个函数都有自己的包装函数
+    compile_thread_num = 1;
+#endif
 
     if ((func_index % (backend_thread_num * compile_thread_num) < backend_thread_num))
     {
@@ -111,12 +116,14 @@ wasm_jit_create_func_block(JITCompContext *comp_ctx, JITFuncContext *func_ctx, W
     block->is_translate_else = false;
     block->param_phis = NULL;
     block->result_phis = NULL;
-    block->llvm_end_block = NULL;
     block->llvm_else_block = NULL;
     block->is_polymorphic = false;
 
+    // 跳转到函数层的br与函数末尾都进入func_end, 在其中返回
     if (!(block->llvm_entry_block = LLVMAppendBasicBlockInContext(
-              comp_ctx->context, func_ctx->func, "func_begin")))
+              comp_ctx->context, func_ctx->func, "func_begin"))
+        || !(block->llvm_end_block = LLVMAppendBasicBlockInContext(
+                 comp_ctx->context, func_ctx->func, "func_end")))
     {
         wasm_jit_set_last_error("add LLVM basic block failed.");
         return false;
@@ -292,11 +299,12 @@ create_memory_info(WASMModule *module, JITCompContext *comp_ctx, JITFuncContext
     func_ctx->mem_info.mem_data_size_addr = LLVMBuildBitCast(
         comp_ctx->builder, func_ctx->mem_info.mem_data_size_addr,
         I32_TYPE_PTR, "mem_data_size_ptr");
+    // 线性内存按最大页数预留地址空间, 扩容不移动基址, 基址总在入口处读取一次
+    func_ctx->mem_info.mem_base_addr = LLVMBuildLoad2(
+        comp_ctx->builder, OPQ_PTR_TYPE,
+        func_ctx->mem_info.mem_base_addr, "mem_base_addr");
     if (mem_space_unchanged)
     {
-        func_ctx->mem_info.mem_base_addr = LLVMBuildLoad2(
-            comp_ctx->builder, OPQ_PTR_TYPE,
-            func_ctx->mem_info.mem_base_addr, "mem_base_addr");
         func_ctx->mem_info.mem_cur_page_count_addr =
             LLVMBuildLoad2(comp_ctx->builder, I32_TYPE,
                            func_ctx->mem_info.mem_cur_page_count_addr,
@@ -440,7 +448,7 @@ wasm_jit_create_func_context(WASMModule *wasm_module, JITCompContext *comp_ctx,
         goto fail;
     }
 
-    if (wasm_func->has_op_memory)
+    if (wasm_func->jit->has_op_memory)
     {
         create_memory_info(wasm_module, comp_ctx, func_ctx);
     }
@@ -449,7 +457,7 @@ wasm_jit_create_func_context(WASMModule *wasm_module, JITCompContext *comp_ctx,
     create_table_info(comp_ctx, func_ctx);
     create_cur_exception(comp_ctx, func_ctx);
 
-    if (wasm_func->has_op_call_indirect)
+    if (wasm_func->jit->has_op_call_indirect)
     {
         create_func_type_indexes(comp_ctx, func_ctx);
     }
@@ -511,6 +519,40 @@ wasm_jit_create_func_contexts(WASMModule *wasm_module, JITCompContext *comp_ctx)
     return func_ctxes;
 }
 
+// 导入函数的入口在编译模块时生成, 这里只声明, 供调用处引用
+static bool
+create_import_funcs(WASMModule *wasm_module, JITCompContext *comp_ctx)
+{
+    uint32 import_function_count = wasm_module->import_function_count;
+    char func_name[48];
+    uint32 i;
+
+    comp_ctx->import_func_count = import_function_count;
+    if (import_function_count == 0)
+        return true;
+
+    if (!(comp_ctx->import_funcs =
+              wasm_runtime_malloc(sizeof(LLVMValueRef) * (uint64)import_function_count)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        return false;
+    }
+
+    for (i = 0; i < import_function_count; i++)
+    {
+        snprintf(func_name, sizeof(func_name), "%s%d", WASM_JIT_IMPORT_PREFIX, i);
+        if (!(comp_ctx->import_funcs[i] = LLVMAddFunction(
+                  comp_ctx->module, func_name,
+                  comp_ctx->jit_func_types[wasm_module->functions[i].type_index]
+                      .llvm_func_type)))
+        {
+            wasm_jit_set_last_error("add LLVM function failed.");
+            return false;
+        }
+    }
+    return true;
+}
+
 static bool
 set_llvm_basic_types(JITLLVMTypes *basic_types, LLVMContextRef context)
 {
@@ -765,6 +807,62 @@ fail:
     return ret;
 }
 
+LLVMValueRef
+wasm_jit_get_runtime_func(JITCompContext *comp_ctx, const char *name,
+                          LLVMTypeRef func_type)
+{
+    LLVMValueRef func;
+
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, name)))
+    {
+        if (!(func = LLVMAddFunction(comp_ctx->module, name, func_type)))
+        {
+            wasm_jit_set_last_error("add LLVM runtime function failed.");
+            return NULL;
+        }
+        LLVMSetLinkage(func, LLVMExternalLinkage);
+    }
+    return func;
+}
+
+bool wasm_jit_define_runtime_symbols(LLVMOrcExecutionSessionRef session,
+                                     LLVMOrcJITDylibRef dylib)
+{
+    const WASMRuntimeSymbol *runtime_symbols;
+    uint32 i, count;
+    LLVMOrcCSymbolMapPairs pairs;
+    LLVMOrcMaterializationUnitRef mu;
+    LLVMErrorRef err;
+
+    runtime_symbols = wasm_runtime_helper_symbols(&count);
+    if (!(pairs = wasm_runtime_malloc(sizeof(*pairs) * (uint64)count)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        return false;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        pairs[i].Name = LLVMOrcExecutionSessionIntern(session, runtime_symbols[i].name);
+        pairs[i].Sym.Address = (LLVMOrcExecutorAddress)(uintptr_t)runtime_symbols[i].addr;
+        pairs[i].Sym.Flags.GenericFlags =
+            LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable;
+        pairs[i].Sym.Flags.TargetFlags = 0;
+    }
+
+    // 符号名的引用由materialization unit接管
+    mu = LLVMOrcAbsoluteSymbols(pairs, count);
+    wasm_runtime_free(pairs);
+
+    if ((err = LLVMOrcJITDylibDefine(dylib, mu)))
+    {
+        LLVMOrcDisposeMaterializationUnit(mu);
+        wasm_jit_handle_llvm_errmsg("failed to define runtime symbols", err);
+        return false;
+    }
+    return true;
+}
+
 static bool
 orc_jit_create(JITCompContext *comp_ctx)
 {
@@ -802,6 +900,11 @@ orc_jit_create(JITCompContext *comp_ctx)
     }
     builder = NULL;
 
+    if (!wasm_jit_define_runtime_symbols(
+            LLVMOrcLLLazyJITGetExecutionSession(orc_jit),
+            LLVMOrcLLLazyJITGetMainJITDylib(orc_jit)))
+        goto fail;
+
     comp_ctx->orc_jit = orc_jit;
     orc_jit = NULL;
     ret = true;
@@ -815,6 +918,71 @@ fail:
     return ret;
 }
 
+uint8 *
+wasm_jit_emit_elf_file(JITCompContext *comp_ctx, uint32 *p_elf_file_size)
+{
+    LLVMTargetMachineRef target_machine;
+    LLVMTargetDataRef data_layout;
+    LLVMMemoryBufferRef object_buf = NULL;
+    char *triple, *cpu, *features, *err_msg = NULL;
+    uint8 *elf_file = NULL;
+    uint64 size;
+
+    triple = LLVMGetTargetMachineTriple(comp_ctx->target_machine);
+    cpu = LLVMGetTargetMachineCPU(comp_ctx->target_machine);
+    features = LLVMGetTargetMachineFeatureString(comp_ctx->target_machine);
+
+    // 位置无关的代码经GOT和PLT引用外部符号, 目标文件可以加载到任意地址
+    target_machine = LLVMCreateTargetMachine(
+        LLVMGetTargetMachineTarget(comp_ctx->target_machine), triple, cpu, features,
+        LLVMCodeGenLevelDefault, LLVMRelocPIC, LLVMCodeModelSmall);
+    if (!target_machine)
+    {
+        wasm_jit_set_last_error("failed to create target machine.");
+        goto fail;
+    }
+
+    // 目标文件由链接器重定位, 模块需带有目标平台的信息
+    LLVMSetTarget(comp_ctx->module, triple);
+    data_layout = LLVMCreateTargetDataLayout(target_machine);
+    LLVMSetModuleDataLayout(comp_ctx->module, data_layout);
+    LLVMDisposeTargetData(data_layout);
+
+    if (LLVMTargetMachineEmitToMemoryBuffer(target_machine, comp_ctx->module,
+                                            LLVMObjectFile, &err_msg, &object_buf))
+    {
+        wasm_jit_set_last_error_v("emit object file failed: %s.", err_msg ? err_msg : "");
+        if (err_msg)
+            LLVMDisposeMessage(err_msg);
+        goto fail;
+    }
+
+    size = LLVMGetBufferSize(object_buf);
+    if (size > UINT32_MAX || !(elf_file = wasm_runtime_malloc(size)))
+    {
+        wasm_jit_set_last_error("allocate memory failed.");
+        goto fail;
+    }
+    memcpy(elf_file, LLVMGetBufferStart(object_buf), size);
+    *p_elf_file_size = (uint32)size;
+
+fail:
+    if (object_buf)
+        LLVMDisposeMemoryBuffer(object_buf);
+    if (target_machine)
+        LLVMDisposeTargetMachine(target_machine);
+    LLVMDisposeMessage(features);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(triple);
+    return elf_file;
+}
+
+void wasm_jit_destroy_elf_file(uint8 *elf_file)
+{
+    if (elf_file)
+        wasm_runtime_free(elf_file);
+}
+
 JITCompContext *
 wasm_jit_create_comp_context(WASMModule *wasm_module)
 {
@@ -865,6 +1033,9 @@ wasm_jit_create_comp_context(WASMModule *wasm_module)
 
     comp_ctx->opt_level = 3;
     comp_ctx->size_level = 3;
+#ifndef OS_ENABLE_HW_BOUND_CHECK
+    comp_ctx->enable_bound_check = true;
+#endif
 
     if (!create_target_machine_detect_host(comp_ctx))
         goto fail;
@@ -910,6 +1081,9 @@ wasm_jit_create_comp_context(WASMModule *wasm_module)
 
     comp_ctx->wasm_module_type = INT8_TYPE_PTR;
 
+    if (!create_import_funcs(wasm_module, comp_ctx))
+        goto fail;
+
     comp_ctx->func_ctx_count = wasm_module->function_count - wasm_module->import_function_count;
     if (comp_ctx->func_ctx_count > 0 && !(comp_ctx->jit_func_ctxes =
                                               wasm_jit_create_func_contexts(wasm_module, comp_ctx)))
@@ -947,6 +1121,9 @@ void wasm_jit_destroy_comp_context(JITCompContext *comp_ctx)
         wasm_jit_destroy_func_contexts(comp_ctx->jit_func_ctxes,
                                        comp_ctx->func_ctx_count);
 
+    if (comp_ctx->import_funcs)
+        wasm_runtime_free(comp_ctx->import_funcs);
+
     if (comp_ctx->target_cpu)
     {
         wasm_runtime_free(comp_ctx->target_cpu);
@@ -35,6 +35,13 @@
 #include <llvm/Transforms/Scalar/LICM.h>
 #include <llvm/Transforms/Scalar/GVN.h>
 #include <llvm/Passes/PassBuilder.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #if LLVM_VERSION_MAJOR >= 12
 #include <llvm/Analysis/AliasAnalysis.h>
@@ -45,6 +52,7 @@
 
 using namespace llvm;
 using namespace llvm::orc;
+using namespace llvm::PatternMatch;
 
 LLVM_C_EXTERN_C_BEGIN
 
@@ -52,6 +60,326 @@ void wasm_jit_add_expand_memory_op_pass(LLVMPassManagerRef pass);
 
 void wasm_jit_add_simple_loop_unswitch_pass(LLVMPassManagerRef pass);
 
+void wasm_jit_set_musttail(LLVMValueRef call);
+
+// 显式越界检查的形式为 br (icmp ugt (add nuw (zext base), end), (zext size)),
+// 越界时跳到got_exception_block. 所有越界检查抛出相同的异常,
+// 之间没有副作用时先报告哪一个不可区分, 内存大小只增不减,
+// 先读到的大小不超过后读到的, 据此:
+// 1. 同一基址的检查在无副作用的直线代码中合并到第一个检查, 取最大的范围
+// 2. 删除被同一基址, 范围不小的检查支配的检查
+// 3. 循环中基址不变, 且每轮开始后没有副作用就会到达的检查外提到循环前
+class BoundCheckOptPass : public PassInfoMixin<BoundCheckOptPass>
+{
+public:
+    PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+
+private:
+    struct BoundCheck
+    {
+        BranchInst *Br;
+        // 零扩展前后的访问地址
+        Value *Base;
+        Value *Addr;
+        uint64_t End;
+        // 零扩展前后的内存大小
+        Value *Size;
+        Value *SizeExt;
+        bool Removed;
+    };
+
+    // 沿无副作用的直线代码前进的最大基本块数
+    static const unsigned MaxWalkBlocks = 64;
+
+    SmallVector<BoundCheck, 32> Checks;
+    DenseMap<BranchInst *, unsigned> CheckIndexes;
+    // 删除检查后不再使用的比较, 最后统一删除
+    SmallVector<WeakTrackingVH, 32> DeadConds;
+    unsigned MDKind;
+
+    bool matchBoundCheck(BranchInst *Br, BoundCheck &Check);
+    static bool isSameMemorySize(Value *Size1, Value *Size2);
+    BoundCheck *nextCheck(BasicBlock *&BB, SmallPtrSetImpl<BasicBlock *> &Visited,
+                          const Loop *L);
+    void removeCheck(BoundCheck &Check);
+    bool mergeChecks();
+    bool removeDominatedChecks(DominatorTree &DT);
+    bool hoistLoopInvariantChecks(LoopInfo &LI);
+};
+
+bool BoundCheckOptPass::matchBoundCheck(BranchInst *Br, BoundCheck &Check)
+{
+    ICmpInst::Predicate Pred;
+    Value *Lhs, *Rhs;
+    ConstantInt *End;
+
+    if (!Br->isConditional() || !Br->getMetadata(MDKind)
+        || !match(Br->getCondition(), m_ICmp(Pred, m_Value(Lhs), m_Value(Rhs))))
+        return false;
+
+    if (Pred == ICmpInst::ICMP_ULT)
+    {
+        std::swap(Lhs, Rhs);
+        Pred = ICmpInst::ICMP_UGT;
+    }
+
+    if (Pred != ICmpInst::ICMP_UGT
+        || !match(Lhs, m_NUWAdd(m_Value(Check.Addr), m_ConstantInt(End)))
+        || !match(Check.Addr, m_ZExt(m_Value(Check.Base)))
+        || !match(Rhs, m_ZExt(m_Value(Check.Size))))
+        return false;
+
+    Check.Br = Br;
+    Check.End = End->getZExtValue();
+    Check.SizeExt = Rhs;
+    Check.Removed = false;
+    return true;
+}
+
+bool BoundCheckOptPass::isSameMemorySize(Value *Size1, Value *Size2)
+{
+    LoadInst *Load1 = dyn_cast<LoadInst>(Size1);
+    LoadInst *Load2 = dyn_cast<LoadInst>(Size2);
+
+    if (Size1 == Size2)
+        return true;
+
+    return Load1 && Load2
+           && Load1->getPointerOperand()->stripPointerCasts()
+                  == Load2->getPointerOperand()->stripPointerCasts();
+}
+
+// 从BB开始沿无副作用的直线代码找到下一个越界检查, BB更新为检查通过后的块
+BoundCheckOptPass::BoundCheck *
+BoundCheckOptPass::nextCheck(BasicBlock *&BB, SmallPtrSetImpl<BasicBlock *> &Visited,
+                             const Loop *L)
+{
+    while (BB && Visited.size() < MaxWalkBlocks && Visited.insert(BB).second
+           && (!L || L->contains(BB)))
+    {
+        BranchInst *Br;
+
+        for (Instruction &I : *BB)
+        {
+            if (I.mayHaveSideEffects())
+                return nullptr;
+        }
+
+        if (!(Br = dyn_cast<BranchInst>(BB->getTerminator())))
+            return nullptr;
+
+        if (Br->isUnconditional())
+        {
+            BB = Br->getSuccessor(0);
+            if (!BB->getSinglePredecessor())
+                return nullptr;
+            continue;
+        }
+
+        auto It = CheckIndexes.find(Br);
+        if (It == CheckIndexes.end())
+            return nullptr;
+
+        BB = Br->getSuccessor(1);
+        if (!BB->getSinglePredecessor())
+            BB = nullptr;
+        if (!Checks[It->second].Removed)
+            return &Checks[It->second];
+    }
+    return nullptr;
+}
+
+void BoundCheckOptPass::removeCheck(BoundCheck &Check)
+{
+    BranchInst *Br = Check.Br;
+
+    Br->getSuccessor(0)->removePredecessor(Br->getParent());
+    BranchInst::Create(Br->getSuccessor(1), Br);
+    if (Instruction *Cond = dyn_cast<Instruction>(Br->getCondition()))
+        DeadConds.push_back(Cond);
+    CheckIndexes.erase(Br);
+    Br->eraseFromParent();
+    Check.Br = nullptr;
+    Check.Removed = true;
+}
+
+bool BoundCheckOptPass::mergeChecks()
+{
+    bool Changed = false;
+
+    for (BoundCheck &Check : Checks)
+    {
+        SmallPtrSet<BasicBlock *, 16> Visited;
+        BasicBlock *BB = Check.Br->getSuccessor(1);
+        uint64_t End = Check.End;
+        BoundCheck *Next;
+
+        if (!BB->getSinglePredecessor())
+            continue;
+
+        while ((Next = nextCheck(BB, Visited, nullptr)))
+        {
+            if (Next->Base == Check.Base && Next->End > End
+                && isSameMemorySize(Check.Size, Next->Size))
+                End = Next->End;
+        }
+
+        if (End == Check.End)
+            continue;
+
+        IRBuilder<> Builder(Check.Br);
+        Value *MaxAddr = Builder.CreateNUWAdd(
+            Check.Addr, ConstantInt::get(Check.Addr->getType(), End), "max_addr");
+        Value *Cond = Builder.CreateICmpUGT(MaxAddr, Check.SizeExt,
+                                            "cmp_max_mem_addr");
+
+        if (Instruction *OldCond = dyn_cast<Instruction>(Check.Br->getCondition()))
+            DeadConds.push_back(OldCond);
+        Check.Br->setCondition(Cond);
+        Check.End = End;
+        Changed = true;
+    }
+    return Changed;
+}
+
+bool BoundCheckOptPass::removeDominatedChecks(DominatorTree &DT)
+{
+    DenseMap<Value *, SmallVector<unsigned, 4>> ChecksByBase;
+    bool Changed = false;
+
+    for (unsigned I = 0; I < Checks.size(); I++)
+        ChecksByBase[Checks[I].Base].push_back(I);
+
+    for (auto &Entry : ChecksByBase)
+    {
+        for (unsigned I : Entry.second)
+        {
+            BoundCheck &Check = Checks[I];
+
+            for (unsigned J : Entry.second)
+            {
+                BoundCheck &Dom = Checks[J];
+
+                if (I == J || Dom.Removed || Dom.End < Check.End
+                    || !isSameMemorySize(Dom.Size, Check.Size)
+                    || !DT.dominates(BasicBlockEdge(Dom.Br->getParent(),
+                                                    Dom.Br->getSuccessor(1)),
+                                     Check.Br->getParent()))
+                    continue;
+
+                removeCheck(Check);
+                Changed = true;
+                break;
+            }
+        }
+    }
+    return Changed;
+}
+
+bool BoundCheckOptPass::hoistLoopInvariantChecks(LoopInfo &LI)
+{
+    SmallVector<std::pair<Loop *, unsigned>, 16> Hoists;
+    DenseMap<Loop *, BasicBlock *> Preheaders;
+    SmallPtrSet<BranchInst *, 16> Hoisted;
+
+    // 先在原来的控制流上选出所有可外提的检查, 外层循环优先
+    for (Loop *L : LI.getLoopsInPreorder())
+    {
+        SmallPtrSet<BasicBlock *, 16> Visited;
+        BasicBlock *BB = L->getHeader();
+        BoundCheck *Check;
+
+        if (!L->getLoopPreheader())
+            continue;
+
+        while ((Check = nextCheck(BB, Visited, L)))
+        {
+            LoadInst *SizeLoad = dyn_cast<LoadInst>(Check->Size);
+
+            if (Hoisted.count(Check->Br) || !L->isLoopInvariant(Check->Base)
+                || !(L->isLoopInvariant(Check->Size)
+                     || (SizeLoad && L->isLoopInvariant(SizeLoad->getPointerOperand()))))
+                continue;
+
+            Hoisted.insert(Check->Br);
+            Hoists.push_back({ L, (unsigned)(Check - Checks.begin()) });
+        }
+        Preheaders[L] = L->getLoopPreheader();
+    }
+
+    for (auto &Hoist : Hoists)
+    {
+        BoundCheck &Check = Checks[Hoist.second];
+        BasicBlock *Preheader = Preheaders[Hoist.first];
+        BasicBlock *ExceptionBB = Check.Br->getSuccessor(0);
+        Instruction *Term = Preheader->getTerminator();
+        IRBuilder<> Builder(Term);
+        Value *Size = Check.Size;
+
+        // 第一轮到达检查前内存大小不会改变, 在循环前重新读取
+        if (!Hoist.first->isLoopInvariant(Size))
+        {
+            Instruction *SizeLoad = cast<LoadInst>(Size)->clone();
+            Builder.Insert(SizeLoad, "mem_data_size");
+            Size = SizeLoad;
+        }
+
+        Value *Addr = Builder.CreateZExt(Check.Base, Check.Addr->getType());
+        Value *MaxAddr = Builder.CreateNUWAdd(
+            Addr, ConstantInt::get(Addr->getType(), Check.End), "max_addr");
+        Value *Cond = Builder.CreateICmpUGT(
+            MaxAddr, Builder.CreateZExt(Size, Check.SizeExt->getType()),
+            "cmp_max_mem_addr");
+
+        BasicBlock *Next = SplitBlock(Preheader, Term);
+        BranchInst *Br = BranchInst::Create(ExceptionBB, Next, Cond);
+        ReplaceInstWithInst(Preheader->getTerminator(), Br);
+        Br->setMetadata(MDKind, Check.Br->getMetadata(MDKind));
+
+        for (PHINode &Phi : ExceptionBB->phis())
+            Phi.addIncoming(Phi.getIncomingValueForBlock(Check.Br->getParent()),
+                            Preheader);
+
+        removeCheck(Check);
+        Preheaders[Hoist.first] = Next;
+    }
+    return !Hoists.empty();
+}
+
+PreservedAnalyses BoundCheckOptPass::run(Function &F, FunctionAnalysisManager &FAM)
+{
+    bool Changed = false;
+
+    MDKind = F.getContext().getMDKindID(WASM_JIT_BOUND_CHECK_MD);
+    Checks.clear();
+    CheckIndexes.clear();
+    DeadConds.clear();
+
+    for (BasicBlock &BB : F)
+    {
+        BranchInst *Br = dyn_cast<BranchInst>(BB.getTerminator());
+        BoundCheck Check;
+
+        if (Br && matchBoundCheck(Br, Check))
+        {
+            CheckIndexes[Br] = Checks.size();
+            Checks.push_back(Check);
+        }
+    }
+
+    if (Checks.empty())
+        return PreservedAnalyses::all();
+
+    Changed |= mergeChecks();
+    // 只删除到异常块的边, 其余块的支配关系和循环结构不变
+    Changed |= removeDominatedChecks(FAM.getResult<DominatorTreeAnalysis>(F));
+    Changed |= hoistLoopInvariantChecks(FAM.getResult<LoopAnalysis>(F));
+
+    RecursivelyDeleteTriviallyDeadInstructionsPermissive(DeadConds);
+
+    return Changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+
 void wasm_jit_apply_llvm_new_pass_manager(JITCompContext *comp_ctx, LLVMModuleRef module);
 
 LLVM_C_EXTERN_C_END
@@ -170,6 +498,12 @@ void wasm_jit_add_simple_loop_unswitch_pass(LLVMPassManagerRef pass)
         createSimpleLoopUnswitchLegacyPass());
 }
 
+// LLVM 18之前的C接口只能设置tail标记
+void wasm_jit_set_musttail(LLVMValueRef call)
+{
+    unwrap<CallInst>(call)->setTailCallKind(CallInst::TCK_MustTail);
+}
+
 void wasm_jit_apply_llvm_new_pass_manager(JITCompContext *comp_ctx, LLVMModuleRef module)
 {
     TargetMachine *TM =
@@ -225,8 +559,13 @@ void wasm_jit_apply_llvm_new_pass_manager(JITCompContext *comp_ctx, LLVMModuleRe
 
     ModulePassManager MPM;
 
-    const char *Passes =
-        "mem2reg,instcombine,simplifycfg,jump-threading,loop-vectorize,indvars";
-    ExitOnErr(PB.parsePassPipeline(MPM, Passes));
+    ExitOnErr(PB.parsePassPipeline(MPM, "mem2reg,instcombine,simplifycfg"));
+    if (comp_ctx->enable_bound_check)
+    {
+        // 检查外提需要循环有唯一的前置块
+        ExitOnErr(PB.parsePassPipeline(MPM, "loop-simplify"));
+        MPM.addPass(createModuleToFunctionPassAdaptor(BoundCheckOptPass()));
+    }
+    ExitOnErr(PB.parsePassPipeline(MPM, "jump-threading,loop-vectorize,indvars"));
     MPM.run(*M, MAM);
 }
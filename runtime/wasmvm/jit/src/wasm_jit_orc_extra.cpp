@@ -152,14 +152,19 @@ PartitionFunction(GlobalValueSet Requested)
             {
                 char buf[16] = {0};
                 char func_name[64];
-                int group_stride, i, j;
+                int group_stride, group_size, i, j;
                 memcpy(buf, gvname + prefix_len,
                        (uint32)(wrapper - (gvname + prefix_len)));
                 i = atoi(buf);
 
                 group_stride = WASM_ORC_JIT_BACKEND_THREAD_NUM;
+                group_size = WASM_ORC_JIT_COMPILE_THREAD_NUM;
+#if WASM_ENABLE_TIERED_JIT != 0
+                // 分层执行时只编译请求的热点函数
+                group_size = 1;
+#endif
 
-                for (j = 0; j < WASM_ORC_JIT_COMPILE_THREAD_NUM; j++)
+                for (j = 0; j < group_size; j++)
                 {
                     snprintf(func_name, sizeof(func_name), "%s%d",
                              WASM_JIT_FUNC_PREFIX, i + j * group_stride);
@@ -36,6 +36,10 @@ bool load_element_section(const uint8 *buf, const uint8 *buf_end, WASMModule *mo
 // 加载code段
 bool load_code_section(const uint8 *buf, const uint8 *buf_end, WASMModule *module);
 
+// 加载code段中的一个函数体, 成功后*p_buf指向下一个函数体
+bool load_function_body(const uint8 **p_buf, const uint8 *buf_end, WASMModule *module,
+                        WASMFunction *func);
+
 // 加载data段
 bool load_data_section(const uint8 *buf, const uint8 *buf_end, WASMModule *module);
 
@@ -43,4 +47,7 @@ bool load_data_section(const uint8 *buf, const uint8 *buf_end, WASMModule *modul
 bool load_datacount_section(const uint8 *buf, const uint8 *buf_end,
                             WASMModule *module);
 
+// 按段的编号加载一个段, 未知的段直接跳过
+bool load_section(uint8 id, const uint8 *buf, const uint8 *buf_end, WASMModule *module);
+
 #endif
\ No newline at end of file
@@ -7,4 +7,27 @@
 bool
 wasm_loader(WASMModule *module, uint8 *buf, uint32 size);
 
+//从只读映射的文件加载, buf不会被改写, 需在模块销毁后才能解除映射
+bool
+wasm_loader_read_only(WASMModule *module, const uint8 *buf, uint32 size);
+
+//流式加载器, 边接收字节边加载和验证, 模块中的指针指向加载器内部的缓冲区
+typedef struct WASMStreamLoader WASMStreamLoader;
+
+//创建流式加载器, 失败时返回NULL并设置模块的异常信息
+WASMStreamLoader *
+wasm_stream_loader_create(WASMModule *module);
+
+//追加收到的字节, 已完整的段和函数体随即加载, 函数体同时交给验证线程
+bool
+wasm_stream_loader_feed(WASMStreamLoader *loader, const uint8 *data, uint32 size);
+
+//所有字节已送达, 成功返回时模块已加载并验证完毕, 无需再调用wasm_validator
+bool
+wasm_stream_loader_finish(WASMStreamLoader *loader);
+
+//释放缓冲区, 需在销毁模块之后调用
+void
+wasm_stream_loader_destroy(WASMStreamLoader *loader);
+
 #endif
\ No newline at end of file
@@ -27,6 +27,7 @@ bool load_function_section(const uint8 *buf, const uint8 *buf_end, WASMModule *m
             /* 设置函数的类型 */
             func->type_index = type_index;
             func->func_type = type;
+            func->type_id = type->type_id;
             func->param_types = type->param;
             func->result_types = type->result;
             func->param_cell_num = type->param_cell_num;
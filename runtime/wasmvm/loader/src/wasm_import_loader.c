@@ -74,6 +74,7 @@ load_function_import(WASMModule *module, const uint8 **p_buf, const uint8 *buf_e
     function->module_name = sub_module_name;
     function->field_name = function_name;
     function->func_type = type;
+    function->type_id = type->type_id;
     function->param_types = type->param;
     function->result_types = type->result;
     function->param_cell_num = type->param_cell_num;
@@ -1,6 +1,110 @@
 #include "wasm_loader.h"
 #include "wasm_runtime_loader_api.h"
 
+bool load_section(uint8 id, const uint8 *buf, const uint8 *buf_end, WASMModule *module)
+{
+    const uint8 *section_data_start = buf, *section_data_end = buf_end;
+
+    switch (id)
+    {
+    case SECTION_TYPE_TYPE:
+        if (!load_type_section(section_data_start, section_data_end,
+                               module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_IMPORT:
+        if (!load_import_section(section_data_start, section_data_end,
+                                 module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_FUNCTION:
+        if (!load_function_section(section_data_start, section_data_end,
+                                   module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_TABLE:
+        if (!load_table_section(section_data_start, section_data_end,
+                                module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_MEMORY:
+        if (!load_memory_section(section_data_start, section_data_end,
+                                 module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_GLOBAL:
+        if (!load_global_section(section_data_start, section_data_end,
+                                 module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_EXPORT:
+        if (!load_export_section(section_data_start, section_data_end,
+                                 module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_START:
+        if (!load_start_section(section_data_start, section_data_end,
+                                module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_ELEMENT:
+        if (!load_element_section(section_data_start, section_data_end,
+                                  module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_CODE:
+        if (!load_code_section(section_data_start, section_data_end,
+                               module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_DATA:
+        if (!load_data_section(section_data_start, section_data_end,
+                               module))
+        {
+            return false;
+        }
+        break;
+
+    case SECTION_TYPE_DATACOUNT:
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
 bool wasm_loader(WASMModule *module, uint8 *buf, uint32 size)
 {
     uint32 magic_number, version, payload_len = 0;
@@ -8,6 +112,8 @@ bool wasm_loader(WASMModule *module, uint8 *buf, uint32 size)
     const uint8 *section_data_start, *section_data_end;
     uint8 id;
 
+    module->module_hash = bh_hash_bytes(BH_HASH_INIT, buf, size);
+
     magic_number = read_uint32(p);
 
     if (magic_number != WASM_MAGIC_NUMBER)
@@ -39,101 +145,9 @@ bool wasm_loader(WASMModule *module, uint8 *buf, uint32 size)
         section_data_end = p + payload_len;
         p = section_data_end;
 
-        switch (id)
+        if (!load_section(id, section_data_start, section_data_end, module))
         {
-        case SECTION_TYPE_TYPE:
-            if (!load_type_section(section_data_start, section_data_end,
-                                   module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_IMPORT:
-            if (!load_import_section(section_data_start, section_data_end,
-                                     module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_FUNCTION:
-            if (!load_function_section(section_data_start, section_data_end,
-                                       module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_TABLE:
-            if (!load_table_section(section_data_start, section_data_end,
-                                    module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_MEMORY:
-            if (!load_memory_section(section_data_start, section_data_end,
-                                     module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_GLOBAL:
-            if (!load_global_section(section_data_start, section_data_end,
-                                     module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_EXPORT:
-            if (!load_export_section(section_data_start, section_data_end,
-                                     module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_START:
-            if (!load_start_section(section_data_start, section_data_end,
-                                    module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_ELEMENT:
-            if (!load_element_section(section_data_start, section_data_end,
-                                      module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_CODE:
-            if (!load_code_section(section_data_start, section_data_end,
-                                   module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_DATA:
-            if (!load_data_section(section_data_start, section_data_end,
-                                   module))
-            {
-                goto fail;
-            }
-            break;
-
-        case SECTION_TYPE_DATACOUNT:
-            break;
-
-        default:
-            break;
+            goto fail;
         }
     }
 
@@ -142,4 +156,11 @@ bool wasm_loader(WASMModule *module, uint8 *buf, uint32 size)
 fail:
     LOG_VERBOSE("Load fail.\n");
     return false;
-}
\ No newline at end of file
+}
+
+bool wasm_loader_read_only(WASMModule *module, const uint8 *buf, uint32 size)
+{
+    // 字符串和函数体在需要改写时复制, 数据段直接引用映射
+    module->code_read_only = true;
+    return wasm_loader(module, (uint8 *)buf, size);
+}
@@ -142,8 +142,25 @@ load_utf8_str(WASMModule *module, const uint8 **p_buf, uint32 len, char**str)
         return true;
     }
 
-    char *c_str = (char *)p - 1;
-    memmove(c_str, c_str + 1, len);
+    char *c_str;
+    WASMStringNode *node;
+
+    if (module->code_read_only) {
+        // 只读映射不能原地补0, 复制一份
+        if (!(node = wasm_runtime_malloc(offsetof(WASMStringNode, str) + len + 1))) {
+            wasm_set_exception(module, "malloc error");
+            *str = NULL;
+            return false;
+        }
+        node->next = module->string_copies;
+        module->string_copies = node;
+        c_str = node->str;
+        memcpy(c_str, p, len);
+    }
+    else {
+        c_str = (char *)p - 1;
+        memmove(c_str, c_str + 1, len);
+    }
     c_str[len] = '\0';
 
     *str = c_str;
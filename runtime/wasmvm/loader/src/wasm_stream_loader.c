@@ -0,0 +1,484 @@
+#include "wasm_loader.h"
+#include "wasm_runtime_loader_api.h"
+#include "wasm_runtime_validator_api.h"
+
+// 预留的地址空间大小, 模块文件不超过4 GiB
+#define STREAM_RESERVE_SIZE ((uint64)UINT32_MAX + 1)
+// 每次提交的字节数
+#define STREAM_COMMIT_SIZE (1024 * 1024)
+
+typedef enum StreamState
+{
+    STREAM_HEADER = 0,
+    STREAM_SECTION,
+    STREAM_CODE_COUNT,
+    STREAM_CODE_BODY,
+} StreamState;
+
+struct WASMStreamLoader
+{
+    WASMModule *module;
+    // 只预留不提交的地址空间, 基址不变, 模块中指向文件的指针始终有效
+    uint8 *buf;
+    uint64 committed;
+    // 已收到的字节数
+    uint32 size;
+    // 下一个待解析的位置
+    uint32 pos;
+    // type到global段在收到之后的段前只记录结束位置, 数量确定后再一起加载
+    uint32 prefix_end;
+    bool prefix_loaded;
+    bool module_validated;
+    StreamState state;
+    uint32 code_end;
+    uint32 body_count;
+    uint32 body_loaded;
+#if WASM_ENABLE_THREAD != 0
+    korp_mutex lock;
+    korp_cond cond;
+    korp_tid threads[WASM_VALIDATE_THREAD_NUM];
+    uint32 thread_num;
+    // 已加载但尚未被验证线程取走的函数体为[body_next, body_ready)
+    uint32 body_next;
+    uint32 body_ready;
+    bool body_done;
+    bool failed;
+#endif
+};
+
+#if WASM_ENABLE_THREAD != 0
+static void *
+stream_validate_callback(void *arg)
+{
+    WASMStreamLoader *loader = (WASMStreamLoader *)arg;
+    WASMModule *module = loader->module;
+    WASMFunction *func;
+    bool ret;
+
+    os_mutex_lock(&loader->lock);
+    while (true)
+    {
+        while (!loader->failed && !loader->body_done
+               && loader->body_next == loader->body_ready)
+            os_cond_wait(&loader->cond, &loader->lock);
+
+        if (loader->failed || loader->body_next == loader->body_ready)
+            break;
+
+        func = module->functions + module->import_function_count + loader->body_next++;
+        os_mutex_unlock(&loader->lock);
+
+        ret = wasm_validator_code(module, func);
+
+        os_mutex_lock(&loader->lock);
+        if (!ret)
+        {
+            loader->failed = true;
+            os_cond_broadcast(&loader->cond);
+        }
+    }
+    os_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+// 通知验证线程不再有新的函数体, 等待其全部退出
+static bool
+stream_join_workers(WASMStreamLoader *loader, bool abort)
+{
+    uint32 i;
+
+    os_mutex_lock(&loader->lock);
+    loader->body_done = true;
+    if (abort)
+        loader->failed = true;
+    os_cond_broadcast(&loader->cond);
+    os_mutex_unlock(&loader->lock);
+
+    for (i = 0; i < loader->thread_num; i++)
+        os_thread_join(loader->threads[i], NULL);
+    loader->thread_num = 0;
+
+    return !loader->failed;
+}
+#endif
+
+// 函数体加载完成, 交给验证线程或直接验证
+static bool
+stream_publish_body(WASMStreamLoader *loader, WASMFunction *func)
+{
+    if (loader->module->lazy_validation)
+    {
+        func->func_kind = Lazy_Func;
+        return true;
+    }
+
+#if WASM_ENABLE_THREAD != 0
+    if (loader->thread_num)
+    {
+        os_mutex_lock(&loader->lock);
+        loader->body_ready++;
+        os_cond_signal(&loader->cond);
+        os_mutex_unlock(&loader->lock);
+        return true;
+    }
+#endif
+    return wasm_validator_code(loader->module, func);
+}
+
+static void
+stream_start_workers(WASMStreamLoader *loader)
+{
+#if WASM_ENABLE_THREAD != 0
+    uint32 i;
+
+    if (loader->module->lazy_validation || loader->body_count == 0)
+        return;
+
+    // 线程创建失败时由当前线程直接验证
+    for (i = 0; i < WASM_VALIDATE_THREAD_NUM && i < loader->body_count; i++)
+    {
+        if (os_thread_create(&loader->threads[i], stream_validate_callback,
+                             (void *)loader, APP_THREAD_STACK_SIZE_DEFAULT) != 0)
+            break;
+        loader->thread_num++;
+    }
+#else
+    (void)loader;
+#endif
+}
+
+// 等待已提交的函数体全部验证完毕
+static bool
+stream_finish_bodies(WASMStreamLoader *loader)
+{
+#if WASM_ENABLE_THREAD != 0
+    if (loader->thread_num)
+        return stream_join_workers(loader, false);
+#else
+    (void)loader;
+#endif
+    return true;
+}
+
+// 返回p处完整leb编码的长度, 数据未到齐时返回0
+static uint32
+stream_leb_size(const uint8 *p, const uint8 *p_end)
+{
+    uint32 i;
+
+    for (i = 0; i < 5 && p + i < p_end; i++)
+    {
+        if (!(p[i] & 0x80))
+            return i + 1;
+    }
+    // 超过5字节的编码交给read_leb报错
+    return i == 5 ? 5 : 0;
+}
+
+static bool
+stream_load_prefix(WASMStreamLoader *loader)
+{
+    WASMModule *module = loader->module;
+    const uint8 *p = loader->buf + 8, *p_end = loader->buf + loader->prefix_end;
+    const uint8 *section_start;
+    uint32 payload_len;
+    uint8 id;
+
+    loader->prefix_loaded = true;
+
+    if (!init_load(p, p_end, module))
+        goto fail;
+
+    while (p < p_end)
+    {
+        read_leb_uint7(p, p_end, id);
+        read_leb_uint32(p, p_end, payload_len);
+
+        section_start = p;
+        p += payload_len;
+
+        if (!load_section(id, section_start, p, module))
+            goto fail;
+    }
+    return true;
+fail:
+    return false;
+}
+
+static bool
+stream_parse(WASMStreamLoader *loader)
+{
+    WASMModule *module = loader->module;
+    const uint8 *p, *p_end = loader->buf + loader->size;
+    const uint8 *section_start;
+    uint32 payload_len, leb_size, count;
+    uint8 id;
+
+    while (true)
+    {
+        p = loader->buf + loader->pos;
+
+        switch (loader->state)
+        {
+        case STREAM_HEADER:
+            if (p_end - p < 8)
+                return true;
+
+            if (read_uint32(p) != WASM_MAGIC_NUMBER)
+            {
+                wasm_set_exception(module, "magic not detected");
+                goto fail;
+            }
+
+            if (read_uint32(p) != WASM_CURRENT_VERSION)
+            {
+                wasm_set_exception(module, "unknown version");
+                goto fail;
+            }
+
+            loader->pos = loader->prefix_end = 8;
+            loader->state = STREAM_SECTION;
+            break;
+
+        case STREAM_SECTION:
+            if (p == p_end || !(leb_size = stream_leb_size(p + 1, p_end)))
+                return true;
+
+            read_leb_uint7(p, p_end, id);
+            read_leb_uint32(p, p_end, payload_len);
+
+            if (id == SECTION_TYPE_CODE)
+            {
+                if (!loader->prefix_loaded && !stream_load_prefix(loader))
+                    goto fail;
+
+                loader->pos = (uint32)(p - loader->buf);
+                loader->code_end = loader->pos + payload_len;
+                if (loader->code_end < loader->pos)
+                {
+                    wasm_set_exception(module, "section size mismatch");
+                    goto fail;
+                }
+                loader->state = STREAM_CODE_COUNT;
+                break;
+            }
+
+            // 其余段收齐后整段加载
+            if ((uint64)(p_end - p) < payload_len)
+                return true;
+
+            section_start = p;
+            p += payload_len;
+            loader->pos = (uint32)(p - loader->buf);
+
+            if (!loader->prefix_loaded && id <= SECTION_TYPE_GLOBAL)
+            {
+                loader->prefix_end = loader->pos;
+                break;
+            }
+
+            if (!loader->prefix_loaded && !stream_load_prefix(loader))
+                goto fail;
+
+            // data段会修改数据段信息, 需等函数体验证完
+            if (!stream_finish_bodies(loader))
+                goto fail;
+
+            if (!load_section(id, section_start, p, module))
+                goto fail;
+            break;
+
+        case STREAM_CODE_COUNT:
+            if (!stream_leb_size(p, p_end))
+                return true;
+
+            read_leb_uint32(p, p_end, count);
+            loader->pos = (uint32)(p - loader->buf);
+
+            if (module->function_count != count)
+            {
+                wasm_set_exception(module, "code size mismatch");
+                goto fail;
+            }
+
+            // 函数体的验证依赖导出和全局变量的验证结果
+            if (!wasm_validator_module(module))
+                goto fail;
+            loader->module_validated = true;
+
+            loader->body_count = count;
+            loader->state = STREAM_CODE_BODY;
+            stream_start_workers(loader);
+            break;
+
+        case STREAM_CODE_BODY:
+            if (loader->body_loaded == loader->body_count)
+            {
+                if (loader->pos != loader->code_end)
+                {
+                    wasm_set_exception(module, "section size mismatch");
+                    goto fail;
+                }
+                loader->state = STREAM_SECTION;
+                break;
+            }
+
+            if (!(leb_size = stream_leb_size(p, p_end)))
+                return true;
+
+            read_leb_uint32(p, p_end, payload_len);
+            if ((uint64)(p - loader->buf) + payload_len > loader->code_end)
+            {
+                wasm_set_exception(module, "section size mismatch");
+                goto fail;
+            }
+            if ((uint64)(p_end - p) < payload_len)
+                return true;
+
+            p = loader->buf + loader->pos;
+            if (!load_function_body(&p, loader->buf + loader->code_end, module,
+                                    module->functions + module->import_function_count
+                                        + loader->body_loaded))
+                goto fail;
+
+            loader->pos = (uint32)(p - loader->buf);
+            if (!stream_publish_body(loader, module->functions + module->import_function_count
+                                                 + loader->body_loaded++))
+                goto fail;
+            break;
+        }
+    }
+fail:
+    return false;
+}
+
+WASMStreamLoader *
+wasm_stream_loader_create(WASMModule *module)
+{
+    WASMStreamLoader *loader;
+
+    if (!(loader = wasm_runtime_malloc(sizeof(WASMStreamLoader))))
+    {
+        wasm_set_exception(module, "malloc error");
+        return NULL;
+    }
+    memset(loader, 0, sizeof(WASMStreamLoader));
+    loader->module = module;
+    module->module_hash = BH_HASH_INIT;
+
+    if (!(loader->buf = os_mmap(NULL, STREAM_RESERVE_SIZE, MMAP_PROT_NONE,
+                                MMAP_MAP_NONE)))
+    {
+        wasm_set_exception(module, "mmap error");
+        goto fail1;
+    }
+
+#if WASM_ENABLE_THREAD != 0
+    if (os_mutex_init(&loader->lock) != 0)
+        goto fail2;
+
+    if (os_cond_init(&loader->cond) != 0)
+    {
+        os_mutex_destroy(&loader->lock);
+        goto fail2;
+    }
+#endif
+    return loader;
+
+#if WASM_ENABLE_THREAD != 0
+fail2:
+    wasm_set_exception(module, "init lock error");
+    os_munmap(loader->buf, STREAM_RESERVE_SIZE);
+#endif
+fail1:
+    wasm_runtime_free(loader);
+    return NULL;
+}
+
+bool
+wasm_stream_loader_feed(WASMStreamLoader *loader, const uint8 *data, uint32 size)
+{
+    uint64 commit_size;
+
+#if WASM_ENABLE_THREAD != 0
+    if (loader->failed)
+        goto fail;
+#endif
+
+    if ((uint64)loader->size + size > UINT32_MAX)
+    {
+        wasm_set_exception(loader->module, "module too large");
+        goto fail;
+    }
+
+    if (loader->size + size > loader->committed)
+    {
+        commit_size = ((uint64)loader->size + size + STREAM_COMMIT_SIZE - 1)
+                      & ~((uint64)STREAM_COMMIT_SIZE - 1);
+        if (os_mprotect(loader->buf + loader->committed, commit_size - loader->committed,
+                        MMAP_PROT_READ | MMAP_PROT_WRITE) != 0)
+        {
+            wasm_set_exception(loader->module, "mprotect error");
+            goto fail;
+        }
+        loader->committed = commit_size;
+    }
+
+    memcpy(loader->buf + loader->size, data, size);
+    loader->size += size;
+    // 按收到的顺序累计哈希, 结果与整个文件一次计算的相同
+    loader->module->module_hash = bh_hash_bytes(loader->module->module_hash, data, size);
+
+    if (!stream_parse(loader))
+        goto fail;
+    return true;
+fail:
+#if WASM_ENABLE_THREAD != 0
+    stream_join_workers(loader, true);
+#endif
+    LOG_VERBOSE("Load fail.\n");
+    return false;
+}
+
+bool
+wasm_stream_loader_finish(WASMStreamLoader *loader)
+{
+    WASMModule *module = loader->module;
+
+    if (loader->state != STREAM_SECTION || loader->pos != loader->size)
+    {
+        wasm_set_exception(module, "unexpected end");
+        goto fail;
+    }
+
+    if (!loader->prefix_loaded && !stream_load_prefix(loader))
+        goto fail;
+
+    // 没有code段时只需验证模块级的内容
+    if (!loader->module_validated && !wasm_validator_module(module))
+        goto fail;
+
+    if (!stream_finish_bodies(loader))
+        goto fail;
+
+    LOG_VERBOSE("Load success.\n");
+    return true;
+fail:
+#if WASM_ENABLE_THREAD != 0
+    stream_join_workers(loader, true);
+#endif
+    LOG_VERBOSE("Load fail.\n");
+    return false;
+}
+
+void
+wasm_stream_loader_destroy(WASMStreamLoader *loader)
+{
+#if WASM_ENABLE_THREAD != 0
+    stream_join_workers(loader, true);
+    os_cond_destroy(&loader->cond);
+    os_mutex_destroy(&loader->lock);
+#endif
+    os_munmap(loader->buf, STREAM_RESERVE_SIZE);
+    wasm_runtime_free(loader);
+}
@@ -1,4 +1,5 @@
 #include "wasm_loader.h"
+#include "wasm_type_registry.h"
 
 //检查两个type是否相同
 inline static bool
@@ -105,6 +106,14 @@ load_type_section(const uint8 *buf, const uint8 *buf_end, WASMModule *module)
                     break;
                 }
             }
+
+            if (j == i
+                && (type->type_id = wasm_type_registry_intern(type->param, param_count,
+                                                              type->result, result_count))
+                       == WASM_TYPE_ID_INVALID) {
+                wasm_set_exception(module, "allocate memory failed");
+                return false;
+            }
         }
 
         //赋值
@@ -10,6 +10,8 @@ typedef struct NativeSymbol
     void *func_ptr;
     const char *signature;
     void *attachment;
+    // 注册时由signature得到的类型编号
+    uint32 type_id;
 } NativeSymbol;
 
 typedef struct NativeSymbolsNode
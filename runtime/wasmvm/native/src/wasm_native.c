@@ -1,6 +1,7 @@
 #include "wasm_native.h"
 #include "wasm_memory.h"
 #include "wasm_exception.h"
+#include "wasm_type_registry.h"
 
 // static FILE *call_info;
 
@@ -241,11 +242,8 @@ bool wasm_runtime_invoke_native(WASMExecEnv *exec_env, uint32 func_idx, uint32 *
         stacks[n_stacks++] = *(uint64 *)argv_src;
         argv_src += 2;
     }
-#if WASM_ENABLE_JIT != 0
-    func_ptr = module->func_ptrs[func_idx];
-#else
+    // 只用于调用宿主函数, 编译好的wasm函数经各函数类型的入口调用
     func_ptr = func->func_ptr;
-#endif
 
     if (result_count == 0)
     {
@@ -296,84 +294,6 @@ bool wasm_runtime_invoke_native(WASMExecEnv *exec_env, uint32 func_idx, uint32 *
     return ret;
 }
 
-static bool
-compare_type_with_signautre(uint8 type, const char signature)
-{
-    const char num_sig_map[] = {'F', 'f', 'I', 'i'};
-
-    if (VALUE_TYPE_F64 <= type && type <= VALUE_TYPE_I32 && signature == num_sig_map[type - VALUE_TYPE_F64])
-    {
-        return true;
-    }
-
-    return false;
-}
-
-static bool
-check_symbol_signature(const WASMType *type, const char *signature)
-{
-    const char *p = signature, *p_end;
-    char sig;
-    uint32 i = 0;
-
-    if (!p || strlen(p) < 2)
-        return false;
-
-    p_end = p + strlen(signature);
-
-    if (*p++ != '(')
-        return false;
-
-    if ((uint32)(p_end - p) < (uint32)(type->param_count + 1))
-        return false;
-
-    for (i = 0; i < type->param_count; i++)
-    {
-        sig = *p++;
-
-        if (compare_type_with_signautre(type->param[i], sig))
-            continue;
-
-        if (type->param[i] != VALUE_TYPE_I32)
-            return false;
-
-        if (sig == '*')
-        {
-            if (i + 1 < type->param_count && type->param[i + 1] == VALUE_TYPE_I32 && *p == '~')
-            {
-                i++;
-                p++;
-            }
-        }
-        else if (sig == '$')
-        {
-        }
-        else
-        {
-            return false;
-        }
-    }
-
-    if (*p++ != ')')
-        return false;
-
-    if (type->result_count)
-    {
-        if (p >= p_end)
-            return false;
-
-        if (!compare_type_with_signautre(type->result[0], *p))
-            return false;
-
-        p++;
-    }
-
-    if (*p != '\0')
-        return false;
-
-    return true;
-}
-
 static inline void
 swap_symbol(NativeSymbol *left, NativeSymbol *right)
 {
@@ -425,9 +345,9 @@ quick_sort_symbols(NativeSymbol *native_symbols, int left, int right)
     quick_sort_symbols(native_symbols, left + 1, pin_right);
 }
 
-static void *
+static NativeSymbol *
 lookup_symbol(NativeSymbol *native_symbols, uint32 n_native_symbols,
-              const char *symbol, const char **p_signature)
+              const char *symbol)
 {
     int low = 0, mid, ret;
     int high = (int32)n_native_symbols - 1;
@@ -437,10 +357,7 @@ lookup_symbol(NativeSymbol *native_symbols, uint32 n_native_symbols,
         mid = (low + high) / 2;
         ret = strcmp(symbol, native_symbols[mid].symbol);
         if (ret == 0)
-        {
-            *p_signature = native_symbols[mid].signature;
-            return native_symbols[mid].func_ptr;
-        }
+            return native_symbols + mid;
         else if (ret < 0)
             high = mid - 1;
         else
@@ -455,8 +372,7 @@ wasm_native_resolve_symbol(const char *module_name, const char *field_name,
                            const WASMType *func_type, const char **p_signature)
 {
     NativeSymbolsNode *node, *node_next;
-    const char *signature = NULL;
-    void *func_ptr = NULL;
+    NativeSymbol *symbol = NULL;
 
     node = g_native_symbols_list;
     while (node)
@@ -464,23 +380,19 @@ wasm_native_resolve_symbol(const char *module_name, const char *field_name,
         node_next = node->next;
         if (!strcmp(node->module_name, module_name))
         {
-            if (!(func_ptr = lookup_symbol(node->native_symbols, node->n_native_symbols,
-                                           field_name, &signature)))
+            if (!(symbol = lookup_symbol(node->native_symbols, node->n_native_symbols,
+                                         field_name)))
                 return NULL;
         }
         node = node_next;
     }
 
-    if (!check_symbol_signature(func_type, signature))
-    {
+    // 签名在注册时已转换为类型编号, 无效签名的编号为0, 不会与任何类型匹配
+    if (!symbol || symbol->type_id == WASM_TYPE_ID_INVALID || symbol->type_id != func_type->type_id)
         return NULL;
-    }
-    else
-    {
-        *p_signature = signature;
-    }
 
-    return func_ptr;
+    *p_signature = symbol->signature;
+    return symbol->func_ptr;
 }
 
 static bool
@@ -489,6 +401,7 @@ wasm_native_register_natives(const char *module_name,
                              uint32 n_native_symbols)
 {
     NativeSymbolsNode *node;
+    uint32 i;
 
     if (!(node = wasm_runtime_malloc(sizeof(NativeSymbolsNode))))
         return false;
@@ -502,6 +415,9 @@ wasm_native_register_natives(const char *module_name,
 
     quick_sort_symbols(native_symbols, 0, (int)(n_native_symbols - 1));
 
+    for (i = 0; i < n_native_symbols; i++)
+        native_symbols[i].type_id = wasm_type_registry_intern_signature(native_symbols[i].signature);
+
     return true;
 }
 
@@ -0,0 +1,9 @@
+#ifndef _WASM_IR_EMITTER_H
+#define _WASM_IR_EMITTER_H
+
+#include "wasm_validator.h"
+
+// 将验证完毕的函数体翻译为解释器使用的预解码指令
+bool wasm_validator_emit_ir(WASMModule *module, WASMValidator *ctx, WASMFunction *func);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef _WASM_LOCAL_VALIDATOR_H
+#define _WASM_LOCAL_VALIDATOR_H
+
+#include "wasm_validator.h"
+
+// 局部变量的确定赋值分析: 找出可能在赋值之前被读取的局部变量, 调用时只需清零这些变量
+
+bool wasm_validator_local_init(WASMValidator *ctx, uint32 local_count);
+
+bool wasm_validator_local_push_block(WASMValidator *ctx);
+
+void wasm_validator_local_branch(WASMValidator *ctx, uint32 depth);
+
+void wasm_validator_local_unreachable(WASMValidator *ctx);
+
+void wasm_validator_local_else(WASMValidator *ctx);
+
+void wasm_validator_local_end(WASMValidator *ctx, bool missing_else);
+
+void wasm_validator_local_get(WASMValidator *ctx, uint32 local_idx);
+
+void wasm_validator_local_set(WASMValidator *ctx, uint32 local_idx);
+
+void wasm_validator_local_finish(WASMValidator *ctx, WASMFunction *func);
+
+#endif
@@ -5,4 +5,16 @@
 
 bool wasm_validator(WASMModule *module);
 
+//验证导出和全局变量并计算全局变量的偏移, 需在验证任何函数体之前完成
+bool wasm_validator_module(WASMModule *module);
+
+//验证一个函数体并生成预解码指令, 不同的函数可在多个线程中同时验证
+bool wasm_validator_code(WASMModule *module, WASMFunction *func);
+
+//开启延迟验证, 需在wasm_validator之前调用, 之后函数体在首次调用时才验证
+bool wasm_set_lazy_validation(WASMModule *module);
+
+//验证延迟验证的函数并发布结果, 已验证时直接返回true, 失败时异常信息已设置
+bool wasm_validator_resolve_lazy(WASMModule *module, WASMFunction *func);
+
 #endif
\ No newline at end of file
@@ -59,6 +59,16 @@ typedef struct WASMValidator
     uint32 branch_table_num;
     uint32 branch_table_size;
 
+    // 局部变量确定赋值分析使用的位图, 见wasm_local_validator.c
+    uint32 *local_sets;
+    uint32 local_set_words;
+    uint32 local_set_depth;
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+    // 每条指令执行前的栈高度, 以4字节为单位
+    uint32 *stack_heights;
+#endif
+
 } WASMValidator;
 
 #endif
\ No newline at end of file
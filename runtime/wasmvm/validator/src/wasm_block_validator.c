@@ -1,4 +1,5 @@
 #include "wasm_block_validator.h"
+#include "wasm_local_validator.h"
 
 bool wasm_validator_push_block(WASMValidator *ctx, uint8 label_type,
                                BlockType block_type, uint8 *start_addr)
@@ -39,7 +40,7 @@ bool wasm_validator_push_block(WASMValidator *ctx, uint8 label_type,
     {
         ctx->max_block_stack_num = ctx->block_stack_num;
     }
-    return true;
+    return wasm_validator_local_push_block(ctx);
 }
 
 bool wasm_validator_pop_block(WASMModule *module, WASMValidator *ctx)
@@ -0,0 +1,1178 @@
+#include "wasm_ir_emitter.h"
+#include "wasm_interp.h"
+#include "wasm_fast_readleb.h"
+
+typedef struct IREmitter
+{
+    uint64 *code;
+    uint32 size;
+    uint32 num;
+} IREmitter;
+
+static bool
+wasm_ir_emit(IREmitter *emitter, uint64 cell)
+{
+    if (emitter->num == emitter->size)
+    {
+        uint64 *code = wasm_runtime_realloc(
+            emitter->code, (emitter->size + 64) * sizeof(uint64));
+        if (!code)
+        {
+            return false;
+        }
+        emitter->code = code;
+        emitter->size += 64;
+    }
+    emitter->code[emitter->num++] = cell;
+    return true;
+}
+
+// 可合并的相邻指令, 由build-scripts/gen_superinstr.py根据指令对统计生成
+// 统计指令对时不合并, 以0结尾
+static const uint8 super_instrs[][3] = {
+#if WASM_ENABLE_OPCODE_PROFILE == 0
+#define SUPER_INSTR(fused, first, second) {first, second, fused},
+#include "wasm_superinstr.def"
+#undef SUPER_INSTR
+#endif
+    {0, 0, 0},
+};
+
+// 查找可由两条指令合并成的超级指令, 没有时返回0
+static uint8
+super_instr_lookup(uint8 first, uint8 second)
+{
+    uint32 i;
+
+    for (i = 0; super_instrs[i][2]; i++)
+    {
+        if (super_instrs[i][0] == first && super_instrs[i][1] == second)
+            return super_instrs[i][2];
+    }
+    return 0;
+}
+
+// 上一条指令的位置为SUPER_NONE时不能与其合并
+#define SUPER_NONE 0xFFFFFFFF
+
+#if WASM_ENABLE_TOS_CACHE != 0
+// 已生成的一条指令及其进入和离开时的栈顶缓存状态
+typedef struct TosInstr
+{
+    uint32 pos;
+    uint8 opcode;
+    uint8 in;
+    uint8 out;
+} TosInstr;
+
+static uint64
+tos_handler(const void **handle_table, uint8 opcode, uint8 in, uint8 out)
+{
+    if (!in && !out)
+        return (uintptr_t)handle_table[opcode];
+    return (uintptr_t)wasm_interp_tos_handle_table[opcode][in][out];
+}
+
+// 改为离开时将栈顶写回frame_sp之下
+static void
+tos_spill(IREmitter *emitter, const void **handle_table, TosInstr *instr)
+{
+    if (instr->pos != SUPER_NONE && instr->out)
+    {
+        instr->out = 0;
+        emitter->code[instr->pos] = tos_handler(handle_table, instr->opcode, instr->in, 0);
+    }
+}
+
+// 按上一条指令留下的状态选择本条指令的处理, 本条能把结果留在缓存中时先假定如此,
+// 由下一条指令决定是否改回写入frame_sp之下
+static void
+tos_emit(IREmitter *emitter, const void **handle_table, TosInstr *last, TosInstr *prev, uint32 pos, uint8 opcode)
+{
+    const void *(*tos_table)[2][2] = wasm_interp_tos_handle_table;
+    uint8 in = 0, out;
+
+    if (last->out)
+    {
+        if (tos_table[opcode][1][0] || tos_table[opcode][1][1])
+            in = 1;
+        else
+            tos_spill(emitter, handle_table, last);
+    }
+    out = tos_table[opcode][in][1] ? 1 : 0;
+    if (in || out)
+        emitter->code[pos] = (uintptr_t)tos_table[opcode][in][out];
+
+    *prev = *last;
+    last->pos = pos;
+    last->opcode = opcode;
+    last->in = in;
+    last->out = out;
+}
+#endif
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+// 栈位置上的值已位于自己的栈槽
+#define SLOT_REAL 0xFFFF
+// frame_sp与当前栈高度不对应
+#define SLOT_SP_UNKNOWN 0xFFFFFFFF
+
+typedef struct SlotStack
+{
+    // 每个栈位置上仍引用的局部变量偏移, 为SLOT_REAL时已在栈槽中
+    uint16 *lazy;
+    uint8 *lazy_cells;
+    uint32 lazy_num;
+    // 当前栈高度, 以4字节为单位
+    uint32 sp;
+    // 第一个栈槽相对frame_lp的偏移
+    uint32 base;
+    // frame_sp当前对应的栈高度
+    uint32 synced_sp;
+    // 最近一条写栈槽的指令, 用于将其结果直接写入局部变量
+    uint32 producer_end;
+    uint32 producer_cell;
+    uint32 producer_pos;
+} SlotStack;
+
+static uint32
+slot_pop(SlotStack *stack, uint32 cells)
+{
+    uint32 pos = stack->sp -= cells;
+    uint16 local_offset = stack->lazy[pos];
+
+    if (local_offset == SLOT_REAL)
+        return stack->base + pos;
+
+    stack->lazy[pos] = SLOT_REAL;
+    stack->lazy_num--;
+    return local_offset;
+}
+
+static uint32
+slot_push(SlotStack *stack, uint32 cells)
+{
+    uint32 pos = stack->sp;
+    stack->sp += cells;
+    return stack->base + pos;
+}
+
+static void
+slot_push_local(SlotStack *stack, uint16 local_offset, uint32 cells)
+{
+    stack->lazy[stack->sp] = local_offset;
+    stack->lazy_cells[stack->sp] = (uint8)cells;
+    stack->lazy_num++;
+    stack->sp += cells;
+}
+
+static bool
+slot_has_ref(SlotStack *stack, uint16 local_offset)
+{
+    uint32 pos;
+    for (pos = 0; stack->lazy_num && pos < stack->sp; pos++)
+    {
+        if (stack->lazy[pos] == local_offset)
+            return true;
+    }
+    return false;
+}
+
+// 将引用局部变量的栈位置复制到各自的栈槽, local_offset为SLOT_REAL时处理全部
+static bool
+slot_flush(IREmitter *emitter, SlotStack *stack, uint16 local_offset)
+{
+    const void **slot_table = wasm_interp_slot_handle_table;
+    uint32 pos;
+    uint16 src;
+    uint8 opcode;
+
+    if (local_offset == SLOT_REAL)
+        stack->producer_end = 0;
+
+    for (pos = 0; stack->lazy_num && pos < stack->sp; pos++)
+    {
+        src = stack->lazy[pos];
+        if (src == SLOT_REAL || (local_offset != SLOT_REAL && src != local_offset))
+            continue;
+
+        opcode = stack->lazy_cells[pos] == 1 ? EXT_OP_SET_LOCAL_FAST : EXT_OP_SET_LOCAL_FAST_64;
+        if (!wasm_ir_emit(emitter, (uintptr_t)slot_table[opcode]) || !wasm_ir_emit(emitter, (stack->base + pos) | ((uint64)src << 16)))
+            return false;
+
+        stack->lazy[pos] = SLOT_REAL;
+        stack->lazy_num--;
+    }
+    return true;
+}
+
+// 栈式指令通过frame_sp访问操作数, 执行前需要同步
+static bool
+slot_sync_sp(IREmitter *emitter, SlotStack *stack)
+{
+    if (stack->synced_sp == stack->sp)
+        return true;
+
+    if (!wasm_ir_emit(emitter, (uintptr_t)wasm_interp_handle_table[EXT_OP_SET_SP]) || !wasm_ir_emit(emitter, stack->base + stack->sp))
+        return false;
+
+    stack->synced_sp = stack->sp;
+    return true;
+}
+
+// 返回数值指令的操作数个数, 并给出操作数和结果占用的单元数
+static uint32
+slot_numeric_cells(uint8 opcode, uint32 *in, uint32 *out)
+{
+    *in = *out = 1;
+    if (opcode == WASM_OP_I32_EQZ || (opcode >= WASM_OP_I32_CLZ && opcode <= WASM_OP_I32_POPCNT) || (opcode >= WASM_OP_F32_ABS && opcode <= WASM_OP_F32_SQRT))
+        return 1;
+    if ((opcode >= WASM_OP_I32_EQ && opcode <= WASM_OP_I32_GE_U) || (opcode >= WASM_OP_F32_EQ && opcode <= WASM_OP_F32_GE) || (opcode >= WASM_OP_I32_ADD && opcode <= WASM_OP_I32_ROTR) || (opcode >= WASM_OP_F32_ADD && opcode <= WASM_OP_F32_COPYSIGN))
+        return 2;
+
+    *in = 2;
+    if (opcode == WASM_OP_I64_EQZ)
+        return 1;
+    if ((opcode >= WASM_OP_I64_EQ && opcode <= WASM_OP_I64_GE_U) || (opcode >= WASM_OP_F64_EQ && opcode <= WASM_OP_F64_GE))
+        return 2;
+
+    *out = 2;
+    if ((opcode >= WASM_OP_I64_CLZ && opcode <= WASM_OP_I64_POPCNT) || (opcode >= WASM_OP_F64_ABS && opcode <= WASM_OP_F64_SQRT))
+        return 1;
+    if ((opcode >= WASM_OP_I64_ADD && opcode <= WASM_OP_I64_ROTR) || (opcode >= WASM_OP_F64_ADD && opcode <= WASM_OP_F64_COPYSIGN))
+        return 2;
+
+    // 类型转换
+    switch (opcode)
+    {
+    case WASM_OP_I32_WRAP_I64:
+    case WASM_OP_I32_TRUNC_S_F64:
+    case WASM_OP_I32_TRUNC_U_F64:
+    case WASM_OP_F32_CONVERT_S_I64:
+    case WASM_OP_F32_CONVERT_U_I64:
+    case WASM_OP_F32_DEMOTE_F64:
+        *in = 2;
+        *out = 1;
+        return 1;
+    case WASM_OP_I64_EXTEND_S_I32:
+    case WASM_OP_I64_EXTEND_U_I32:
+    case WASM_OP_I64_TRUNC_S_F32:
+    case WASM_OP_I64_TRUNC_U_F32:
+    case WASM_OP_F64_CONVERT_S_I32:
+    case WASM_OP_F64_CONVERT_U_I32:
+    case WASM_OP_F64_PROMOTE_F32:
+        *in = 1;
+        *out = 2;
+        return 1;
+    case WASM_OP_I64_TRUNC_S_F64:
+    case WASM_OP_I64_TRUNC_U_F64:
+    case WASM_OP_F64_CONVERT_S_I64:
+    case WASM_OP_F64_CONVERT_U_I64:
+    case WASM_OP_I64_REINTERPRET_F64:
+    case WASM_OP_F64_REINTERPRET_I64:
+    case WASM_OP_I64_EXTEND8_S:
+    case WASM_OP_I64_EXTEND16_S:
+    case WASM_OP_I64_EXTEND32_S:
+        *in = *out = 2;
+        return 1;
+    case WASM_OP_I32_TRUNC_S_F32:
+    case WASM_OP_I32_TRUNC_U_F32:
+    case WASM_OP_F32_CONVERT_S_I32:
+    case WASM_OP_F32_CONVERT_U_I32:
+    case WASM_OP_I32_REINTERPRET_F32:
+    case WASM_OP_F32_REINTERPRET_I32:
+    case WASM_OP_I32_EXTEND8_S:
+    case WASM_OP_I32_EXTEND16_S:
+        *in = *out = 1;
+        return 1;
+    default:
+        return 0;
+    }
+}
+#endif
+
+#define EMIT_CELL(cell)                              \
+    do                                               \
+    {                                                \
+        if (!wasm_ir_emit(&emitter, (uint64)(cell))) \
+            goto fail;                               \
+    } while (0)
+
+// 记录所用处理对应的操作码, 供合并指令和栈顶缓存使用
+#define EMIT_HANDLER(opcode)                              \
+    do                                                    \
+    {                                                     \
+        ir_opcode = (opcode);                             \
+        EMIT_CELL((uintptr_t)handle_table[ir_opcode]);    \
+    } while (0)
+
+#define EMIT_POINTER(ptr) EMIT_CELL((uintptr_t)(ptr))
+
+// 跳转目标先记录为原始字节偏移, 翻译结束后统一改写为指令地址
+#define EMIT_BRANCH_TARGET(branch)                                  \
+    do                                                              \
+    {                                                               \
+        fixups[fixup_num++] = emitter.num;                          \
+        EMIT_CELL((branch)->ip - code);                             \
+        EMIT_CELL(((uint64)(branch)->pop << 32) | (branch)->push); \
+    } while (0)
+
+// return之后的单元高32位为栈帧头部相对frame_lp的偏移, 低32位为返回值的单元数
+#define EMIT_RETURN_CELLS()                                                                          \
+    EMIT_CELL(((uint64)(func->param_cell_num + func->local_cell_num) << 32) | func->ret_cell_num)
+
+// call_indirect的内联缓存, 初始时不与任何元素匹配
+#define EMIT_INDIRECT_CACHE() EMIT_CELL(UINT64_MAX)
+
+#if WASM_ENABLE_TIERED_JIT != 0
+// 跳回循环的目标是循环体的第一条指令, 之后将其改为指向这里的回边计数
+#define EMIT_LOOP_HOTNESS()                 \
+    do                                      \
+    {                                       \
+        loop_head = emitter.num;            \
+        loop_body = (uint32)(p - code);     \
+        EMIT_HANDLER(EXT_OP_LOOP_HOTNESS);  \
+        EMIT_POINTER(func);                 \
+    } while (0)
+#endif
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+#define EMIT_SLOT_HANDLER(opcode) EMIT_CELL((uintptr_t)slot_table[opcode])
+
+#define SLOT_CHECK(expr)  \
+    do                    \
+    {                     \
+        if (!(expr))      \
+            goto fail;    \
+    } while (0)
+
+// 目的操作数位于刚写入的单元的低16位
+#define SLOT_PRODUCER(pos)                      \
+    do                                          \
+    {                                           \
+        slot.producer_cell = emitter.num - 1;   \
+        slot.producer_pos = (pos)-slot.base;    \
+        slot.producer_end = emitter.num;        \
+    } while (0)
+
+// 跳转时把结果从栈顶复制到目标块的栈底
+#define SLOT_BRANCH_COPY(branch)                                    \
+    ((uint64)(slot.base + slot.sp - (branch)->pop)                  \
+     | ((uint64)(slot.base + slot.sp - (branch)->push) << 16)       \
+     | ((uint64)((branch)->pop != (branch)->push ? (branch)->push : 0) << 32))
+
+#define SLOT_EMIT_BRANCH_TARGET(branch)            \
+    do                                             \
+    {                                              \
+        fixups[fixup_num++] = emitter.num;         \
+        EMIT_CELL((branch)->ip - code);            \
+    } while (0)
+#endif
+
+bool wasm_validator_emit_ir(WASMModule *module, WASMValidator *ctx, WASMFunction *func)
+{
+    uint8 *code = (uint8 *)func->func_ptr, *p = code, *p_end = func->code_end;
+    uint32 code_size = (uint32)(p_end - code);
+    const void **handle_table = wasm_interp_handle_table;
+    WASMBranchTable *branch = ctx->branch_table_bottom;
+    WASMGlobal *globals = module->globals;
+    IREmitter emitter = {NULL, 0, 0};
+    uint32 *ir_offsets = NULL, *fixups = NULL, fixup_num = 0;
+    uint32 param_count = func->param_count, local_idx, idx, count, i;
+    uint32 u32;
+    int32 i32;
+    int64 i64;
+    uint8 opcode, local_type, ir_opcode = 0;
+    // 上一条栈式指令的位置和操作码
+    uint32 ir_start, fixup_mark, super_pos = 0, super_end = SUPER_NONE;
+    uint8 super_op = 0, fused;
+#if WASM_ENABLE_TIERED_JIT != 0
+    // 最近一个循环的回边计数指令位置和循环体的字节偏移
+    uint32 loop_head = 0, loop_body = UINT32_MAX;
+#endif
+#if WASM_ENABLE_TOS_CACHE != 0
+    // 最近两条栈式指令, 合并指令时需要改写更早的一条
+    TosInstr tos_last = {SUPER_NONE, 0, 0, 0}, tos_prev = {SUPER_NONE, 0, 0, 0};
+    bool tos_mode = true;
+#endif
+#if WASM_ENABLE_SLOT_INTERP != 0
+    const void **slot_table = wasm_interp_slot_handle_table;
+    uint32 *heights = ctx->stack_heights;
+    // 操作数栈位于局部变量和栈帧头部之后
+    SlotStack slot = {NULL, NULL, 0, 0, func->param_cell_num + func->local_cell_num + WASM_FRAME_HEADER_CELLS, 0, 0, 0, 0};
+    // 帧内偏移需能用16位表示
+    bool slot_mode = slot.base + func->max_stack_cell_num < SLOT_REAL;
+    // 处于不可达代码中时生成的指令会被丢弃
+    bool dead = false;
+    uint32 dead_depth = 0, dead_mark = 0, dead_fixup_mark = 0;
+    uint32 in, out, arity, dst, src, cond, cells;
+#endif
+
+    // 原始字节偏移到预解码指令偏移的映射
+    if (!(ir_offsets = wasm_runtime_malloc((code_size + 1) * sizeof(uint32))))
+        goto fail;
+
+    if (ctx->branch_table_num && !(fixups = wasm_runtime_malloc(ctx->branch_table_num * sizeof(uint32))))
+        goto fail;
+
+#if WASM_ENABLE_SLOT_INTERP != 0 && WASM_ENABLE_TOS_CACHE != 0
+    // 槽位模式的函数不使用栈顶缓存
+    tos_mode = !slot_mode;
+#endif
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+    if (slot_mode)
+    {
+        if (!(slot.lazy = wasm_runtime_malloc((func->max_stack_cell_num + 2) * sizeof(uint16))) || !(slot.lazy_cells = wasm_runtime_malloc(func->max_stack_cell_num + 2)))
+            goto fail;
+        memset(slot.lazy, 0xFF, (func->max_stack_cell_num + 2) * sizeof(uint16));
+    }
+#endif
+
+    while (p < p_end)
+    {
+#if WASM_ENABLE_SLOT_INTERP != 0
+        // 跳转到end的分支与顺序执行需看到同样的栈槽, 先写回尚未落地的局部变量和常量引用,
+        // 否则顺序执行在跳转目标之后的写回会覆盖分支带来的值
+        if (slot_mode && !dead && *p == WASM_OP_END)
+        {
+            slot.sp = heights[p - code];
+            SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+        }
+#endif
+        ir_offsets[p - code] = emitter.num;
+#if WASM_ENABLE_TIERED_JIT != 0
+        if ((uint32)(p - code) == loop_body)
+            ir_offsets[p - code] = loop_head;
+#endif
+        opcode = *p++;
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+        // 槽位模式的函数不使用超级指令
+        if (slot_mode)
+            super_end = SUPER_NONE;
+
+        if (slot_mode && opcode != WASM_OP_NOP && dead)
+        {
+            switch (opcode)
+            {
+            case WASM_OP_BLOCK:
+            case WASM_OP_LOOP:
+            case WASM_OP_IF:
+                dead_depth++;
+                break;
+
+            // 回到所在块的边界后重新变为可达
+            case WASM_OP_ELSE:
+                if (dead_depth == 0)
+                {
+                    branch++;
+                    dead = false;
+                    slot.synced_sp = SLOT_SP_UNKNOWN;
+                    continue;
+                }
+                break;
+
+            case WASM_OP_END:
+                if (dead_depth == 0)
+                {
+                    dead = false;
+                    slot.synced_sp = SLOT_SP_UNKNOWN;
+                    if (p == p_end)
+                    {
+                        EMIT_SLOT_HANDLER(WASM_OP_RETURN);
+                        EMIT_CELL(slot.base);
+                        EMIT_RETURN_CELLS();
+                    }
+                    continue;
+                }
+                dead_depth--;
+                break;
+
+            default:
+                break;
+            }
+            dead_mark = emitter.num;
+            dead_fixup_mark = fixup_num;
+        }
+        else if (slot_mode && opcode != WASM_OP_NOP)
+        {
+            slot.sp = heights[p - 1 - code];
+
+            switch (opcode)
+            {
+            case WASM_OP_BLOCK:
+            case WASM_OP_LOOP:
+                if (*p == VALUE_TYPE_VOID || is_value_type(*p))
+                    p++;
+                else
+                    skip_leb_int32(p, p_end);
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+#if WASM_ENABLE_TIERED_JIT != 0
+                if (opcode == WASM_OP_LOOP)
+                    EMIT_LOOP_HOTNESS();
+#endif
+                continue;
+
+            case WASM_OP_IF:
+                if (*p == VALUE_TYPE_VOID || is_value_type(*p))
+                    p++;
+                else
+                    skip_leb_int32(p, p_end);
+                cond = slot_pop(&slot, 1);
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                EMIT_SLOT_HANDLER(WASM_OP_IF);
+                SLOT_EMIT_BRANCH_TARGET(branch);
+                EMIT_CELL(cond);
+                branch++;
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+                continue;
+
+            case WASM_OP_ELSE:
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                EMIT_HANDLER(WASM_OP_ELSE);
+                SLOT_EMIT_BRANCH_TARGET(branch);
+                branch++;
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+                continue;
+
+            case WASM_OP_END:
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                if (p == p_end)
+                {
+                    EMIT_SLOT_HANDLER(WASM_OP_RETURN);
+                    EMIT_CELL(slot.base + slot.sp - func->ret_cell_num);
+                    EMIT_RETURN_CELLS();
+                }
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+                continue;
+
+            case WASM_OP_RETURN:
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                EMIT_SLOT_HANDLER(WASM_OP_RETURN);
+                EMIT_CELL(slot.base + slot.sp - func->ret_cell_num);
+                EMIT_RETURN_CELLS();
+                dead = true;
+                dead_depth = 0;
+                continue;
+
+            // 不需要复制结果的跳转直接使用else的处理
+            case WASM_OP_BR:
+                skip_leb_uint32(p, p_end);
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                if (branch->pop != branch->push && branch->push)
+                {
+                    EMIT_SLOT_HANDLER(WASM_OP_BR);
+                    SLOT_EMIT_BRANCH_TARGET(branch);
+                    EMIT_CELL(SLOT_BRANCH_COPY(branch));
+                }
+                else
+                {
+                    EMIT_HANDLER(WASM_OP_ELSE);
+                    SLOT_EMIT_BRANCH_TARGET(branch);
+                }
+                branch++;
+                dead = true;
+                dead_depth = 0;
+                continue;
+
+            case WASM_OP_BR_IF:
+                skip_leb_uint32(p, p_end);
+                cond = slot_pop(&slot, 1);
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                EMIT_SLOT_HANDLER(WASM_OP_BR_IF);
+                SLOT_EMIT_BRANCH_TARGET(branch);
+                EMIT_CELL(SLOT_BRANCH_COPY(branch) | ((uint64)cond << 48));
+                branch++;
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+                continue;
+
+            case WASM_OP_BR_TABLE:
+                read_leb_uint32(p, p_end, count);
+                idx = slot_pop(&slot, 1);
+                SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+                EMIT_SLOT_HANDLER(WASM_OP_BR_TABLE);
+                EMIT_CELL(count | ((uint64)idx << 32));
+                for (i = 0; i <= count; i++)
+                {
+                    skip_leb_uint32(p, p_end);
+                    SLOT_EMIT_BRANCH_TARGET(branch);
+                    EMIT_CELL(SLOT_BRANCH_COPY(branch));
+                    branch++;
+                }
+                dead = true;
+                dead_depth = 0;
+                continue;
+
+            case WASM_OP_DROP:
+            case WASM_OP_DROP_64:
+                slot_pop(&slot, opcode == WASM_OP_DROP ? 1 : 2);
+                continue;
+
+            case WASM_OP_SELECT:
+            case WASM_OP_SELECT_64:
+                cells = opcode == WASM_OP_SELECT ? 1 : 2;
+                cond = slot_pop(&slot, 1);
+                src = slot_pop(&slot, cells);
+                idx = slot_pop(&slot, cells);
+                dst = slot_push(&slot, cells);
+                EMIT_SLOT_HANDLER(opcode);
+                EMIT_CELL(dst | ((uint64)idx << 16) | ((uint64)src << 32) | ((uint64)cond << 48));
+                SLOT_PRODUCER(dst);
+                continue;
+
+            // 读取局部变量只记录引用, 由使用者直接访问
+            case EXT_OP_GET_LOCAL_FAST:
+            case EXT_OP_GET_LOCAL_FAST_64:
+                slot_push_local(&slot, *p++, opcode == EXT_OP_GET_LOCAL_FAST ? 1 : 2);
+                continue;
+
+            case WASM_OP_GET_LOCAL:
+                read_leb_uint32(p, p_end, local_idx);
+                local_type = local_idx < param_count
+                                 ? func->param_types[local_idx]
+                                 : func->local_types[local_idx - param_count];
+                slot_push_local(&slot, func->local_offsets[local_idx], wasm_value_type_cell_num(local_type));
+                continue;
+
+            case EXT_OP_SET_LOCAL_FAST:
+            case EXT_OP_SET_LOCAL_FAST_64:
+            case EXT_OP_TEE_LOCAL_FAST:
+            case EXT_OP_TEE_LOCAL_FAST_64:
+            case WASM_OP_SET_LOCAL:
+            case WASM_OP_TEE_LOCAL:
+            {
+                uint16 local_offset;
+                uint32 pos;
+                bool is_tee = opcode == EXT_OP_TEE_LOCAL_FAST || opcode == EXT_OP_TEE_LOCAL_FAST_64 || opcode == WASM_OP_TEE_LOCAL;
+
+                if (opcode == WASM_OP_SET_LOCAL || opcode == WASM_OP_TEE_LOCAL)
+                {
+                    read_leb_uint32(p, p_end, local_idx);
+                    local_type = local_idx < param_count
+                                     ? func->param_types[local_idx]
+                                     : func->local_types[local_idx - param_count];
+                    local_offset = func->local_offsets[local_idx];
+                    cells = wasm_value_type_cell_num(local_type);
+                }
+                else
+                {
+                    local_offset = *p++;
+                    cells = opcode == EXT_OP_SET_LOCAL_FAST || opcode == EXT_OP_TEE_LOCAL_FAST ? 1 : 2;
+                }
+
+                pos = slot.sp - cells;
+                src = slot_pop(&slot, cells);
+                // 先保存仍引用该局部变量旧值的栈位置
+                if (slot_has_ref(&slot, local_offset))
+                    SLOT_CHECK(slot_flush(&emitter, &slot, local_offset));
+
+                if (src == slot.base + pos && slot.producer_end == emitter.num && slot.producer_pos == pos)
+                {
+                    // 上一条指令直接写入局部变量
+                    emitter.code[slot.producer_cell] = (emitter.code[slot.producer_cell] & ~(uint64)0xFFFF) | local_offset;
+                    slot.producer_end = 0;
+                }
+                else if (src != local_offset)
+                {
+                    EMIT_SLOT_HANDLER(cells == 1 ? EXT_OP_SET_LOCAL_FAST : EXT_OP_SET_LOCAL_FAST_64);
+                    EMIT_CELL(local_offset | ((uint64)src << 16));
+                }
+
+                if (is_tee)
+                    slot_push_local(&slot, local_offset, cells);
+                continue;
+            }
+
+            case WASM_OP_GET_GLOBAL:
+            case WASM_OP_GET_GLOBAL_64:
+            case EXT_OP_GET_GLOBAL:
+            case EXT_OP_GET_GLOBAL_64:
+                if (opcode == WASM_OP_GET_GLOBAL || opcode == WASM_OP_GET_GLOBAL_64)
+                    read_leb_uint32(p, p_end, idx);
+                else
+                    idx = 0;
+                cells = opcode == WASM_OP_GET_GLOBAL || opcode == EXT_OP_GET_GLOBAL ? 1 : 2;
+                dst = slot_push(&slot, cells);
+                EMIT_SLOT_HANDLER(cells == 1 ? WASM_OP_GET_GLOBAL : WASM_OP_GET_GLOBAL_64);
+                EMIT_CELL(dst | ((uint64)globals[idx].data_offset << 32));
+                SLOT_PRODUCER(dst);
+                continue;
+
+            case WASM_OP_SET_GLOBAL:
+            case WASM_OP_SET_GLOBAL_64:
+            case EXT_OP_SET_GLOBAL:
+            case EXT_OP_SET_GLOBAL_64:
+                if (opcode == WASM_OP_SET_GLOBAL || opcode == WASM_OP_SET_GLOBAL_64)
+                    read_leb_uint32(p, p_end, idx);
+                else
+                    idx = 0;
+                cells = opcode == WASM_OP_SET_GLOBAL || opcode == EXT_OP_SET_GLOBAL ? 1 : 2;
+                src = slot_pop(&slot, cells);
+                EMIT_SLOT_HANDLER(cells == 1 ? WASM_OP_SET_GLOBAL : WASM_OP_SET_GLOBAL_64);
+                EMIT_CELL(src | ((uint64)globals[idx].data_offset << 32));
+                continue;
+
+            case WASM_OP_I32_LOAD:
+            case WASM_OP_I64_LOAD:
+            case WASM_OP_F32_LOAD:
+            case WASM_OP_F64_LOAD:
+            case WASM_OP_I32_LOAD8_S:
+            case WASM_OP_I32_LOAD8_U:
+            case WASM_OP_I32_LOAD16_S:
+            case WASM_OP_I32_LOAD16_U:
+            case WASM_OP_I64_LOAD8_S:
+            case WASM_OP_I64_LOAD8_U:
+            case WASM_OP_I64_LOAD16_S:
+            case WASM_OP_I64_LOAD16_U:
+            case WASM_OP_I64_LOAD32_S:
+            case WASM_OP_I64_LOAD32_U:
+                skip_leb_uint32(p, p_end);
+                read_leb_uint32(p, p_end, u32);
+                cells = opcode == WASM_OP_I64_LOAD || opcode == WASM_OP_F64_LOAD || opcode >= WASM_OP_I64_LOAD8_S ? 2 : 1;
+                src = slot_pop(&slot, 1);
+                dst = slot_push(&slot, cells);
+                EMIT_SLOT_HANDLER(opcode);
+                EMIT_CELL(dst | ((uint64)src << 16) | ((uint64)u32 << 32));
+                SLOT_PRODUCER(dst);
+                continue;
+
+            case WASM_OP_I32_STORE:
+            case WASM_OP_I64_STORE:
+            case WASM_OP_F32_STORE:
+            case WASM_OP_F64_STORE:
+            case WASM_OP_I32_STORE8:
+            case WASM_OP_I32_STORE16:
+            case WASM_OP_I64_STORE8:
+            case WASM_OP_I64_STORE16:
+            case WASM_OP_I64_STORE32:
+                skip_leb_uint32(p, p_end);
+                read_leb_uint32(p, p_end, u32);
+                cells = opcode == WASM_OP_I64_STORE || opcode == WASM_OP_F64_STORE || opcode >= WASM_OP_I64_STORE8 ? 2 : 1;
+                src = slot_pop(&slot, cells);
+                idx = slot_pop(&slot, 1);
+                EMIT_SLOT_HANDLER(opcode);
+                EMIT_CELL(src | ((uint64)idx << 16) | ((uint64)u32 << 32));
+                continue;
+
+            case WASM_OP_I32_CONST:
+                read_leb_int32(p, p_end, i32);
+                dst = slot_push(&slot, 1);
+                EMIT_SLOT_HANDLER(WASM_OP_I32_CONST);
+                EMIT_CELL(dst | ((uint64)(uint32)i32 << 32));
+                SLOT_PRODUCER(dst);
+                continue;
+
+            case WASM_OP_F32_CONST:
+                memcpy(&u32, p, sizeof(uint32));
+                p += sizeof(float32);
+                dst = slot_push(&slot, 1);
+                EMIT_SLOT_HANDLER(WASM_OP_I32_CONST);
+                EMIT_CELL(dst | ((uint64)u32 << 32));
+                SLOT_PRODUCER(dst);
+                continue;
+
+            case WASM_OP_I64_CONST:
+            case WASM_OP_F64_CONST:
+                if (opcode == WASM_OP_I64_CONST)
+                {
+                    read_leb_int64(p, p_end, i64);
+                }
+                else
+                {
+                    memcpy(&i64, p, sizeof(int64));
+                    p += sizeof(float64);
+                }
+                dst = slot_push(&slot, 2);
+                EMIT_SLOT_HANDLER(WASM_OP_I64_CONST);
+                EMIT_CELL(dst);
+                SLOT_PRODUCER(dst);
+                EMIT_CELL(i64);
+                slot.producer_end = emitter.num;
+                continue;
+
+            default:
+                if (slot_table[opcode] && (arity = slot_numeric_cells(opcode, &in, &out)))
+                {
+                    src = arity == 2 ? slot_pop(&slot, in) : 0;
+                    idx = slot_pop(&slot, in);
+                    dst = slot_push(&slot, out);
+                    EMIT_SLOT_HANDLER(opcode);
+                    EMIT_CELL(dst | ((uint64)idx << 16) | ((uint64)src << 32));
+                    SLOT_PRODUCER(dst);
+                    continue;
+                }
+                break;
+            }
+
+            // 其余指令使用栈式处理, 操作数需全部位于栈槽中
+            SLOT_CHECK(slot_flush(&emitter, &slot, SLOT_REAL));
+            SLOT_CHECK(slot_sync_sp(&emitter, &slot));
+        }
+#endif
+
+        ir_start = emitter.num;
+        fixup_mark = fixup_num;
+
+        switch (opcode)
+        {
+        // 控制块本身不产生指令
+        case WASM_OP_NOP:
+            break;
+
+        case WASM_OP_BLOCK:
+        case WASM_OP_LOOP:
+        case WASM_OP_IF:
+            if (*p == VALUE_TYPE_VOID || is_value_type(*p))
+                p++;
+            else
+                skip_leb_int32(p, p_end);
+
+            if (opcode == WASM_OP_IF)
+            {
+                EMIT_HANDLER(WASM_OP_IF);
+                fixups[fixup_num++] = emitter.num;
+                EMIT_CELL(branch->ip - code);
+                branch++;
+            }
+#if WASM_ENABLE_TIERED_JIT != 0
+            else if (opcode == WASM_OP_LOOP)
+            {
+                EMIT_LOOP_HOTNESS();
+            }
+#endif
+            break;
+
+        case WASM_OP_ELSE:
+            EMIT_HANDLER(WASM_OP_ELSE);
+            fixups[fixup_num++] = emitter.num;
+            EMIT_CELL(branch->ip - code);
+            branch++;
+            break;
+
+        case WASM_OP_END:
+            // 只有函数末尾的end需要返回
+            if (p == p_end)
+            {
+                EMIT_HANDLER(WASM_OP_RETURN);
+                EMIT_RETURN_CELLS();
+            }
+            break;
+
+        case WASM_OP_RETURN:
+            EMIT_HANDLER(WASM_OP_RETURN);
+            EMIT_RETURN_CELLS();
+            break;
+
+        case WASM_OP_BR:
+        case WASM_OP_BR_IF:
+            skip_leb_uint32(p, p_end);
+            EMIT_HANDLER(opcode);
+            EMIT_BRANCH_TARGET(branch);
+            branch++;
+            break;
+
+        case WASM_OP_BR_TABLE:
+            read_leb_uint32(p, p_end, count);
+            EMIT_HANDLER(WASM_OP_BR_TABLE);
+            EMIT_CELL(count);
+            for (i = 0; i <= count; i++)
+            {
+                skip_leb_uint32(p, p_end);
+                EMIT_BRANCH_TARGET(branch);
+                branch++;
+            }
+            break;
+
+        case WASM_OP_CALL:
+            read_leb_uint32(p, p_end, idx);
+            EMIT_HANDLER(WASM_OP_CALL);
+            EMIT_POINTER(module->functions + idx);
+            break;
+
+        case WASM_OP_CALL_INDIRECT:
+            read_leb_uint32(p, p_end, idx);
+            read_leb_uint32(p, p_end, u32);
+            EMIT_HANDLER(WASM_OP_CALL_INDIRECT);
+            EMIT_CELL(module->types[idx]->type_id);
+            EMIT_CELL(u32);
+            EMIT_INDIRECT_CACHE();
+            break;
+
+        // 尾调用需要找到当前栈帧的头部, 因此与return一样带上帧布局
+        case WASM_OP_RETURN_CALL:
+            read_leb_uint32(p, p_end, idx);
+            EMIT_HANDLER(WASM_OP_RETURN_CALL);
+            EMIT_POINTER(module->functions + idx);
+            EMIT_RETURN_CELLS();
+            break;
+
+        case WASM_OP_RETURN_CALL_INDIRECT:
+            read_leb_uint32(p, p_end, idx);
+            read_leb_uint32(p, p_end, u32);
+            EMIT_HANDLER(WASM_OP_RETURN_CALL_INDIRECT);
+            EMIT_CELL(module->types[idx]->type_id);
+            EMIT_CELL(u32);
+            EMIT_INDIRECT_CACHE();
+            EMIT_RETURN_CELLS();
+            break;
+
+        case EXT_OP_GET_LOCAL_FAST:
+        case EXT_OP_GET_LOCAL_FAST_64:
+        case EXT_OP_SET_LOCAL_FAST:
+        case EXT_OP_SET_LOCAL_FAST_64:
+        case EXT_OP_TEE_LOCAL_FAST:
+        case EXT_OP_TEE_LOCAL_FAST_64:
+            EMIT_HANDLER(opcode);
+            EMIT_CELL(*p++);
+            break;
+
+        // 偏移量过大的局部变量同样转换为fast指令
+        case WASM_OP_GET_LOCAL:
+        case WASM_OP_SET_LOCAL:
+        case WASM_OP_TEE_LOCAL:
+            read_leb_uint32(p, p_end, local_idx);
+            local_type = local_idx < param_count
+                             ? func->param_types[local_idx]
+                             : func->local_types[local_idx - param_count];
+            if (local_type == VALUE_TYPE_I32 || local_type == VALUE_TYPE_F32)
+            {
+                EMIT_HANDLER(opcode == WASM_OP_GET_LOCAL   ? EXT_OP_GET_LOCAL_FAST
+                             : opcode == WASM_OP_SET_LOCAL ? EXT_OP_SET_LOCAL_FAST
+                                                           : EXT_OP_TEE_LOCAL_FAST);
+            }
+            else
+            {
+                EMIT_HANDLER(opcode == WASM_OP_GET_LOCAL   ? EXT_OP_GET_LOCAL_FAST_64
+                             : opcode == WASM_OP_SET_LOCAL ? EXT_OP_SET_LOCAL_FAST_64
+                                                           : EXT_OP_TEE_LOCAL_FAST_64);
+            }
+            EMIT_CELL(func->local_offsets[local_idx]);
+            break;
+
+        case WASM_OP_GET_GLOBAL:
+        case WASM_OP_SET_GLOBAL:
+        case WASM_OP_GET_GLOBAL_64:
+        case WASM_OP_SET_GLOBAL_64:
+            read_leb_uint32(p, p_end, idx);
+            EMIT_HANDLER(opcode);
+            EMIT_CELL(globals[idx].data_offset);
+            break;
+
+        case WASM_OP_I32_LOAD:
+        case WASM_OP_I64_LOAD:
+        case WASM_OP_F32_LOAD:
+        case WASM_OP_F64_LOAD:
+        case WASM_OP_I32_LOAD8_S:
+        case WASM_OP_I32_LOAD8_U:
+        case WASM_OP_I32_LOAD16_S:
+        case WASM_OP_I32_LOAD16_U:
+        case WASM_OP_I64_LOAD8_S:
+        case WASM_OP_I64_LOAD8_U:
+        case WASM_OP_I64_LOAD16_S:
+        case WASM_OP_I64_LOAD16_U:
+        case WASM_OP_I64_LOAD32_S:
+        case WASM_OP_I64_LOAD32_U:
+        case WASM_OP_I32_STORE:
+        case WASM_OP_I64_STORE:
+        case WASM_OP_F32_STORE:
+        case WASM_OP_F64_STORE:
+        case WASM_OP_I32_STORE8:
+        case WASM_OP_I32_STORE16:
+        case WASM_OP_I64_STORE8:
+        case WASM_OP_I64_STORE16:
+        case WASM_OP_I64_STORE32:
+            // 对齐信息对解释器无用
+            skip_leb_uint32(p, p_end);
+            read_leb_uint32(p, p_end, u32);
+            EMIT_HANDLER(opcode);
+            EMIT_CELL(u32);
+            break;
+
+        case WASM_OP_MEMORY_SIZE:
+        case WASM_OP_MEMORY_GROW:
+            p++;
+            EMIT_HANDLER(opcode);
+            break;
+
+        case WASM_OP_I32_CONST:
+            read_leb_int32(p, p_end, i32);
+            EMIT_HANDLER(WASM_OP_I32_CONST);
+            EMIT_CELL((uint32)i32);
+            break;
+
+        case WASM_OP_I64_CONST:
+            read_leb_int64(p, p_end, i64);
+            EMIT_HANDLER(WASM_OP_I64_CONST);
+            EMIT_CELL(i64);
+            break;
+
+        case WASM_OP_F32_CONST:
+            memcpy(&u32, p, sizeof(uint32));
+            p += sizeof(float32);
+            EMIT_HANDLER(WASM_OP_F32_CONST);
+            EMIT_CELL(u32);
+            break;
+
+        case WASM_OP_F64_CONST:
+            memcpy(&i64, p, sizeof(int64));
+            p += sizeof(float64);
+            EMIT_HANDLER(WASM_OP_F64_CONST);
+            EMIT_CELL(i64);
+            break;
+
+        case WASM_OP_MISC_PREFIX:
+        {
+            uint32 opcode1;
+
+            read_leb_uint32(p, p_end, opcode1);
+            EMIT_HANDLER(WASM_OP_MISC_PREFIX);
+            EMIT_CELL(opcode1);
+            switch (opcode1)
+            {
+            case WASM_OP_MEMORY_INIT:
+                read_leb_uint32(p, p_end, idx);
+                p++;
+                EMIT_CELL(idx);
+                break;
+            case WASM_OP_DATA_DROP:
+                read_leb_uint32(p, p_end, idx);
+                EMIT_CELL(idx);
+                break;
+            case WASM_OP_MEMORY_COPY:
+                p += 2;
+                break;
+            case WASM_OP_MEMORY_FILL:
+                p++;
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+
+        // 其余指令没有立即数
+        default:
+            EMIT_HANDLER(opcode);
+            break;
+        }
+
+        if (emitter.num > ir_start)
+        {
+#if WASM_ENABLE_OPCODE_PROFILE != 0
+            // 在指令前插入计数指令, 之后的处理针对其后的原指令
+            EMIT_CELL(0);
+            EMIT_CELL(0);
+            memmove(emitter.code + ir_start + 2, emitter.code + ir_start, (emitter.num - ir_start - 2) * sizeof(uint64));
+            emitter.code[ir_start] = (uintptr_t)handle_table[EXT_OP_PROFILE];
+            emitter.code[ir_start + 1] = ir_opcode;
+            for (i = fixup_mark; i < fixup_num; i++)
+                fixups[i] += 2;
+            ir_start += 2;
+#endif
+            // 与紧邻的上一条指令合并, 本条的操作数直接接在其后
+            if (super_end == ir_start && (fused = super_instr_lookup(super_op, ir_opcode)))
+            {
+                emitter.code[super_pos] = (uintptr_t)handle_table[fused];
+                memmove(emitter.code + ir_start, emitter.code + ir_start + 1, (emitter.num - ir_start - 1) * sizeof(uint64));
+                emitter.num--;
+                for (i = fixup_mark; i < fixup_num; i++)
+                    fixups[i]--;
+                super_op = fused;
+#if WASM_ENABLE_TOS_CACHE != 0
+                // 超级指令只有栈式处理, 进入前栈顶需已写回
+                if (tos_mode)
+                {
+                    tos_spill(&emitter, handle_table, &tos_prev);
+                    tos_last.opcode = fused;
+                    tos_last.in = tos_last.out = 0;
+                }
+#endif
+            }
+            else
+            {
+                super_pos = ir_start;
+                super_op = ir_opcode;
+#if WASM_ENABLE_TOS_CACHE != 0
+                if (tos_mode)
+                    tos_emit(&emitter, handle_table, &tos_last, &tos_prev, ir_start, ir_opcode);
+#endif
+            }
+            super_end = emitter.num;
+        }
+
+        // 块边界之后的指令可能是跳转目标, 不能与之前的指令合并, 栈顶也需已写回
+        if (opcode == WASM_OP_BLOCK || opcode == WASM_OP_LOOP || opcode == WASM_OP_ELSE || opcode == WASM_OP_END)
+        {
+            super_end = SUPER_NONE;
+#if WASM_ENABLE_TOS_CACHE != 0
+            if (tos_mode)
+            {
+                tos_spill(&emitter, handle_table, &tos_last);
+                tos_last.pos = SUPER_NONE;
+            }
+#endif
+        }
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+        if (slot_mode && opcode != WASM_OP_NOP)
+        {
+            if (dead)
+            {
+                emitter.num = dead_mark;
+                fixup_num = dead_fixup_mark;
+            }
+            else if (opcode == WASM_OP_UNREACHABLE || opcode == WASM_OP_RETURN_CALL || opcode == WASM_OP_RETURN_CALL_INDIRECT)
+            {
+                dead = true;
+                dead_depth = 0;
+            }
+            else if (opcode == WASM_OP_CALL || opcode == WASM_OP_CALL_INDIRECT || p == p_end)
+            {
+                slot.synced_sp = SLOT_SP_UNKNOWN;
+            }
+            else
+            {
+                slot.synced_sp = heights[p - code];
+            }
+        }
+#endif
+    }
+    ir_offsets[code_size] = emitter.num;
+
+    for (i = 0; i < fixup_num; i++)
+    {
+        uint64 *cell = emitter.code + fixups[i];
+        *cell = (uint64)(uintptr_t)(emitter.code + ir_offsets[*cell]);
+    }
+
+    func->ir_code = emitter.code;
+
+    wasm_runtime_free(ir_offsets);
+    if (fixups)
+        wasm_runtime_free(fixups);
+#if WASM_ENABLE_SLOT_INTERP != 0
+    if (slot.lazy)
+        wasm_runtime_free(slot.lazy);
+    if (slot.lazy_cells)
+        wasm_runtime_free(slot.lazy_cells);
+#endif
+    return true;
+
+fail:
+    wasm_set_exception(module, "allocate memory failed");
+    if (emitter.code)
+        wasm_runtime_free(emitter.code);
+    if (ir_offsets)
+        wasm_runtime_free(ir_offsets);
+    if (fixups)
+        wasm_runtime_free(fixups);
+#if WASM_ENABLE_SLOT_INTERP != 0
+    if (slot.lazy)
+        wasm_runtime_free(slot.lazy);
+    if (slot.lazy_cells)
+        wasm_runtime_free(slot.lazy_cells);
+#endif
+    return false;
+}
@@ -0,0 +1,143 @@
+#include "wasm_local_validator.h"
+
+// 以位图表示局部变量的集合, 不含参数, 依次为当前位置已确定赋值的变量, 可能在赋值前被读取的变量,
+// 以及每层控制块进入时和到达end时已确定赋值的变量
+#define LOCAL_SET(ctx, idx) ((ctx)->local_sets + (idx) * (ctx)->local_set_words)
+#define LOCAL_SET_CUR(ctx) LOCAL_SET(ctx, 0)
+#define LOCAL_SET_READ(ctx) LOCAL_SET(ctx, 1)
+#define LOCAL_SET_ENTRY(ctx, depth) LOCAL_SET(ctx, 2 + (depth) * 2)
+#define LOCAL_SET_END(ctx, depth) LOCAL_SET(ctx, 3 + (depth) * 2)
+
+static inline void
+local_set_fill(uint32 *set, uint32 words)
+{
+    memset(set, 0xFF, words * sizeof(uint32));
+}
+
+static inline void
+local_set_and(uint32 *dst, const uint32 *src, uint32 words)
+{
+    uint32 i;
+
+    for (i = 0; i < words; i++)
+        dst[i] &= src[i];
+}
+
+bool wasm_validator_local_init(WASMValidator *ctx, uint32 local_count)
+{
+    ctx->local_set_words = (local_count + 31) / 32;
+    ctx->local_set_depth = 0;
+    ctx->local_sets = NULL;
+
+    // 没有局部变量时不需要分析
+    if (!ctx->local_set_words)
+        return true;
+
+    if (!(ctx->local_sets = wasm_runtime_malloc(2 * ctx->local_set_words * sizeof(uint32))))
+        return false;
+    memset(ctx->local_sets, 0, 2 * ctx->local_set_words * sizeof(uint32));
+    return true;
+}
+
+bool wasm_validator_local_push_block(WASMValidator *ctx)
+{
+    uint32 depth = ctx->block_stack_num - 1, words = ctx->local_set_words;
+
+    if (!words)
+        return true;
+
+    if (depth >= ctx->local_set_depth)
+    {
+        uint32 *sets = wasm_runtime_realloc(
+            ctx->local_sets,
+            (2 + (ctx->local_set_depth + 8) * 2) * words * sizeof(uint32));
+        if (!sets)
+            return false;
+        ctx->local_sets = sets;
+        ctx->local_set_depth += 8;
+    }
+
+    memcpy(LOCAL_SET_ENTRY(ctx, depth), LOCAL_SET_CUR(ctx), words * sizeof(uint32));
+    local_set_fill(LOCAL_SET_END(ctx, depth), words);
+    return true;
+}
+
+// 跳转到外层块的end时, 该块结束处的集合与当前集合取交集, 跳转到loop开头不影响
+void wasm_validator_local_branch(WASMValidator *ctx, uint32 depth)
+{
+    BranchBlock *target = ctx->block_stack - depth - 1;
+
+    if (!ctx->local_set_words || target->label_type == LABEL_TYPE_LOOP)
+        return;
+
+    local_set_and(LOCAL_SET_END(ctx, ctx->block_stack_num - depth - 1),
+                  LOCAL_SET_CUR(ctx), ctx->local_set_words);
+}
+
+// 不可达代码中的读取不会发生, 视为所有变量都已赋值
+void wasm_validator_local_unreachable(WASMValidator *ctx)
+{
+    if (ctx->local_set_words)
+        local_set_fill(LOCAL_SET_CUR(ctx), ctx->local_set_words);
+}
+
+// then分支结束后回到if进入时的状态
+void wasm_validator_local_else(WASMValidator *ctx)
+{
+    uint32 depth = ctx->block_stack_num - 1, words = ctx->local_set_words;
+
+    if (!words)
+        return;
+
+    local_set_and(LOCAL_SET_END(ctx, depth), LOCAL_SET_CUR(ctx), words);
+    memcpy(LOCAL_SET_CUR(ctx), LOCAL_SET_ENTRY(ctx, depth), words * sizeof(uint32));
+}
+
+// 没有else的if在条件为假时直接从进入时的状态到达end
+void wasm_validator_local_end(WASMValidator *ctx, bool missing_else)
+{
+    uint32 depth = ctx->block_stack_num - 1, words = ctx->local_set_words;
+
+    if (!words)
+        return;
+
+    if (missing_else)
+        local_set_and(LOCAL_SET_END(ctx, depth), LOCAL_SET_ENTRY(ctx, depth), words);
+    local_set_and(LOCAL_SET_CUR(ctx), LOCAL_SET_END(ctx, depth), words);
+}
+
+void wasm_validator_local_get(WASMValidator *ctx, uint32 local_idx)
+{
+    uint32 *cur = LOCAL_SET_CUR(ctx);
+
+    if (!(cur[local_idx / 32] & (1u << (local_idx % 32))))
+        LOCAL_SET_READ(ctx)[local_idx / 32] |= 1u << (local_idx % 32);
+}
+
+void wasm_validator_local_set(WASMValidator *ctx, uint32 local_idx)
+{
+    LOCAL_SET_CUR(ctx)[local_idx / 32] |= 1u << (local_idx % 32);
+}
+
+// 需要清零的变量合并为一段连续范围, 调用时只需一次memset
+void wasm_validator_local_finish(WASMValidator *ctx, WASMFunction *func)
+{
+    uint32 *read = LOCAL_SET_READ(ctx);
+    uint32 i, offset, begin = UINT32_MAX, end = 0;
+
+    for (i = 0; i < func->local_count; i++)
+    {
+        if (!(read[i / 32] & (1u << (i % 32))))
+            continue;
+
+        offset = func->local_offsets[func->param_count + i];
+        if (offset < begin)
+            begin = offset;
+        offset += wasm_value_type_cell_num(func->local_types[i]);
+        if (offset > end)
+            end = offset;
+    }
+
+    func->zero_cell_offset = end ? (uint16)begin : 0;
+    func->zero_cell_num = end ? (uint16)(end - begin) : 0;
+}
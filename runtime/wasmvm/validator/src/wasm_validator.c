@@ -3,6 +3,8 @@
 #include "wasm_leb_validator.h"
 #include "wasm_block_validator.h"
 #include "wasm_stack_validator.h"
+#include "wasm_local_validator.h"
+#include "wasm_ir_emitter.h"
 
 #if WASM_ENABLE_JIT != 0
 #define ADD_EXTINFO(res)                                          \
@@ -11,8 +13,8 @@
         ExtInfo *_op_info = wasm_runtime_malloc(sizeof(ExtInfo)); \
         _op_info->next_op = NULL;                                 \
         _op_info->idx = res;                                      \
-        func->last_op_info->next_op = _op_info;                   \
-        func->last_op_info = _op_info;                            \
+        func->jit->last_op_info->next_op = _op_info;              \
+        func->jit->last_op_info = _op_info;                       \
     } while (0)
 
 #define INIT_BLOCK_IN_FUNCTION()                                    \
@@ -22,32 +24,47 @@
         _block->next_block = NULL;                                  \
         _block->pre_block = NULL;                                   \
         _block->is_set = false;                                     \
-        func->blocks = func->last_block = _block;                   \
+        _block->has_else = false;                                   \
+        func->jit->blocks = func->jit->last_block = _block;         \
     } while (0)
 
 #define ADD_BLOCK_IN_FUNCTION()                                     \
     do                                                              \
     {                                                               \
         WASMBlock *_block = wasm_runtime_malloc(sizeof(WASMBlock)); \
-        _block->pre_block = func->last_block;                       \
+        _block->pre_block = func->jit->last_block;                  \
         _block->next_block = NULL;                                  \
         _block->is_set = false;                                     \
-        func->last_block->next_block = _block;                      \
-        func->last_block = _block;                                  \
+        _block->has_else = false;                                   \
+        func->jit->last_block->next_block = _block;                 \
+        func->jit->last_block = _block;                             \
     } while (0)
 
-#define SET_BLOCK_IN_FUNCTION(cur_block)          \
-    do                                            \
-    {                                             \
-        WASMBlock *_block = func->last_block;     \
-        while (_block->is_set)                    \
-        {                                         \
-            _block = _block->pre_block;           \
-        }                                         \
-        _block->is_set = true;                    \
-        _block->stack_num = cur_block->stack_num; \
-        _block->else_addr = cur_block->else_addr; \
-        _block->end_addr = cur_block->end_addr;   \
+#define SET_BLOCK_IN_FUNCTION(cur_block)               \
+    do                                                 \
+    {                                                  \
+        WASMBlock *_block = func->jit->last_block;     \
+        while (_block->is_set)                         \
+        {                                              \
+            _block = _block->pre_block;                \
+        }                                              \
+        _block->is_set = true;                         \
+        _block->stack_num = cur_block->stack_num;      \
+        _block->else_addr = cur_block->else_addr;      \
+        _block->end_addr = cur_block->end_addr;        \
+        _block->end_op_info = func->jit->last_op_info; \
+    } while (0)
+
+#define SET_BLOCK_ELSE_IN_FUNCTION()                    \
+    do                                                  \
+    {                                                   \
+        WASMBlock *_block = func->jit->last_block;      \
+        while (_block->is_set)                          \
+        {                                               \
+            _block = _block->pre_block;                 \
+        }                                               \
+        _block->else_op_info = func->jit->last_op_info; \
+        _block->has_else = true;                        \
     } while (0)
 #endif
 
@@ -384,6 +401,12 @@ fail:
 #define BLOCK_HAS_PARAM(block_type) \
     (!block_type.is_value_type && block_type.u.type->param_count > 0)
 
+// 实例化会把各数量改为包含导入项, 延迟验证可能发生在实例化之后
+#define MODULE_TOTAL_COUNT(module, kind)      \
+    ((module)->module_stage >= Compile        \
+         ? (module)->kind##_count             \
+         : (module)->import_##kind##_count + (module)->kind##_count)
+
 static bool
 check_table_index(WASMModule *module, uint32 table_index)
 {
@@ -393,7 +416,7 @@ check_table_index(WASMModule *module, uint32 table_index)
         return false;
     }
 
-    if (table_index >= module->import_table_count + module->table_count)
+    if (table_index >= MODULE_TOTAL_COUNT(module, table))
     {
         wasm_set_exception(module, "unknown table");
         return false;
@@ -404,7 +427,7 @@ check_table_index(WASMModule *module, uint32 table_index)
 static bool
 check_function_index(WASMModule *module, uint32 function_index)
 {
-    if (function_index >= module->import_function_count + module->function_count)
+    if (function_index >= MODULE_TOTAL_COUNT(module, function))
     {
         wasm_set_exception(module, "unknown function");
         return false;
@@ -425,6 +448,20 @@ wasm_loader_ctx_destroy(WASMValidator *ctx)
         {
             wasm_runtime_free(ctx->block_stack_bottom);
         }
+        if (ctx->branch_table_bottom)
+        {
+            wasm_runtime_free(ctx->branch_table_bottom);
+        }
+        if (ctx->local_sets)
+        {
+            wasm_runtime_free(ctx->local_sets);
+        }
+#if WASM_ENABLE_SLOT_INTERP != 0
+        if (ctx->stack_heights)
+        {
+            wasm_runtime_free(ctx->stack_heights);
+        }
+#endif
         wasm_runtime_free(ctx);
     }
 }
@@ -460,6 +497,14 @@ wasm_loader_ctx_init()
     loader_ctx->branch_table_size = 0;
     loader_ctx->branch_table_bottom = NULL;
 
+    loader_ctx->local_sets = NULL;
+    loader_ctx->local_set_words = 0;
+    loader_ctx->local_set_depth = 0;
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+    loader_ctx->stack_heights = NULL;
+#endif
+
     return loader_ctx;
 
 fail:
@@ -467,6 +512,15 @@ fail:
     return NULL;
 }
 
+static void
+wasm_validator_release_code_copy(WASMFunction *func, uint8 *code_org)
+{
+    func->code_end = code_org + (func->code_end - (uint8 *)func->func_ptr);
+    func->func_ptr = code_org;
+    wasm_runtime_free(func->code_copy);
+    func->code_copy = NULL;
+}
+
 bool wasm_validator_code(WASMModule *module, WASMFunction *func)
 {
     uint8 *p = (uint8 *)func->func_ptr, *p_end = func->code_end, *p_org;
@@ -481,8 +535,25 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
     uint8 opcode;
     WASMValidator *loader_ctx;
     BranchBlock *frame_csp_tmp;
+    uint8 *code_org = NULL;
 
-    global_count = module->import_global_count + module->global_count;
+    // 只读映射的函数体不能原地改写指令, 在副本上验证
+    if (module->code_read_only)
+    {
+        if (!(func->code_copy = wasm_runtime_malloc((uint32)(p_end - p) + 1)))
+        {
+            wasm_set_exception(module, "malloc error");
+            return false;
+        }
+        memcpy(func->code_copy, p, (uint32)(p_end - p));
+        code_org = p;
+        p_end = func->code_copy + (p_end - p);
+        p = func->code_copy;
+        func->func_ptr = p;
+        func->code_end = p_end;
+    }
+
+    global_count = MODULE_TOTAL_COUNT(module, global);
 
     param_count = func->param_count;
     param_types = func->func_type->param;
@@ -497,16 +568,40 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
     if (!(loader_ctx = wasm_loader_ctx_init()))
         goto fail;
 
+    if (!wasm_validator_local_init(loader_ctx, local_count))
+        goto fail;
+
+#if WASM_ENABLE_SLOT_INTERP != 0
+    // 槽位模式根据栈高度为每个操作数分配固定位置
+    if (!(loader_ctx->stack_heights = wasm_runtime_malloc((uint32)(p_end - p + 1) * sizeof(uint32))))
+        goto fail;
+    memset(loader_ctx->stack_heights, 0, (uint32)(p_end - p + 1) * sizeof(uint32));
+#endif
+
     PUSH_BLOCK(loader_ctx, LABEL_TYPE_FUNCTION, func_block_type, p);
 
 #if WASM_ENABLE_JIT != 0
+    if (!(func->jit = wasm_runtime_malloc(sizeof(WASMFunctionJIT))))
+    {
+        wasm_set_exception(module, "malloc error");
+        goto fail;
+    }
+    memset(func->jit, 0, sizeof(WASMFunctionJIT));
     INIT_BLOCK_IN_FUNCTION();
     ADD_BLOCK_IN_FUNCTION();
-    func->op_info = func->last_op_info = wasm_runtime_malloc(sizeof(ExtInfo));
+    if (!(func->jit->op_info = func->jit->last_op_info = wasm_runtime_malloc(sizeof(ExtInfo))))
+    {
+        wasm_set_exception(module, "malloc error");
+        goto fail;
+    }
+    func->jit->op_info->next_op = NULL;
 #endif
 
     while (p < p_end)
     {
+#if WASM_ENABLE_SLOT_INTERP != 0
+        loader_ctx->stack_heights[p - (uint8 *)func->func_ptr] = loader_ctx->stack_cell_num;
+#endif
         opcode = *p++;
 
         switch (opcode)
@@ -514,6 +609,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
         case WASM_OP_UNREACHABLE:
             RESET_STACK();
             SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(true);
+            wasm_validator_local_unreachable(loader_ctx);
             break;
 
         case WASM_OP_NOP:
@@ -596,6 +692,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
 
             RESET_STACK();
             SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(false);
+            wasm_validator_local_else(loader_ctx);
 
             if (BLOCK_HAS_PARAM(block_type))
             {
@@ -606,6 +703,10 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             if (!wasm_emit_branch_table(loader_ctx, WASM_OP_ELSE, 0))
                 goto fail;
 
+#if WASM_ENABLE_JIT != 0
+            SET_BLOCK_ELSE_IN_FUNCTION();
+#endif
+
             break;
         }
 
@@ -616,6 +717,8 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             if (!check_block_stack(module, loader_ctx, cur_block))
                 goto fail;
 
+            wasm_validator_local_end(loader_ctx, cur_block->label_type == LABEL_TYPE_IF && !cur_block->else_addr);
+
             if (cur_block->label_type == LABEL_TYPE_IF && !cur_block->else_addr)
             {
                 uint32 block_param_count = 0, block_ret_count = 0;
@@ -673,8 +776,10 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                 goto fail;
             if (!wasm_emit_branch_table(loader_ctx, WASM_OP_BR, depth))
                 goto fail;
+            wasm_validator_local_branch(loader_ctx, depth);
             RESET_STACK();
             SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(true);
+            wasm_validator_local_unreachable(loader_ctx);
             break;
         }
 
@@ -687,6 +792,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                 goto fail;
             if (!wasm_emit_branch_table(loader_ctx, WASM_OP_BR_IF, depth))
                 goto fail;
+            wasm_validator_local_branch(loader_ctx, depth);
 
             break;
         }
@@ -708,6 +814,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                     goto fail;
                 if (!wasm_emit_branch_table(loader_ctx, WASM_OP_BR_TABLE, depth))
                     goto fail;
+                wasm_validator_local_branch(loader_ctx, depth);
 
                 frame_csp_tmp = loader_ctx->block_stack - depth - 1;
 
@@ -740,6 +847,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
 
             RESET_STACK();
             SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(true);
+            wasm_validator_local_unreachable(loader_ctx);
             break;
         }
 
@@ -756,6 +864,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
 
             RESET_STACK();
             SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(true);
+            wasm_validator_local_unreachable(loader_ctx);
             break;
         }
 
@@ -793,7 +902,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             int32 idx;
             WASMType *func_type;
 #if WASM_ENABLE_JIT != 0
-            func->has_op_call_indirect = true;
+            func->jit->has_op_call_indirect = true;
 #endif
             validate_leb_uint32(p, p_end, type_idx);
             validate_leb_uint32(p, p_end, table_idx);
@@ -828,6 +937,69 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             break;
         }
 
+        case WASM_OP_RETURN_CALL:
+        case WASM_OP_RETURN_CALL_INDIRECT:
+        {
+            WASMType *func_type;
+            int32 idx;
+
+            if (opcode == WASM_OP_RETURN_CALL)
+            {
+                validate_leb_uint32(p, p_end, func_idx);
+                if (!check_function_index(module, func_idx))
+                {
+                    goto fail;
+                }
+
+                func_type = module->functions[func_idx].func_type;
+            }
+            else
+            {
+#if WASM_ENABLE_JIT != 0
+                func->jit->has_op_call_indirect = true;
+#endif
+                validate_leb_uint32(p, p_end, type_idx);
+                validate_leb_uint32(p, p_end, table_idx);
+                if (!check_table_index(module, table_idx))
+                {
+                    goto fail;
+                }
+
+                POP_I32();
+
+                if (type_idx >= module->type_count)
+                {
+                    wasm_set_exception(module, "unknown type");
+                    goto fail;
+                }
+
+                func_type = module->types[type_idx];
+            }
+
+            // 被调用函数的结果直接作为当前函数的结果返回
+            if (func_type->result_count != func->result_count || (func->result_count && 0 != memcmp(func_type->result, func->result_types, func->result_count)))
+            {
+                wasm_set_exception(module,
+                                   "type mismatch: tail call results must "
+                                   "match the caller's results");
+                goto fail;
+            }
+
+            if (func_type->param_count > 0)
+            {
+                for (idx = (int32)(func_type->param_count - 1); idx >= 0;
+                     idx--)
+                {
+                    POP_TYPE(func_type->param[idx]);
+                }
+            }
+
+            RESET_STACK();
+            SET_CUR_BLOCK_STACK_POLYMORPHIC_STATE(true);
+            wasm_validator_local_unreachable(loader_ctx);
+            break;
+        }
+
         case WASM_OP_DROP:
         {
             uint8 type = *(loader_ctx->value_stack - 1);
@@ -860,6 +1032,8 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             p_org = p - 1;
             GET_LOCAL_INDEX_TYPE_AND_OFFSET();
             PUSH_TYPE(local_type);
+            if (local_idx >= param_count)
+                wasm_validator_local_get(loader_ctx, local_idx - param_count);
 #if WASM_ENABLE_JIT != 0
             ADD_EXTINFO(local_idx);
 #endif
@@ -887,6 +1061,8 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             p_org = p - 1;
             GET_LOCAL_INDEX_TYPE_AND_OFFSET();
             POP_TYPE(local_type);
+            if (local_idx >= param_count)
+                wasm_validator_local_set(loader_ctx, local_idx - param_count);
 #if WASM_ENABLE_JIT != 0
             ADD_EXTINFO(local_idx);
 #endif
@@ -914,6 +1090,8 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
             p_org = p - 1;
             GET_LOCAL_INDEX_TYPE_AND_OFFSET();
             POP_TYPE(local_type);
+            if (local_idx >= param_count)
+                wasm_validator_local_set(loader_ctx, local_idx - param_count);
             PUSH_TYPE(local_type);
 
 #if WASM_ENABLE_JIT != 0
@@ -1057,7 +1235,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
         {
             CHECK_MEMORY();
 #if WASM_ENABLE_JIT != 0
-            func->has_op_memory = true;
+            func->jit->has_op_memory = true;
 #endif
             validate_leb_uint32(p, p_end, align);      /* align */
             validate_leb_uint32(p, p_end, mem_offset); /* offset */
@@ -1431,7 +1609,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                 if (module->data_seg_count1 == 0)
                     goto fail_data_cnt_sec_require;
 #if WASM_ENABLE_JIT != 0
-                func->has_op_memory = true;
+                func->jit->has_op_memory = true;
 #endif
                 POP_I32();
                 POP_I32();
@@ -1460,7 +1638,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                 if (module->import_memory_count == 0 && module->memory_count == 0)
                     goto fail_unknown_memory;
 #if WASM_ENABLE_JIT != 0
-                func->has_op_memory = true;
+                func->jit->has_op_memory = true;
 #endif
                 POP_I32();
                 POP_I32();
@@ -1478,7 +1656,7 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
                     goto fail_unknown_memory;
                 }
 #if WASM_ENABLE_JIT != 0
-                func->has_op_memory = true;
+                func->jit->has_op_memory = true;
 #endif
                 POP_I32();
                 POP_I32();
@@ -1518,14 +1696,29 @@ bool wasm_validator_code(WASMModule *module, WASMFunction *func)
         goto fail;
     }
 
-    func->branch_table = loader_ctx->branch_table_bottom;
     func->max_stack_cell_num = loader_ctx->max_stack_cell_num;
     func->max_block_num = loader_ctx->max_block_stack_num;
     func->max_stack_num = loader_ctx->max_stack_num;
+    wasm_validator_local_finish(loader_ctx, func);
+
+#if WASM_ENABLE_JIT == 0 || WASM_ENABLE_TIERED_JIT != 0
+    // 跳转表只在生成预解码指令时使用
+    if (!wasm_validator_emit_ir(module, loader_ctx, func))
+        goto fail;
+#endif
+
+    wasm_loader_ctx_destroy(loader_ctx);
+#if WASM_ENABLE_JIT == 0
+    // 解释器只执行预解码指令, 副本用完即释放
+    if (code_org)
+        wasm_validator_release_code_copy(func, code_org);
+#endif
     return true;
 
 fail:
     wasm_loader_ctx_destroy(loader_ctx);
+    if (code_org)
+        wasm_validator_release_code_copy(func, code_org);
 
     (void)table_idx;
     (void)table_seg_idx;
@@ -1561,11 +1754,47 @@ void *wasm_validator_code_callback(void *arg)
 
 #endif
 
-bool wasm_validator(WASMModule *module)
+bool wasm_set_lazy_validation(WASMModule *module)
+{
+    if (module->lazy_validation)
+        return true;
+
+    if (os_mutex_init(&module->shared->lazy_lock) != 0)
+    {
+        wasm_set_exception(module, "init lazy validation lock failed");
+        return false;
+    }
+    module->lazy_validation = true;
+    return true;
+}
+
+bool wasm_validator_resolve_lazy(WASMModule *module, WASMFunction *func)
+{
+    bool ret = true;
+    // 实例与已编译模块共享函数, 使用同一把锁
+    korp_mutex *lock = &module->shared->lazy_lock;
+
+    os_mutex_lock(lock);
+    // 其他线程可能已经完成验证
+    if (func->func_kind == Lazy_Func)
+    {
+        ret = wasm_validator_code(module, func);
+        if (ret)
+        {
+            // 调用者看到Wasm_Func之后才会读取预解码指令和栈大小
+            os_atomic_thread_fence(os_memory_order_release);
+            func->func_kind = Wasm_Func;
+        }
+    }
+    os_mutex_unlock(lock);
+
+    return ret;
+}
+
+bool wasm_validator_module(WASMModule *module)
 {
     uint32 i, j, index, str_len;
     char *name;
-    WASMFunction *func;
     WASMGlobal *global, *globals;
     WASMExport *export;
 
@@ -1639,6 +1868,37 @@ bool wasm_validator(WASMModule *module)
                 sizeof(WASMValue));
         }
     }
+
+    // 预解码指令直接使用全局变量在global_data中的偏移
+    global = module->globals;
+    for (i = 0, index = 0; i < module->import_global_count + module->global_count; i++, global++)
+    {
+        global->data_offset = index;
+        index += wasm_value_type_size(global->type);
+    }
+
+    return true;
+}
+
+bool wasm_validator(WASMModule *module)
+{
+    uint32 i;
+    WASMFunction *func;
+
+    if (!wasm_validator_module(module))
+        goto fail;
+
+    if (module->lazy_validation)
+    {
+        // 只记录函数体的边界, 首次调用时再验证
+        func = module->functions + module->import_function_count;
+        for (i = 0; i < module->function_count; i++, func++)
+            func->func_kind = Lazy_Func;
+
+        LOG_VERBOSE("Validate deferred.\n");
+        return true;
+    }
+
 #if WASM_ENABLE_THREAD != 0
     korp_tid threads[WASM_VALIDATE_THREAD_NUM];
     uint64 args[WASM_VALIDATE_THREAD_NUM][2];
@@ -54,6 +54,13 @@ if (RUNTIME_BUILD_JIT EQUAL 1)
     )
 endif()
 
+#本地代码调用的运行时函数和预编译文件的加载器, JIT也使用其中的运行时函数
+if (RUNTIME_BUILD_JIT EQUAL 1 OR RUNTIME_BUILD_AOT EQUAL 1)
+    set (AOT_DIR ${WASMVM_DIR}/aot)
+    include_directories(${AOT_DIR}/include)
+    file (GLOB_RECURSE AOT_SOURCE ${AOT_DIR}/src/*.c)
+endif()
+
 file (GLOB_RECURSE COMMON_SOURCE
     ${COMMON_DIR}/src/*.c
     ${LOADER_DIR}/src/*.c
@@ -71,4 +78,5 @@ set (WASMVM_SOURCE
     ${COMMON_SOURCE}
     ${WASI_SOURCE}
     ${JIT_SOURE}
+    ${AOT_SOURCE}
 )
\ No newline at end of file